@@ -0,0 +1,159 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "Allocations.h"
+
+#include <dlfcn.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+using Malloc = void* (*)(size_t);
+using Calloc = void* (*)(size_t, size_t);
+using Realloc = void* (*)(void*, size_t);
+using Free = void (*)(void*);
+using PosixMemalign = int (*)(void**, size_t, size_t);
+using AlignedAlloc = void* (*)(size_t, size_t);
+
+Malloc nextMalloc;
+Calloc nextCalloc;
+Realloc nextRealloc;
+Free nextFree;
+PosixMemalign nextPosixMemalign;
+AlignedAlloc nextAlignedAlloc;
+AlignedAlloc nextMemalign;
+
+// dlsym allocates while the functions are being looked up, those allocations
+// are served from here and never freed
+alignas(std::max_align_t) char bootstrap[4096];
+size_t bootstrapUsed{0};
+bool resolving{false};
+
+bool fromBootstrap(const void* p) {
+  return p >= bootstrap && p < bootstrap + sizeof(bootstrap);
+}
+
+void* bootstrapAllocate(size_t size) {
+  constexpr auto kAlign = alignof(std::max_align_t);
+  size = (size + kAlign - 1) / kAlign * kAlign;
+  if (bootstrapUsed + size > sizeof(bootstrap)) {
+    return nullptr;
+  }
+  auto p = bootstrap + bootstrapUsed;
+  bootstrapUsed += size;
+  return p;
+}
+
+template <typename F>
+void lookup(F& f, const char* name) {
+  f = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+/// Looks up the functions being interposed, on the first allocation.
+/// Allocations start before any thread is, so this does not race.
+bool resolve() {
+  if (resolving) {
+    return false;
+  }
+  resolving = true;
+  lookup(nextCalloc, "calloc");
+  lookup(nextRealloc, "realloc");
+  lookup(nextFree, "free");
+  lookup(nextPosixMemalign, "posix_memalign");
+  lookup(nextAlignedAlloc, "aligned_alloc");
+  lookup(nextMemalign, "memalign");
+  // the last one, it tells the functions are ready
+  lookup(nextMalloc, "malloc");
+  resolving = false;
+  return true;
+}
+
+bool ready() {
+  return nextMalloc || resolve();
+}
+
+void count() {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+namespace reactivesocket {
+uint64_t heapAllocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+}
+
+extern "C" {
+
+void* malloc(size_t size) {
+  if (!ready()) {
+    return bootstrapAllocate(size);
+  }
+  count();
+  return nextMalloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  if (!ready()) {
+    // the bootstrap memory is zeroed and never reused
+    return bootstrapAllocate(n * size);
+  }
+  count();
+  return nextCalloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+  if (fromBootstrap(p)) {
+    auto moved = malloc(size);
+    if (moved) {
+      std::memcpy(
+          moved,
+          p,
+          std::min<size_t>(
+              size, bootstrap + sizeof(bootstrap) - static_cast<char*>(p)));
+    }
+    return moved;
+  }
+  if (!ready()) {
+    return nullptr;
+  }
+  count();
+  return nextRealloc(p, size);
+}
+
+void free(void* p) {
+  if (!p || fromBootstrap(p) || !ready()) {
+    return;
+  }
+  nextFree(p);
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size) {
+  if (!ready()) {
+    return ENOMEM;
+  }
+  count();
+  return nextPosixMemalign(p, alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  if (!ready()) {
+    return nullptr;
+  }
+  count();
+  return nextAlignedAlloc(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  if (!ready()) {
+    return nullptr;
+  }
+  count();
+  return nextMemalign(alignment, size);
+}
+}
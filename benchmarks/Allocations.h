@@ -0,0 +1,17 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <cstdint>
+
+namespace reactivesocket {
+
+/// Heap allocations made by the process so far, by any thread: the calls to
+/// malloc, calloc, realloc and the aligned variants, through which operator
+/// new and IOBuf allocate, whichever allocator provides them.
+///
+/// Counted by the benchmarks which link Allocations.cpp, which interposes
+/// those functions. Allocations which bypass them are not seen, e.g. folly
+/// growing an fbstring or fbvector with rallocx when running on jemalloc.
+uint64_t heapAllocations();
+}
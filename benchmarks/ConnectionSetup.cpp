@@ -0,0 +1,92 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Costs which resumption adds to connections: generating the resume token,
+// creating a socket and the frames tracked by its ResumeCache. Connections
+// which are not resumable generate no token and have no ResumeCache.
+
+#include <benchmark/benchmark.h>
+#include <folly/Random.h>
+#include <folly/io/async/EventBase.h>
+#include "src/Common.h"
+#include "src/ConnectionSetupPayload.h"
+#include "src/Frame.h"
+#include "src/NullRequestHandler.h"
+#include "src/ReactiveSocket.h"
+#include "src/ResumeCache.h"
+
+using namespace ::reactivesocket;
+
+/// The thread local batch of secure random bytes of generateNew().
+static void BM_GenerateToken(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(ResumeIdentificationToken::generateNew());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// A random number per byte of the token, as generateNew() used to.
+static void BM_GenerateTokenPerByte(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    std::vector<uint8_t> data;
+    data.reserve(16);
+    for (size_t i = 0; i < 16; ++i) {
+      data.push_back(static_cast<uint8_t>(folly::Random::rand32()));
+    }
+    ResumeIdentificationToken token;
+    token.set(std::move(data));
+    benchmark::DoNotOptimize(token);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// The argument is whether the connection is resumable.
+static void BM_SetupPayload(benchmark::State& state) {
+  const bool resumable = state.range(0);
+  while (state.KeepRunning()) {
+    ConnectionSetupPayload setupPayload("", "", Payload(), resumable);
+    benchmark::DoNotOptimize(setupPayload);
+  }
+  state.SetLabel(resumable ? "resumable" : "not resumable");
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Creating and closing a socket, which no longer allocates a ResumeCache
+/// until it is made resumable.
+static void BM_CreateSocket(benchmark::State& state) {
+  folly::EventBase eventBase;
+  while (state.KeepRunning()) {
+    auto socket = ReactiveSocket::disconnectedClient(
+        eventBase, std::make_unique<NullRequestHandler>());
+    benchmark::DoNotOptimize(socket);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// The tracking of a sent and a received PAYLOAD frame, which resumable
+/// connections pay per frame and the others skip. The argument is the size
+/// of the data.
+static void BM_TrackFrame(benchmark::State& state) {
+  auto serializer = FrameSerializer::createCurrentVersion();
+  const auto frame = serializer->serializeOut(Frame_PAYLOAD(
+      1,
+      FrameFlags::NEXT,
+      Payload(std::string(static_cast<size_t>(state.range(0)), 'x'))));
+  ResumeCache cache(Stats::noop());
+  while (state.KeepRunning()) {
+    cache.trackSentFrame(*frame, FrameType::PAYLOAD, StreamId(1));
+    cache.trackReceivedFrame(*frame, FrameType::PAYLOAD);
+    // as the keepalives of the peer would
+    if (cache.size() > (64 << 10)) {
+      cache.resetUpToPosition(cache.position());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GenerateToken);
+BENCHMARK(BM_GenerateTokenPerByte);
+BENCHMARK(BM_SetupPayload)->Arg(0)->Arg(1);
+BENCHMARK(BM_CreateSocket);
+BENCHMARK(BM_TrackFrame)->Arg(64)->Arg(4 << 10);
+
+BENCHMARK_MAIN()
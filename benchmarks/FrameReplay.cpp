@@ -0,0 +1,342 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Replays a frame capture (see src/FrameCapture.h) against a server.
+//
+// The frames one side of the captured connection sent are written to a fresh
+// connection to the server, either at the recorded timing or as fast as
+// possible, and the responses are matched to the requests by stream id. The
+// capture should start at the SETUP frame, i.e. at the beginning of a
+// connection.
+
+#include <folly/Baton.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/Optional.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+#include "rsocket/transports/TcpConnectionFactory.h"
+#include "src/FrameCapture.h"
+#include "src/FrameSerializer.h"
+#include "src/HdrHistogram.h"
+
+using namespace ::reactivesocket;
+using namespace ::rsocket;
+
+DEFINE_string(capture, "", "frame capture to replay");
+DEFINE_string(host, "localhost", "host to connect to");
+DEFINE_int32(port, 9898, "port to connect to");
+DEFINE_int32(connect_seconds, 5, "seconds to wait for the connection");
+DEFINE_string(
+    direction,
+    "inbound",
+    "captured frames to replay: inbound (captured by a server) or outbound "
+    "(captured by a client)");
+DEFINE_string(
+    timing,
+    "recorded",
+    "recorded (keep the captured intervals) or flat (as fast as possible)");
+DEFINE_int32(
+    drain_seconds,
+    5,
+    "seconds to wait for outstanding responses after the last frame");
+DEFINE_string(json, "", "write the results as JSON to this file, - for stdout");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool isRequest(FrameType frameType) {
+  switch (frameType) {
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Writes the replayed frames to the connection and reads the responses.
+///
+/// Lives on the EventBase of the connection, all methods but outstanding()
+/// must be called there.
+class Replayer : public Subscriber<std::unique_ptr<folly::IOBuf>>,
+                 public Subscription,
+                 public std::enable_shared_from_this<Replayer> {
+ public:
+  explicit Replayer(std::unique_ptr<DuplexConnection> connection)
+      : connection_(std::move(connection)) {}
+
+  void start() {
+    output_ = connection_->getOutput();
+    output_->onSubscribe(shared_from_this());
+    connection_->setInput(shared_from_this());
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> frame) {
+    if (!output_) {
+      return;
+    }
+    if (!serializer_) {
+      serializer_ = FrameSerializer::createAutodetectedSerializer(*frame);
+      if (!serializer_) {
+        LOG(WARNING) << "the capture does not start with SETUP";
+        serializer_ = FrameSerializer::createCurrentVersion();
+      }
+    }
+    if (isRequest(serializer_->peekFrameType(*frame))) {
+      if (auto streamId = serializer_->peekStreamId(*frame)) {
+        sentAt_[*streamId] = Clock::now();
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    ++framesSent_;
+    bytesSent_ += frame->computeChainDataLength();
+    output_->onNext(std::move(frame));
+  }
+
+  void close() {
+    if (auto output = std::move(output_)) {
+      output->onComplete();
+    }
+    if (auto input = std::move(input_)) {
+      input->cancel();
+    }
+  }
+
+  uint64_t outstanding() const {
+    return outstanding_.load(std::memory_order_relaxed);
+  }
+
+  folly::dynamic results() const {
+    auto micros = [&](double percentile) {
+      return latencies_.percentile(percentile) / 1000.0;
+    };
+    return folly::dynamic::object("frames_sent", framesSent_)(
+        "bytes_sent", bytesSent_)("frames_received", framesReceived_)(
+        "bytes_received", bytesReceived_)("responses", latencies_.count())(
+        "unanswered", outstanding())(
+        "first_response_latency_us",
+        folly::dynamic::object("p50", micros(50))("p90", micros(90))(
+            "p99", micros(99))("p999", micros(99.9))("max", micros(100)));
+  }
+
+ private:
+  void onSubscribe(std::shared_ptr<Subscription> subscription) noexcept
+      override {
+    input_ = std::move(subscription);
+    input_->request(std::numeric_limits<size_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> frame) noexcept override {
+    ++framesReceived_;
+    bytesReceived_ += frame->computeChainDataLength();
+    if (!serializer_) {
+      return;
+    }
+    auto frameType = serializer_->peekFrameType(*frame);
+    if (frameType != FrameType::PAYLOAD && frameType != FrameType::ERROR) {
+      return;
+    }
+    auto streamId = serializer_->peekStreamId(*frame);
+    if (!streamId) {
+      return;
+    }
+    auto it = sentAt_.find(*streamId);
+    if (it == sentAt_.end()) {
+      if (*streamId == 0) {
+        LOG(ERROR) << "the server closed the connection with an error";
+      }
+      return;
+    }
+    latencies_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Clock::now() - it->second)
+                          .count());
+    sentAt_.erase(it);
+    outstanding_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void onComplete() noexcept override {
+    output_ = nullptr;
+  }
+
+  void onError(folly::exception_wrapper ex) noexcept override {
+    LOG(ERROR) << "connection failed: " << ex.what();
+    output_ = nullptr;
+  }
+
+  // Frames are replayed regardless of the writability of the connection, so
+  // that the server sees the captured timing.
+  void request(size_t) noexcept override {}
+  void cancel() noexcept override {
+    output_ = nullptr;
+  }
+
+  std::unique_ptr<DuplexConnection> connection_;
+  std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> output_;
+  std::shared_ptr<Subscription> input_;
+  std::unique_ptr<FrameSerializer> serializer_;
+
+  /// Requests waiting for their first response.
+  std::unordered_map<StreamId, Clock::time_point> sentAt_;
+  std::atomic<uint64_t> outstanding_{0};
+
+  uint64_t framesSent_{0};
+  uint64_t bytesSent_{0};
+  uint64_t framesReceived_{0};
+  uint64_t bytesReceived_{0};
+  HdrHistogram latencies_;
+};
+
+/// The connection to the server, handed over by the connect callbacks.
+struct Connecting {
+  folly::Baton<> done;
+  std::shared_ptr<Replayer> replayer;
+  folly::EventBase* eventBase{nullptr};
+  folly::exception_wrapper error;
+};
+
+/// Returns nothing when the capture could not be replayed.
+folly::Optional<folly::dynamic> replay() {
+  CHECK(!FLAGS_capture.empty()) << "--capture is required";
+  CHECK(FLAGS_direction == "inbound" || FLAGS_direction == "outbound")
+      << "unknown direction " << FLAGS_direction;
+  CHECK(FLAGS_timing == "recorded" || FLAGS_timing == "flat")
+      << "unknown timing " << FLAGS_timing;
+  const auto direction = FLAGS_direction == "inbound"
+      ? FrameDirection::INBOUND
+      : FrameDirection::OUTBOUND;
+  const bool recordedTiming = FLAGS_timing == "recorded";
+
+  FrameCaptureReader reader(FLAGS_capture);
+
+  folly::SocketAddress address;
+  address.setFromHostPort(FLAGS_host, FLAGS_port);
+  TcpConnectionFactory factory(std::move(address));
+
+  // the callbacks may still run after a timeout, they share the state
+  auto connecting = std::make_shared<Connecting>();
+  factory.connect(
+      [connecting](
+          std::unique_ptr<DuplexConnection> connection, folly::EventBase& evb) {
+        auto replayer = std::make_shared<Replayer>(std::move(connection));
+        replayer->start();
+        connecting->replayer = std::move(replayer);
+        connecting->eventBase = &evb;
+        connecting->done.post();
+      },
+      [connecting](folly::exception_wrapper ex) {
+        connecting->error = std::move(ex);
+        connecting->done.post();
+      });
+  if (!connecting->done.timed_wait(
+          Clock::now() + std::chrono::seconds(FLAGS_connect_seconds))) {
+    LOG(ERROR) << "timed out connecting to " << FLAGS_host << ":"
+               << FLAGS_port;
+    return folly::none;
+  }
+  if (connecting->error) {
+    LOG(ERROR) << "failed to connect to " << FLAGS_host << ":" << FLAGS_port
+               << ": " << connecting->error.what();
+    return folly::none;
+  }
+  auto replayer = std::move(connecting->replayer);
+  auto eventBase = connecting->eventBase;
+
+  FrameCaptureReader::Record record;
+  folly::Optional<std::chrono::nanoseconds> firstOffset;
+  const auto start = Clock::now();
+  while (reader.next(record)) {
+    if (record.direction != direction) {
+      continue;
+    }
+    if (!firstOffset) {
+      firstOffset = record.offset;
+    }
+    if (recordedTiming) {
+      std::this_thread::sleep_until(start + (record.offset - *firstOffset));
+    }
+    auto frame = folly::IOBuf::copyBuffer(record.frame);
+    eventBase->runInEventBaseThread(
+        [replayer, frame = std::move(frame)]() mutable {
+          replayer->send(std::move(frame));
+        });
+  }
+  // all the frames have been written once this returns
+  eventBase->runInEventBaseThreadAndWait([] {});
+  const auto elapsed = Clock::now() - start;
+
+  const auto drainUntil =
+      Clock::now() + std::chrono::seconds(FLAGS_drain_seconds);
+  while (replayer->outstanding() > 0 && Clock::now() < drainUntil) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  folly::dynamic results;
+  eventBase->runInEventBaseThreadAndWait([&] {
+    results = replayer->results();
+    replayer->close();
+    // the connection has to be destroyed on its EventBase
+    replayer = nullptr;
+  });
+
+  const auto seconds = std::chrono::duration<double>(elapsed).count();
+  results["capture"] = FLAGS_capture;
+  results["timing"] = FLAGS_timing;
+  results["seconds"] = seconds;
+  results["frames_per_second"] = results["frames_sent"].asInt() / seconds;
+  results["megabytes_per_second"] =
+      results["bytes_sent"].asInt() / seconds / (1 << 20);
+  return results;
+}
+
+void report(const folly::dynamic& results) {
+  auto json = folly::toPrettyJson(results);
+  if (FLAGS_json == "-") {
+    std::cout << json << std::endl;
+    return;
+  }
+  if (!FLAGS_json.empty()) {
+    std::ofstream(FLAGS_json) << json << std::endl;
+  }
+
+  const auto& latency = results["first_response_latency_us"];
+  std::cout << results["frames_sent"].asInt() << " frames in "
+            << results["seconds"].asDouble() << "s, "
+            << results["frames_per_second"].asDouble() << " frames/s, "
+            << results["megabytes_per_second"].asDouble() << " MB/s\n"
+            << results["responses"].asInt() << " responses, "
+            << results["unanswered"].asInt() << " unanswered\n"
+            << "first response latency us: p50 " << latency["p50"].asDouble()
+            << ", p90 " << latency["p90"].asDouble() << ", p99 "
+            << latency["p99"].asDouble() << ", p999 "
+            << latency["p999"].asDouble() << ", max "
+            << latency["max"].asDouble() << std::endl;
+}
+}
+
+int main(int argc, char* argv[]) {
+#ifdef OSS
+  google::ParseCommandLineFlags(&argc, &argv, true);
+#else
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+#endif
+
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  auto results = replay();
+  if (!results) {
+    return 1;
+  }
+  report(*results);
+  return 0;
+}
@@ -0,0 +1,391 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Encode and decode cost of every frame type in every protocol version,
+// reported as time and heap allocations per frame.
+//
+// Arguments of the data-carrying frames are
+//   protocol version/payload size/with metadata/chained
+// where a chained payload is split into four IOBufs, those of the other frames
+// just the protocol version. Versions are 0: 0.0, 1: 0.1, 2: 1.0.
+//
+// Encoding includes cloning the payload into a new frame (an IOBuf per data
+// and metadata), decoding includes cloning the serialized frame (one IOBuf),
+// which is what the connection does too.
+//
+// The allocations are counted in malloc (see Allocations.h), so that those of
+// the IOBuf buffers are included along with those of operator new.
+
+#include <benchmark/benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include "Allocations.h"
+#include "src/Frame.h"
+#include "src/FrameSerializer.h"
+#include "src/versions/FrameSerializer_v0.h"
+#include "src/versions/FrameSerializer_v0_1.h"
+#include "src/versions/FrameSerializer_v1_0.h"
+
+using namespace ::reactivesocket;
+
+namespace {
+
+constexpr StreamId kStreamId = 7;
+
+std::unique_ptr<FrameSerializer> createSerializer(int version) {
+  switch (version) {
+    case 0:
+      return FrameSerializer::createFrameSerializer(FrameSerializerV0::Version);
+    case 1:
+      return FrameSerializer::createFrameSerializer(
+          FrameSerializerV0_1::Version);
+    default:
+      return FrameSerializer::createFrameSerializer(
+          FrameSerializerV1_0::Version);
+  }
+}
+
+std::unique_ptr<folly::IOBuf> makeBuffer(size_t size, bool chained) {
+  if (!chained || size < 4) {
+    auto buffer = folly::IOBuf::create(size);
+    std::memset(buffer->writableData(), 'a', size);
+    buffer->append(size);
+    return buffer;
+  }
+  std::unique_ptr<folly::IOBuf> head;
+  for (size_t i = 0; i < 4; ++i) {
+    auto part = makeBuffer(i < 3 ? size / 4 : size - 3 * (size / 4), false);
+    if (head) {
+      head->prependChain(std::move(part));
+    } else {
+      head = std::move(part);
+    }
+  }
+  return head;
+}
+
+/// Payload described by the arguments of the benchmark.
+Payload makePayload(const benchmark::State& state) {
+  const auto size = static_cast<size_t>(state.range(1));
+  const bool chained = state.range(3);
+  return Payload(
+      makeBuffer(size, chained),
+      state.range(2) ? makeBuffer(std::min<size_t>(size, 64), chained)
+                     : nullptr);
+}
+
+// Frames made for a benchmark, the payload is cloned from the prototype.
+
+template <typename Frame>
+Frame makeFrame(const Payload& payload);
+
+template <>
+Frame_REQUEST_STREAM makeFrame<Frame_REQUEST_STREAM>(const Payload& payload) {
+  return Frame_REQUEST_STREAM(
+      kStreamId, FrameFlags::EMPTY, 128, payload.clone());
+}
+
+template <>
+Frame_REQUEST_CHANNEL makeFrame<Frame_REQUEST_CHANNEL>(const Payload& payload) {
+  return Frame_REQUEST_CHANNEL(
+      kStreamId, FrameFlags::EMPTY, 128, payload.clone());
+}
+
+template <>
+Frame_REQUEST_RESPONSE makeFrame<Frame_REQUEST_RESPONSE>(
+    const Payload& payload) {
+  return Frame_REQUEST_RESPONSE(kStreamId, FrameFlags::EMPTY, payload.clone());
+}
+
+template <>
+Frame_REQUEST_FNF makeFrame<Frame_REQUEST_FNF>(const Payload& payload) {
+  return Frame_REQUEST_FNF(kStreamId, FrameFlags::EMPTY, payload.clone());
+}
+
+template <>
+Frame_PAYLOAD makeFrame<Frame_PAYLOAD>(const Payload& payload) {
+  return Frame_PAYLOAD(kStreamId, FrameFlags::NEXT, payload.clone());
+}
+
+template <>
+Frame_ERROR makeFrame<Frame_ERROR>(const Payload& payload) {
+  return Frame_ERROR(
+      kStreamId, ErrorCode::APPLICATION_ERROR, payload.clone());
+}
+
+template <>
+Frame_METADATA_PUSH makeFrame<Frame_METADATA_PUSH>(const Payload& payload) {
+  return Frame_METADATA_PUSH(
+      payload.metadata ? payload.metadata->clone() : payload.data->clone());
+}
+
+template <>
+Frame_KEEPALIVE makeFrame<Frame_KEEPALIVE>(const Payload& payload) {
+  return Frame_KEEPALIVE(
+      FrameFlags::KEEPALIVE_RESPOND, 1024, payload.data->clone());
+}
+
+template <>
+Frame_SETUP makeFrame<Frame_SETUP>(const Payload& payload) {
+  return Frame_SETUP(
+      FrameFlags::EMPTY,
+      1,
+      0,
+      1000,
+      1000,
+      ResumeIdentificationToken(),
+      "text/plain",
+      "text/plain",
+      payload.clone());
+}
+
+template <>
+Frame_LEASE makeFrame<Frame_LEASE>(const Payload& payload) {
+  return Frame_LEASE(1000, 100, payload.data->clone());
+}
+
+template <>
+Frame_REQUEST_N makeFrame<Frame_REQUEST_N>(const Payload&) {
+  return Frame_REQUEST_N(kStreamId, 128);
+}
+
+template <>
+Frame_CANCEL makeFrame<Frame_CANCEL>(const Payload&) {
+  return Frame_CANCEL(kStreamId);
+}
+
+template <>
+Frame_RESUME makeFrame<Frame_RESUME>(const Payload&) {
+  return Frame_RESUME(
+      ResumeIdentificationToken::generateNew(),
+      1024,
+      2048,
+      FrameSerializerV1_0::Version);
+}
+
+template <>
+Frame_RESUME_OK makeFrame<Frame_RESUME_OK>(const Payload&) {
+  return Frame_RESUME_OK(1024);
+}
+
+template <typename Frame>
+std::unique_ptr<folly::IOBuf> serialize(
+    FrameSerializer& serializer,
+    Frame&& frame) {
+  return serializer.serializeOut(std::forward<Frame>(frame));
+}
+
+std::unique_ptr<folly::IOBuf> serialize(
+    FrameSerializer& serializer,
+    Frame_KEEPALIVE&& frame) {
+  return serializer.serializeOut(std::move(frame), true);
+}
+
+template <typename Frame>
+bool deserialize(
+    FrameSerializer& serializer,
+    Frame& frame,
+    std::unique_ptr<folly::IOBuf> in) {
+  return serializer.deserializeFrom(frame, std::move(in));
+}
+
+bool deserialize(
+    FrameSerializer& serializer,
+    Frame_KEEPALIVE& frame,
+    std::unique_ptr<folly::IOBuf> in) {
+  return serializer.deserializeFrom(frame, std::move(in), true);
+}
+
+/// Frames benchmarked with the protocol version as the only argument.
+template <typename Frame>
+struct FixedSize : std::false_type {};
+template <>
+struct FixedSize<Frame_LEASE> : std::true_type {};
+template <>
+struct FixedSize<Frame_REQUEST_N> : std::true_type {};
+template <>
+struct FixedSize<Frame_CANCEL> : std::true_type {};
+template <>
+struct FixedSize<Frame_RESUME> : std::true_type {};
+template <>
+struct FixedSize<Frame_RESUME_OK> : std::true_type {};
+
+/// Prototype payload: from the arguments for the data-carrying frames,
+/// a small one otherwise (some frames without a Payload still carry data).
+template <typename Frame>
+Payload prototypePayload(const benchmark::State& state) {
+  if (FixedSize<Frame>::value) {
+    return Payload("data", "metadata");
+  }
+  return makePayload(state);
+}
+
+void report(benchmark::State& state, uint64_t allocationsBefore) {
+  const auto frames = state.iterations();
+  char label[64];
+  std::snprintf(
+      label,
+      sizeof(label),
+      "allocs/frame: %.2f",
+      frames ? static_cast<double>(heapAllocations() - allocationsBefore) /
+              frames
+             : 0.0);
+  state.SetLabel(label);
+  state.SetItemsProcessed(frames);
+}
+
+template <typename Frame>
+void BM_Serialize(benchmark::State& state) {
+  auto serializer = createSerializer(state.range(0));
+  const auto payload = prototypePayload<Frame>(state);
+  size_t bytes = 0;
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    auto out = serialize(*serializer, makeFrame<Frame>(payload));
+    bytes = out->computeChainDataLength();
+    benchmark::DoNotOptimize(out);
+  }
+  report(state, allocationsBefore);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+template <typename Frame>
+void BM_Deserialize(benchmark::State& state) {
+  auto serializer = createSerializer(state.range(0));
+  const auto payload = prototypePayload<Frame>(state);
+  const auto serialized = serialize(*serializer, makeFrame<Frame>(payload));
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    Frame frame;
+    auto ok = deserialize(*serializer, frame, serialized->clone());
+    benchmark::DoNotOptimize(ok);
+  }
+  report(state, allocationsBefore);
+  state.SetBytesProcessed(
+      state.iterations() * serialized->computeChainDataLength());
+}
+
+/// What ConnectionAutomaton::processFrameImpl does for every frame.
+void BM_Peek(benchmark::State& state) {
+  auto serializer = createSerializer(state.range(0));
+  const auto serialized = serialize(
+      *serializer, makeFrame<Frame_PAYLOAD>(Payload("data", "metadata")));
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    auto frameType = serializer->peekFrameType(*serialized);
+    auto streamId = serializer->peekStreamId(*serialized);
+    benchmark::DoNotOptimize(frameType);
+    benchmark::DoNotOptimize(streamId);
+  }
+  report(state, allocationsBefore);
+}
+
+/// The single pass replacement of BM_Peek.
+void BM_PeekHeader(benchmark::State& state) {
+  auto serializer = createSerializer(state.range(0));
+  const auto serialized = serialize(
+      *serializer, makeFrame<Frame_PAYLOAD>(Payload("data", "metadata")));
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    FrameHeader header;
+    auto valid = serializer->peekFrameHeader(*serialized, header);
+    benchmark::DoNotOptimize(valid);
+    benchmark::DoNotOptimize(header);
+  }
+  report(state, allocationsBefore);
+}
+
+/// Peeking at and decoding a small PAYLOAD frame, as done for every frame
+/// received on a stream; the 1.0 serializer is called without virtual
+/// dispatch, as in ConnectionAutomaton.
+void BM_ReceivePayload(benchmark::State& state) {
+  auto serializer = createSerializer(state.range(0));
+  auto serializerV1_0 = dynamic_cast<FrameSerializerV1_0*>(serializer.get());
+  const auto serialized = serialize(
+      *serializer, makeFrame<Frame_PAYLOAD>(Payload("data", "metadata")));
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    FrameHeader header;
+    Frame_PAYLOAD frame;
+    auto valid = serializerV1_0
+        ? serializerV1_0->peekFrameHeader(*serialized, header) &&
+            serializerV1_0->deserializeFrom(frame, serialized->clone())
+        : serializer->peekFrameHeader(*serialized, header) &&
+            serializer->deserializeFrom(frame, serialized->clone());
+    benchmark::DoNotOptimize(valid);
+  }
+  report(state, allocationsBefore);
+}
+
+/// BM_ReceivePayload with the frame parsed in place and taken as a Payload, as
+/// ConnectionAutomaton does for 1.0. The argument is whether the frame carries
+/// metadata.
+void BM_ReceivePayloadView(benchmark::State& state) {
+  FrameSerializerV1_0 serializer;
+  const auto serialized = serializer.serializeOut(makeFrame<Frame_PAYLOAD>(
+      state.range(0) ? Payload("data", "metadata") : Payload("data")));
+
+  const auto allocationsBefore = heapAllocations();
+  while (state.KeepRunning()) {
+    FrameHeader header;
+    PayloadFrameView frame;
+    auto valid = serializer.peekFrameHeader(*serialized, header) &&
+        serializer.deserializeFrom(frame, serialized->clone());
+    auto payload = frame.takePayload();
+    benchmark::DoNotOptimize(valid);
+    benchmark::DoNotOptimize(payload);
+  }
+  report(state, allocationsBefore);
+}
+
+void versions(benchmark::internal::Benchmark* benchmark) {
+  for (int version = 0; version < 3; ++version) {
+    benchmark->Arg(version);
+  }
+}
+
+void payloads(benchmark::internal::Benchmark* benchmark) {
+  for (int version = 0; version < 3; ++version) {
+    for (int size : {0, 64, 4 << 10, 64 << 10, 1 << 20}) {
+      for (int metadata : {0, 1}) {
+        for (int chained : {0, 1}) {
+          benchmark->Args({version, size, metadata, chained});
+        }
+      }
+    }
+  }
+}
+}
+
+#define FRAME_BENCHMARKS(Frame, Arguments)                   \
+  BENCHMARK_TEMPLATE(BM_Serialize, Frame)->Apply(Arguments); \
+  BENCHMARK_TEMPLATE(BM_Deserialize, Frame)->Apply(Arguments)
+
+FRAME_BENCHMARKS(Frame_REQUEST_STREAM, payloads);
+FRAME_BENCHMARKS(Frame_REQUEST_CHANNEL, payloads);
+FRAME_BENCHMARKS(Frame_REQUEST_RESPONSE, payloads);
+FRAME_BENCHMARKS(Frame_REQUEST_FNF, payloads);
+FRAME_BENCHMARKS(Frame_PAYLOAD, payloads);
+FRAME_BENCHMARKS(Frame_ERROR, payloads);
+FRAME_BENCHMARKS(Frame_METADATA_PUSH, payloads);
+FRAME_BENCHMARKS(Frame_KEEPALIVE, payloads);
+FRAME_BENCHMARKS(Frame_SETUP, payloads);
+FRAME_BENCHMARKS(Frame_LEASE, versions);
+FRAME_BENCHMARKS(Frame_REQUEST_N, versions);
+FRAME_BENCHMARKS(Frame_CANCEL, versions);
+FRAME_BENCHMARKS(Frame_RESUME, versions);
+FRAME_BENCHMARKS(Frame_RESUME_OK, versions);
+
+BENCHMARK(BM_Peek)->Apply(versions);
+BENCHMARK(BM_PeekHeader)->Apply(versions);
+BENCHMARK(BM_ReceivePayload)->Apply(versions);
+BENCHMARK(BM_ReceivePayloadView)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN()
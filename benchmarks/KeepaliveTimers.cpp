@@ -0,0 +1,120 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// CPU spent on keepalives per idle connection and keepalive period, with a
+// FollyKeepaliveTimer per connection and with the connections of the
+// EventBase sharing a KeepaliveWheel. The argument is the number of
+// connections.
+//
+// Each iteration runs the EventBase for one keepalive period, in which every
+// connection sends one keepalive. The connections answer all keepalives at
+// the end of the period, outside of the measurement.
+
+#include <benchmark/benchmark.h>
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include "src/ConnectionAutomaton.h"
+#include "src/Frame.h"
+#include "src/folly/FollyKeepaliveTimer.h"
+#include "src/folly/KeepaliveWheel.h"
+
+using namespace ::reactivesocket;
+
+namespace {
+
+constexpr std::chrono::milliseconds kPeriod{100};
+
+class IdleConnection : public FrameSink {
+ public:
+  void disconnectOrCloseWithError(Frame_ERROR&&) override {
+    LOG(FATAL) << "idle connection missed a keepalive";
+  }
+
+  void sendKeepalive(std::unique_ptr<folly::IOBuf>) override {
+    ++keepalives;
+  }
+
+  static uint64_t keepalives;
+};
+
+uint64_t IdleConnection::keepalives{0};
+
+template <typename CreateTimer>
+void runIdleConnections(
+    benchmark::State& state,
+    folly::EventBase& eventBase,
+    CreateTimer createTimer) {
+  const auto connections = static_cast<size_t>(state.range(0));
+  auto connection = std::make_shared<IdleConnection>();
+  std::vector<std::unique_ptr<KeepaliveTimer>> timers;
+  timers.reserve(connections);
+  for (size_t i = 0; i < connections; ++i) {
+    timers.push_back(createTimer());
+    timers.back()->start(connection);
+  }
+
+  std::clock_t cpu{0};
+  uint64_t periods{0};
+  IdleConnection::keepalives = 0;
+  while (state.KeepRunning()) {
+    const auto start = std::clock();
+    eventBase.runAfterDelay(
+        [&] { eventBase.terminateLoopSoon(); },
+        static_cast<uint32_t>(kPeriod.count()));
+    eventBase.loopForever();
+    cpu += std::clock() - start;
+    ++periods;
+
+    state.PauseTiming();
+    for (auto& timer : timers) {
+      timer->keepaliveReceived();
+    }
+    state.ResumeTiming();
+  }
+
+  for (auto& timer : timers) {
+    timer->stop();
+  }
+  timers.clear();
+
+  char label[128];
+  std::snprintf(
+      label,
+      sizeof(label),
+      "CPU ns/connection/period: %.1f, keepalives/period: %.0f",
+      1e9 * cpu / CLOCKS_PER_SEC / periods / connections,
+      static_cast<double>(IdleConnection::keepalives) / periods);
+  state.SetLabel(label);
+}
+}
+
+static void BM_FollyKeepaliveTimer(benchmark::State& state) {
+  folly::EventBase eventBase;
+  runIdleConnections(state, eventBase, [&] {
+    return std::make_unique<FollyKeepaliveTimer>(eventBase, kPeriod);
+  });
+}
+
+static void BM_KeepaliveWheel(benchmark::State& state) {
+  folly::EventBase eventBase;
+  auto wheel = std::make_shared<KeepaliveWheel>(eventBase);
+  runIdleConnections(
+      state, eventBase, [&] { return wheel->createTimer(kPeriod); });
+}
+
+BENCHMARK(BM_FollyKeepaliveTimer)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(500000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_KeepaliveWheel)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(500000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN()
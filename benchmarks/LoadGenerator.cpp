@@ -0,0 +1,379 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Open-loop load generator.
+//
+// Requests are issued on a fixed schedule, independently of how fast the
+// responses come back, and every latency is measured from the time the
+// request was *scheduled* to be sent.  A stalled server or client therefore
+// shows up in the percentiles instead of silently lowering the request rate
+// (coordinated omission).
+//
+// Runs the client and the server over loopback in one process by default, or
+// either side alone with --mode=server / --mode=client.
+
+#include <folly/ExceptionString.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/TcpConnectionAcceptor.h"
+#include "rsocket/transports/TcpConnectionFactory.h"
+#include "src/HdrHistogram.h"
+#include "yarpl/Flowable.h"
+#include "yarpl/Single.h"
+
+using namespace ::reactivesocket;
+using namespace ::rsocket;
+using namespace yarpl;
+
+DEFINE_string(
+    mode,
+    "loopback",
+    "loopback (client and server in this process), server or client");
+DEFINE_string(host, "localhost", "host to connect to");
+DEFINE_int32(port, 9899, "port to listen on or connect to");
+DEFINE_string(
+    interaction,
+    "request_response",
+    "interaction model: request_response or stream");
+DEFINE_int32(payload_size, 32, "size of the request and response data");
+DEFINE_int32(stream_items, 10, "number of items of every stream");
+DEFINE_int32(
+    connections,
+    1,
+    "number of client connections, each loaded by its own thread");
+DEFINE_int32(rate, 10000, "requests per second across all connections");
+DEFINE_int32(warmup_seconds, 2, "seconds of load excluded from the results");
+DEFINE_int32(duration_seconds, 10, "seconds of load included in the results");
+DEFINE_int32(
+    drain_seconds,
+    5,
+    "seconds to wait for outstanding requests after the load stops");
+DEFINE_string(json, "", "write the results as JSON to this file, - for stdout");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class Responder : public RSocketResponder {
+ public:
+  Responder() : data_(FLAGS_payload_size, 'a') {}
+
+  Reference<single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    return single::Single<Payload>::create(
+        [this](Reference<single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(data_));
+        });
+  }
+
+  Reference<flowable::Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    return flowable::Flowables::fromGenerator<Payload>([this] {
+      return Payload(data_);
+    })->take(FLAGS_stream_items);
+  }
+
+ private:
+  std::string data_;
+};
+
+/// Results of a single connection.
+///
+/// Completions of a connection are all delivered on its EventBase thread,
+/// which makes it the only writer of the histogram. Shared with the
+/// observers of the requests, which may outlive the run when they time out.
+class Recorder {
+ public:
+  explicit Recorder(Clock::time_point measureFrom)
+      : measureFrom_(measureFrom) {}
+
+  bool measured(Clock::time_point scheduled) const {
+    return scheduled >= measureFrom_;
+  }
+
+  void issued(Clock::time_point scheduled) {
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    if (measured(scheduled)) {
+      ++issued_;
+    }
+  }
+
+  void completed(Clock::time_point scheduled) {
+    if (measured(scheduled) && !stopped()) {
+      latencies_.record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              Clock::now() - scheduled)
+              .count());
+    }
+    outstanding_.fetch_sub(1, std::memory_order_release);
+  }
+
+  void failed(Clock::time_point scheduled, std::exception_ptr ex) {
+    if (stopped()) {
+      outstanding_.fetch_sub(1, std::memory_order_release);
+      return;
+    }
+    LOG_EVERY_N(ERROR, 1000) << folly::exceptionStr(ex);
+    if (measured(scheduled)) {
+      errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    outstanding_.fetch_sub(1, std::memory_order_release);
+  }
+
+  uint64_t outstanding() const {
+    return outstanding_.load(std::memory_order_acquire);
+  }
+
+  /// Ends the measurement: the requests which terminate from now on, like
+  /// those failed by closing the connection, are left out of the results.
+  void stop() {
+    stopped_.store(true, std::memory_order_relaxed);
+  }
+
+  bool stopped() const {
+    return stopped_.load(std::memory_order_relaxed);
+  }
+
+  const Clock::time_point measureFrom_;
+  std::atomic<uint64_t> issued_{0};
+  std::atomic<uint64_t> errors_{0};
+  std::atomic<uint64_t> outstanding_{0};
+  std::atomic<bool> stopped_{false};
+  HdrHistogram latencies_;
+};
+
+class ResponseObserver : public single::SingleObserver<Payload> {
+ public:
+  ResponseObserver(
+      std::shared_ptr<Recorder> recorder,
+      Clock::time_point scheduled)
+      : recorder_(std::move(recorder)), scheduled_(scheduled) {}
+
+  void onSuccess(Payload payload) override {
+    recorder_->completed(scheduled_);
+    single::SingleObserver<Payload>::onSuccess(std::move(payload));
+  }
+
+  void onError(std::exception_ptr ex) override {
+    recorder_->failed(scheduled_, ex);
+    single::SingleObserver<Payload>::onError(ex);
+  }
+
+ private:
+  const std::shared_ptr<Recorder> recorder_;
+  const Clock::time_point scheduled_;
+};
+
+/// Measures the time until the whole stream completes.
+class StreamSubscriber : public flowable::Subscriber<Payload> {
+ public:
+  StreamSubscriber(
+      std::shared_ptr<Recorder> recorder,
+      Clock::time_point scheduled)
+      : recorder_(std::move(recorder)), scheduled_(scheduled) {}
+
+  void onSubscribe(Reference<flowable::Subscription> subscription) override {
+    flowable::Subscriber<Payload>::onSubscribe(subscription);
+    subscription->request(FLAGS_stream_items);
+  }
+
+  void onComplete() override {
+    recorder_->completed(scheduled_);
+    flowable::Subscriber<Payload>::onComplete();
+  }
+
+  void onError(std::exception_ptr ex) override {
+    recorder_->failed(scheduled_, ex);
+    flowable::Subscriber<Payload>::onError(ex);
+  }
+
+ private:
+  const std::shared_ptr<Recorder> recorder_;
+  const Clock::time_point scheduled_;
+};
+
+/// Issues requests on rs at the given interval, starting at start, until end.
+void generateLoad(
+    RSocketRequester& rs,
+    const std::shared_ptr<Recorder>& recorder,
+    Clock::duration interval,
+    Clock::time_point start,
+    Clock::time_point end) {
+  const bool stream = FLAGS_interaction == "stream";
+  const std::string data(FLAGS_payload_size, 'a');
+
+  for (uint64_t i = 0;; ++i) {
+    const auto scheduled = start + interval * i;
+    if (scheduled >= end) {
+      break;
+    }
+    // Returns right away when behind the schedule; the delay is accounted
+    // for in the latency, as it is measured from the scheduled time.
+    std::this_thread::sleep_until(scheduled);
+
+    recorder->issued(scheduled);
+    if (stream) {
+      rs.requestStream(Payload(data))
+          ->subscribe(make_ref<StreamSubscriber>(recorder, scheduled));
+    } else {
+      rs.requestResponse(Payload(data))
+          ->subscribe(make_ref<ResponseObserver>(recorder, scheduled));
+    }
+  }
+}
+
+folly::dynamic runClient() {
+  CHECK_GT(FLAGS_connections, 0);
+  CHECK_GT(FLAGS_rate, 0);
+  CHECK(
+      FLAGS_interaction == "request_response" ||
+      FLAGS_interaction == "stream")
+      << "unknown interaction " << FLAGS_interaction;
+
+  std::vector<std::unique_ptr<RSocketClient>> clients;
+  std::vector<std::shared_ptr<RSocketRequester>> requesters;
+  for (int i = 0; i < FLAGS_connections; ++i) {
+    folly::SocketAddress address;
+    address.setFromHostPort(FLAGS_host, FLAGS_port);
+    clients.push_back(RSocket::createClient(
+        std::make_unique<TcpConnectionFactory>(std::move(address))));
+    requesters.push_back(clients.back()->connect().get());
+  }
+
+  // Every connection takes an equal share of the rate, with the schedules
+  // of the connections interleaved.
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::nanoseconds(1000000000LL * FLAGS_connections / FLAGS_rate));
+  const auto start = Clock::now() + std::chrono::milliseconds(100);
+  const auto measureFrom = start + std::chrono::seconds(FLAGS_warmup_seconds);
+  const auto end = measureFrom + std::chrono::seconds(FLAGS_duration_seconds);
+
+  std::vector<std::shared_ptr<Recorder>> recorders;
+  std::vector<std::thread> generators;
+  for (int i = 0; i < FLAGS_connections; ++i) {
+    recorders.push_back(std::make_shared<Recorder>(measureFrom));
+    generators.emplace_back([&, i] {
+      generateLoad(
+          *requesters[i],
+          recorders[i],
+          interval,
+          start + interval * i / FLAGS_connections,
+          end);
+    });
+  }
+  for (auto& generator : generators) {
+    generator.join();
+  }
+
+  const auto drainUntil =
+      Clock::now() + std::chrono::seconds(FLAGS_drain_seconds);
+  for (auto& recorder : recorders) {
+    while (recorder->outstanding() > 0 && Clock::now() < drainUntil) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // The requests still outstanding timed out. Closing the connections fails
+  // them, and stops the EventBase threads, after which the histograms are no
+  // longer written to.
+  uint64_t outstanding = 0;
+  for (auto& recorder : recorders) {
+    recorder->stop();
+    outstanding += recorder->outstanding();
+  }
+  requesters.clear();
+  clients.clear();
+
+  HdrHistogram latencies;
+  uint64_t issued = 0;
+  uint64_t errors = 0;
+  for (auto& recorder : recorders) {
+    latencies.merge(recorder->latencies_);
+    issued += recorder->issued_;
+    errors += recorder->errors_;
+  }
+
+  auto micros = [&](double percentile) {
+    return latencies.percentile(percentile) / 1000.0;
+  };
+  return folly::dynamic::object("interaction", FLAGS_interaction)(
+      "payload_size", FLAGS_payload_size)("stream_items", FLAGS_stream_items)(
+      "connections", FLAGS_connections)("target_rate", FLAGS_rate)(
+      "duration_seconds", FLAGS_duration_seconds)("issued", issued)(
+      "completed", latencies.count())("errors", errors)(
+      "timed_out", outstanding)(
+      "achieved_rate",
+      static_cast<double>(latencies.count()) / FLAGS_duration_seconds)(
+      "latency_us",
+      folly::dynamic::object("p50", micros(50))("p90", micros(90))(
+          "p99", micros(99))("p999", micros(99.9))("p9999", micros(99.99))(
+          "max", micros(100)));
+}
+
+void report(const folly::dynamic& results) {
+  auto json = folly::toPrettyJson(results);
+  if (FLAGS_json == "-") {
+    std::cout << json << std::endl;
+    return;
+  }
+  if (!FLAGS_json.empty()) {
+    std::ofstream(FLAGS_json) << json << std::endl;
+  }
+
+  const auto& latency = results["latency_us"];
+  std::cout << results["interaction"].asString() << ": "
+            << results["completed"].asInt() << " completed, "
+            << results["errors"].asInt() << " errors, "
+            << results["timed_out"].asInt() << " timed out, "
+            << results["achieved_rate"].asDouble() << "/s of "
+            << results["target_rate"].asInt() << "/s\n"
+            << "latency us: p50 " << latency["p50"].asDouble() << ", p90 "
+            << latency["p90"].asDouble() << ", p99 "
+            << latency["p99"].asDouble() << ", p999 "
+            << latency["p999"].asDouble() << ", p9999 "
+            << latency["p9999"].asDouble() << ", max "
+            << latency["max"].asDouble() << std::endl;
+}
+}
+
+int main(int argc, char* argv[]) {
+#ifdef OSS
+  google::ParseCommandLineFlags(&argc, &argv, true);
+#else
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+#endif
+
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  CHECK(
+      FLAGS_mode == "loopback" || FLAGS_mode == "server" ||
+      FLAGS_mode == "client")
+      << "unknown mode " << FLAGS_mode;
+
+  std::unique_ptr<RSocketServer> server;
+  if (FLAGS_mode != "client") {
+    server = RSocket::createServer(
+        std::make_unique<TcpConnectionAcceptor>(TcpConnectionAcceptor::Options{
+            static_cast<uint16_t>(FLAGS_port)}));
+    auto responder = std::make_shared<Responder>();
+    auto onAccept = [responder](auto) { return responder; };
+    if (FLAGS_mode == "server") {
+      server->startAndPark(onAccept);
+      return 0;
+    }
+    server->start(onAccept);
+  }
+
+  report(runClient());
+  return 0;
+}
@@ -0,0 +1,177 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// CPU against bytes on the wire of request/responses over loopback with the
+// responses compressed by PayloadCompression. The arguments are the response
+// size, 1KB, 64KB or 1MB, and the codec, 0 for none, 1 for ZSTD and 2 for LZ4.
+// CPU is of the whole process, client and server together. The bytes on the
+// wire are those of the response payload as the server compresses it.
+
+#include <benchmark/benchmark.h>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <folly/Baton.h>
+#include <folly/Conv.h>
+#include <folly/ExceptionString.h>
+#include <experimental/rsocket/transports/TcpConnectionAcceptor.h>
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/TcpConnectionFactory.h"
+#include "src/PayloadCompression.h"
+#include "yarpl/Single.h"
+
+using namespace ::reactivesocket;
+using namespace ::folly;
+using namespace ::rsocket;
+using namespace yarpl;
+
+DEFINE_string(host, "localhost", "host to connect to");
+DEFINE_int32(port, 9898, "host:port to connect to");
+
+namespace {
+
+constexpr size_t kSizes[] = {1 << 10, 64 << 10, 1 << 20};
+
+/// JSON records, about as compressible as typical API responses.
+std::string makeResponse(size_t size) {
+  std::string response;
+  for (size_t i = 0; response.size() < size; ++i) {
+    response += folly::to<std::string>(
+        "{\"id\":",
+        i,
+        ",\"name\":\"user-",
+        i * 7919 % 100003,
+        "\",\"score\":",
+        i * 31 % 1000,
+        ",\"tags\":[\"alpha\",\"beta\"]}\n");
+  }
+  response.resize(size);
+  return response;
+}
+
+/// Answers with a response of the size in the request.
+class ResponseHandler : public RSocketResponder {
+ public:
+  ResponseHandler() {
+    for (auto size : kSizes) {
+      responses_.emplace(size, makeResponse(size));
+    }
+  }
+
+  yarpl::Reference<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload request,
+      StreamId) override {
+    const auto& response =
+        responses_.at(folly::to<size_t>(request.moveDataToString()));
+    return yarpl::single::Single<Payload>::create(
+        [&response](Reference<yarpl::single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(response));
+        });
+  }
+
+ private:
+  // read only once built
+  std::unordered_map<size_t, std::string> responses_;
+};
+
+class Observer : public yarpl::single::SingleObserver<Payload> {
+ public:
+  void onSuccess(Payload response) override {
+    completed_.post();
+    yarpl::single::SingleObserver<Payload>::onSuccess(std::move(response));
+  }
+
+  void onError(std::exception_ptr ex) override {
+    LOG(ERROR) << "request failed: " << folly::exceptionStr(ex);
+    completed_.post();
+    yarpl::single::SingleObserver<Payload>::onError(ex);
+  }
+
+  void awaitCompleted() {
+    completed_.wait();
+  }
+
+ private:
+  folly::Baton<> completed_;
+};
+
+std::unique_ptr<RSocketServer> startServer(uint16_t port) {
+  auto serverRs = RSocket::createServer(std::make_unique<TcpConnectionAcceptor>(
+      TcpConnectionAcceptor::Options{port}));
+  auto handler = std::make_shared<ResponseHandler>();
+  serverRs->start([handler](auto r) { return handler; });
+  return serverRs;
+}
+}
+
+static void BM_PayloadCompression(benchmark::State& state) {
+  FLAGS_minloglevel = 6;
+  static auto serverRs = startServer(static_cast<uint16_t>(FLAGS_port));
+
+  const auto size = static_cast<size_t>(state.range(0));
+  const auto codec = static_cast<CompressionCodec>(state.range(1));
+  if (!PayloadCompression::isSupported(codec)) {
+    state.SkipWithError("codec not supported by this build");
+    return;
+  }
+
+  folly::SocketAddress address;
+  address.setFromHostPort(FLAGS_host, static_cast<uint16_t>(FLAGS_port));
+  auto clientRs = RSocket::createClient(
+      std::make_unique<TcpConnectionFactory>(std::move(address)));
+  CompressionOptions compression;
+  if (codec != CompressionCodec::NONE) {
+    compression.codecs = {codec};
+    clientRs->setCompression(compression);
+  }
+  auto rs = clientRs->connect().get();
+
+  // as the server compresses the responses, the client connects with
+  // composite metadata when it offers a codec
+  Payload sample(makeResponse(size));
+  compression.compositeMetadata = true;
+  PayloadCompression sampleCompression(compression);
+  sampleCompression.setCodec(PayloadCompression::choose(compression.codecs));
+  sampleCompression.compress(sample);
+  const auto wireBytes = sample.data->computeChainDataLength() +
+      (sample.metadata ? sample.metadata->computeChainDataLength() : 0);
+
+  const auto request = folly::to<std::string>(size);
+  const auto cpuBefore = std::clock();
+  size_t requests = 0;
+  while (state.KeepRunning()) {
+    auto observer = make_ref<Observer>();
+    rs->requestResponse(Payload(request))->subscribe(observer);
+    observer->awaitCompleted();
+    ++requests;
+  }
+  const double cpuSeconds =
+      static_cast<double>(std::clock() - cpuBefore) / CLOCKS_PER_SEC;
+
+  char label[256];
+  std::snprintf(
+      label,
+      sizeof(label),
+      "%s, wire bytes/response: %zu (%.1f%%), CPU us/response: %.1f",
+      to_string(codec).c_str(),
+      wireBytes,
+      100.0 * wireBytes / size,
+      requests ? 1e6 * cpuSeconds / requests : 0.0);
+  state.SetLabel(label);
+  state.SetItemsProcessed(requests);
+  state.SetBytesProcessed(requests * size);
+}
+
+static void sizesAndCodecs(benchmark::internal::Benchmark* b) {
+  for (auto size : kSizes) {
+    for (auto codec : {CompressionCodec::NONE,
+                       CompressionCodec::ZSTD,
+                       CompressionCodec::LZ4}) {
+      b->Args({static_cast<int>(size), static_cast<int>(codec)});
+    }
+  }
+}
+
+BENCHMARK(BM_PayloadCompression)->Apply(sizesAndCodecs)->UseRealTime();
+
+BENCHMARK_MAIN()
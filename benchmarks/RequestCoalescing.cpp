@@ -0,0 +1,60 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Calls to the backend and latency of request/responses with and without a
+// CoalescingResponder in front of a backend which answers after 1ms. The keys
+// of the requests follow a Zipfian distribution (s = 1); the arguments are the
+// number of distinct keys and whether the requests are coalesced.
+//
+// Each iteration issues a burst of 1000 requests on one EventBase and waits
+// for all of their responses.
+
+#include <cstdio>
+#include <string>
+#include "ResponderBursts.h"
+#include "rsocket/CoalescingResponder.h"
+
+using namespace ::reactivesocket;
+using namespace ::rsocket;
+
+namespace {
+folly::Optional<uint64_t> keyByData(const Payload& request) {
+  return std::hash<std::string>()(request.cloneDataToString());
+}
+}
+
+static void BM_RequestCoalescing(benchmark::State& state) {
+  const auto keys = static_cast<size_t>(state.range(0));
+  const bool coalescing = state.range(1) != 0;
+
+  auto backend = std::make_shared<DelayedBackend>();
+  std::shared_ptr<RSocketResponder> responder = backend;
+  if (coalescing) {
+    responder = std::make_shared<CoalescingResponder>(backend, keyByData);
+  }
+
+  HdrHistogram latencies;
+  const auto requests = runBursts(state, *responder, keys, latencies);
+
+  char label[256];
+  std::snprintf(
+      label,
+      sizeof(label),
+      "backend calls/request: %.3f, latency us p50: %.0f, p99: %.0f",
+      static_cast<double>(backend->calls.load()) / requests,
+      latencies.percentile(50) / 1000.0,
+      latencies.percentile(99) / 1000.0);
+  state.SetLabel(label);
+  state.SetItemsProcessed(requests);
+}
+
+BENCHMARK(BM_RequestCoalescing)
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({100000, 0})
+    ->Args({100000, 1})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN()
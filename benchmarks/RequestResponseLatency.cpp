@@ -2,15 +2,14 @@
 
 #include <benchmark/benchmark.h>
 #include <thread>
+#include <folly/Baton.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/ExceptionString.h>
 #include <iostream>
 #include <experimental/rsocket/transports/TcpConnectionAcceptor.h>
-#include <src/NullRequestHandler.h>
-#include <src/SubscriptionBase.h>
 #include "rsocket/RSocket.h"
 #include "rsocket/transports/TcpConnectionFactory.h"
-#include "yarpl/Flowable.h"
+#include "yarpl/Single.h"
 
 using namespace ::reactivesocket;
 using namespace ::folly;
@@ -22,161 +21,68 @@ using namespace yarpl;
 DEFINE_string(host, "localhost", "host to connect to");
 DEFINE_int32(port, 9898, "host:port to connect to");
 
-
-class BM_Subscription : public yarpl::flowable::Subscription {
- public:
-  explicit BM_Subscription(
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber,
-      size_t length)
-      : subscriber_(std::move(subscriber)),
-        data_(length, 'a'),
-        cancelled_(false)
-  {
-  }
-
- private:
-  void request(int64_t n) noexcept override {
-      LOG(INFO) << "requested=" << n;
-
-      if (cancelled_) {
-          LOG(INFO) << "emission stopped by cancellation";
-          return;
-      }
-
-      subscriber_->onNext(Payload(data_));
-      subscriber_->onComplete();
-  }
-
-  void cancel() noexcept override {
-      LOG(INFO) << "cancellation received";
-      cancelled_ = true;
-  }
-
-  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber_;
-  std::string data_;
-  std::atomic_bool cancelled_;
-};
-
 class BM_RequestHandler : public RSocketResponder
 {
  public:
-  // TODO(lehecka): enable when we have support for request-response
-  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
-  handleRequestStream(
+  BM_RequestHandler() : data_(MESSAGE_LENGTH, 'a') {}
+
+  yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+  handleRequestResponse(
       reactivesocket::Payload request,
       reactivesocket::StreamId streamId) override {
-      CHECK(false) << "not implemented";
+    return yarpl::single::Single<Payload>::create([this](
+        yarpl::Reference<yarpl::single::SingleObserver<Payload>> observer) {
+      observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+      observer->onSuccess(Payload(data_));
+    });
   }
 
-  // void handleRequestResponse(
-  //     Payload request, StreamId streamId, const yarpl::Reference<yarpl::flowable::Subscriber<Payload>> &response) noexcept override
-  // {
-  //     LOG(INFO) << "BM_RequestHandler.handleRequestResponse " << request;
-
-  //     response->onSubscribe(
-  //         std::make_shared<BM_Subscription>(response, MESSAGE_LENGTH));
-  // }
-
-  // std::shared_ptr<StreamState> handleSetupPayload(
-  //     ReactiveSocket &socket, ConnectionSetupPayload request) noexcept override
-  // {
-  //     LOG(INFO) << "BM_RequestHandler.handleSetupPayload " << request;
-  //     return nullptr;
-  // }
+ private:
+  std::string data_;
 };
 
-class BM_Subscriber
-    : public yarpl::flowable::Subscriber<Payload> {
+class BM_Subscriber : public yarpl::single::SingleObserver<Payload> {
  public:
-  ~BM_Subscriber() {
-      LOG(INFO) << "BM_Subscriber destroy " << this;
-  }
-
-  BM_Subscriber()
-      : initialRequest_(8),
-        thresholdForRequest_(initialRequest_ * 0.75) {
-      LOG(INFO) << "BM_Subscriber " << this << " created with => "
-                << "  Initial Request: " << initialRequest_
-                << "  Threshold for re-request: " << thresholdForRequest_;
-  }
-
-  void onSubscribe(yarpl::Reference<yarpl::flowable::Subscription> subscription) noexcept override
-  {
-      LOG(INFO) << "BM_Subscriber " << this << " onSubscribe";
-      subscription_ = std::move(subscription);
-      requested_ = initialRequest_;
-      subscription_->request(initialRequest_);
-  }
-
-  void onNext(reactivesocket::Payload element) noexcept override
+  void onSuccess(reactivesocket::Payload element) override
   {
-      LOG(INFO) << "BM_Subscriber " << this
-                << " onNext as string: " << element.moveDataToString();
-
-      if (--requested_ == thresholdForRequest_) {
-          int toRequest = (initialRequest_ - thresholdForRequest_);
-          LOG(INFO) << "BM_Subscriber " << this << " requesting " << toRequest
-                    << " more items";
-          requested_ += toRequest;
-          subscription_->request(toRequest);
-      }
+      completed_.post();
+      yarpl::single::SingleObserver<Payload>::onSuccess(std::move(element));
   }
 
-  void onComplete() noexcept override
+  void onError(std::exception_ptr ex) override
   {
-      LOG(INFO) << "BM_Subscriber " << this << " onComplete";
-      terminated_ = true;
-      completed_ = true;
-      terminalEventCV_.notify_all();
+      LOG(ERROR) << "BM_Subscriber " << this << " onError "
+                 << folly::exceptionStr(ex);
+      completed_.post();
+      yarpl::single::SingleObserver<Payload>::onError(ex);
   }
 
-  void onError(std::exception_ptr ex) noexcept override
+  void awaitCompleted()
   {
-      LOG(INFO) << "BM_Subscriber " << this << " onError " << folly::exceptionStr(ex);
-      terminated_ = true;
-      terminalEventCV_.notify_all();
-  }
-
-  void awaitTerminalEvent()
-  {
-      LOG(INFO) << "BM_Subscriber " << this << " block thread";
-      // now block this thread
-      std::unique_lock<std::mutex> lk(m_);
-      // if shutdown gets implemented this would then be released by it
-      terminalEventCV_.wait(lk, [this] { return terminated_; });
-      LOG(INFO) << "BM_Subscriber " << this << " unblocked";
-  }
-
-  bool completed()
-  {
-      return completed_;
+      completed_.wait();
   }
 
  private:
-  int initialRequest_;
-  int thresholdForRequest_;
-  int requested_;
-  yarpl::Reference<yarpl::flowable::Subscription> subscription_;
-  bool terminated_{false};
-  std::mutex m_;
-  std::condition_variable terminalEventCV_;
-  std::atomic_bool completed_{false};
+  folly::Baton<> completed_;
 };
 
+std::unique_ptr<RSocketServer> startServer(uint16_t port)
+{
+  auto serverRs = RSocket::createServer(
+      std::make_unique<TcpConnectionAcceptor>(
+          TcpConnectionAcceptor::Options{port}));
+  auto handler = std::make_shared<BM_RequestHandler>();
+  serverRs->start([handler](auto r) { return handler; });
+  return serverRs;
+}
+
 class BM_RsFixture : public benchmark::Fixture
 {
  public:
-  BM_RsFixture() :
-      host_(FLAGS_host),
-      port_(static_cast<uint16_t>(FLAGS_port)),
-      serverRs_(RSocket::createServer(
-          std::make_unique<TcpConnectionAcceptor>(
-              TcpConnectionAcceptor::Options{port_}))),
-      handler_(std::make_shared<BM_RequestHandler>())
+  BM_RsFixture()
   {
       FLAGS_v = 0;
       FLAGS_minloglevel = 6;
-      serverRs_->start([this](auto r) { return handler_; });
   }
 
   virtual ~BM_RsFixture()
@@ -185,6 +91,12 @@ class BM_RsFixture : public benchmark::Fixture
 
   void SetUp(benchmark::State &state) noexcept override
   {
+      host_ = FLAGS_host;
+      port_ = static_cast<uint16_t>(FLAGS_port);
+
+      // each registered benchmark gets its own fixture instance, so they
+      // share one server rather than each binding the port
+      static auto serverRs = startServer(port_);
   }
 
   void TearDown(benchmark::State &state) noexcept override
@@ -193,42 +105,107 @@ class BM_RsFixture : public benchmark::Fixture
 
   std::string host_;
   uint16_t port_;
-  std::unique_ptr<RSocketServer> serverRs_;
-  std::shared_ptr<BM_RequestHandler> handler_;
 };
 
 BENCHMARK_F(BM_RsFixture, BM_RequestResponse_Latency)(benchmark::State &state)
 {
-    // TODO(lehecka): enable test
-//    folly::SocketAddress address;
-//    address.setFromHostPort(host_, port_);
-//
-//    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
-//        std::move(address)));
-//    int reqs = 0;
-//
-//    auto rs = clientRs->connect().get();
-//
-//    while (state.KeepRunning())
-//    {
-//        auto sub = make_ref<BM_Subscriber>();
-//        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(sub);
-//
-//        while (!sub->completed())
-//        {
-//            std::this_thread::yield();
-//        }
-//
-//        reqs++;
-//    }
-//
-//    char label[256];
-//
-//    std::snprintf(label, sizeof(label), "Message Length: %d", MESSAGE_LENGTH);
-//    state.SetLabel(label);
-//
-//    state.SetItemsProcessed(reqs);
+    folly::SocketAddress address;
+    address.setFromHostPort(host_, port_);
+
+    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
+        std::move(address)));
+    int reqs = 0;
+
+    auto rs = clientRs->connect().get();
+
+    while (state.KeepRunning())
+    {
+        auto sub = make_ref<BM_Subscriber>();
+        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(sub);
+
+        sub->awaitCompleted();
+
+        reqs++;
+    }
+
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Message Length: %d", MESSAGE_LENGTH);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(reqs);
 }
 
-BENCHMARK_MAIN()
+// Time from opening a fresh connection until its first response arrives.
+// Client creation and teardown are excluded, connection setup is not.
+BENCHMARK_F(BM_RsFixture, BM_FirstResponse_Connect)(benchmark::State &state)
+{
+    int conns = 0;
+
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        folly::SocketAddress address;
+        address.setFromHostPort(host_, port_);
+        auto clientRs = RSocket::createClient(
+            std::make_unique<TcpConnectionFactory>(std::move(address)));
+        state.ResumeTiming();
+
+        auto rs = clientRs->connect().get();
+        auto sub = make_ref<BM_Subscriber>();
+        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(sub);
+
+        sub->awaitCompleted();
+
+        state.PauseTiming();
+        rs.reset();
+        clientRs.reset();
+        state.ResumeTiming();
+
+        conns++;
+    }
 
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Message Length: %d", MESSAGE_LENGTH);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(conns);
+}
+
+BENCHMARK_F(BM_RsFixture, BM_FirstResponse_FastConnect)(benchmark::State &state)
+{
+    int conns = 0;
+
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        folly::SocketAddress address;
+        address.setFromHostPort(host_, port_);
+        auto clientRs = RSocket::createClient(
+            std::make_unique<TcpConnectionFactory>(std::move(address)));
+        state.ResumeTiming();
+
+        auto rs = clientRs->fastConnect();
+        auto sub = make_ref<BM_Subscriber>();
+        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(sub);
+
+        sub->awaitCompleted();
+
+        state.PauseTiming();
+        rs.reset();
+        clientRs.reset();
+        state.ResumeTiming();
+
+        conns++;
+    }
+
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Message Length: %d", MESSAGE_LENGTH);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(conns);
+}
+
+BENCHMARK_MAIN()
@@ -2,16 +2,16 @@
 
 #include <benchmark/benchmark.h>
 #include <thread>
+#include <vector>
 
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/ExceptionString.h>
 #include <iostream>
 #include <experimental/rsocket/transports/TcpConnectionAcceptor.h>
-#include <src/NullRequestHandler.h>
-#include <src/SubscriptionBase.h>
 #include "rsocket/RSocket.h"
+#include "rsocket/RSocketClientPool.h"
 #include "rsocket/transports/TcpConnectionFactory.h"
-#include "yarpl/Flowable.h"
+#include "yarpl/Single.h"
 
 using namespace ::reactivesocket;
 using namespace ::folly;
@@ -20,168 +20,170 @@ using namespace yarpl;
 
 #define MAX_REQUESTS (64)
 #define MESSAGE_LENGTH (32)
+#define REQUESTS_PER_THREAD (1024)
+#define POOL_CALLER_THREADS (8)
 
 DEFINE_string(host, "localhost", "host to connect to");
 DEFINE_int32(port, 9898, "host:port to connect to");
-
-class BM_Subscription : public SubscriptionBase {
-public:
-    explicit BM_Subscription(
-        std::shared_ptr<Subscriber<Payload>> subscriber,
-        size_t length)
-        : ExecutorBase(defaultExecutor()),
-        subscriber_(std::move(subscriber)),
-        data_(length, 'a'),
-        cancelled_(false)
-    {
-    }
-
-private:
-    void requestImpl(size_t n) noexcept override
-    {
-        LOG(INFO) << "requested=" << n;
-
-        if (cancelled_) {
-            LOG(INFO) << "emission stopped by cancellation";
-            return;
-        }
-
-        subscriber_->onNext(Payload(data_));
-        subscriber_->onComplete();
-    }
-
-    void cancelImpl() noexcept override
-    {
-        LOG(INFO) << "cancellation received";
-        cancelled_ = true;
-    }
-
-    std::shared_ptr<Subscriber<Payload>> subscriber_;
-    std::string data_;
-    std::atomic_bool cancelled_;
-};
+DEFINE_int32(server_threads, 8, "number of server worker threads");
 
 class BM_RequestHandler : public RSocketResponder
 {
 public:
-    // TODO(lehecka): enable when we have support for request-response
-    yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
-    handleRequestStream(
+    BM_RequestHandler() : data_(MESSAGE_LENGTH, 'a') {}
+
+    yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+    handleRequestResponse(
       reactivesocket::Payload request,
       reactivesocket::StreamId streamId) override {
-        CHECK(false) << "not implemented";
+        return yarpl::single::Single<Payload>::create([this](
+            yarpl::Reference<yarpl::single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(data_));
+        });
     }
 
-    // void handleRequestResponse(
-    //     Payload request, StreamId streamId, const std::shared_ptr<Subscriber<Payload>> &response) noexcept override
-    // {
-    //     LOG(INFO) << "BM_RequestHandler.handleRequestResponse " << request;
-
-    //     response->onSubscribe(
-    //         std::make_shared<BM_Subscription>(response, MESSAGE_LENGTH));
-    // }
-
-    // std::shared_ptr<StreamState> handleSetupPayload(
-    //     ReactiveSocket &socket, ConnectionSetupPayload request) noexcept override
-    // {
-    //     LOG(INFO) << "BM_RequestHandler.handleSetupPayload " << request;
-    //     return nullptr;
-    // }
+private:
+    std::string data_;
 };
 
-class BM_Subscriber
-    : public yarpl::flowable::Subscriber<Payload> {
+class BM_Subscriber : public yarpl::single::SingleObserver<Payload> {
 public:
-    ~BM_Subscriber()
+    void onSuccess(reactivesocket::Payload element) override
     {
-        LOG(INFO) << "BM_Subscriber destroy " << this;
+        complete();
+        yarpl::single::SingleObserver<Payload>::onSuccess(std::move(element));
     }
 
-    BM_Subscriber()
-        : initialRequest_(8),
-        thresholdForRequest_(initialRequest_ * 0.75)
+    void onError(std::exception_ptr ex) override
     {
-        LOG(INFO) << "BM_Subscriber " << this << " created with => "
-            << "  Initial Request: " << initialRequest_
-            << "  Threshold for re-request: " << thresholdForRequest_;
+        LOG(ERROR) << "BM_Subscriber " << this << " onError "
+                   << folly::exceptionStr(ex);
+        complete();
+        yarpl::single::SingleObserver<Payload>::onError(ex);
     }
 
-    void onSubscribe(yarpl::Reference<yarpl::flowable::Subscription> subscription) noexcept override
+    void awaitTerminalEvent()
     {
-        LOG(INFO) << "BM_Subscriber " << this << " onSubscribe";
-        subscription_ = std::move(subscription);
-        requested_ = initialRequest_;
-        subscription_->request(initialRequest_);
+        std::unique_lock<std::mutex> lk(m_);
+        terminalEventCV_.wait(lk, [this] { return completed_.load(); });
     }
 
-    void onNext(reactivesocket::Payload element) noexcept override
+    bool completed()
     {
-        LOG(INFO) << "BM_Subscriber " << this
-            << " onNext as string: " << element.moveDataToString();
-
-        if (--requested_ == thresholdForRequest_) {
-            int toRequest = (initialRequest_ - thresholdForRequest_);
-            LOG(INFO) << "BM_Subscriber " << this << " requesting " << toRequest
-                << " more items";
-            requested_ += toRequest;
-            subscription_->request(toRequest);
-        }
+        return completed_;
     }
 
-    void onComplete() noexcept override
+private:
+    void complete()
     {
-        LOG(INFO) << "BM_Subscriber " << this << " onComplete";
-        terminated_ = true;
-        completed_ = true;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            completed_ = true;
+        }
         terminalEventCV_.notify_all();
     }
 
-    void onError(std::exception_ptr ex) noexcept override
+    std::mutex m_;
+    std::condition_variable terminalEventCV_;
+    std::atomic_bool completed_{false};
+};
+
+class BM_CountingSubscriber : public yarpl::single::SingleObserver<Payload> {
+public:
+    BM_CountingSubscriber(std::atomic<int>& outstanding, std::mutex& m, std::condition_variable& cv)
+        : outstanding_(outstanding), m_(m), cv_(cv) {}
+
+    void onSuccess(reactivesocket::Payload element) override
     {
-        LOG(INFO) << "BM_Subscriber " << this << " onError " << folly::exceptionStr(ex);
-        terminated_ = true;
-        terminalEventCV_.notify_all();
+        complete();
+        yarpl::single::SingleObserver<Payload>::onSuccess(std::move(element));
     }
 
-    void awaitTerminalEvent()
+    void onError(std::exception_ptr ex) override
     {
-        LOG(INFO) << "BM_Subscriber " << this << " block thread";
-        // now block this thread
-        std::unique_lock<std::mutex> lk(m_);
-        // if shutdown gets implemented this would then be released by it
-        terminalEventCV_.wait(lk, [this] { return terminated_; });
-        LOG(INFO) << "BM_Subscriber " << this << " unblocked";
+        LOG(ERROR) << "BM_CountingSubscriber " << this << " onError "
+                   << folly::exceptionStr(ex);
+        complete();
+        yarpl::single::SingleObserver<Payload>::onError(ex);
     }
 
-    bool completed()
+private:
+    void complete()
     {
-        return completed_;
+        if (--outstanding_ == 0)
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            cv_.notify_all();
+        }
     }
 
-private:
-    int initialRequest_;
-    int thresholdForRequest_;
-    int requested_;
-  yarpl::Reference<yarpl::flowable::Subscription> subscription_;
-    bool terminated_{false};
-    std::mutex m_;
-    std::condition_variable terminalEventCV_;
-    std::atomic_bool completed_{false};
+    std::atomic<int>& outstanding_;
+    std::mutex& m_;
+    std::condition_variable& cv_;
 };
 
+// Issues a burst of REQUESTS_PER_THREAD requests from each of numThreads
+// caller threads and waits for all of the responses.
+template <typename Requester>
+int64_t requestBurst(Requester& rs, int numThreads)
+{
+    std::mutex m;
+    std::condition_variable cv;
+    std::atomic<int> outstanding{numThreads * REQUESTS_PER_THREAD};
+    std::vector<std::thread> callers;
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        callers.emplace_back([&] {
+            for (int i = 0; i < REQUESTS_PER_THREAD; i++)
+            {
+                rs.requestResponse(Payload("BM_RequestResponse"))->subscribe(
+                    make_ref<BM_CountingSubscriber>(outstanding, m, cv));
+            }
+        });
+    }
+
+    for (auto& caller : callers)
+    {
+        caller.join();
+    }
+
+    std::unique_lock<std::mutex> lk(m);
+    cv.wait(lk, [&] { return outstanding.load() == 0; });
+
+    return numThreads * REQUESTS_PER_THREAD;
+}
+
+std::unique_ptr<RSocketServer> startServer(uint16_t port)
+{
+    TcpConnectionAcceptor::Options opts;
+    opts.port = port;
+    opts.threads = static_cast<size_t>(FLAGS_server_threads);
+
+    auto serverRs = RSocket::createServer(
+        std::make_unique<TcpConnectionAcceptor>(std::move(opts)));
+    auto handler = std::make_shared<BM_RequestHandler>();
+    serverRs->start([handler](auto r) { return handler; });
+    return serverRs;
+}
+
+// Every registered benchmark gets its own fixture instance, the multi-threaded
+// one included, so they all share this one server rather than each binding
+// the port. Started by the first benchmark which runs.
+RSocketServer& sharedServer(uint16_t port)
+{
+    static auto serverRs = startServer(port);
+    return *serverRs;
+}
+
 class BM_RsFixture : public benchmark::Fixture
 {
 public:
-    BM_RsFixture() :
-        host_(FLAGS_host),
-        port_(static_cast<uint16_t>(FLAGS_port)),
-        serverRs_(RSocket::createServer(std::make_unique<TcpConnectionAcceptor>(
-            TcpConnectionAcceptor::Options{port_}))),
-        handler_(std::make_shared<BM_RequestHandler>())
+    BM_RsFixture()
     {
         FLAGS_v = 0;
         FLAGS_minloglevel = 6;
-        serverRs_->start([this](auto r) { return handler_; });
     }
 
     virtual ~BM_RsFixture()
@@ -190,6 +192,10 @@ public:
 
     void SetUp(benchmark::State &state) override
     {
+        host_ = FLAGS_host;
+        port_ = static_cast<uint16_t>(FLAGS_port);
+
+        sharedServer(port_);
     }
 
     void TearDown(benchmark::State &state) override
@@ -198,61 +204,121 @@ public:
 
     std::string host_;
     uint16_t port_;
-    std::unique_ptr<RSocketServer> serverRs_;
-    std::shared_ptr<BM_RequestHandler> handler_;
 };
 
 BENCHMARK_DEFINE_F(BM_RsFixture, BM_RequestResponse_Throughput)(benchmark::State &state)
 {
-// TODO(lehecka): enable test
-//    folly::SocketAddress address;
-//    address.setFromHostPort(host_, port_);
-//
-//    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
-//        std::move(address)));
-//    int reqs = 0;
-//    int numSubscribers = state.range(0);
-//    int mask = numSubscribers - 1;
-//
-//    yarpl::Reference<BM_Subscriber> subs[MAX_REQUESTS+1];
-//
-//    auto rs = clientRs->connect().get();
-//
-//    while (state.KeepRunning())
-//    {
-//        int index = reqs & mask;
-//
-//        if (nullptr != subs[index])
-//        {
-//            while (!subs[index]->completed())
-//            {
-//                std::this_thread::yield();
-//            }
-//
-//            subs[index].reset();
-//        }
-//
-//        subs[index] = make_ref<BM_Subscriber>();
-//        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(subs[index]);
-//        reqs++;
-//    }
-//
-//    for (int i = 0; i < numSubscribers; i++)
-//    {
-//        if (subs[i])
-//        {
-//            subs[i]->awaitTerminalEvent();
-//        }
-//    }
-//
-//    char label[256];
-//
-//    std::snprintf(label, sizeof(label), "Max Requests: %d, Message Length: %d", numSubscribers, MESSAGE_LENGTH);
-//    state.SetLabel(label);
-//
-//    state.SetItemsProcessed(reqs);
+    folly::SocketAddress address;
+    address.setFromHostPort(host_, port_);
+
+    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
+        std::move(address)));
+    int reqs = 0;
+    int numSubscribers = state.range(0);
+    int mask = numSubscribers - 1;
+
+    yarpl::Reference<BM_Subscriber> subs[MAX_REQUESTS+1];
+
+    auto rs = clientRs->connect().get();
+
+    while (state.KeepRunning())
+    {
+        int index = reqs & mask;
+
+        if (nullptr != subs[index])
+        {
+            while (!subs[index]->completed())
+            {
+                std::this_thread::yield();
+            }
+
+            subs[index].reset();
+        }
+
+        subs[index] = make_ref<BM_Subscriber>();
+        rs->requestResponse(Payload("BM_RequestResponse"))->subscribe(subs[index]);
+        reqs++;
+    }
+
+    for (int i = 0; i < numSubscribers; i++)
+    {
+        if (subs[i])
+        {
+            subs[i]->awaitTerminalEvent();
+        }
+    }
+
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Max Requests: %d, Message Length: %d", numSubscribers, MESSAGE_LENGTH);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(reqs);
 }
 
 BENCHMARK_REGISTER_F(BM_RsFixture, BM_RequestResponse_Throughput)->Arg(1)->Arg(2)->Arg(8)->Arg(16)->Arg(32);
 
+BENCHMARK_DEFINE_F(BM_RsFixture, BM_RequestResponse_MultiThreadedThroughput)(benchmark::State &state)
+{
+    folly::SocketAddress address;
+    address.setFromHostPort(host_, port_);
+
+    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
+        std::move(address)));
+    int numThreads = state.range(0);
+    int64_t reqs = 0;
+
+    auto rs = clientRs->connect().get();
+
+    while (state.KeepRunning())
+    {
+        // every caller thread issues its burst against the same requester, so
+        // submissions from all of them contend on one EventBase
+        reqs += requestBurst(*rs, numThreads);
+    }
+
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Caller Threads: %d, Requests/Thread: %d, Message Length: %d",
+                  numThreads, REQUESTS_PER_THREAD, MESSAGE_LENGTH);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(reqs);
+}
+
+BENCHMARK_REGISTER_F(BM_RsFixture, BM_RequestResponse_MultiThreadedThroughput)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_RsFixture, BM_RequestResponse_PoolThroughput)(benchmark::State &state)
+{
+    int poolSize = state.range(0);
+    int64_t reqs = 0;
+
+    // every connection gets its own factory, and with it its own EventBase
+    std::vector<std::unique_ptr<ConnectionFactory>> factories;
+    for (int i = 0; i < poolSize; i++)
+    {
+        folly::SocketAddress address;
+        address.setFromHostPort(host_, port_);
+        factories.push_back(std::make_unique<TcpConnectionFactory>(std::move(address)));
+    }
+
+    auto pool = RSocket::createClientPool(std::move(factories));
+    pool->connect().get();
+
+    while (state.KeepRunning())
+    {
+        reqs += requestBurst(*pool, POOL_CALLER_THREADS);
+    }
+
+    char label[256];
+
+    std::snprintf(label, sizeof(label), "Pool Size: %d, Caller Threads: %d, Server Threads: %d",
+                  poolSize, POOL_CALLER_THREADS, FLAGS_server_threads);
+    state.SetLabel(label);
+
+    state.SetItemsProcessed(reqs);
+}
+
+BENCHMARK_REGISTER_F(BM_RsFixture, BM_RequestResponse_PoolThroughput)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
 BENCHMARK_MAIN()
@@ -0,0 +1,137 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Drives an RSocketResponder with bursts of request/responses, for the
+// benchmarks of the responder decorators.
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <folly/Baton.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "Zipf.h"
+#include "rsocket/RSocketResponder.h"
+#include "src/HdrHistogram.h"
+#include "yarpl/Single.h"
+
+namespace reactivesocket {
+
+/// Answers every request with its data after a delay, on its own thread.
+class DelayedBackend : public rsocket::RSocketResponder {
+ public:
+  explicit DelayedBackend(
+      std::chrono::milliseconds delay = std::chrono::milliseconds(1))
+      : delay_(delay) {}
+
+  yarpl::Reference<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload request,
+      StreamId) override {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    return yarpl::single::Single<Payload>::create([
+      this,
+      request = std::move(request)
+    ](yarpl::Reference<yarpl::single::SingleObserver<Payload>> observer) mutable {
+      observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+      auto eventBase = thread_.getEventBase();
+      eventBase->runInEventBaseThread([
+        this,
+        eventBase,
+        observer = std::move(observer),
+        request = std::move(request)
+      ]() mutable {
+        eventBase->runAfterDelay(
+            [ observer = std::move(observer), request = std::move(request) ] {
+              observer->onSuccess(request.clone());
+            },
+            static_cast<uint32_t>(delay_.count()));
+      });
+    });
+  }
+
+  std::atomic<uint64_t> calls{0};
+
+ private:
+  const std::chrono::milliseconds delay_;
+  folly::ScopedEventBaseThread thread_;
+};
+
+/// Records the latency of a request and counts down the outstanding ones.
+class LatencyObserver : public yarpl::single::SingleObserver<Payload> {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  LatencyObserver(
+      HdrHistogram& latencies,
+      std::atomic<size_t>& outstanding,
+      folly::Baton<>& done)
+      : latencies_(latencies), outstanding_(outstanding), done_(done) {}
+
+  void onSuccess(Payload response) override {
+    complete();
+    yarpl::single::SingleObserver<Payload>::onSuccess(std::move(response));
+  }
+
+  void onError(std::exception_ptr ex) override {
+    complete();
+    yarpl::single::SingleObserver<Payload>::onError(ex);
+  }
+
+ private:
+  void complete() {
+    latencies_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Clock::now() - start_)
+                          .count());
+    if (--outstanding_ == 0) {
+      done_.post();
+    }
+  }
+
+  HdrHistogram& latencies_;
+  std::atomic<size_t>& outstanding_;
+  folly::Baton<>& done_;
+  const Clock::time_point start_{Clock::now()};
+};
+
+/// Issues a burst of `burst` requests on one EventBase per iteration of the
+/// benchmark and waits for their responses. The data of the requests are
+/// keys 0 to keys - 1 following a Zipfian distribution (s = 1). Returns the
+/// number of requests.
+inline uint64_t runBursts(
+    benchmark::State& state,
+    rsocket::RSocketResponder& responder,
+    size_t keys,
+    HdrHistogram& latencies,
+    size_t burst = 1000) {
+  folly::ScopedEventBaseThread requestThread;
+  Zipf zipf(keys);
+  std::mt19937_64 random(1);
+  uint64_t requests = 0;
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::vector<Payload> payloads;
+    payloads.reserve(burst);
+    for (size_t i = 0; i < burst; ++i) {
+      payloads.emplace_back(std::to_string(zipf(random)));
+    }
+    state.ResumeTiming();
+
+    std::atomic<size_t> outstanding{burst};
+    folly::Baton<> done;
+    requestThread.getEventBase()->runInEventBaseThread([&] {
+      for (size_t i = 0; i < burst; ++i) {
+        responder.handleRequestResponse(std::move(payloads[i]), 2 * i + 1)
+            ->subscribe(yarpl::make_ref<LatencyObserver>(
+                latencies, outstanding, done));
+      }
+    });
+    done.wait();
+    requests += burst;
+  }
+  return requests;
+}
+}
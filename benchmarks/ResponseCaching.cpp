@@ -0,0 +1,58 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Hit rate and latency of request/responses with a CachingResponder in front
+// of a backend which answers after 1ms. The keys of the requests follow a
+// Zipfian distribution (s = 1); the arguments are the number of distinct keys
+// and the byte budget of the cache in KB, 0 for no cache.
+//
+// Each iteration issues a burst of 1000 requests on one EventBase and waits
+// for all of their responses.
+
+#include <cstdio>
+#include "ResponderBursts.h"
+#include "rsocket/CachingResponder.h"
+
+using namespace ::reactivesocket;
+using namespace ::rsocket;
+
+static void BM_ResponseCaching(benchmark::State& state) {
+  const auto keys = static_cast<size_t>(state.range(0));
+  const auto budget = static_cast<size_t>(state.range(1)) << 10;
+
+  auto backend = std::make_shared<DelayedBackend>();
+  std::shared_ptr<RSocketResponder> responder = backend;
+  if (budget > 0) {
+    ResponseCache::Options options;
+    options.maxBytes = budget;
+    options.ttl = std::chrono::minutes(1);
+    responder = std::make_shared<CachingResponder>(
+        backend, std::make_shared<ResponseCache>(options));
+  }
+
+  HdrHistogram latencies;
+  const auto requests = runBursts(state, *responder, keys, latencies);
+
+  char label[256];
+  std::snprintf(
+      label,
+      sizeof(label),
+      "hit rate: %.3f, latency us p50: %.1f, p90: %.1f, p99: %.1f",
+      1 - static_cast<double>(backend->calls.load()) / requests,
+      latencies.percentile(50) / 1000.0,
+      latencies.percentile(90) / 1000.0,
+      latencies.percentile(99) / 1000.0);
+  state.SetLabel(label);
+  state.SetItemsProcessed(requests);
+}
+
+BENCHMARK(BM_ResponseCaching)
+    ->Args({1000, 0})
+    ->Args({1000, 64})
+    ->Args({1000, 1024})
+    ->Args({100000, 0})
+    ->Args({100000, 1024})
+    ->Args({100000, 16384})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN()
@@ -0,0 +1,102 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Cost of dispatching a request on its route for 10 to 10k routes: the
+// lookup in a RouteTable against a std::unordered_map of the route names, and
+// RoutingResponder::route, which also parses the composite metadata of the
+// request. The argument is the number of routes.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rsocket/RouteTable.h"
+#include "rsocket/RoutingResponder.h"
+#include "src/CompositeMetadata.h"
+
+using namespace ::reactivesocket;
+using namespace ::rsocket;
+
+namespace {
+
+std::vector<std::string> makeRoutes(size_t count) {
+  std::vector<std::string> routes;
+  routes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    routes.push_back("com.example.Service" + std::to_string(i) + ".method");
+  }
+  return routes;
+}
+
+/// The routes in a random order, so that the lookups miss the caches like
+/// they would serving varied traffic.
+std::vector<std::string> shuffled(std::vector<std::string> routes) {
+  std::shuffle(routes.begin(), routes.end(), std::mt19937(1));
+  return routes;
+}
+}
+
+static void BM_RouteTable(benchmark::State& state) {
+  const auto routes = makeRoutes(state.range(0));
+  const RouteTable table(routes);
+  const auto lookups = shuffled(routes);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.find(lookups[i]));
+    if (++i == lookups.size()) {
+      i = 0;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_UnorderedMap(benchmark::State& state) {
+  const auto routes = makeRoutes(state.range(0));
+  std::unordered_map<std::string, size_t> map;
+  for (size_t i = 0; i < routes.size(); ++i) {
+    map.emplace(routes[i], i);
+  }
+  const auto lookups = shuffled(routes);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(map.find(lookups[i]));
+    if (++i == lookups.size()) {
+      i = 0;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_RoutingResponder(benchmark::State& state) {
+  const auto routes = makeRoutes(state.range(0));
+  RoutingResponder::Routes responders;
+  for (const auto& route : routes) {
+    responders.emplace_back(route, std::make_shared<RSocketResponder>());
+  }
+  const RoutingResponder responder(std::move(responders));
+
+  std::vector<Payload> requests;
+  for (const auto& route : shuffled(routes)) {
+    requests.emplace_back(
+        folly::IOBuf::copyBuffer("data"),
+        CompositeMetadataBuilder()
+            .add("application/json", folly::IOBuf::copyBuffer("{}"))
+            .addRoute({route})
+            .build());
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(responder.route(requests[i]));
+    if (++i == requests.size()) {
+      i = 0;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RouteTable)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_UnorderedMap)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_RoutingResponder)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN()
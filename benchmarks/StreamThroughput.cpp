@@ -1,17 +1,18 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include <benchmark/benchmark.h>
+#include <atomic>
 #include <thread>
 
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/ExceptionString.h>
 #include <iostream>
 #include <experimental/rsocket/transports/TcpConnectionAcceptor.h>
-#include <src/NullRequestHandler.h>
-#include <src/SubscriptionBase.h>
+#include "Allocations.h"
 #include "rsocket/RSocket.h"
-#include "rsocket/OldNewBridge.h"
 #include "rsocket/transports/TcpConnectionFactory.h"
+#include "src/CounterStats.h"
+#include "src/FrameTrace.h"
 #include "yarpl/Flowable.h"
 
 using namespace ::reactivesocket;
@@ -24,54 +25,22 @@ using namespace yarpl;
 DEFINE_string(host, "localhost", "host to connect to");
 DEFINE_int32(port, 9898, "host:port to connect to");
 
-class BM_Subscription : public yarpl::flowable::Subscription {
-public:
-    explicit BM_Subscription(
-        yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber,
-        size_t length)
-        : subscriber_(std::move(subscriber)),
-          data_(length, 'a'),
-          cancelled_(false)
-    {
-    }
-
-private:
-    void request(int64_t n) noexcept override {
-        LOG(INFO) << "requested=" << n << " currentElem=" << currentElem_;
-
-        for (int64_t i = 0; i < n; i++) {
-            if (cancelled_) {
-                LOG(INFO) << "emission stopped by cancellation";
-                return;
-            }
-            subscriber_->onNext(Payload(data_));
-            currentElem_++;
-        }
-    }
-
-    void cancel() noexcept override {
-        LOG(INFO) << "cancellation received";
-        cancelled_ = true;
-    }
-
-    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber_;
-    std::string data_;
-    size_t currentElem_ = 0;
-    std::atomic_bool cancelled_;
-};
-
 class BM_RequestHandler : public RSocketResponder
 {
 public:
+    BM_RequestHandler() : data_(MESSAGE_LENGTH, 'a') {}
+
     yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
     handleRequestStream(
       reactivesocket::Payload request,
       reactivesocket::StreamId streamId) override {
-        CHECK(false) << "not implemented";
-        // TODO(lehecka) need to implement new operator fromGenerator
-        // return yarpl::flowable::Flowables::fromGenerator<reactivesocket::Payload>(
-        //     []{return Payload(std::string(MESSAGE_LENGTH, 'a')); });
+        // emits exactly as many payloads as the requester asked for
+        return yarpl::flowable::Flowables::fromGenerator<reactivesocket::Payload>(
+            [this] { return Payload(data_); });
     }
+
+private:
+    std::string data_;
 };
 
 class BM_Subscriber
@@ -102,15 +71,10 @@ public:
 
     void onNext(reactivesocket::Payload element) noexcept override
     {
-        LOG(INFO) << "BM_Subscriber " << this
-            << " onNext as string: " << element.moveDataToString();
-
         received_.store(received_ + 1, std::memory_order_release);
 
         if (--requested_ == thresholdForRequest_) {
             int toRequest = (initialRequest_ - thresholdForRequest_);
-            LOG(INFO) << "BM_Subscriber " << this << " requesting " << toRequest
-                << " more items";
             requested_ += toRequest;
             subscription_->request(toRequest);
         };
@@ -167,18 +131,22 @@ private:
     std::atomic<size_t> received_;
 };
 
+std::unique_ptr<RSocketServer> startServer(uint16_t port)
+{
+    auto serverRs = RSocket::createServer(
+        std::make_unique<TcpConnectionAcceptor>(
+            TcpConnectionAcceptor::Options{port}));
+    auto handler = std::make_shared<BM_RequestHandler>();
+    serverRs->start([handler](auto r) { return handler; });
+    return serverRs;
+}
+
 class BM_RsFixture : public benchmark::Fixture
 {
 public:
-    BM_RsFixture() :
-        host_(FLAGS_host),
-        port_(static_cast<uint16_t>(FLAGS_port)),
-        serverRs_(RSocket::createServer(std::make_unique<TcpConnectionAcceptor>(
-            TcpConnectionAcceptor::Options{port_}))),
-        handler_(std::make_shared<BM_RequestHandler>())
+    BM_RsFixture()
     {
         FLAGS_minloglevel = 100;
-        serverRs_->start([this](auto r) { return handler_; });
     }
 
     virtual ~BM_RsFixture()
@@ -187,55 +155,122 @@ public:
 
     void SetUp(benchmark::State &state) noexcept override
     {
+        host_ = FLAGS_host;
+        port_ = static_cast<uint16_t>(FLAGS_port);
+
+        // each registered benchmark gets its own fixture instance, so they
+        // share one server rather than each binding the port
+        static auto serverRs = startServer(port_);
     }
 
     void TearDown(benchmark::State &state) noexcept override
     {
     }
 
+    void streamThroughput(
+        benchmark::State &state,
+        std::shared_ptr<Stats> stats)
+    {
+        folly::SocketAddress address;
+        address.setFromHostPort(host_, port_);
+
+        auto clientRs = RSocket::createClient(
+            std::make_unique<TcpConnectionFactory>(std::move(address)),
+            std::move(stats));
+
+        auto s = make_ref<BM_Subscriber>(state.range(0));
+
+        clientRs
+            ->connect()
+                .then(
+                    [s](std::shared_ptr<RSocketRequester> rs)
+                    {
+                       rs->requestStream(Payload("BM_Stream"))->subscribe(
+                            std::move(s));
+                    });
+
+        size_t rcvedBefore = 0;
+        uint64_t allocationsBefore = 0;
+        while (state.KeepRunning())
+        {
+            if (rcvedBefore == 0)
+            {
+                // start counting once the stream is flowing, to leave the
+                // connection setup out
+                rcvedBefore = s->received();
+                // of the whole process, client and server together
+                allocationsBefore = heapAllocations();
+            }
+            std::this_thread::yield();
+        }
+
+        size_t rcved = s->received();
+        uint64_t allocs = heapAllocations() - allocationsBefore;
+
+        s->cancel();
+        s->awaitTerminalEvent();
+
+        char label[256];
+
+        std::snprintf(
+            label,
+            sizeof(label),
+            "Message Length: %d, allocs/message: %.2f",
+            MESSAGE_LENGTH,
+            rcved > rcvedBefore
+                ? static_cast<double>(allocs) / (rcved - rcvedBefore)
+                : 0.0);
+        state.SetLabel(label);
+
+        state.SetItemsProcessed(rcved);
+    }
+
     std::string host_;
     uint16_t port_;
-    std::unique_ptr<RSocketServer> serverRs_;
-    std::shared_ptr<BM_RequestHandler> handler_;
 };
 
 BENCHMARK_DEFINE_F(BM_RsFixture, BM_Stream_Throughput)(benchmark::State &state)
 {
-    folly::SocketAddress address;
-    address.setFromHostPort(host_, port_);
+    streamThroughput(state, Stats::noop());
+}
 
-    auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
-        std::move(address)));
+BENCHMARK_REGISTER_F(BM_RsFixture, BM_Stream_Throughput)->Arg(8)->Arg(32)->Arg(128);
 
-    auto s = make_ref<BM_Subscriber>(state.range(0));
+// Same as BM_Stream_Throughput, with every client frame and byte counted,
+// which shows the overhead of CounterStats over the noop Stats.
+BENCHMARK_DEFINE_F(BM_RsFixture, BM_Stream_Throughput_CounterStats)(benchmark::State &state)
+{
+    auto stats = std::make_shared<CounterStats>();
+    streamThroughput(state, stats);
+    VLOG(1) << stats->snapshot().toString();
+}
 
-    clientRs
-        ->connect()
-            .then(
-                [s](std::shared_ptr<RSocketRequester> rs)
-                {
-                   rs->requestStream(Payload("BM_Stream"))->subscribe(
-                        std::move(s));
-                });
+BENCHMARK_REGISTER_F(BM_RsFixture, BM_Stream_Throughput_CounterStats)->Arg(8)->Arg(32)->Arg(128);
 
-    while (state.KeepRunning())
-    {
-        std::this_thread::yield();
+namespace {
+class BM_FrameTraceSink : public FrameTraceSink {
+public:
+    void onFrame(const FrameTraceRecord& record) override {
+        ++frames;
     }
 
-    size_t rcved = s->received();
-
-    s->cancel();
-    s->awaitTerminalEvent();
-
-    char label[256];
-
-    std::snprintf(label, sizeof(label), "Message Length: %d", MESSAGE_LENGTH);
-    state.SetLabel(label);
+    std::atomic<size_t> frames{0};
+};
+}
 
-    state.SetItemsProcessed(rcved);
+// Same as BM_Stream_Throughput, with one in every 1000 frames traced, which
+// shows the cost of leaving the frame trace on.
+BENCHMARK_DEFINE_F(BM_RsFixture, BM_Stream_Throughput_FrameTrace)(benchmark::State &state)
+{
+    auto sink = std::make_shared<BM_FrameTraceSink>();
+    setFrameTraceSink(sink);
+    FLAGS_rs_frame_trace_sampling = 1000;
+    streamThroughput(state, Stats::noop());
+    FLAGS_rs_frame_trace_sampling = 0;
+    setFrameTraceSink(nullptr);
+    VLOG(1) << sink->frames << " frames traced";
 }
 
-BENCHMARK_REGISTER_F(BM_RsFixture, BM_Stream_Throughput)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK_REGISTER_F(BM_RsFixture, BM_Stream_Throughput_FrameTrace)->Arg(8)->Arg(32)->Arg(128);
 
 BENCHMARK_MAIN()
@@ -0,0 +1,210 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+// Handshake rate and throughput of the TCP transport over loopback, in
+// plaintext, with TLS and with TLS encrypted by the kernel (kTLS). The first
+// argument is the mode, 0 for plaintext, 1 for TLS and 2 for kTLS.
+//
+// TLS needs a certificate, a self-signed one will do:
+//   openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost \
+//     -keyout key.pem -out cert.pem
+//   tlstransport --cert=cert.pem --key=key.pem
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <folly/Baton.h>
+#include <folly/Conv.h>
+#include <folly/ExceptionString.h>
+#include <folly/io/async/SSLContext.h>
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/TcpConnectionAcceptor.h"
+#include "rsocket/transports/TcpConnectionFactory.h"
+#include "rsocket/transports/Tls.h"
+#include "yarpl/Single.h"
+
+using namespace ::reactivesocket;
+using namespace ::folly;
+using namespace ::rsocket;
+using namespace yarpl;
+
+DEFINE_string(host, "localhost", "host to connect to");
+DEFINE_int32(port, 9898, "first of the 3 ports of the servers");
+DEFINE_string(cert, "", "PEM certificate of the TLS servers");
+DEFINE_string(key, "", "PEM private key of the TLS servers");
+
+namespace {
+
+enum Mode { PLAINTEXT = 0, TLS = 1, KTLS = 2 };
+
+const char* modeName(int mode) {
+  return mode == PLAINTEXT ? "plaintext" : mode == TLS ? "TLS" : "kTLS";
+}
+
+std::shared_ptr<folly::SSLContext> sslContext(int mode, bool server) {
+  if (mode == PLAINTEXT) {
+    return nullptr;
+  }
+  auto context = std::make_shared<folly::SSLContext>();
+  if (server) {
+    context->loadCertificate(FLAGS_cert.c_str());
+    context->loadPrivateKey(FLAGS_key.c_str());
+  }
+  if (mode == KTLS) {
+    enableKernelTls(*context);
+  }
+  return context;
+}
+
+/// Answers with a response of the size in the request.
+class ResponseHandler : public RSocketResponder {
+ public:
+  yarpl::Reference<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload request,
+      StreamId) override {
+    auto size = folly::to<size_t>(request.moveDataToString());
+    return yarpl::single::Single<Payload>::create(
+        [size](Reference<yarpl::single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(std::string(size, 'a')));
+        });
+  }
+};
+
+class Observer : public yarpl::single::SingleObserver<Payload> {
+ public:
+  void onSuccess(Payload response) override {
+    completed_.post();
+    yarpl::single::SingleObserver<Payload>::onSuccess(std::move(response));
+  }
+
+  void onError(std::exception_ptr ex) override {
+    LOG(ERROR) << "request failed: " << folly::exceptionStr(ex);
+    completed_.post();
+    yarpl::single::SingleObserver<Payload>::onError(ex);
+  }
+
+  void awaitCompleted() {
+    completed_.wait();
+  }
+
+ private:
+  folly::Baton<> completed_;
+};
+
+uint16_t port(int mode) {
+  return static_cast<uint16_t>(FLAGS_port + mode);
+}
+
+folly::SocketAddress address(int mode) {
+  folly::SocketAddress address;
+  address.setFromHostPort(FLAGS_host, port(mode));
+  return address;
+}
+
+/// Starts the servers of the 3 modes, once.
+bool startServers(benchmark::State& state) {
+  if (FLAGS_cert.empty() || FLAGS_key.empty()) {
+    state.SkipWithError("--cert and --key are required");
+    return false;
+  }
+  static auto servers = [] {
+    FLAGS_minloglevel = 6;
+    std::vector<std::unique_ptr<RSocketServer>> servers;
+    auto handler = std::make_shared<ResponseHandler>();
+    for (int mode : {PLAINTEXT, TLS, KTLS}) {
+      TcpConnectionAcceptor::Options options;
+      options.port = port(mode);
+      options.sslContext = sslContext(mode, true);
+      servers.push_back(RSocket::createServer(
+          std::make_unique<TcpConnectionAcceptor>(std::move(options))));
+      servers.back()->start([handler](auto r) { return handler; });
+    }
+    return servers;
+  }();
+  return true;
+}
+
+/// Opens a transport connection, handshake included, and closes it.
+void connectOnce(TcpConnectionFactory& factory) {
+  folly::Baton<> connected;
+  factory.connect([&connected](
+      std::unique_ptr<DuplexConnection> connection, folly::EventBase&) {
+    connection.reset();
+    connected.post();
+  });
+  connected.wait();
+}
+}
+
+// Connections per second, the second argument is whether the connections
+// resume the TLS session of the previous one.
+static void BM_Handshake(benchmark::State& state) {
+  if (!startServers(state)) {
+    return;
+  }
+  const int mode = state.range(0);
+  const bool resume = state.range(1);
+  auto context = sslContext(mode, false);
+
+  std::unique_ptr<TcpConnectionFactory> factory;
+  size_t connections = 0;
+  while (state.KeepRunning()) {
+    if (!factory || !resume) {
+      // a fresh factory has no session to resume
+      state.PauseTiming();
+      factory.reset();
+      factory = std::make_unique<TcpConnectionFactory>(address(mode), context);
+      state.ResumeTiming();
+    }
+    connectOnce(*factory);
+    ++connections;
+  }
+
+  state.SetLabel(folly::to<std::string>(
+      modeName(mode), resume ? ", resumed sessions" : ", full handshakes"));
+  state.SetItemsProcessed(connections);
+}
+
+// Request/responses on one connection, the second argument is the response
+// size.
+static void BM_Throughput(benchmark::State& state) {
+  if (!startServers(state)) {
+    return;
+  }
+  const int mode = state.range(0);
+  const auto size = static_cast<size_t>(state.range(1));
+
+  auto clientRs = RSocket::createClient(std::make_unique<TcpConnectionFactory>(
+      address(mode), sslContext(mode, false)));
+  auto rs = clientRs->connect().get();
+
+  const auto request = folly::to<std::string>(size);
+  size_t requests = 0;
+  while (state.KeepRunning()) {
+    auto observer = make_ref<Observer>();
+    rs->requestResponse(Payload(request))->subscribe(observer);
+    observer->awaitCompleted();
+    ++requests;
+  }
+
+  state.SetLabel(modeName(mode));
+  state.SetItemsProcessed(requests);
+  state.SetBytesProcessed(requests * size);
+}
+
+BENCHMARK(BM_Handshake)
+    ->Args({PLAINTEXT, 0})
+    ->Args({TLS, 0})
+    ->Args({TLS, 1})
+    ->Args({KTLS, 1})
+    ->UseRealTime();
+
+BENCHMARK(BM_Throughput)
+    ->Args({PLAINTEXT, 64 << 10})
+    ->Args({TLS, 64 << 10})
+    ->Args({KTLS, 64 << 10})
+    ->Args({PLAINTEXT, 1 << 20})
+    ->Args({TLS, 1 << 20})
+    ->Args({KTLS, 1 << 20})
+    ->UseRealTime();
+
+BENCHMARK_MAIN()
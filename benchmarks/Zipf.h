@@ -0,0 +1,36 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace reactivesocket {
+
+/// Samples keys 0 to keys - 1 with probability proportional to
+/// 1 / (key + 1)^s.
+class Zipf {
+ public:
+  explicit Zipf(size_t keys, double s = 1) : cdf_(keys) {
+    double sum = 0;
+    for (size_t i = 0; i < keys; ++i) {
+      sum += 1 / std::pow(i + 1, s);
+      cdf_[i] = sum;
+    }
+    for (auto& p : cdf_) {
+      p /= sum;
+    }
+  }
+
+  size_t operator()(std::mt19937_64& random) {
+    auto p = std::uniform_real_distribution<double>(0, 1)(random);
+    auto it = std::upper_bound(cdf_.begin(), cdf_.end(), p);
+    return std::min<size_t>(it - cdf_.begin(), cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+}
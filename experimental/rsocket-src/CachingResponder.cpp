@@ -0,0 +1,98 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/CachingResponder.h"
+
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace rsocket {
+
+/**
+ * Forwards the response of the decorated responder to the observer, caching
+ * it on the way.
+ */
+class CachingResponder::Filler : public single::SingleObserver<Payload>,
+                                 public single::SingleSubscription {
+ public:
+  Filler(
+      std::shared_ptr<ResponseCache> cache,
+      Payload request,
+      Reference<single::SingleObserver<Payload>> observer)
+      : cache_(std::move(cache)),
+        request_(std::move(request)),
+        observer_(std::move(observer)) {}
+
+  void onSubscribe(Reference<single::SingleSubscription> upstream) override {
+    single::SingleObserver<Payload>::onSubscribe(std::move(upstream));
+    observer_->onSubscribe(Reference<single::SingleSubscription>(this));
+  }
+
+  void onSuccess(Payload response) override {
+    cache_->put(request_, response.clone());
+    auto observer = std::move(observer_);
+    single::SingleObserver<Payload>::onSuccess(Payload());
+    observer->onSuccess(std::move(response));
+  }
+
+  void onError(std::exception_ptr ex) override {
+    auto observer = std::move(observer_);
+    single::SingleObserver<Payload>::onError(ex);
+    observer->onError(ex);
+  }
+
+  void cancel() override {
+    if (auto upstream = subscription()) {
+      upstream->cancel();
+    }
+  }
+
+ private:
+  const std::shared_ptr<ResponseCache> cache_;
+  const Payload request_;
+  Reference<single::SingleObserver<Payload>> observer_;
+};
+
+CachingResponder::CachingResponder(
+    std::shared_ptr<RSocketResponder> responder,
+    std::shared_ptr<ResponseCache> cache)
+    : responder_(std::move(responder)), cache_(std::move(cache)) {}
+
+Reference<single::Single<Payload>> CachingResponder::handleRequestResponse(
+    Payload request,
+    StreamId streamId) {
+  if (auto response = cache_->get(request)) {
+    return single::Single<Payload>::create([response = std::move(*response)](
+        Reference<single::SingleObserver<Payload>> observer) {
+      observer->onSubscribe(single::SingleSubscriptions::empty());
+      observer->onSuccess(response.clone());
+    });
+  }
+  auto upstream = responder_->handleRequestResponse(request.clone(), streamId);
+  return single::Single<Payload>::create([
+    cache = cache_,
+    upstream = std::move(upstream),
+    request = std::move(request)
+  ](Reference<single::SingleObserver<Payload>> observer) {
+    upstream->subscribe(
+        make_ref<Filler>(cache, request.clone(), std::move(observer)));
+  });
+}
+
+Reference<flowable::Flowable<Payload>> CachingResponder::handleRequestStream(
+    Payload request,
+    StreamId streamId) {
+  return responder_->handleRequestStream(std::move(request), streamId);
+}
+
+Reference<flowable::Flowable<Payload>> CachingResponder::handleRequestChannel(
+    Payload request,
+    Reference<flowable::Flowable<Payload>> requestStream,
+    StreamId streamId) {
+  return responder_->handleRequestChannel(
+      std::move(request), std::move(requestStream), streamId);
+}
+
+void CachingResponder::handleFireAndForget(Payload request, StreamId streamId) {
+  responder_->handleFireAndForget(std::move(request), streamId);
+}
+}
@@ -0,0 +1,615 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/CoalescingResponder.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace reactivesocket;
+using namespace folly;
+using namespace yarpl;
+
+namespace rsocket {
+
+namespace {
+constexpr int64_t kMaxRequestN = std::numeric_limits<int64_t>::max();
+
+EventBase* currentEventBase() {
+  return EventBaseManager::get()->getExistingEventBase();
+}
+
+/// Runs the function on the EventBase, inline when already running on it or
+/// when there is no EventBase.
+void runOn(EventBase* eventBase, Func func) {
+  if (!eventBase || eventBase->isInEventBaseThread()) {
+    func();
+  } else {
+    eventBase->runInEventBaseThread(std::move(func));
+  }
+}
+
+/// Drops the reference once the current call returns, the referenced object
+/// may be up the stack.
+template <typename T>
+void releaseLater(EventBase* eventBase, Reference<T> reference) {
+  if (eventBase) {
+    eventBase->runInEventBaseThread([reference = std::move(reference)]{});
+  }
+}
+}
+
+/**
+ * A requestResponse to the decorated responder and the observers waiting for
+ * its response. The state is guarded by Calls::mutex.
+ */
+class CoalescingResponder::ResponseCall
+    : public single::SingleObserver<Payload> {
+ public:
+  class Waiter : public single::SingleSubscription {
+   public:
+    Waiter(
+        Reference<ResponseCall> call,
+        Reference<single::SingleObserver<Payload>> observer)
+        : call_(std::move(call)),
+          observer_(std::move(observer)),
+          eventBase_(currentEventBase()) {}
+
+    void subscribe() {
+      observer_->onSubscribe(Reference<single::SingleSubscription>(this));
+    }
+
+    void cancel() override {
+      if (call_->leave(this)) {
+        // the observer references this subscription
+        releaseLater(eventBase_, std::move(observer_));
+      }
+    }
+
+    void deliverSuccess(Payload response) {
+      runOn(eventBase_, [
+        observer = std::move(observer_),
+        response = std::move(response)
+      ]() mutable { observer->onSuccess(std::move(response)); });
+    }
+
+    void deliverError(std::exception_ptr ex) {
+      runOn(eventBase_, [ observer = std::move(observer_), ex ] {
+        observer->onError(ex);
+      });
+    }
+
+   private:
+    const Reference<ResponseCall> call_;
+    Reference<single::SingleObserver<Payload>> observer_;
+    EventBase* const eventBase_;
+  };
+
+  ResponseCall(std::shared_ptr<Calls> calls, uint64_t key)
+      : calls_(std::move(calls)), key_(key), eventBase_(currentEventBase()) {}
+
+  /// Called with Calls::mutex held.
+  void addWaiter(Reference<Waiter> waiter) {
+    waiters_.push_back(std::move(waiter));
+  }
+
+  void onSubscribe(Reference<single::SingleSubscription> upstream) override;
+  void onSuccess(Payload response) override;
+  void onError(std::exception_ptr ex) override;
+
+ private:
+  /// Returns false when the result is already being delivered to the waiter.
+  bool leave(Waiter* waiter);
+  /// Ends the call, returning the waiters to deliver the result to.
+  std::vector<Reference<Waiter>> finish();
+
+  const std::shared_ptr<Calls> calls_;
+  const uint64_t key_;
+  /// Where the call was made, the upstream is only signalled there.
+  EventBase* const eventBase_;
+  std::vector<Reference<Waiter>> waiters_;
+  Reference<single::SingleSubscription> upstream_;
+  /// The call has its result or lost all of its waiters.
+  bool done_{false};
+};
+
+/**
+ * A requestStream to the decorated responder multicast to its subscribers.
+ * The state is guarded by Calls::mutex.
+ *
+ * The items are queued for each subscriber and delivered as it requests them.
+ * The upstream is only asked for what every subscriber requested, so the
+ * queue stays empty but for a subscriber which joined after the others had
+ * requested items: it holds at most what had been requested by then.
+ */
+class CoalescingResponder::StreamCall
+    : public flowable::Subscriber<Payload> {
+ public:
+  class Waiter : public flowable::Subscription {
+   public:
+    Waiter(
+        Reference<StreamCall> call,
+        Reference<flowable::Subscriber<Payload>> subscriber)
+        : call_(std::move(call)),
+          subscriber_(std::move(subscriber)),
+          eventBase_(currentEventBase()) {}
+
+    void subscribe() {
+      subscriber_->onSubscribe(Reference<flowable::Subscription>(this));
+    }
+
+    void request(int64_t n) override {
+      call_->request(this, n);
+    }
+
+    void cancel() override {
+      if (call_->leave(this)) {
+        // the subscriber references this subscription
+        releaseLater(eventBase_, std::move(subscriber_));
+      }
+      release();
+    }
+
+    // The subscriber is only touched on its EventBase.
+    void deliverQueued() {
+      runOn(eventBase_, [self = Reference<Waiter>(this)] { self->drain(); });
+    }
+
+    void deliverComplete() {
+      runOn(eventBase_, [self = Reference<Waiter>(this)] {
+        // after the items still queued
+        self->completing_ = true;
+        self->drain();
+      });
+    }
+
+    void deliverError(std::exception_ptr ex) {
+      runOn(eventBase_, [ self = Reference<Waiter>(this), ex ] {
+        if (auto subscriber = std::move(self->subscriber_)) {
+          subscriber->onError(ex);
+        }
+        self->release();
+      });
+    }
+
+   private:
+    friend class StreamCall;
+
+    /// Delivers the queued items the subscriber requested, in order even
+    /// when it requests more from within onNext.
+    void drain() {
+      if (draining_) {
+        return;
+      }
+      draining_ = true;
+      bool drained = false;
+      while (auto item = call_->takeQueued(this, drained)) {
+        if (auto subscriber = subscriber_) {
+          subscriber->onNext(std::move(*item));
+        }
+      }
+      draining_ = false;
+      if (drained && completing_) {
+        completing_ = false;
+        if (auto subscriber = std::move(subscriber_)) {
+          subscriber->onComplete();
+        }
+        release();
+      }
+    }
+
+    const Reference<StreamCall> call_;
+    Reference<flowable::Subscriber<Payload>> subscriber_;
+    EventBase* const eventBase_;
+    /// Guarded by Calls::mutex: the total requested by the subscriber, the
+    /// total delivered to it and the items it did not request yet.
+    int64_t requested_{0};
+    int64_t delivered_{0};
+    std::deque<Payload> queue_;
+    /// Only used on the EventBase of the subscriber.
+    bool draining_{false};
+    bool completing_{false};
+  };
+
+  StreamCall(std::shared_ptr<Calls> calls, uint64_t key)
+      : calls_(std::move(calls)), key_(key), eventBase_(currentEventBase()) {}
+
+  /// Called with Calls::mutex held.
+  void addWaiter(Reference<Waiter> waiter) {
+    waiters_.push_back(std::move(waiter));
+  }
+
+  void onSubscribe(Reference<flowable::Subscription> upstream) override;
+  void onNext(Payload item) override;
+  void onComplete() override;
+  void onError(std::exception_ptr ex) override;
+
+ private:
+  void request(Waiter* waiter, int64_t n);
+  /// The next queued item the waiter requested, none when there is no such
+  /// item. Sets drained when the queue of the waiter is empty.
+  folly::Optional<Payload> takeQueued(Waiter* waiter, bool& drained);
+  /// Returns false when the terminal signal is already being delivered to
+  /// the waiter.
+  bool leave(Waiter* waiter);
+  /// Ends the call, returning the waiters to deliver the terminal signal to.
+  std::vector<Reference<Waiter>> finish();
+  /// What is to be requested from the upstream to catch up with the slowest
+  /// subscriber, called with Calls::mutex held.
+  int64_t takeUpstreamDemand();
+  void requestUpstream(Reference<flowable::Subscription> upstream, int64_t n);
+
+  const std::shared_ptr<Calls> calls_;
+  const uint64_t key_;
+  /// Where the call was made, the upstream is only signalled there.
+  EventBase* const eventBase_;
+  std::vector<Reference<Waiter>> waiters_;
+  Reference<flowable::Subscription> upstream_;
+  int64_t upstreamRequested_{0};
+  /// The first item was emitted, no more subscribers can join.
+  bool started_{false};
+  bool done_{false};
+};
+
+struct CoalescingResponder::Calls {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Reference<ResponseCall>> responses;
+  std::unordered_map<uint64_t, Reference<StreamCall>> streams;
+  std::atomic<uint64_t> upstreamCalls{0};
+  std::atomic<uint64_t> coalescedRequests{0};
+
+  /// Stops new requests from joining the call, called with the mutex held.
+  template <typename Call>
+  void erase(
+      std::unordered_map<uint64_t, Reference<Call>>& map,
+      uint64_t key,
+      const Call* call) {
+    auto it = map.find(key);
+    if (it != map.end() && it->second.get() == call) {
+      map.erase(it);
+    }
+  }
+};
+
+void CoalescingResponder::ResponseCall::onSubscribe(
+    Reference<single::SingleSubscription> upstream) {
+  single::SingleObserver<Payload>::onSubscribe(upstream);
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    if (!done_) {
+      upstream_ = std::move(upstream);
+      return;
+    }
+  }
+  // every waiter left before the call got going
+  upstream->cancel();
+}
+
+void CoalescingResponder::ResponseCall::onSuccess(Payload response) {
+  for (auto& waiter : finish()) {
+    waiter->deliverSuccess(response.clone());
+  }
+  single::SingleObserver<Payload>::onSuccess(Payload());
+}
+
+void CoalescingResponder::ResponseCall::onError(std::exception_ptr ex) {
+  for (auto& waiter : finish()) {
+    waiter->deliverError(ex);
+  }
+  single::SingleObserver<Payload>::onError(ex);
+}
+
+std::vector<Reference<CoalescingResponder::ResponseCall::Waiter>>
+CoalescingResponder::ResponseCall::finish() {
+  std::lock_guard<std::mutex> lock(calls_->mutex);
+  done_ = true;
+  upstream_ = nullptr;
+  calls_->erase(calls_->responses, key_, this);
+  return std::move(waiters_);
+}
+
+bool CoalescingResponder::ResponseCall::leave(Waiter* waiter) {
+  Reference<single::SingleSubscription> upstream;
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    auto it = std::find_if(
+        waiters_.begin(), waiters_.end(), [waiter](const Reference<Waiter>& w) {
+          return w.get() == waiter;
+        });
+    if (it == waiters_.end()) {
+      return false;
+    }
+    waiters_.erase(it);
+    if (!waiters_.empty() || done_) {
+      return true;
+    }
+    done_ = true;
+    calls_->erase(calls_->responses, key_, this);
+    upstream = std::move(upstream_);
+  }
+  if (upstream) {
+    runOn(eventBase_, [upstream] { upstream->cancel(); });
+  }
+  return true;
+}
+
+void CoalescingResponder::StreamCall::onSubscribe(
+    Reference<flowable::Subscription> upstream) {
+  flowable::Subscriber<Payload>::onSubscribe(upstream);
+  int64_t demand = 0;
+  bool abandoned;
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    abandoned = done_;
+    if (!abandoned) {
+      upstream_ = upstream;
+      demand = takeUpstreamDemand();
+    }
+  }
+  if (abandoned) {
+    // every subscriber left before the call got going
+    upstream->cancel();
+    return;
+  }
+  requestUpstream(std::move(upstream), demand);
+}
+
+void CoalescingResponder::StreamCall::onNext(Payload item) {
+  std::vector<Reference<Waiter>> waiters;
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    if (!started_) {
+      // late subscribers would miss this item
+      started_ = true;
+      calls_->erase(calls_->streams, key_, this);
+    }
+    for (auto& waiter : waiters_) {
+      waiter->queue_.push_back(item.clone());
+    }
+    waiters = waiters_;
+  }
+  for (auto& waiter : waiters) {
+    waiter->deliverQueued();
+  }
+}
+
+void CoalescingResponder::StreamCall::onComplete() {
+  for (auto& waiter : finish()) {
+    waiter->deliverComplete();
+  }
+  flowable::Subscriber<Payload>::onComplete();
+}
+
+void CoalescingResponder::StreamCall::onError(std::exception_ptr ex) {
+  for (auto& waiter : finish()) {
+    waiter->deliverError(ex);
+  }
+  flowable::Subscriber<Payload>::onError(ex);
+}
+
+std::vector<Reference<CoalescingResponder::StreamCall::Waiter>>
+CoalescingResponder::StreamCall::finish() {
+  std::lock_guard<std::mutex> lock(calls_->mutex);
+  done_ = true;
+  upstream_ = nullptr;
+  calls_->erase(calls_->streams, key_, this);
+  return std::move(waiters_);
+}
+
+void CoalescingResponder::StreamCall::request(Waiter* waiter, int64_t n) {
+  if (n <= 0) {
+    return;
+  }
+  Reference<flowable::Subscription> upstream;
+  int64_t demand;
+  bool queued;
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    waiter->requested_ = n >= kMaxRequestN - waiter->requested_
+        ? kMaxRequestN
+        : waiter->requested_ + n;
+    demand = takeUpstreamDemand();
+    upstream = upstream_;
+    queued = !waiter->queue_.empty();
+  }
+  requestUpstream(std::move(upstream), demand);
+  if (queued) {
+    // items which arrived before the subscriber asked for them
+    waiter->deliverQueued();
+  }
+}
+
+folly::Optional<Payload> CoalescingResponder::StreamCall::takeQueued(
+    Waiter* waiter,
+    bool& drained) {
+  std::lock_guard<std::mutex> lock(calls_->mutex);
+  drained = waiter->queue_.empty();
+  if (drained || waiter->delivered_ >= waiter->requested_) {
+    return folly::none;
+  }
+  ++waiter->delivered_;
+  auto item = std::move(waiter->queue_.front());
+  waiter->queue_.pop_front();
+  return std::move(item);
+}
+
+bool CoalescingResponder::StreamCall::leave(Waiter* waiter) {
+  Reference<flowable::Subscription> upstream;
+  int64_t demand = 0;
+  bool cancel = false;
+  {
+    std::lock_guard<std::mutex> lock(calls_->mutex);
+    auto it = std::find_if(
+        waiters_.begin(), waiters_.end(), [waiter](const Reference<Waiter>& w) {
+          return w.get() == waiter;
+        });
+    if (it == waiters_.end()) {
+      return false;
+    }
+    waiters_.erase(it);
+    if (done_) {
+      return true;
+    }
+    if (waiters_.empty()) {
+      done_ = true;
+      cancel = true;
+      calls_->erase(calls_->streams, key_, this);
+      upstream = std::move(upstream_);
+    } else {
+      // the slowest subscriber may have left
+      demand = takeUpstreamDemand();
+      upstream = upstream_;
+    }
+  }
+  if (cancel) {
+    if (upstream) {
+      runOn(eventBase_, [upstream] { upstream->cancel(); });
+    }
+    return true;
+  }
+  requestUpstream(std::move(upstream), demand);
+  return true;
+}
+
+int64_t CoalescingResponder::StreamCall::takeUpstreamDemand() {
+  if (!upstream_ || done_ || waiters_.empty()) {
+    return 0;
+  }
+  int64_t target = kMaxRequestN;
+  for (const auto& waiter : waiters_) {
+    target = std::min(target, waiter->requested_);
+  }
+  if (target <= upstreamRequested_) {
+    return 0;
+  }
+  auto demand =
+      target == kMaxRequestN ? kMaxRequestN : target - upstreamRequested_;
+  upstreamRequested_ = target;
+  return demand;
+}
+
+void CoalescingResponder::StreamCall::requestUpstream(
+    Reference<flowable::Subscription> upstream,
+    int64_t n) {
+  if (upstream && n > 0) {
+    runOn(eventBase_, [upstream, n] { upstream->request(n); });
+  }
+}
+
+CoalescingResponder::CoalescingResponder(
+    std::shared_ptr<RSocketResponder> responder,
+    KeyFunction key)
+    : responder_(std::move(responder)),
+      key_(std::move(key)),
+      calls_(std::make_shared<Calls>()) {}
+
+CoalescingResponder::~CoalescingResponder() = default;
+
+Reference<single::Single<Payload>> CoalescingResponder::handleRequestResponse(
+    Payload request,
+    StreamId streamId) {
+  auto key = key_(request);
+  if (!key) {
+    return responder_->handleRequestResponse(std::move(request), streamId);
+  }
+  return single::Single<Payload>::create([
+    calls = calls_,
+    responder = responder_,
+    key = *key,
+    request = std::move(request),
+    streamId
+  ](Reference<single::SingleObserver<Payload>> observer) mutable {
+    Reference<ResponseCall> call;
+    Reference<ResponseCall::Waiter> waiter;
+    bool created = false;
+    {
+      std::lock_guard<std::mutex> lock(calls->mutex);
+      auto& slot = calls->responses[key];
+      if (!slot) {
+        slot = make_ref<ResponseCall>(calls, key);
+        created = true;
+      }
+      call = slot;
+      waiter = make_ref<ResponseCall::Waiter>(call, std::move(observer));
+      call->addWaiter(waiter);
+    }
+    waiter->subscribe();
+    if (!created) {
+      ++calls->coalescedRequests;
+      return;
+    }
+    ++calls->upstreamCalls;
+    responder->handleRequestResponse(std::move(request), streamId)
+        ->subscribe(std::move(call));
+  });
+}
+
+Reference<flowable::Flowable<Payload>> CoalescingResponder::handleRequestStream(
+    Payload request,
+    StreamId streamId) {
+  auto key = key_(request);
+  if (!key) {
+    return responder_->handleRequestStream(std::move(request), streamId);
+  }
+  return flowable::Flowables::fromPublisher<Payload>([
+    calls = calls_,
+    responder = responder_,
+    key = *key,
+    request = std::move(request),
+    streamId
+  ](Reference<flowable::Subscriber<Payload>> subscriber) mutable {
+    Reference<StreamCall> call;
+    Reference<StreamCall::Waiter> waiter;
+    bool created = false;
+    {
+      std::lock_guard<std::mutex> lock(calls->mutex);
+      auto& slot = calls->streams[key];
+      if (!slot) {
+        slot = make_ref<StreamCall>(calls, key);
+        created = true;
+      }
+      call = slot;
+      waiter = make_ref<StreamCall::Waiter>(call, std::move(subscriber));
+      call->addWaiter(waiter);
+    }
+    waiter->subscribe();
+    if (!created) {
+      ++calls->coalescedRequests;
+      return;
+    }
+    ++calls->upstreamCalls;
+    responder->handleRequestStream(std::move(request), streamId)
+        ->subscribe(std::move(call));
+  });
+}
+
+Reference<flowable::Flowable<Payload>>
+CoalescingResponder::handleRequestChannel(
+    Payload request,
+    Reference<flowable::Flowable<Payload>> requestStream,
+    StreamId streamId) {
+  return responder_->handleRequestChannel(
+      std::move(request), std::move(requestStream), streamId);
+}
+
+void CoalescingResponder::handleFireAndForget(
+    Payload request,
+    StreamId streamId) {
+  responder_->handleFireAndForget(std::move(request), streamId);
+}
+
+uint64_t CoalescingResponder::upstreamCalls() const {
+  return calls_->upstreamCalls.load();
+}
+
+uint64_t CoalescingResponder::coalescedRequests() const {
+  return calls_->coalescedRequests.load();
+}
+}
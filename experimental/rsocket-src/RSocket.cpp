@@ -7,8 +7,20 @@
 namespace rsocket {
 
 std::unique_ptr<RSocketClient> RSocket::createClient(
-    std::unique_ptr<ConnectionFactory> connectionFactory) {
-  return std::make_unique<RSocketClient>(std::move(connectionFactory));
+    std::unique_ptr<ConnectionFactory> connectionFactory,
+    std::shared_ptr<reactivesocket::Stats> stats) {
+  return std::make_unique<RSocketClient>(
+      std::move(connectionFactory), std::move(stats));
+}
+
+std::unique_ptr<RSocketClientPool> RSocket::createClientPool(
+    std::vector<std::unique_ptr<ConnectionFactory>> connectionFactories,
+    std::shared_ptr<reactivesocket::Stats> stats,
+    reactivesocket::CompressionOptions compression) {
+  return std::make_unique<RSocketClientPool>(
+      std::move(connectionFactories),
+      std::move(stats),
+      std::move(compression));
 }
 
 std::unique_ptr<RSocketServer> RSocket::createServer(
@@ -2,29 +2,52 @@
 
 #include "rsocket/RSocketClient.h"
 #include "rsocket/RSocketRequester.h"
+#include "src/CompositeMetadata.h"
+#include "src/FrameTransport.h"
 #include "src/NullRequestHandler.h"
 #include "src/ReactiveSocket.h"
-#include "src/folly/FollyKeepaliveTimer.h"
+#include "src/folly/KeepaliveWheel.h"
 
 using namespace reactivesocket;
 using namespace folly;
 
 namespace rsocket {
 
-RSocketClient::RSocketClient(std::unique_ptr<ConnectionFactory> connection)
-    : lazyConnection_(std::move(connection)) {
-  LOG(INFO) << "RSocketClient => created";
+namespace {
+ConnectionSetupPayload setupPayload(const CompressionOptions& compression) {
+  // TODO need to allow this being passed in
+  ConnectionSetupPayload setupPayload(
+      "text/plain", "text/plain", Payload("meta", "data"));
+  if (!compression.codecs.empty()) {
+    // the codecs are offered in composite metadata, which the metadata of
+    // the connection have to be then
+    setupPayload.metadataMimeType = kCompositeMetadataMimeType.str();
+    setupPayload.payload.metadata.reset();
+  }
+  setupPayload.compression = compression;
+  // a draining server's lease of no requests closes the RSocketRequester to
+  // new requests, see RSocketRequester::isPeerDraining
+  setupPayload.honorsLease = true;
+  return setupPayload;
+}
+}
+
+RSocketClient::RSocketClient(
+    std::unique_ptr<ConnectionFactory> connection,
+    std::shared_ptr<Stats> stats)
+    : lazyConnection_(std::move(connection)), stats_(std::move(stats)) {
+  VLOG(2) << "RSocketClient => created";
 }
 
 Future<std::shared_ptr<RSocketRequester>> RSocketClient::connect() {
-  LOG(INFO) << "RSocketClient => start connection with Future";
+  VLOG(3) << "RSocketClient => start connection with Future";
 
   auto promise = std::make_shared<Promise<std::shared_ptr<RSocketRequester>>>();
 
-  lazyConnection_->connect([this, promise](
+  auto onConnect = [this, promise](
       std::unique_ptr<DuplexConnection> framedConnection,
       EventBase& eventBase) {
-    LOG(INFO) << "RSocketClient => onConnect received DuplexConnection";
+    VLOG(3) << "RSocketClient => onConnect received DuplexConnection";
 
     auto r = ReactiveSocket::fromClientConnection(
         eventBase,
@@ -32,24 +55,87 @@ Future<std::shared_ptr<RSocketRequester>> RSocketClient::connect() {
         // TODO need to optionally allow this being passed in for a duplex
         // client
         std::make_unique<NullRequestHandler>(),
-        // TODO need to allow this being passed in
-        ConnectionSetupPayload(
-            "text/plain", "text/plain", Payload("meta", "data")),
-        Stats::noop(),
+        setupPayload(compression_),
+        stats_,
         // TODO need to optionally allow defining the keepalive timer
-        std::make_unique<FollyKeepaliveTimer>(
-            eventBase, std::chrono::milliseconds(5000)));
+        KeepaliveWheel::forEventBase(eventBase)->createTimer(
+            std::chrono::milliseconds(5000)));
 
     auto rsocket = RSocketRequester::create(std::move(r), eventBase);
     // store it so it lives as long as the RSocketClient
-    rsockets_.push_back(rsocket);
+    rsockets_.lock()->push_back(rsocket);
     promise->setValue(rsocket);
-  });
+  };
+  auto onConnectError = [promise](folly::exception_wrapper ex) {
+    VLOG(3) << "RSocketClient => connect failed: " << ex.what();
+    promise->setException(std::move(ex));
+  };
+  lazyConnection_->connect(std::move(onConnect), std::move(onConnectError));
 
   return promise->getFuture();
 }
 
+std::shared_ptr<RSocketRequester> RSocketClient::fastConnect() {
+  VLOG(3) << "RSocketClient => fast start connection";
+
+  auto eventBase = lazyConnection_->getEventBase();
+  CHECK(eventBase) << "ConnectionFactory does not support fast start";
+
+  // ReactiveSocket has to be created on its EventBase, this is only a thread
+  // hop, not a network round trip
+  std::unique_ptr<ReactiveSocket> r;
+  eventBase->runImmediatelyOrRunInEventBaseThreadAndWait([this, &r, eventBase] {
+    r = ReactiveSocket::disconnectedClient(
+        *eventBase,
+        // TODO need to optionally allow this being passed in for a duplex
+        // client
+        std::make_unique<NullRequestHandler>(),
+        stats_,
+        // TODO need to optionally allow defining the keepalive timer
+        KeepaliveWheel::forEventBase(*eventBase)->createTimer(
+            std::chrono::milliseconds(5000)));
+  });
+
+  // owned by the requester below, which stays alive as long as the
+  // RSocketClient does
+  auto srs = r.get();
+  auto rsocket = RSocketRequester::create(std::move(r), *eventBase);
+  rsockets_.lock()->push_back(rsocket);
+
+  // until the transport connects, requests accumulate in the StreamState of
+  // the disconnected socket and are flushed right behind SETUP by
+  // clientConnect
+  std::weak_ptr<RSocketRequester> weakRSocket = rsocket;
+  auto onConnect = [ srs, weakRSocket, compression = compression_ ](
+      std::unique_ptr<DuplexConnection> framedConnection,
+      EventBase& eventBase) {
+    VLOG(3) << "RSocketClient => fast start received DuplexConnection";
+
+    auto rsocket = weakRSocket.lock();
+    if (!rsocket) {
+      return;
+    }
+    srs->clientConnect(
+        std::make_shared<FrameTransport>(std::move(framedConnection)),
+        setupPayload(compression));
+  };
+  // the buffered requests fail with the connect error, both callbacks run on
+  // the EventBase of the socket
+  auto onConnectError = [srs, weakRSocket](folly::exception_wrapper ex) {
+    VLOG(3) << "RSocketClient => fast start failed: " << ex.what();
+
+    auto rsocket = weakRSocket.lock();
+    if (!rsocket) {
+      return;
+    }
+    srs->connectFailed(std::move(ex));
+  };
+  lazyConnection_->connect(std::move(onConnect), std::move(onConnectError));
+
+  return rsocket;
+}
+
 RSocketClient::~RSocketClient() {
-  LOG(INFO) << "RSocketClient => destroy";
+  VLOG(2) << "RSocketClient => destroy";
 }
 }
@@ -0,0 +1,555 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/RSocketClientPool.h"
+
+#include <folly/Random.h>
+#include <folly/io/async/EventBase.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "src/CompositeMetadata.h"
+#include "src/NullRequestHandler.h"
+#include "src/ReactiveSocket.h"
+#include "src/folly/KeepaliveWheel.h"
+
+using namespace reactivesocket;
+using namespace folly;
+using namespace yarpl;
+
+namespace rsocket {
+
+namespace {
+// weight of the newest sample in the latency moving average
+constexpr double kLatencyDecay = 0.2;
+
+ConnectionSetupPayload setupPayload(const CompressionOptions& compression) {
+  // TODO need to allow this being passed in
+  ConnectionSetupPayload setupPayload(
+      "text/plain", "text/plain", Payload("meta", "data"));
+  if (!compression.codecs.empty()) {
+    // as with RSocketClient, the codecs are offered in composite metadata
+    setupPayload.metadataMimeType = kCompositeMetadataMimeType.str();
+    setupPayload.payload.metadata.reset();
+  }
+  setupPayload.compression = compression;
+  // draining servers are taken out of rotation, see Member::requester()
+  setupPayload.honorsLease = true;
+  return setupPayload;
+}
+}
+
+/**
+ * A single pooled connection, reconnected through its ConnectionFactory
+ * whenever it closes or fails to connect.
+ */
+class RSocketClientPool::Member : public std::enable_shared_from_this<Member> {
+ public:
+  /// Told the outcome of the first connection attempt, an empty exception
+  /// when it succeeded.
+  using OnFirstAttempt = std::function<void(folly::exception_wrapper)>;
+
+  Member(
+      std::unique_ptr<ConnectionFactory> factory,
+      std::shared_ptr<Stats> stats,
+      CompressionOptions compression,
+      std::chrono::milliseconds minReconnectDelay,
+      std::chrono::milliseconds maxReconnectDelay)
+      : factory_(std::move(factory)),
+        stats_(std::move(stats)),
+        compression_(std::move(compression)),
+        minReconnectDelay_(minReconnectDelay),
+        maxReconnectDelay_(maxReconnectDelay),
+        reconnectDelay_(minReconnectDelay) {}
+
+  void connect(OnFirstAttempt onFirstAttempt) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      onFirstAttempt_ = std::move(onFirstAttempt);
+    }
+    reconnect();
+  }
+
+  /// Stops replacing the connection and drops the current one.
+  void shutdown() {
+    std::shared_ptr<RSocketRequester> requester;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+      requester = std::move(requester_);
+    }
+  }
+
+  /// The connection when it can take requests.  A draining peer takes none,
+  /// the connection is replaced once the peer closes it.
+  std::shared_ptr<RSocketRequester> requester() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (requester_ && requester_->isPeerDraining()) {
+      return nullptr;
+    }
+    return requester_;
+  }
+
+  double cost() const {
+    auto latency = std::max(latencyNanos_.load(), 1.0);
+    return latency * static_cast<double>(outstanding_.load() + 1);
+  }
+
+  void requestStarted() {
+    ++outstanding_;
+  }
+
+  void requestFinished() {
+    --outstanding_;
+  }
+
+  /// Folds a latency sample into the moving average. Concurrent updates may
+  /// overwrite each other, which is fine for a load balancing heuristic.
+  void recordLatency(std::chrono::steady_clock::duration latency) {
+    auto sample = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    auto average = latencyNanos_.load();
+    latencyNanos_.store(
+        average == 0 ? sample : average + kLatencyDecay * (sample - average));
+  }
+
+ private:
+  void reconnect() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (shutdown_) {
+        return;
+      }
+    }
+
+    std::weak_ptr<Member> weakSelf = shared_from_this();
+    auto onConnect = [weakSelf](
+        std::unique_ptr<DuplexConnection> framedConnection,
+        EventBase& eventBase) {
+      auto self = weakSelf.lock();
+      if (!self) {
+        return;
+      }
+
+      auto r = ReactiveSocket::fromClientConnection(
+          eventBase,
+          std::move(framedConnection),
+          std::make_unique<NullRequestHandler>(),
+          setupPayload(self->compression_),
+          self->stats_,
+          KeepaliveWheel::forEventBase(eventBase)->createTimer(
+              std::chrono::milliseconds(5000)));
+
+      r->onClosed([weakSelf, &eventBase](const folly::exception_wrapper& ex) {
+        if (auto self = weakSelf.lock()) {
+          self->onClosed(eventBase, ex);
+        }
+      });
+
+      self->onConnected(RSocketRequester::create(std::move(r), eventBase));
+    };
+    auto onConnectError = [weakSelf](folly::exception_wrapper ex) {
+      if (auto self = weakSelf.lock()) {
+        self->onConnectError(std::move(ex));
+      }
+    };
+    factory_->connect(std::move(onConnect), std::move(onConnectError));
+  }
+
+  void onConnected(std::shared_ptr<RSocketRequester> requester) {
+    OnFirstAttempt onFirstAttempt;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (shutdown_) {
+        return;
+      }
+      requester_ = std::move(requester);
+      reconnectDelay_ = minReconnectDelay_;
+      onFirstAttempt = std::move(onFirstAttempt_);
+      onFirstAttempt_ = nullptr;
+    }
+    if (onFirstAttempt) {
+      onFirstAttempt(folly::exception_wrapper());
+    }
+  }
+
+  void onConnectError(folly::exception_wrapper ex) {
+    OnFirstAttempt onFirstAttempt;
+    std::chrono::milliseconds delay;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (shutdown_) {
+        return;
+      }
+      delay = reconnectDelay_;
+      reconnectDelay_ = std::min(reconnectDelay_ * 2, maxReconnectDelay_);
+      onFirstAttempt = std::move(onFirstAttempt_);
+      onFirstAttempt_ = nullptr;
+    }
+
+    LOG(WARNING) << "RSocketClientPool => connect failed, retrying in "
+                 << delay.count() << "ms: " << ex.what();
+
+    if (onFirstAttempt) {
+      onFirstAttempt(std::move(ex));
+    }
+
+    std::weak_ptr<Member> weakSelf = shared_from_this();
+    folly::futures::sleep(delay).then([weakSelf] {
+      if (auto self = weakSelf.lock()) {
+        self->reconnect();
+      }
+    });
+  }
+
+  void onClosed(EventBase& eventBase, const folly::exception_wrapper& ex) {
+    std::shared_ptr<RSocketRequester> requester;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (shutdown_ || !requester_) {
+        return;
+      }
+      requester = std::move(requester_);
+    }
+
+    LOG(WARNING) << "RSocketClientPool => connection closed, replacing it: "
+                 << ex.what();
+
+    // we are called from within the closing ReactiveSocket, so it must be
+    // destroyed on a later loop iteration
+    eventBase.runInEventBaseThread([requester = std::move(requester)] {});
+
+    // requests outstanding on the old connection are terminated along with
+    // it, only the latency history is stale
+    latencyNanos_ = 0;
+    reconnect();
+  }
+
+  const std::unique_ptr<ConnectionFactory> factory_;
+  const std::shared_ptr<Stats> stats_;
+  const CompressionOptions compression_;
+  const std::chrono::milliseconds minReconnectDelay_;
+  const std::chrono::milliseconds maxReconnectDelay_;
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<RSocketRequester> requester_;
+  OnFirstAttempt onFirstAttempt_;
+  /// Wait before the next attempt after a failed one.
+  std::chrono::milliseconds reconnectDelay_;
+  bool shutdown_{false};
+
+  std::atomic<int64_t> outstanding_{0};
+  std::atomic<double> latencyNanos_{0};
+};
+
+namespace {
+
+/// Tracks a request/response on a pooled connection: counts it as outstanding
+/// until it terminates and samples its latency.
+template <typename TMember>
+class MeasuringSingleObserver : public single::SingleObserver<Payload>,
+                                public single::SingleSubscription {
+ public:
+  MeasuringSingleObserver(
+      std::shared_ptr<TMember> member,
+      Reference<single::SingleObserver<Payload>> inner)
+      : member_(std::move(member)),
+        inner_(std::move(inner)),
+        start_(std::chrono::steady_clock::now()) {
+    member_->requestStarted();
+  }
+
+  void onSubscribe(Reference<single::SingleSubscription> subscription) override {
+    single::SingleObserver<Payload>::onSubscribe(std::move(subscription));
+    inner_->onSubscribe(Reference<single::SingleSubscription>(this));
+  }
+
+  void onSuccess(Payload payload) override {
+    member_->recordLatency(std::chrono::steady_clock::now() - start_);
+    finish();
+    inner_->onSuccess(std::move(payload));
+    single::SingleObserver<Payload>::onSuccess(Payload());
+  }
+
+  void onError(const std::exception_ptr ex) override {
+    finish();
+    inner_->onError(ex);
+    single::SingleObserver<Payload>::onError(ex);
+  }
+
+  void cancel() override {
+    finish();
+    if (auto subscription = single::SingleObserver<Payload>::subscription()) {
+      subscription->cancel();
+    }
+  }
+
+ private:
+  void finish() {
+    if (!finished_.exchange(true)) {
+      member_->requestFinished();
+    }
+  }
+
+  const std::shared_ptr<TMember> member_;
+  const Reference<single::SingleObserver<Payload>> inner_;
+  const std::chrono::steady_clock::time_point start_;
+  std::atomic<bool> finished_{false};
+};
+
+/// Tracks a stream or channel on a pooled connection: counts it as
+/// outstanding until it terminates and samples its time to first payload.
+template <typename TMember>
+class MeasuringSubscriber : public flowable::Subscriber<Payload>,
+                            public flowable::Subscription {
+ public:
+  MeasuringSubscriber(
+      std::shared_ptr<TMember> member,
+      Reference<flowable::Subscriber<Payload>> inner)
+      : member_(std::move(member)),
+        inner_(std::move(inner)),
+        start_(std::chrono::steady_clock::now()) {
+    member_->requestStarted();
+  }
+
+  void onSubscribe(Reference<flowable::Subscription> subscription) override {
+    flowable::Subscriber<Payload>::onSubscribe(std::move(subscription));
+    inner_->onSubscribe(Reference<flowable::Subscription>(this));
+  }
+
+  void onNext(Payload payload) override {
+    if (!sampled_) {
+      sampled_ = true;
+      member_->recordLatency(std::chrono::steady_clock::now() - start_);
+    }
+    inner_->onNext(std::move(payload));
+  }
+
+  void onComplete() override {
+    finish();
+    inner_->onComplete();
+    flowable::Subscriber<Payload>::onComplete();
+    release();
+  }
+
+  void onError(const std::exception_ptr ex) override {
+    finish();
+    inner_->onError(ex);
+    flowable::Subscriber<Payload>::onError(ex);
+    release();
+  }
+
+  void request(int64_t n) override {
+    if (auto subscription = flowable::Subscriber<Payload>::subscription()) {
+      subscription->request(n);
+    }
+  }
+
+  void cancel() override {
+    finish();
+    if (auto subscription = flowable::Subscriber<Payload>::subscription()) {
+      subscription->cancel();
+    }
+    release();
+  }
+
+ private:
+  void finish() {
+    if (!finished_.exchange(true)) {
+      member_->requestFinished();
+    }
+  }
+
+  const std::shared_ptr<TMember> member_;
+  const Reference<flowable::Subscriber<Payload>> inner_;
+  const std::chrono::steady_clock::time_point start_;
+  bool sampled_{false};
+  std::atomic<bool> finished_{false};
+};
+
+std::runtime_error noConnectionError() {
+  return std::runtime_error("RSocketClientPool has no connected RSocket");
+}
+
+} // namespace
+
+RSocketClientPool::RSocketClientPool(
+    std::vector<std::unique_ptr<ConnectionFactory>> factories,
+    std::shared_ptr<Stats> stats,
+    CompressionOptions compression,
+    std::chrono::milliseconds minReconnectDelay,
+    std::chrono::milliseconds maxReconnectDelay) {
+  CHECK(!factories.empty());
+  CHECK(minReconnectDelay <= maxReconnectDelay);
+  LOG(INFO) << "RSocketClientPool => created with " << factories.size()
+            << " connections";
+  for (auto& factory : factories) {
+    members_.push_back(std::make_shared<Member>(
+        std::move(factory),
+        stats,
+        compression,
+        minReconnectDelay,
+        maxReconnectDelay));
+  }
+}
+
+RSocketClientPool::~RSocketClientPool() {
+  LOG(INFO) << "RSocketClientPool => destroy";
+  for (auto& member : members_) {
+    member->shutdown();
+  }
+}
+
+Future<Unit> RSocketClientPool::connect() {
+  struct FirstAttempts {
+    explicit FirstAttempts(size_t members) : pending(members) {}
+
+    std::mutex mutex;
+    size_t pending;
+    bool connected{false};
+    folly::exception_wrapper lastError;
+    Promise<Unit> promise;
+  };
+  auto attempts = std::make_shared<FirstAttempts>(members_.size());
+
+  for (auto& member : members_) {
+    member->connect([attempts](folly::exception_wrapper ex) {
+      std::unique_lock<std::mutex> lock(attempts->mutex);
+      if (ex) {
+        attempts->lastError = std::move(ex);
+      } else {
+        attempts->connected = true;
+      }
+      if (--attempts->pending > 0) {
+        return;
+      }
+      lock.unlock();
+
+      if (attempts->connected) {
+        attempts->promise.setValue();
+      } else {
+        attempts->promise.setException(std::move(attempts->lastError));
+      }
+    });
+  }
+
+  return attempts->promise.getFuture();
+}
+
+std::shared_ptr<RSocketClientPool::Member> RSocketClientPool::select(
+    std::shared_ptr<RSocketRequester>& requester) const {
+  auto size = static_cast<uint32_t>(members_.size());
+  if (size > 1) {
+    auto i = folly::Random::rand32(size);
+    auto j = folly::Random::rand32(size - 1);
+    if (j >= i) {
+      ++j;
+    }
+
+    auto first = members_[i];
+    auto second = members_[j];
+    if (second->cost() < first->cost()) {
+      std::swap(first, second);
+    }
+    if ((requester = first->requester())) {
+      return first;
+    }
+    if ((requester = second->requester())) {
+      return second;
+    }
+  }
+
+  // both choices are down, fall back to any connection that is up
+  for (auto& member : members_) {
+    if ((requester = member->requester())) {
+      return member;
+    }
+  }
+  return nullptr;
+}
+
+Reference<flowable::Flowable<Payload>> RSocketClientPool::requestStream(
+    Payload request) {
+  std::shared_ptr<RSocketRequester> requester;
+  auto member = select(requester);
+  if (!member) {
+    return flowable::Flowables::error<Payload>(noConnectionError());
+  }
+
+  return flowable::Flowables::fromPublisher<Payload>([
+    member = std::move(member),
+    responses = requester->requestStream(std::move(request))
+  ](Reference<flowable::Subscriber<Payload>> subscriber) {
+    responses->subscribe(make_ref<MeasuringSubscriber<Member>>(
+        member, std::move(subscriber)));
+  });
+}
+
+Reference<flowable::Flowable<Payload>> RSocketClientPool::requestChannel(
+    Reference<flowable::Flowable<Payload>> requests) {
+  std::shared_ptr<RSocketRequester> requester;
+  auto member = select(requester);
+  if (!member) {
+    return flowable::Flowables::error<Payload>(noConnectionError());
+  }
+
+  return flowable::Flowables::fromPublisher<Payload>([
+    member = std::move(member),
+    responses = requester->requestChannel(std::move(requests))
+  ](Reference<flowable::Subscriber<Payload>> subscriber) {
+    responses->subscribe(make_ref<MeasuringSubscriber<Member>>(
+        member, std::move(subscriber)));
+  });
+}
+
+Reference<single::Single<Payload>> RSocketClientPool::requestResponse(
+    Payload request) {
+  std::shared_ptr<RSocketRequester> requester;
+  auto member = select(requester);
+  if (!member) {
+    return single::Singles::error<Payload>(noConnectionError());
+  }
+
+  return single::Single<Payload>::create([
+    member = std::move(member),
+    response = requester->requestResponse(std::move(request))
+  ](Reference<single::SingleObserver<Payload>> observer) {
+    response->subscribe(make_ref<MeasuringSingleObserver<Member>>(
+        member, std::move(observer)));
+  });
+}
+
+Reference<single::Single<void>> RSocketClientPool::fireAndForget(
+    Payload request) {
+  std::shared_ptr<RSocketRequester> requester;
+  if (!select(requester)) {
+    return single::Singles::error<void>(noConnectionError());
+  }
+  return requester->fireAndForget(std::move(request));
+}
+
+void RSocketClientPool::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
+  std::shared_ptr<RSocketRequester> requester;
+  if (!select(requester)) {
+    LOG(WARNING) << "RSocketClientPool => dropping metadata push, "
+                 << "no connected RSocket";
+    return;
+  }
+  requester->metadataPush(std::move(metadata));
+}
+
+size_t RSocketClientPool::size() const {
+  return members_.size();
+}
+
+size_t RSocketClientPool::connectedCount() const {
+  size_t count = 0;
+  for (auto& member : members_) {
+    if (member->requester()) {
+      ++count;
+    }
+  }
+  return count;
+}
+}
@@ -1,7 +1,6 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include "rsocket/RSocketConnectionHandler.h"
-#include <atomic>
 
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseManager.h>
@@ -53,49 +52,10 @@ class RSocketHandlerBridge : public reactivesocket::DefaultRequestHandler {
   void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>&
-          responseSubscriber) noexcept override {
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          responseObserver) noexcept override {
     auto single = handler_->handleRequestResponse(std::move(request), streamId);
-    // bridge from the existing eager RequestHandler and old Subscriber type
-    // to the lazy Single and new SingleObserver type
-
-    class BridgeSubscriptionToSingle : public yarpl::flowable::Subscription {
-     public:
-      BridgeSubscriptionToSingle(
-          yarpl::Reference<yarpl::single::Single<Payload>> single,
-          yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSubscriber)
-          : single_{std::move(single)},
-            responseSubscriber_{std::move(responseSubscriber)} {}
-
-      void request(int64_t n) noexcept override {
-        // when we get a request we subscribe to Single
-        bool expected = false;
-        if (n > 0 && subscribed_.compare_exchange_strong(expected, true)) {
-          single_->subscribe(yarpl::single::SingleObservers::create<Payload>(
-              [this](Payload p) {
-                // onNext
-                responseSubscriber_->onNext(std::move(p));
-              },
-              [this](std::exception_ptr eptr) {
-                responseSubscriber_->onError(std::move(eptr));
-              }));
-        }
-      }
-
-      void cancel() noexcept override{
-          // TODO this code will be deleted shortly, so not bothering to make
-          // work
-      };
-
-     private:
-      yarpl::Reference<yarpl::single::Single<Payload>> single_;
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSubscriber_;
-      std::atomic_bool subscribed_{false};
-    };
-
-    responseSubscriber->onSubscribe(
-        make_ref<BridgeSubscriptionToSingle>(
-            std::move(single), responseSubscriber));
+    single->subscribe(responseObserver);
   }
 
   void handleFireAndForgetRequest(
@@ -111,13 +71,15 @@ class RSocketHandlerBridge : public reactivesocket::DefaultRequestHandler {
 void RSocketConnectionHandler::setupNewSocket(
     std::shared_ptr<FrameTransport> frameTransport,
     ConnectionSetupPayload setupPayload) {
-  LOG(INFO) << "RSocketServer => received new setup payload";
+  VLOG(3) << "RSocketServer => received new setup payload";
 
   // FIXME(alexanderm): Handler should be tied to specific executor
   auto executor = folly::EventBaseManager::get()->getExistingEventBase();
 
   auto socketParams =
       SocketParameters(setupPayload.resumable, setupPayload.protocolVersion);
+  socketParams.compression = setupPayload.compression;
+  socketParams.honorsLease = setupPayload.honorsLease;
   std::shared_ptr<ConnectionSetupRequest> setupRequest =
       std::make_shared<ConnectionSetupRequest>(std::move(setupPayload));
   std::shared_ptr<RSocketResponder> requestHandler;
@@ -129,7 +91,7 @@ void RSocketConnectionHandler::setupNewSocket(
         folly::exception_wrapper{std::current_exception(), e});
     return;
   }
-  LOG(INFO) << "RSocketServer => received request handler";
+  VLOG(3) << "RSocketServer => received request handler";
 
   auto handlerBridge =
       std::make_shared<RSocketHandlerBridge>(std::move(requestHandler));
@@ -7,18 +7,90 @@
 
 #include <folly/ExceptionWrapper.h>
 
+#include <atomic>
+
 using namespace reactivesocket;
 using namespace folly;
 using namespace yarpl;
 
 namespace rsocket {
 
+namespace {
+/// Requests made as the connection closes, e.g. once a draining server is
+/// done, reach the ReactiveSocket after it closed.
+std::runtime_error closedError() {
+  return std::runtime_error("RSocket is closed");
+}
+}
+
+class RSocketRequester::SubmissionQueue
+    : public std::enable_shared_from_this<SubmissionQueue> {
+ public:
+  explicit SubmissionQueue(EventBase& eventBase) : eventBase_(eventBase) {}
+
+  ~SubmissionQueue() {
+    // only reachable once no drain is scheduled, so nothing is left to run
+    deleteNodes(head_.exchange(nullptr, std::memory_order_acquire));
+  }
+
+  void submit(folly::Function<void()> task) {
+    auto node = new Node{std::move(task), nullptr};
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!head_.compare_exchange_weak(
+        head, node, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the producer which observed the empty queue schedules the drain.
+    // Everything pushed before the drain swaps the list out rides along.
+    if (head == nullptr) {
+      eventBase_.runInEventBaseThread(
+          [self = shared_from_this()] { self->drain(); });
+    }
+  }
+
+ private:
+  struct Node {
+    folly::Function<void()> task;
+    Node* next;
+  };
+
+  void drain() {
+    auto node = head_.exchange(nullptr, std::memory_order_acquire);
+
+    // the list is LIFO, reverse it to run tasks in submission order
+    Node* fifo = nullptr;
+    while (node) {
+      auto next = node->next;
+      node->next = fifo;
+      fifo = node;
+      node = next;
+    }
+
+    while (fifo) {
+      std::unique_ptr<Node> current(fifo);
+      fifo = fifo->next;
+      current->task();
+    }
+  }
+
+  static void deleteNodes(Node* node) {
+    while (node) {
+      std::unique_ptr<Node> current(node);
+      node = node->next;
+    }
+  }
+
+  EventBase& eventBase_;
+  std::atomic<Node*> head_{nullptr};
+};
+
 std::shared_ptr<RSocketRequester> RSocketRequester::create(
     std::unique_ptr<ReactiveSocket> srs,
     EventBase& eventBase) {
   auto customDeleter = [&eventBase](RSocketRequester* pRequester) {
     eventBase.runImmediatelyOrRunInEventBaseThreadAndWait([&pRequester] {
-      LOG(INFO) << "RSocketRequester => destroy on EventBase";
+      VLOG(3) << "RSocketRequester => destroy on EventBase";
       delete pRequester;
     });
   };
@@ -31,98 +103,92 @@ std::shared_ptr<RSocketRequester> RSocketRequester::create(
 RSocketRequester::RSocketRequester(
     std::unique_ptr<ReactiveSocket> srs,
     EventBase& eventBase)
-    : reactiveSocket_(std::move(srs)), eventBase_(eventBase) {}
+    : reactiveSocket_(std::move(srs)),
+      eventBase_(eventBase),
+      submissionQueue_(std::make_shared<SubmissionQueue>(eventBase)) {}
 
 RSocketRequester::~RSocketRequester() {
-  LOG(INFO) << "RSocketRequester => destroy";
+  VLOG(3) << "RSocketRequester => destroy";
 }
 
 yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
 RSocketRequester::requestChannel(
     yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
-        requestStream) {
-  auto& eb = eventBase_;
-  auto srs = reactiveSocket_;
+        requestStream,
+    RequestDeadline deadline) {
   return yarpl::flowable::Flowables::fromPublisher<Payload>([
-    &eb,
+    queue = submissionQueue_,
     requestStream = std::move(requestStream),
-    srs = std::move(srs)
+    deadline,
+    srs = reactiveSocket_
   ](yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber) mutable {
-    eb.runInEventBaseThread([
+    queue->submit([
       requestStream = std::move(requestStream),
+      deadline,
       subscriber = std::move(subscriber),
       srs = std::move(srs)
     ]() mutable {
-      auto responseSink = srs->requestChannel(std::move(subscriber));
+      if (srs->isClosed()) {
+        yarpl::flowable::Flowables::error<Payload>(closedError())
+            ->subscribe(std::move(subscriber));
+        return;
+      }
+      auto responseSink =
+          srs->requestChannel(std::move(subscriber), deadline);
       requestStream->subscribe(std::move(responseSink));
     });
   });
 }
 
 yarpl::Reference<yarpl::flowable::Flowable<Payload>>
-RSocketRequester::requestStream(Payload request) {
+RSocketRequester::requestStream(Payload request, RequestDeadline deadline) {
   return yarpl::flowable::Flowables::fromPublisher<Payload>([
-    eb = &eventBase_,
+    queue = submissionQueue_,
     request = std::move(request),
+    deadline,
     srs = reactiveSocket_
   ](yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber) mutable {
-    eb->runInEventBaseThread([
+    queue->submit([
       request = std::move(request),
+      deadline,
       subscriber = std::move(subscriber),
       srs = std::move(srs)
-    ]() mutable { srs->requestStream(std::move(request), std::move(subscriber)); });
+    ]() mutable {
+      if (srs->isClosed()) {
+        yarpl::flowable::Flowables::error<Payload>(closedError())
+            ->subscribe(std::move(subscriber));
+        return;
+      }
+      srs->requestStream(std::move(request), std::move(subscriber), deadline);
+    });
   });
 }
 
 yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
-RSocketRequester::requestResponse(Payload request) {
-  // TODO bridge in use until SingleSubscriber is used internally
-  class SingleToSubscriberBridge : public yarpl::flowable::Subscriber<Payload> {
-   public:
-    SingleToSubscriberBridge(
-        yarpl::Reference<yarpl::single::SingleObserver<Payload>>
-            singleSubscriber)
-        : singleSubscriber_{std::move(singleSubscriber)} {}
-
-    void onSubscribe(
-        yarpl::Reference<yarpl::flowable::Subscription> subscription) noexcept override {
-      // register cancellation callback with SingleSubscriber
-      auto singleSubscription = yarpl::single::SingleSubscriptions::create(
-          [subscription] { subscription->cancel(); });
-
-      singleSubscriber_->onSubscribe(std::move(singleSubscription));
-
-      // kick off request (TODO this is not needed once we use the proper type)
-      subscription->request(1);
-    }
-    void onNext(Payload payload) noexcept override {
-      singleSubscriber_->onSuccess(std::move(payload));
-    }
-    void onComplete() noexcept override {
-      // ignore as we're done once we get a single value back
-    }
-    void onError(std::exception_ptr ex) noexcept override {
-      DLOG(ERROR) << folly::exceptionStr(ex);
-      singleSubscriber_->onError(std::move(ex));
-    }
-
-   private:
-    yarpl::Reference<yarpl::single::SingleObserver<Payload>> singleSubscriber_;
-  };
-
+RSocketRequester::requestResponse(
+    Payload request,
+    RequestDeadline deadline) {
   return yarpl::single::Single<Payload>::create(
-      [ eb = &eventBase_, request = std::move(request), srs = reactiveSocket_ ](
-          yarpl::Reference<yarpl::single::SingleObserver<Payload>>
-              subscriber) mutable {
-        eb->runInEventBaseThread([
+      [
+        queue = submissionQueue_,
+        request = std::move(request),
+        deadline,
+        srs = reactiveSocket_
+      ](yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+            subscriber) mutable {
+        queue->submit([
           request = std::move(request),
+          deadline,
           subscriber = std::move(subscriber),
           srs = std::move(srs)
         ]() mutable {
+          if (srs->isClosed()) {
+            yarpl::single::Singles::error<Payload>(closedError())
+                ->subscribe(std::move(subscriber));
+            return;
+          }
           srs->requestResponse(
-              std::move(request),
-              make_ref<SingleToSubscriberBridge>(
-                  std::move(subscriber)));
+              std::move(request), std::move(subscriber), deadline);
         });
       });
 }
@@ -130,15 +196,20 @@ RSocketRequester::requestResponse(Payload request) {
 yarpl::Reference<yarpl::single::Single<void>> RSocketRequester::fireAndForget(
     reactivesocket::Payload request) {
   return yarpl::single::Single<void>::create([
-    eb = &eventBase_,
+    queue = submissionQueue_,
     request = std::move(request),
     srs = reactiveSocket_
   ](yarpl::Reference<yarpl::single::SingleObserver<void>> subscriber) mutable {
-    eb->runInEventBaseThread([
+    queue->submit([
       request = std::move(request),
       subscriber = std::move(subscriber),
       srs = std::move(srs)
     ]() mutable {
+      if (srs->isClosed()) {
+        yarpl::single::Singles::error<void>(closedError())
+            ->subscribe(std::move(subscriber));
+        return;
+      }
       // TODO pass in SingleSubscriber for underlying layers to
       // call onSuccess/onError once put on network
       srs->requestFireAndForget(std::move(request));
@@ -149,9 +220,15 @@ yarpl::Reference<yarpl::single::Single<void>> RSocketRequester::fireAndForget(
 }
 
 void RSocketRequester::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
-  eventBase_.runInEventBaseThread(
-      [ this, metadata = std::move(metadata) ]() mutable {
-        reactiveSocket_->metadataPush(std::move(metadata));
+  submissionQueue_->submit(
+      [ srs = reactiveSocket_, metadata = std::move(metadata) ]() mutable {
+        if (!srs->isClosed()) {
+          srs->metadataPush(std::move(metadata));
+        }
       });
 }
+
+bool RSocketRequester::isPeerDraining() const {
+  return reactiveSocket_->isPeerDraining();
+}
 }
@@ -48,11 +48,24 @@ RSocketServer::RSocketServer(
 
 RSocketServer::~RSocketServer() {
   // Stop accepting new connections.
-  lazyAcceptor_->stop();
+  stopAccepting();
 
   // FIXME(alexanderm): This is where we /should/ close the FrameTransports
   // sitting around in the ServerConnectionAcceptor, but we can't yet...
 
+  closeSockets();
+
+  // All requests are fully finished, worker threads can be safely killed off.
+}
+
+void RSocketServer::stopAccepting() {
+  if (!acceptorStopped_) {
+    acceptorStopped_ = true;
+    lazyAcceptor_->stop();
+  }
+}
+
+void RSocketServer::closeSockets() {
   // Asynchronously close all existing ReactiveSockets.  If there are none, then
   // we can do an early exit.
   {
@@ -72,8 +85,6 @@ RSocketServer::~RSocketServer() {
   // Wait for all ReactiveSockets to close.
   shutdown_->wait();
   DCHECK(sockets_.lock()->empty());
-
-  // All requests are fully finished, worker threads can be safely killed off.
 }
 
 void RSocketServer::start(OnAccept onAccept) {
@@ -90,7 +101,7 @@ void RSocketServer::start(OnAccept onAccept) {
       ->start([this](
                   std::unique_ptr<DuplexConnection> conn,
                   folly::Executor& executor) {
-        LOG(INFO) << "Going to accept duplex connection";
+        VLOG(3) << "Going to accept duplex connection";
 
         // FIXME(alexanderm): This isn't thread safe
         acceptor_.accept(std::move(conn), connectionHandler_);
@@ -109,8 +120,57 @@ void RSocketServer::unpark() {
   waiting_.post();
 }
 
+void RSocketServer::drain(std::chrono::milliseconds timeout) {
+  stopAccepting();
+
+  // Each ReactiveSocket closes itself once its requests are done.
+  {
+    auto locked = sockets_.lock();
+    draining_ = true;
+    if (locked->empty()) {
+      return;
+    }
+
+    shutdown_.emplace();
+
+    for (auto& socket : *locked) {
+      drainSocket(socket.get());
+    }
+  }
+
+  if (shutdown_->timed_wait(std::chrono::steady_clock::now() + timeout)) {
+    return;
+  }
+
+  LOG(WARNING) << "Closing ReactiveSockets which did not drain in "
+               << timeout.count() << "ms";
+  closeSockets();
+}
+
 void RSocketServer::addSocket(std::unique_ptr<ReactiveSocket> socket) {
-  sockets_.lock()->insert(std::move(socket));
+  auto locked = sockets_.lock();
+  if (draining_) {
+    // the connection was set up while the acceptor was stopping
+    drainSocket(socket.get());
+  }
+  locked->insert(std::move(socket));
+}
+
+void RSocketServer::drainSocket(ReactiveSocket* socket) {
+  socket->executor().add([this, socket] {
+    // a socket which closed meanwhile may already be deleted by removeSocket,
+    // which runs on the same executor
+    {
+      std::unique_ptr<ReactiveSocket> ptr{socket};
+      auto locked = sockets_.lock();
+      auto found = locked->count(ptr) != 0;
+      ptr.release();
+      if (!found) {
+        return;
+      }
+    }
+    socket->drain();
+  });
 }
 
 void RSocketServer::removeSocket(ReactiveSocket* socket) {
@@ -124,7 +184,7 @@ void RSocketServer::removeSocket(ReactiveSocket* socket) {
 
   ptr.release();
 
-  LOG(INFO) << "Removed ReactiveSocket";
+  VLOG(3) << "Removed ReactiveSocket";
 
   if (shutdown_ && locked->empty()) {
     shutdown_->post();
@@ -0,0 +1,226 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/ResponseCache.h"
+
+#include <folly/Bits.h>
+#include <folly/Hash.h>
+#include <folly/io/IOBuf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace reactivesocket;
+
+namespace rsocket {
+
+namespace {
+uint64_t hashChain(const folly::IOBuf* buf) {
+  uint64_t hash = folly::hash::FNV_64_HASH_START;
+  if (buf) {
+    for (auto range : *buf) {
+      hash = folly::hash::fnv64_buf(range.data(), range.size(), hash);
+    }
+  }
+  return hash;
+}
+
+std::string toString(const folly::IOBuf* buf) {
+  std::string bytes;
+  if (buf) {
+    bytes.reserve(buf->computeChainDataLength());
+    for (auto range : *buf) {
+      bytes.append(reinterpret_cast<const char*>(range.data()), range.size());
+    }
+  }
+  return bytes;
+}
+
+bool equals(const folly::IOBuf* buf, const std::string& bytes) {
+  size_t offset = 0;
+  if (buf) {
+    for (auto range : *buf) {
+      if (range.size() > bytes.size() - offset ||
+          std::memcmp(range.data(), bytes.data() + offset, range.size())) {
+        return false;
+      }
+      offset += range.size();
+    }
+  }
+  return offset == bytes.size();
+}
+
+size_t capacityOf(const folly::IOBuf* buf) {
+  size_t capacity = 0;
+  if (buf) {
+    auto current = buf;
+    do {
+      capacity += current->capacity();
+      current = current->next();
+    } while (current != buf);
+  }
+  return capacity;
+}
+
+/// Copies the response when it is a small part of its buffers, so that the
+/// cache does not keep the rest of them alive.
+void compact(std::unique_ptr<folly::IOBuf>& buf) {
+  if (!buf) {
+    return;
+  }
+  const auto length = buf->computeChainDataLength();
+  if (capacityOf(buf.get()) <= 2 * length + 64) {
+    return;
+  }
+  auto copy = folly::IOBuf::create(length);
+  for (auto range : *buf) {
+    std::memcpy(copy->writableTail(), range.data(), range.size());
+    copy->append(range.size());
+  }
+  buf = std::move(copy);
+}
+}
+
+class ResponseCache::Shard {
+ public:
+  struct Entry {
+    uint64_t hash;
+    std::string data;
+    std::string metadata;
+    Payload response;
+    Clock::time_point expires;
+    size_t bytes;
+
+    bool matches(const Payload& request) const {
+      return equals(request.data.get(), data) &&
+          equals(request.metadata.get(), metadata);
+    }
+  };
+
+  using Entries = std::list<Entry>;
+
+  /// The list and map nodes of an entry.
+  static constexpr size_t kEntryOverhead =
+      sizeof(Entry) + 4 * sizeof(void*) + sizeof(uint64_t);
+
+  explicit Shard(size_t maxBytes) : maxBytes(maxBytes) {}
+
+  void erase(Entries::iterator entry) {
+    bytes -= entry->bytes;
+    index.erase(entry->hash);
+    entries.erase(entry);
+  }
+
+  const size_t maxBytes;
+  std::mutex mutex;
+  /// The most recently used first.
+  Entries entries;
+  std::unordered_map<uint64_t, Entries::iterator> index;
+  size_t bytes{0};
+};
+
+constexpr size_t ResponseCache::Shard::kEntryOverhead;
+
+ResponseCache::ResponseCache(Options options) : ttl_(options.ttl) {
+  const auto shards = folly::nextPowTwo(std::max<size_t>(options.shards, 1));
+  shards_.reserve(shards);
+  for (size_t i = 0; i < shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>(options.maxBytes / shards));
+  }
+}
+
+ResponseCache::ResponseCache() : ResponseCache(Options()) {}
+
+ResponseCache::~ResponseCache() = default;
+
+folly::Optional<Payload> ResponseCache::get(
+    const Payload& request,
+    Clock::time_point now) {
+  const auto key = hash(request);
+  auto& shard = shardOf(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      auto entry = it->second;
+      if (entry->expires <= now) {
+        shard.erase(entry);
+      } else if (entry->matches(request)) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry->response.clone();
+      }
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return folly::none;
+}
+
+void ResponseCache::put(
+    const Payload& request,
+    Payload response,
+    Clock::time_point now) {
+  const auto key = hash(request);
+  auto& shard = shardOf(key);
+
+  compact(response.data);
+  compact(response.metadata);
+  Shard::Entry entry{key,
+                     toString(request.data.get()),
+                     toString(request.metadata.get()),
+                     std::move(response),
+                     now + ttl_,
+                     0};
+  entry.bytes = Shard::kEntryOverhead + entry.data.size() +
+      entry.metadata.size() + capacityOf(entry.response.data.get()) +
+      capacityOf(entry.response.metadata.get());
+  if (entry.bytes > shard.maxBytes) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    shard.erase(it->second);
+  }
+  while (shard.bytes + entry.bytes > shard.maxBytes) {
+    shard.erase(std::prev(shard.entries.end()));
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  shard.bytes += entry.bytes;
+  shard.entries.push_front(std::move(entry));
+  shard.index[key] = shard.entries.begin();
+}
+
+size_t ResponseCache::bytes() const {
+  size_t bytes = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    bytes += shard->bytes;
+  }
+  return bytes;
+}
+
+size_t ResponseCache::size() const {
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    size += shard->entries.size();
+  }
+  return size;
+}
+
+uint64_t ResponseCache::hash(const Payload& request) {
+  return folly::hash::hash_128_to_64(
+      hashChain(request.data.get()), hashChain(request.metadata.get()));
+}
+
+ResponseCache::Shard& ResponseCache::shardOf(uint64_t hash) {
+  // the low bits pick the bucket of the index
+  return *shards_[(hash >> 32) & (shards_.size() - 1)];
+}
+}
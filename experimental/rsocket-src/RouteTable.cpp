@@ -0,0 +1,119 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/RouteTable.h"
+
+#include <folly/Bits.h>
+#include <folly/Hash.h>
+#include <folly/SpookyHashV2.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace rsocket {
+
+namespace {
+/// Seeds tried for a bucket before the table is grown.
+constexpr uint32_t kMaxSeed = 1 << 16;
+/// Average number of routes per bucket.
+constexpr size_t kBucketSize = 4;
+constexpr int kMaxGrowths = 8;
+}
+
+constexpr uint32_t RouteTable::kEmpty;
+
+RouteTable::RouteTable(std::vector<std::string> routes)
+    : routes_(std::move(routes)) {
+  std::unordered_set<folly::StringPiece, folly::StringPieceHash> unique;
+  std::vector<uint64_t> hashes;
+  hashes.reserve(routes_.size());
+  for (const auto& route : routes_) {
+    if (!unique.insert(route).second) {
+      throw std::invalid_argument("duplicate route " + route);
+    }
+    hashes.push_back(hash(route));
+  }
+
+  // a load factor of at most 0.8 keeps the search for seeds short
+  auto slots = folly::nextPowTwo(std::max<size_t>(routes_.size() * 5 / 4, 1));
+  for (int growths = 0; !build(hashes, slots); ++growths) {
+    // only routes with the same 64 bit hash get that far
+    if (growths == kMaxGrowths) {
+      throw std::runtime_error("cannot build a perfect hash of the routes");
+    }
+    slots *= 2;
+  }
+}
+
+folly::Optional<size_t> RouteTable::find(folly::StringPiece route) const {
+  const auto h = hash(route);
+  const auto index = slots_[slotHash(h, seeds_[h & bucketMask_]) & slotMask_];
+  if (index == kEmpty || routes_[index] != route) {
+    return folly::none;
+  }
+  return index;
+}
+
+uint64_t RouteTable::hash(folly::StringPiece route) {
+  return folly::hash::SpookyHashV2::Hash64(route.data(), route.size(), 0);
+}
+
+uint64_t RouteTable::slotHash(uint64_t hash, uint32_t seed) {
+  // the bucket is picked by the low bits
+  return folly::hash::hash_128_to_64(hash >> 32 | hash << 32, seed);
+}
+
+bool RouteTable::build(const std::vector<uint64_t>& hashes, size_t slots) {
+  const auto buckets =
+      folly::nextPowTwo(std::max<size_t>(hashes.size() / kBucketSize, 1));
+  bucketMask_ = buckets - 1;
+  slotMask_ = slots - 1;
+  seeds_.assign(buckets, 0);
+  slots_.assign(slots, kEmpty);
+
+  std::vector<std::vector<uint32_t>> routesOf(buckets);
+  for (uint32_t i = 0; i < hashes.size(); ++i) {
+    routesOf[hashes[i] & bucketMask_].push_back(i);
+  }
+  std::vector<uint32_t> order(buckets);
+  for (uint32_t i = 0; i < buckets; ++i) {
+    order[i] = i;
+  }
+  // the largest buckets are the hardest to place, place them first
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return routesOf[a].size() > routesOf[b].size();
+  });
+
+  std::vector<uint64_t> placed;
+  for (auto bucket : order) {
+    const auto& routes = routesOf[bucket];
+    if (routes.empty()) {
+      break;
+    }
+    bool found = false;
+    for (uint32_t seed = 0; seed < kMaxSeed && !found; ++seed) {
+      placed.clear();
+      found = true;
+      for (auto route : routes) {
+        const auto slot = slotHash(hashes[route], seed) & slotMask_;
+        if (slots_[slot] != kEmpty ||
+            std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+          found = false;
+          break;
+        }
+        placed.push_back(slot);
+      }
+      if (found) {
+        seeds_[bucket] = seed;
+        for (size_t i = 0; i < routes.size(); ++i) {
+          slots_[placed[i]] = routes[i];
+        }
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+}
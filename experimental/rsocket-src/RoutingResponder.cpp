@@ -0,0 +1,97 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/RoutingResponder.h"
+
+#include <glog/logging.h>
+
+#include "src/CompositeMetadata.h"
+
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace rsocket {
+
+namespace {
+std::vector<std::string> routeNames(const RoutingResponder::Routes& routes) {
+  std::vector<std::string> names;
+  names.reserve(routes.size());
+  for (const auto& route : routes) {
+    names.push_back(route.first);
+  }
+  return names;
+}
+}
+
+RoutingResponder::RoutingResponder(
+    Routes routes,
+    std::shared_ptr<RSocketResponder> fallback)
+    : table_(routeNames(routes)), fallback_(std::move(fallback)) {
+  responders_.reserve(routes.size());
+  for (auto& route : routes) {
+    responders_.push_back(std::move(route.second));
+  }
+}
+
+RSocketResponder* RoutingResponder::route(const Payload& request) const {
+  if (request.metadata) {
+    std::string scratch;
+    if (auto route = readRoute(*request.metadata, scratch)) {
+      if (auto index = table_.find(*route)) {
+        return responders_[*index].get();
+      }
+    }
+  }
+  return fallback_.get();
+}
+
+std::string RoutingResponder::describeRoute(const Payload& request) const {
+  std::string scratch;
+  if (request.metadata) {
+    if (auto route = readRoute(*request.metadata, scratch)) {
+      return route->str();
+    }
+  }
+  return "(none)";
+}
+
+Reference<single::Single<Payload>> RoutingResponder::handleRequestResponse(
+    Payload request,
+    StreamId streamId) {
+  if (auto responder = route(request)) {
+    return responder->handleRequestResponse(std::move(request), streamId);
+  }
+  return single::Singles::error<Payload>(
+      NoRouteException(describeRoute(request)));
+}
+
+Reference<flowable::Flowable<Payload>> RoutingResponder::handleRequestStream(
+    Payload request,
+    StreamId streamId) {
+  if (auto responder = route(request)) {
+    return responder->handleRequestStream(std::move(request), streamId);
+  }
+  return flowable::Flowables::error<Payload>(
+      NoRouteException(describeRoute(request)));
+}
+
+Reference<flowable::Flowable<Payload>> RoutingResponder::handleRequestChannel(
+    Payload request,
+    Reference<flowable::Flowable<Payload>> requestStream,
+    StreamId streamId) {
+  if (auto responder = route(request)) {
+    return responder->handleRequestChannel(
+        std::move(request), std::move(requestStream), streamId);
+  }
+  return flowable::Flowables::error<Payload>(
+      NoRouteException(describeRoute(request)));
+}
+
+void RoutingResponder::handleFireAndForget(Payload request, StreamId streamId) {
+  if (auto responder = route(request)) {
+    responder->handleFireAndForget(std::move(request), streamId);
+    return;
+  }
+  VLOG(1) << "dropping fire-and-forget without responder for route "
+          << describeRoute(request);
+}
+}
@@ -3,8 +3,11 @@
 #include "rsocket/transports/TcpConnectionAcceptor.h"
 
 #include <folly/ThreadName.h>
+#include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
+#include <unordered_map>
 
+#include "rsocket/transports/Tls.h"
 #include "src/framed/FramedDuplexConnection.h"
 #include "src/tcp/TcpDuplexConnection.h"
 
@@ -12,39 +15,131 @@ using namespace reactivesocket;
 
 namespace rsocket {
 
+namespace {
+
+/// Owns an accepted TLS connection until its handshake is done.
+class TlsHandshake : public folly::AsyncSSLSocket::HandshakeCB {
+ public:
+  using OnHandshake = std::function<void(folly::AsyncSocket::UniquePtr)>;
+  /// The handshakes in progress, by their address.
+  using Handshakes =
+      std::unordered_map<TlsHandshake*, std::unique_ptr<TlsHandshake>>;
+
+  /// Adds the handshake to the handshakes, which it removes itself from (and
+  /// so is destroyed) once it is done.
+  static void start(
+      folly::AsyncSSLSocket::UniquePtr socket,
+      OnHandshake onHandshake,
+      Handshakes& handshakes,
+      std::chrono::milliseconds timeout) {
+    auto handshake = new TlsHandshake(
+        std::move(socket), std::move(onHandshake), handshakes);
+    handshakes.emplace(handshake, std::unique_ptr<TlsHandshake>(handshake));
+    handshake->socket_->sslAccept(
+        handshake, static_cast<uint32_t>(timeout.count()));
+  }
+
+  ~TlsHandshake() {
+    // closing the socket fails a handshake in progress, which must not look
+    // for this in the handshakes anymore
+    handshakes_ = nullptr;
+    socket_.reset();
+  }
+
+  void handshakeSuc(folly::AsyncSSLSocket* socket) noexcept override {
+    VLOG(3) << "TLS session "
+            << (socket->getSSLSessionReused() ? "resumed" : "new") << ", kTLS "
+            << kernelTlsActive(*socket);
+    auto onHandshake = std::move(onHandshake_);
+    auto accepted = std::move(socket_);
+    forget();
+    onHandshake(std::move(accepted));
+  }
+
+  void handshakeErr(
+      folly::AsyncSSLSocket*,
+      const folly::AsyncSocketException& ex) noexcept override {
+    VLOG(2) << "TLS handshake failed: " << ex.what();
+    forget();
+  }
+
+ private:
+  TlsHandshake(
+      folly::AsyncSSLSocket::UniquePtr socket,
+      OnHandshake onHandshake,
+      Handshakes& handshakes)
+      : socket_(std::move(socket)),
+        onHandshake_(std::move(onHandshake)),
+        handshakes_(&handshakes) {}
+
+  /// Destroys this.
+  void forget() {
+    if (handshakes_) {
+      handshakes_->erase(this);
+    }
+  }
+
+  folly::AsyncSSLSocket::UniquePtr socket_;
+  OnHandshake onHandshake_;
+  Handshakes* handshakes_;
+};
+}
+
 class TcpConnectionAcceptor::SocketCallback
     : public folly::AsyncServerSocket::AcceptCallback {
  public:
-  explicit SocketCallback(std::function<void(
-                              std::unique_ptr<reactivesocket::DuplexConnection>,
-                              folly::EventBase&)>& onAccept)
-      : onAccept_{onAccept} {}
+  SocketCallback(
+      std::function<void(
+          std::unique_ptr<reactivesocket::DuplexConnection>,
+          folly::EventBase&)>& onAccept,
+      const Options& options)
+      : onAccept_{onAccept}, options_(options) {}
 
   void connectionAccepted(
       int fd,
       const folly::SocketAddress&) noexcept override {
-    LOG(INFO) << "Accepting TCP connection on FD " << fd;
-
-    folly::AsyncSocket::UniquePtr socket(
-        new folly::AsyncSocket(eventBase(), fd));
-
-    auto connection = std::make_unique<TcpDuplexConnection>(
-        std::move(socket), inlineExecutor());
-    auto framedConnection = std::make_unique<FramedDuplexConnection>(
-        std::move(connection), inlineExecutor());
+    VLOG(3) << "Accepting TCP connection on FD " << fd;
+
+    if (options_.sslContext) {
+      folly::AsyncSSLSocket::UniquePtr socket(new folly::AsyncSSLSocket(
+          options_.sslContext, eventBase(), fd, /* server */ true));
+      TlsHandshake::start(
+          std::move(socket),
+          [this](folly::AsyncSocket::UniquePtr socket) {
+            accepted(std::move(socket));
+          },
+          handshakes_,
+          options_.handshakeTimeout);
+      return;
+    }
 
-    onAccept_(std::move(framedConnection), *eventBase());
+    accepted(folly::AsyncSocket::UniquePtr(
+        new folly::AsyncSocket(eventBase(), fd)));
   }
 
   void acceptError(const std::exception& ex) noexcept override {
-    LOG(INFO) << "TCP error: " << ex.what();
+    VLOG(1) << "TCP error: " << ex.what();
   }
 
   folly::EventBase* eventBase() const {
     return thread_.getEventBase();
   }
 
+  /// Closes the connections still in their TLS handshake.
+  void stop() {
+    eventBase()->runInEventBaseThreadAndWait([this] { handshakes_.clear(); });
+  }
+
  private:
+  void accepted(folly::AsyncSocket::UniquePtr socket) {
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket), inlineExecutor());
+    auto framedConnection = std::make_unique<FramedDuplexConnection>(
+        std::move(connection), inlineExecutor());
+
+    onAccept_(std::move(framedConnection), *eventBase());
+  }
+
   /// The thread running this callback.
   folly::ScopedEventBaseThread thread_;
 
@@ -52,6 +147,13 @@ class TcpConnectionAcceptor::SocketCallback
   std::function<void(
       std::unique_ptr<reactivesocket::DuplexConnection>,
       folly::EventBase&)>& onAccept_;
+
+  /// Options of the ConnectionAcceptor.
+  const Options& options_;
+
+  /// Accepted TLS connections until their handshake is done.  Used on the
+  /// EventBase of the thread only.
+  TlsHandshake::Handshakes handshakes_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -76,13 +178,16 @@ folly::Future<folly::Unit> TcpConnectionAcceptor::start(
   }
 
   onAccept_ = std::move(acceptor);
+  if (options_.sslContext) {
+    enableSessionResumption(*options_.sslContext);
+  }
   serverThread_ = std::make_unique<folly::ScopedEventBaseThread>();
   serverThread_->getEventBase()->runInEventBaseThread(
       [] { folly::setThreadName("TcpConnectionAcceptor.Listener"); });
 
   callbacks_.reserve(options_.threads);
   for (size_t i = 0; i < options_.threads; ++i) {
-    callbacks_.push_back(std::make_unique<SocketCallback>(onAccept_));
+    callbacks_.push_back(std::make_unique<SocketCallback>(onAccept_, options_));
     callbacks_[i]->eventBase()->runInEventBaseThread(
         [] { folly::setThreadName("TcpConnectionAcceptor.Worker"); });
   }
@@ -121,5 +226,10 @@ void TcpConnectionAcceptor::stop() {
   serverThread_->getEventBase()->runInEventBaseThread(
       [this] { serverSocket_.reset(); });
   serverThread_.reset();
+
+  // nothing is accepted anymore, the handshakes in progress can not complete
+  for (auto& callback : callbacks_) {
+    callback->stop();
+  }
 }
 }
@@ -2,6 +2,7 @@
 
 #include "rsocket/transports/TcpConnectionFactory.h"
 
+#include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <glog/logging.h>
@@ -17,8 +18,16 @@ namespace {
 
 class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
  public:
-  ConnectCallback(folly::SocketAddress address, OnConnect onConnect)
-      : address_(address), onConnect_{std::move(onConnect)} {
+  ConnectCallback(
+      folly::SocketAddress address,
+      OnConnect onConnect,
+      OnConnectError onConnectError,
+      std::shared_ptr<folly::SSLContext> sslContext,
+      TlsSessionCache& sessionCache)
+      : address_(address),
+        onConnect_{std::move(onConnect)},
+        onConnectError_{std::move(onConnectError)},
+        sessionCache_(sessionCache) {
     VLOG(2) << "Constructing ConnectCallback";
 
     // Set up by ScopedEventBaseThread.
@@ -26,7 +35,14 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
     DCHECK(evb);
 
     VLOG(3) << "Starting socket";
-    socket_.reset(new folly::AsyncSocket(evb));
+    if (sslContext) {
+      // connects and then does the handshake before connectSuccess()
+      sslSocket_ = new folly::AsyncSSLSocket(std::move(sslContext), evb);
+      sessionCache_.apply(*sslSocket_);
+      socket_.reset(sslSocket_);
+    } else {
+      socket_.reset(new folly::AsyncSocket(evb));
+    }
 
     VLOG(3) << "Attempting connection to " << address_;
 
@@ -44,6 +60,13 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
 
     VLOG(4) << "connectSuccess() on " << address_;
 
+    if (sslSocket_) {
+      sessionCache_.update(*sslSocket_);
+      VLOG(3) << "TLS session "
+              << (sslSocket_->getSSLSessionReused() ? "resumed" : "new")
+              << ", kTLS " << kernelTlsActive(*sslSocket_);
+    }
+
     auto connection = std::make_unique<TcpDuplexConnection>(
         std::move(socket_), *evb, Stats::noop());
     auto framedConnection =
@@ -56,28 +79,55 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
     std::unique_ptr<ConnectCallback> deleter(this);
 
     VLOG(4) << "connectErr(" << ex.what() << ") on " << address_;
+
+    if (onConnectError_) {
+      onConnectError_(
+          folly::make_exception_wrapper<folly::AsyncSocketException>(ex));
+    }
   }
 
  private:
   folly::SocketAddress address_;
   folly::AsyncSocket::UniquePtr socket_;
+  /// socket_ when it speaks TLS.
+  folly::AsyncSSLSocket* sslSocket_{nullptr};
   OnConnect onConnect_;
+  OnConnectError onConnectError_;
+  TlsSessionCache& sessionCache_;
 };
 
 } // namespace
 
-TcpConnectionFactory::TcpConnectionFactory(folly::SocketAddress address)
-    : address_{std::move(address)} {
+TcpConnectionFactory::TcpConnectionFactory(
+    folly::SocketAddress address,
+    std::shared_ptr<folly::SSLContext> sslContext)
+    : address_{std::move(address)}, sslContext_{std::move(sslContext)} {
   VLOG(1) << "Constructing TcpConnectionFactory";
 }
 
-void TcpConnectionFactory::connect(OnConnect cb) {
+void TcpConnectionFactory::connect(OnConnect cb, OnConnectError errorCb) {
   worker_.getEventBase()->runInEventBaseThread(
-      [ this, fn = std::move(cb) ]() mutable {
-        new ConnectCallback(address_, std::move(fn));
+      [ this, fn = std::move(cb), errorFn = std::move(errorCb) ]() mutable {
+        new ConnectCallback(
+            address_,
+            std::move(fn),
+            std::move(errorFn),
+            sslContext_,
+            sessionCache_);
       });
 }
 
+folly::EventBase* TcpConnectionFactory::getEventBase() {
+  return worker_.getEventBase();
+}
+
+size_t TcpConnectionFactory::resumedTlsSessions() {
+  size_t resumed = 0;
+  worker_.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { resumed = sessionCache_.resumed(); });
+  return resumed;
+}
+
 TcpConnectionFactory::~TcpConnectionFactory() {
   VLOG(1) << "Destroying TcpConnectionFactory";
 }
@@ -0,0 +1,55 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "rsocket/transports/Tls.h"
+
+#include <glog/logging.h>
+#include <openssl/ssl.h>
+
+namespace rsocket {
+
+bool enableKernelTls(folly::SSLContext& context) {
+#ifdef SSL_OP_ENABLE_KTLS
+  SSL_CTX_set_options(context.getSSLCtx(), SSL_OP_ENABLE_KTLS);
+  return true;
+#else
+  LOG(WARNING) << "OpenSSL was built without kTLS, encrypting in user space";
+  return false;
+#endif
+}
+
+bool kernelTlsActive(const folly::AsyncSSLSocket& socket) {
+#ifdef SSL_OP_ENABLE_KTLS
+  auto ssl = socket.getSSL();
+  return ssl && BIO_get_ktls_send(SSL_get_wbio(ssl));
+#else
+  return false;
+#endif
+}
+
+void enableSessionResumption(folly::SSLContext& serverContext) {
+  static const unsigned char kSessionIdContext[] = "rsocket";
+  auto ctx = serverContext.getSSLCtx();
+  // sessions of the cache are only resumed in the same id context
+  SSL_CTX_set_session_id_context(
+      ctx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+  // tickets, keyed by the context, resume without the server cache
+  SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+}
+
+void TlsSessionCache::update(folly::AsyncSSLSocket& socket) {
+  if (socket.getSSLSessionReused()) {
+    ++resumed_;
+  }
+  if (auto session = socket.getSSLSession()) {
+    // getSSLSession() took a reference for us
+    session_.reset(session, SSL_SESSION_free);
+  }
+}
+
+void TlsSessionCache::apply(folly::AsyncSSLSocket& socket) const {
+  if (session_) {
+    socket.setSSLSession(session_.get(), /*takeOwnership=*/false);
+  }
+}
+}
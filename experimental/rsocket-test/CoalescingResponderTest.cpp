@@ -0,0 +1,284 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "rsocket/CoalescingResponder.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace {
+
+class FakeSingleSubscription : public single::SingleSubscription {
+ public:
+  void cancel() override {
+    cancelled = true;
+  }
+
+  bool cancelled{false};
+};
+
+class FakeSubscription : public flowable::Subscription {
+ public:
+  void request(int64_t n) override {
+    requested += n;
+  }
+
+  void cancel() override {
+    cancelled = true;
+    release();
+  }
+
+  int64_t requested{0};
+  bool cancelled{false};
+};
+
+/// Holds on to the requests so that the test can answer them.
+class FakeResponder : public RSocketResponder {
+ public:
+  Reference<single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    ++calls;
+    return single::Single<Payload>::create(
+        [this](Reference<single::SingleObserver<Payload>> observer) {
+          auto subscription = make_ref<FakeSingleSubscription>();
+          observer->onSubscribe(subscription);
+          observers.push_back(std::move(observer));
+          singleSubscriptions.push_back(std::move(subscription));
+        });
+  }
+
+  Reference<flowable::Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    ++calls;
+    return flowable::Flowables::fromPublisher<Payload>(
+        [this](Reference<flowable::Subscriber<Payload>> subscriber) {
+          auto subscription = make_ref<FakeSubscription>();
+          subscriber->onSubscribe(subscription);
+          subscribers.push_back(std::move(subscriber));
+          subscriptions.push_back(std::move(subscription));
+        });
+  }
+
+  int calls{0};
+  std::vector<Reference<single::SingleObserver<Payload>>> observers;
+  std::vector<Reference<FakeSingleSubscription>> singleSubscriptions;
+  std::vector<Reference<flowable::Subscriber<Payload>>> subscribers;
+  std::vector<Reference<FakeSubscription>> subscriptions;
+};
+
+class CollectingObserver : public single::SingleObserver<Payload> {
+ public:
+  void onSuccess(Payload response) override {
+    responses.push_back(response.moveDataToString());
+    single::SingleObserver<Payload>::onSuccess(Payload());
+  }
+
+  void onError(std::exception_ptr ex) override {
+    ++errors;
+    single::SingleObserver<Payload>::onError(ex);
+  }
+
+  void cancel() {
+    subscription()->cancel();
+  }
+
+  std::vector<std::string> responses;
+  int errors{0};
+};
+
+class CollectingSubscriber : public flowable::Subscriber<Payload> {
+ public:
+  void onNext(Payload item) override {
+    items.push_back(item.moveDataToString());
+  }
+
+  void onComplete() override {
+    completed = true;
+    flowable::Subscriber<Payload>::onComplete();
+  }
+
+  void request(int64_t n) {
+    subscription()->request(n);
+  }
+
+  void cancel() {
+    subscription()->cancel();
+  }
+
+  std::vector<std::string> items;
+  bool completed{false};
+};
+
+folly::Optional<uint64_t> keyByData(const Payload& request) {
+  auto data = request.cloneDataToString();
+  if (data.empty()) {
+    return folly::none;
+  }
+  return std::hash<std::string>()(data);
+}
+
+struct CoalescingResponderTest : public testing::Test {
+  std::shared_ptr<FakeResponder> upstream{std::make_shared<FakeResponder>()};
+  CoalescingResponder responder{upstream, keyByData};
+};
+}
+
+TEST_F(CoalescingResponderTest, RequestResponseSharesTheCall) {
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  auto other = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("a"), 3)->subscribe(second);
+  responder.handleRequestResponse(Payload("b"), 5)->subscribe(other);
+
+  ASSERT_EQ(2, upstream->calls);
+  EXPECT_EQ(2u, responder.upstreamCalls());
+  EXPECT_EQ(1u, responder.coalescedRequests());
+
+  upstream->observers[0]->onSuccess(Payload("response"));
+  EXPECT_EQ(std::vector<std::string>{"response"}, first->responses);
+  EXPECT_EQ(std::vector<std::string>{"response"}, second->responses);
+  EXPECT_TRUE(other->responses.empty());
+
+  // the call is over, the next request makes a new one
+  auto late = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 7)->subscribe(late);
+  EXPECT_EQ(3, upstream->calls);
+}
+
+TEST_F(CoalescingResponderTest, RequestResponseErrorIsShared) {
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("a"), 3)->subscribe(second);
+
+  upstream->observers[0]->onError(
+      std::make_exception_ptr(std::runtime_error("failed")));
+  EXPECT_EQ(1, first->errors);
+  EXPECT_EQ(1, second->errors);
+}
+
+TEST_F(CoalescingResponderTest, RequestsWithoutKeyPassThrough) {
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload(), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload(), 3)->subscribe(second);
+
+  EXPECT_EQ(2, upstream->calls);
+  EXPECT_EQ(0u, responder.upstreamCalls());
+  EXPECT_EQ(0u, responder.coalescedRequests());
+}
+
+TEST_F(CoalescingResponderTest, CancelLeavesTheCallToTheOthers) {
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("a"), 3)->subscribe(second);
+
+  first->cancel();
+  EXPECT_FALSE(upstream->singleSubscriptions[0]->cancelled);
+
+  upstream->observers[0]->onSuccess(Payload("response"));
+  EXPECT_TRUE(first->responses.empty());
+  EXPECT_EQ(std::vector<std::string>{"response"}, second->responses);
+}
+
+TEST_F(CoalescingResponderTest, LastCancelCancelsTheCall) {
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("a"), 3)->subscribe(second);
+
+  first->cancel();
+  second->cancel();
+  EXPECT_TRUE(upstream->singleSubscriptions[0]->cancelled);
+
+  auto late = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 5)->subscribe(late);
+  EXPECT_EQ(2, upstream->calls);
+}
+
+TEST_F(CoalescingResponderTest, StreamIsPacedByTheSlowestSubscriber) {
+  auto fast = make_ref<CollectingSubscriber>();
+  auto slow = make_ref<CollectingSubscriber>();
+  responder.handleRequestStream(Payload("a"), 1)->subscribe(fast);
+  responder.handleRequestStream(Payload("a"), 3)->subscribe(slow);
+  ASSERT_EQ(1, upstream->calls);
+
+  fast->request(10);
+  EXPECT_EQ(0, upstream->subscriptions[0]->requested);
+  slow->request(2);
+  EXPECT_EQ(2, upstream->subscriptions[0]->requested);
+
+  upstream->subscribers[0]->onNext(Payload("1"));
+  upstream->subscribers[0]->onNext(Payload("2"));
+  EXPECT_EQ((std::vector<std::string>{"1", "2"}), fast->items);
+  EXPECT_EQ((std::vector<std::string>{"1", "2"}), slow->items);
+
+  // the fast subscriber is paced by the slow one until it leaves
+  slow->cancel();
+  EXPECT_EQ(10, upstream->subscriptions[0]->requested);
+  EXPECT_FALSE(upstream->subscriptions[0]->cancelled);
+
+  upstream->subscribers[0]->onNext(Payload("3"));
+  upstream->subscribers[0]->onComplete();
+  EXPECT_EQ((std::vector<std::string>{"1", "2", "3"}), fast->items);
+  EXPECT_TRUE(fast->completed);
+  EXPECT_FALSE(slow->completed);
+}
+
+TEST_F(CoalescingResponderTest, StreamIsNotJoinedAfterTheFirstItem) {
+  auto first = make_ref<CollectingSubscriber>();
+  responder.handleRequestStream(Payload("a"), 1)->subscribe(first);
+  first->request(1);
+  upstream->subscribers[0]->onNext(Payload("1"));
+
+  auto late = make_ref<CollectingSubscriber>();
+  responder.handleRequestStream(Payload("a"), 3)->subscribe(late);
+  EXPECT_EQ(2, upstream->calls);
+  EXPECT_EQ(0u, responder.coalescedRequests());
+
+  late->cancel();
+  EXPECT_TRUE(upstream->subscriptions[1]->cancelled);
+  EXPECT_FALSE(upstream->subscriptions[0]->cancelled);
+  first->cancel();
+}
+
+TEST_F(CoalescingResponderTest, LateSubscriberGetsOnlyWhatItRequested) {
+  auto first = make_ref<CollectingSubscriber>();
+  responder.handleRequestStream(Payload("a"), 1)->subscribe(first);
+  first->request(3);
+  EXPECT_EQ(3, upstream->subscriptions[0]->requested);
+
+  // joins after the upstream was asked for items, before any was emitted
+  auto late = make_ref<CollectingSubscriber>();
+  responder.handleRequestStream(Payload("a"), 3)->subscribe(late);
+  ASSERT_EQ(1, upstream->calls);
+
+  upstream->subscribers[0]->onNext(Payload("1"));
+  upstream->subscribers[0]->onNext(Payload("2"));
+  EXPECT_EQ((std::vector<std::string>{"1", "2"}), first->items);
+  EXPECT_TRUE(late->items.empty());
+
+  late->request(1);
+  EXPECT_EQ(std::vector<std::string>{"1"}, late->items);
+  EXPECT_EQ(3, upstream->subscriptions[0]->requested);
+
+  // the completion waits for the items the late subscriber has not taken
+  upstream->subscribers[0]->onNext(Payload("3"));
+  upstream->subscribers[0]->onComplete();
+  EXPECT_TRUE(first->completed);
+  EXPECT_EQ(std::vector<std::string>{"1"}, late->items);
+  EXPECT_FALSE(late->completed);
+
+  late->request(2);
+  EXPECT_EQ((std::vector<std::string>{"1", "2", "3"}), late->items);
+  EXPECT_TRUE(late->completed);
+}
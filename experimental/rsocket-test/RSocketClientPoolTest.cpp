@@ -0,0 +1,259 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Baton.h>
+#include <folly/ExceptionString.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/RSocketClientPool.h"
+#include "src/CounterStats.h"
+#include "src/NullRequestHandler.h"
+#include "src/ReactiveSocket.h"
+#include "test/InlineConnection.h"
+#include "yarpl/single/SingleObservers.h"
+#include "yarpl/single/SingleSubscriptions.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace {
+
+/// Answers every request/response with the name of its server, and counts
+/// the clients which offered compression at SETUP.
+class NamedRequestHandler : public NullRequestHandler {
+ public:
+  NamedRequestHandler(std::string name, std::atomic<int>& offeredCompression)
+      : name_(std::move(name)), offeredCompression_(offeredCompression) {}
+
+  std::shared_ptr<StreamState> handleSetupPayload(
+      ReactiveSocket&,
+      ConnectionSetupPayload setupPayload) noexcept override {
+    if (!setupPayload.compression.codecs.empty()) {
+      ++offeredCompression_;
+    }
+    return nullptr;
+  }
+
+  void handleRequestResponse(
+      Payload,
+      StreamId,
+      const Reference<single::SingleObserver<Payload>>& response) noexcept
+      override {
+    response->onSubscribe(single::SingleSubscriptions::empty());
+    response->onSuccess(Payload(name_));
+  }
+
+ private:
+  const std::string name_;
+  std::atomic<int>& offeredCompression_;
+};
+
+/// Connects to an in-process server over an InlineConnection, after failing
+/// as many attempts as it is told to.
+class FakeConnectionFactory : public ConnectionFactory {
+ public:
+  explicit FakeConnectionFactory(std::string name) : name_(std::move(name)) {}
+
+  ~FakeConnectionFactory() {
+    worker_.getEventBase()->runInEventBaseThreadAndWait(
+        [this] { servers_.clear(); });
+  }
+
+  void connect(OnConnect onConnect, OnConnectError onConnectError) override {
+    worker_.getEventBase()->runInEventBaseThread([
+      this,
+      onConnect = std::move(onConnect),
+      onConnectError = std::move(onConnectError)
+    ] {
+      ++attempts;
+      if (failures > 0) {
+        --failures;
+        onConnectError(
+            folly::make_exception_wrapper<std::runtime_error>("refused"));
+        return;
+      }
+
+      auto& eventBase = *worker_.getEventBase();
+      auto clientConn = std::make_unique<InlineConnection>();
+      auto serverConn = std::make_unique<InlineConnection>();
+      clientConn->connectTo(*serverConn);
+      servers_.push_back(ReactiveSocket::fromServerConnection(
+          eventBase,
+          std::move(serverConn),
+          std::make_unique<NamedRequestHandler>(name_, offeredCompression)));
+      onConnect(std::move(clientConn), eventBase);
+    });
+  }
+
+  folly::EventBase* getEventBase() override {
+    return worker_.getEventBase();
+  }
+
+  /// Closes the server end of every connection made so far.
+  void closeConnections() {
+    worker_.getEventBase()->runInEventBaseThreadAndWait([this] {
+      for (auto& server : servers_) {
+        if (!server->isClosed()) {
+          server->close();
+        }
+      }
+    });
+  }
+
+  std::atomic<int> failures{0};
+  std::atomic<int> attempts{0};
+  std::atomic<int> offeredCompression{0};
+
+ private:
+  const std::string name_;
+  std::vector<std::unique_ptr<ReactiveSocket>> servers_;
+  folly::ScopedEventBaseThread worker_;
+};
+
+template <typename Condition>
+bool eventually(Condition condition) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+/// The name of the server which answered, or the error.
+std::string requestResponse(RSocketClientPool& pool) {
+  folly::Baton<> done;
+  std::string result;
+  pool.requestResponse(Payload("hello"))
+      ->subscribe(single::SingleObservers::create<Payload>(
+          [&](Payload response) {
+            result = response.moveDataToString();
+            done.post();
+          },
+          [&](std::exception_ptr ex) {
+            result = folly::exceptionStr(ex).toStdString();
+            done.post();
+          }));
+  done.wait();
+  return result;
+}
+
+struct Pool {
+  explicit Pool(
+      std::vector<std::string> names,
+      std::shared_ptr<Stats> stats = Stats::noop(),
+      CompressionOptions compression = CompressionOptions()) {
+    std::vector<std::unique_ptr<ConnectionFactory>> factories;
+    for (auto& name : names) {
+      auto factory = std::make_unique<FakeConnectionFactory>(name);
+      members.push_back(factory.get());
+      factories.push_back(std::move(factory));
+    }
+    pool = std::make_unique<RSocketClientPool>(
+        std::move(factories),
+        std::move(stats),
+        std::move(compression),
+        std::chrono::milliseconds(1),
+        std::chrono::milliseconds(10));
+  }
+
+  std::vector<FakeConnectionFactory*> members;
+  std::unique_ptr<RSocketClientPool> pool;
+};
+
+} // namespace
+
+TEST(RSocketClientPoolTest, ConnectSkipsFailedMember) {
+  Pool p({"a", "b"});
+  p.members[1]->failures = 1000000;
+
+  p.pool->connect().get();
+  EXPECT_EQ(1u, p.pool->connectedCount());
+
+  // every request goes to the one member which is up
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ("a", requestResponse(*p.pool));
+  }
+
+  // while the other one keeps being retried
+  EXPECT_TRUE(eventually([&] { return p.members[1]->attempts > 2; }));
+}
+
+TEST(RSocketClientPoolTest, ConnectFailsWhenNoMemberConnects) {
+  Pool p({"a"});
+  p.members[0]->failures = 1;
+
+  EXPECT_THROW(p.pool->connect().get(), std::runtime_error);
+
+  // the failed member is retried after the backoff
+  EXPECT_TRUE(eventually([&] { return p.pool->connectedCount() == 1; }));
+  EXPECT_EQ(2, p.members[0]->attempts);
+  EXPECT_EQ("a", requestResponse(*p.pool));
+}
+
+TEST(RSocketClientPoolTest, ReconnectsClosedMember) {
+  Pool p({"a", "b"});
+  p.pool->connect().get();
+  EXPECT_EQ(2u, p.pool->connectedCount());
+
+  // the replacement connection fails a few times before it is back
+  p.members[0]->failures = 3;
+  p.members[0]->closeConnections();
+
+  EXPECT_TRUE(eventually([&] { return p.pool->connectedCount() == 2; }));
+  EXPECT_EQ(5, p.members[0]->attempts);
+  EXPECT_EQ(1, p.members[1]->attempts);
+}
+
+TEST(RSocketClientPoolTest, SelectsAroundClosedMember) {
+  Pool p({"a", "b"});
+  p.pool->connect().get();
+
+  p.members[1]->failures = 1000000;
+  p.members[1]->closeConnections();
+  EXPECT_TRUE(eventually([&] { return p.pool->connectedCount() == 1; }));
+
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ("a", requestResponse(*p.pool));
+  }
+}
+
+TEST(RSocketClientPoolTest, ConnectionsReportToTheStats) {
+  auto stats = std::make_shared<CounterStats>();
+  Pool p({"a", "b"}, stats);
+  p.pool->connect().get();
+
+  auto name = requestResponse(*p.pool);
+  EXPECT_TRUE(name == "a" || name == "b") << name;
+  auto snapshot = stats->snapshot();
+  EXPECT_EQ(2u, snapshot.socketsCreated);
+  EXPECT_EQ(
+      1u,
+      snapshot.framesWritten[static_cast<size_t>(FrameType::REQUEST_RESPONSE)]);
+}
+
+TEST(RSocketClientPoolTest, ConnectionsOfferCompression) {
+  auto codec = PayloadCompression::choose(
+      {CompressionCodec::ZSTD, CompressionCodec::LZ4});
+  if (codec == CompressionCodec::NONE) {
+    return;
+  }
+  CompressionOptions compression;
+  compression.codecs = {codec};
+  Pool p({"a", "b"}, Stats::noop(), compression);
+  p.pool->connect().get();
+
+  EXPECT_EQ(1, p.members[0]->offeredCompression);
+  EXPECT_EQ(1, p.members[1]->offeredCompression);
+  auto name = requestResponse(*p.pool);
+  EXPECT_TRUE(name == "a" || name == "b") << name;
+}
@@ -0,0 +1,128 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Baton.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/RSocketRequester.h"
+#include "src/NullRequestHandler.h"
+#include "src/ReactiveSocket.h"
+#include "test/InlineConnection.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+
+namespace {
+
+/// Records the metadata pushes in the order the server receives them, which
+/// over an InlineConnection is the order the requester dispatched them in.
+/// The first push is held until the test lets it go, which keeps the drain
+/// it is part of in progress.
+class RecordingRequestHandler : public NullRequestHandler {
+ public:
+  void handleMetadataPush(
+      std::unique_ptr<folly::IOBuf> metadata) noexcept override {
+    auto push = metadata->moveToFbString().toStdString();
+    if (push == "hold") {
+      holding.post();
+      EXPECT_TRUE(released.timed_wait(std::chrono::seconds(5)));
+      return;
+    }
+    received.push_back(std::move(push));
+    ++count;
+  }
+
+  folly::Baton<> holding;
+  folly::Baton<> released;
+  /// Written on the EventBase, read once count says it is complete.
+  std::vector<std::string> received;
+  std::atomic<size_t> count{0};
+};
+
+template <typename Condition>
+bool eventually(Condition condition) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(RSocketRequesterTest, SubmissionsFromSeveralThreads) {
+  constexpr size_t kThreads = 8;
+  constexpr size_t kPushesPerThread = 2000;
+
+  folly::ScopedEventBaseThread worker;
+  auto& eventBase = *worker.getEventBase();
+
+  auto handler = std::make_unique<RecordingRequestHandler>();
+  auto& recorder = *handler;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  std::shared_ptr<RSocketRequester> requester;
+  eventBase.runInEventBaseThreadAndWait([&] {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(handler));
+    requester = RSocketRequester::create(
+        ReactiveSocket::fromClientConnection(
+            eventBase,
+            std::move(clientConn),
+            std::make_unique<NullRequestHandler>()),
+        eventBase);
+  });
+
+  // a drain is in progress from here until the push is released
+  requester->metadataPush(folly::IOBuf::copyBuffer("hold"));
+  ASSERT_TRUE(recorder.holding.timed_wait(std::chrono::seconds(5)));
+
+  std::atomic<size_t> submitted{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < kPushesPerThread; ++i) {
+        requester->metadataPush(
+            folly::IOBuf::copyBuffer(folly::to<std::string>(t, ":", i)));
+        ++submitted;
+      }
+    });
+  }
+
+  // half of the pushes race with the drain, the rest follow it
+  ASSERT_TRUE(eventually(
+      [&] { return submitted >= kThreads * kPushesPerThread / 2; }));
+  recorder.released.post();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // every push is dispatched, in the order of its thread
+  EXPECT_TRUE(eventually(
+      [&] { return recorder.count == kThreads * kPushesPerThread; }));
+  std::map<size_t, size_t> next;
+  for (const auto& push : recorder.received) {
+    size_t thread;
+    size_t index;
+    ASSERT_TRUE(folly::split(':', push, thread, index));
+    EXPECT_EQ(next[thread]++, index) << "thread " << thread;
+  }
+  EXPECT_EQ(kThreads, next.size());
+
+  requester.reset();
+  eventBase.runInEventBaseThreadAndWait([&] { serverSock.reset(); });
+}
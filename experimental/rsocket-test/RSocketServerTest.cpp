@@ -0,0 +1,323 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <folly/Baton.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/RSocket.h"
+#include "src/Common.h"
+#include "test/InlineConnection.h"
+#include "yarpl/single/SingleObservers.h"
+#include "yarpl/single/SingleSubscriptions.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace {
+
+/// Connects clients and the server over InlineConnections, all of which live
+/// on one EventBase.
+class InlineNetwork {
+ public:
+  folly::EventBase& eventBase() {
+    return *worker_.getEventBase();
+  }
+
+  void listen(OnDuplexConnectionAccept onAccept) {
+    eventBase().runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&] { onAccept_ = std::move(onAccept); });
+  }
+
+  void stop() {
+    eventBase().runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&] { stopped_ = true; });
+  }
+
+  /// Hands the server end of a new connection to the server and returns the
+  /// client end, or nullptr when the server does not listen.  A connection
+  /// racing with stop() is accepted regardless.  Called on the EventBase.
+  std::unique_ptr<DuplexConnection> connect(bool racingStop) {
+    if (!onAccept_ || (stopped_ && !racingStop)) {
+      return nullptr;
+    }
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+    onAccept_(std::move(serverConn), eventBase());
+    return std::move(clientConn);
+  }
+
+ private:
+  OnDuplexConnectionAccept onAccept_;
+  bool stopped_{false};
+  folly::ScopedEventBaseThread worker_;
+};
+
+class InlineConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  explicit InlineConnectionAcceptor(std::shared_ptr<InlineNetwork> network)
+      : network_(std::move(network)) {}
+
+  folly::Future<folly::Unit> start(OnDuplexConnectionAccept onAccept) override {
+    network_->listen(std::move(onAccept));
+    return folly::makeFuture();
+  }
+
+  void stop() override {
+    network_->stop();
+  }
+
+ private:
+  const std::shared_ptr<InlineNetwork> network_;
+};
+
+class InlineConnectionFactory : public ConnectionFactory {
+ public:
+  explicit InlineConnectionFactory(
+      std::shared_ptr<InlineNetwork> network,
+      bool racingStop = false)
+      : network_(std::move(network)), racingStop_(racingStop) {}
+
+  void connect(OnConnect onConnect, OnConnectError onConnectError) override {
+    network_->eventBase().runInEventBaseThread([
+      network = network_,
+      racingStop = racingStop_,
+      onConnect = std::move(onConnect),
+      onConnectError = std::move(onConnectError)
+    ] {
+      auto connection = network->connect(racingStop);
+      if (!connection) {
+        onConnectError(folly::make_exception_wrapper<std::runtime_error>(
+            "connection refused"));
+        return;
+      }
+      onConnect(std::move(connection), network->eventBase());
+    });
+  }
+
+  folly::EventBase* getEventBase() override {
+    return &network_->eventBase();
+  }
+
+ private:
+  const std::shared_ptr<InlineNetwork> network_;
+  const bool racingStop_;
+};
+
+/// Answers every request/response a few milliseconds later.
+class DelayedResponder : public RSocketResponder {
+ public:
+  Reference<single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    return single::Single<Payload>::create(
+        [](Reference<single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(single::SingleSubscriptions::empty());
+          folly::EventBaseManager::get()->getExistingEventBase()->runAfterDelay(
+              [observer] { observer->onSuccess(Payload("response")); }, 2);
+        });
+  }
+};
+
+/// Holds on to every request/response until the test answers it.  Used on
+/// the EventBase only.
+class HoldingResponder : public RSocketResponder {
+ public:
+  Reference<single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    return single::Single<Payload>::create(
+        [this](Reference<single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(single::SingleSubscriptions::empty());
+          observers.push_back(std::move(observer));
+          ++held;
+        });
+  }
+
+  std::vector<Reference<single::SingleObserver<Payload>>> observers;
+  std::atomic<size_t> held{0};
+};
+
+template <typename Condition>
+bool eventually(Condition condition) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+/// Outcomes of requests, counted from whichever thread they complete on.
+struct Outcomes {
+  Reference<single::SingleObserver<Payload>> observer() {
+    ++issued;
+    return single::SingleObservers::create<Payload>(
+        [this](Payload) { ++succeeded; },
+        [this](std::exception_ptr ex) {
+          try {
+            std::rethrow_exception(ex);
+          } catch (const RejectedException&) {
+            ++rejected;
+          } catch (const std::runtime_error& e) {
+            // no pooled connection, or one which closed since it was picked
+            if (std::string(e.what()).find("RSocket") != std::string::npos) {
+              ++unavailable;
+            } else {
+              ++failed;
+            }
+          } catch (...) {
+            ++failed;
+          }
+        });
+  }
+
+  size_t completed() const {
+    return succeeded + rejected + unavailable + failed;
+  }
+
+  std::atomic<size_t> issued{0};
+  std::atomic<size_t> succeeded{0};
+  std::atomic<size_t> rejected{0};
+  std::atomic<size_t> unavailable{0};
+  std::atomic<size_t> failed{0};
+};
+
+} // namespace
+
+TEST(RSocketServerTest, DrainUnderLoadWithClientPool) {
+  auto network = std::make_shared<InlineNetwork>();
+  RSocketServer server(std::make_unique<InlineConnectionAcceptor>(network));
+  server.start([](std::shared_ptr<ConnectionSetupRequest>) {
+    return std::make_shared<DelayedResponder>();
+  });
+
+  std::vector<std::unique_ptr<ConnectionFactory>> factories;
+  for (int i = 0; i < 3; ++i) {
+    factories.push_back(std::make_unique<InlineConnectionFactory>(network));
+  }
+  RSocketClientPool pool(
+      std::move(factories),
+      Stats::noop(),
+      CompressionOptions(),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(10));
+  pool.connect().get();
+  ASSERT_EQ(3u, pool.connectedCount());
+
+  Outcomes outcomes;
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      while (!stop) {
+        pool.requestResponse(Payload("request"))
+            ->subscribe(outcomes.observer());
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+  }
+
+  EXPECT_TRUE(eventually([&] { return outcomes.succeeded > 100; }));
+
+  auto start = std::chrono::steady_clock::now();
+  server.drain(std::chrono::seconds(5));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  // the acceptor stopped, so the pool can not replace the connections
+  EXPECT_EQ(0u, pool.connectedCount());
+
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // every request terminated, none of them was cut off while in flight
+  EXPECT_TRUE(
+      eventually([&] { return outcomes.completed() == outcomes.issued; }));
+  EXPECT_EQ(0u, outcomes.failed);
+}
+
+TEST(RSocketServerTest, DrainTimesOut) {
+  auto network = std::make_shared<InlineNetwork>();
+  auto responder = std::make_shared<HoldingResponder>();
+  RSocketServer server(std::make_unique<InlineConnectionAcceptor>(network));
+  server.start([responder](std::shared_ptr<ConnectionSetupRequest>) {
+    return responder;
+  });
+
+  auto client = RSocket::createClient(
+      std::make_unique<InlineConnectionFactory>(network));
+  auto requester = client->connect().get();
+
+  Outcomes outcomes;
+  requester->requestResponse(Payload("request"))
+      ->subscribe(outcomes.observer());
+  ASSERT_TRUE(eventually([&] { return responder->held == 1; }));
+
+  auto start = std::chrono::steady_clock::now();
+  server.drain(std::chrono::milliseconds(50));
+  EXPECT_GE(
+      std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+  // the request was still in flight when the connection was closed
+  EXPECT_TRUE(eventually([&] { return outcomes.completed() == 1; }));
+  EXPECT_EQ(0u, outcomes.succeeded);
+  EXPECT_EQ(1u, outcomes.failed);
+
+  network->eventBase().runInEventBaseThreadAndWait(
+      [&] { responder->observers.clear(); });
+}
+
+TEST(RSocketServerTest, DrainsSocketAddedWhileDraining) {
+  auto network = std::make_shared<InlineNetwork>();
+  auto responder = std::make_shared<HoldingResponder>();
+  RSocketServer server(std::make_unique<InlineConnectionAcceptor>(network));
+  server.start([responder](std::shared_ptr<ConnectionSetupRequest>) {
+    return responder;
+  });
+
+  auto client = RSocket::createClient(
+      std::make_unique<InlineConnectionFactory>(network));
+  auto requester = client->connect().get();
+
+  Outcomes outcomes;
+  requester->requestResponse(Payload("request"))
+      ->subscribe(outcomes.observer());
+  ASSERT_TRUE(eventually([&] { return responder->held == 1; }));
+
+  std::atomic<bool> drained{false};
+  std::thread drainer([&] {
+    server.drain(std::chrono::seconds(5));
+    drained = true;
+  });
+  ASSERT_TRUE(eventually([&] { return requester->isPeerDraining(); }));
+
+  // a connection accepted just as the acceptor stopped is drained too
+  auto lateClient = RSocket::createClient(
+      std::make_unique<InlineConnectionFactory>(network, true));
+  auto lateRequester = lateClient->connect().get();
+  EXPECT_TRUE(eventually([&] { return lateRequester->isPeerDraining(); }));
+  EXPECT_FALSE(drained);
+
+  // the last request in flight ends the drain
+  auto start = std::chrono::steady_clock::now();
+  network->eventBase().runInEventBaseThreadAndWait([&] {
+    for (auto& observer : responder->observers) {
+      observer->onSuccess(Payload("response"));
+    }
+    responder->observers.clear();
+  });
+  drainer.join();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+  EXPECT_EQ(1u, outcomes.succeeded);
+}
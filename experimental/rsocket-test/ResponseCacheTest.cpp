@@ -0,0 +1,168 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/CachingResponder.h"
+#include "rsocket/ResponseCache.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace {
+
+using Clock = ResponseCache::Clock;
+
+ResponseCache::Options options(size_t maxBytes, size_t shards = 1) {
+  ResponseCache::Options options;
+  options.maxBytes = maxBytes;
+  options.ttl = std::chrono::seconds(10);
+  options.shards = shards;
+  return options;
+}
+
+/// Answers every request with its data, counting the calls.
+class EchoResponder : public RSocketResponder {
+ public:
+  Reference<single::Single<Payload>> handleRequestResponse(
+      Payload request,
+      StreamId) override {
+    ++calls;
+    auto data = request.moveDataToString();
+    if (data == "fail") {
+      return single::Singles::error<Payload>(std::runtime_error("failed"));
+    }
+    return single::Single<Payload>::create(
+        [data](Reference<single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(data));
+        });
+  }
+
+  int calls{0};
+};
+
+class CollectingObserver : public single::SingleObserver<Payload> {
+ public:
+  void onSuccess(Payload response) override {
+    responses.push_back(response.moveDataToString());
+    single::SingleObserver<Payload>::onSuccess(Payload());
+  }
+
+  void onError(std::exception_ptr ex) override {
+    ++errors;
+    single::SingleObserver<Payload>::onError(ex);
+  }
+
+  std::vector<std::string> responses;
+  int errors{0};
+};
+}
+
+TEST(ResponseCache, HitAndMiss) {
+  ResponseCache cache(options(1 << 20));
+  EXPECT_FALSE(cache.get(Payload("a")));
+  cache.put(Payload("a"), Payload("response"));
+
+  auto response = cache.get(Payload("a"));
+  ASSERT_TRUE(response);
+  EXPECT_EQ("response", response->moveDataToString());
+  EXPECT_FALSE(cache.get(Payload("a", "metadata")));
+  EXPECT_FALSE(cache.get(Payload("b")));
+  EXPECT_EQ(1u, cache.hits());
+  EXPECT_EQ(3u, cache.misses());
+}
+
+TEST(ResponseCache, KeyIsTheBytesOfTheRequest) {
+  ResponseCache cache(options(1 << 20));
+  // same bytes in a different chain
+  auto data = folly::IOBuf::copyBuffer("ab");
+  data->prependChain(folly::IOBuf::copyBuffer("cd"));
+  cache.put(Payload(std::move(data)), Payload("response"));
+  EXPECT_TRUE(cache.get(Payload("abcd")));
+  // the boundary between data and metadata matters
+  EXPECT_FALSE(cache.get(Payload("ab", "cd")));
+  EXPECT_NE(
+      ResponseCache::hash(Payload("ab", "cd")),
+      ResponseCache::hash(Payload("abcd")));
+}
+
+TEST(ResponseCache, ResponsesExpire) {
+  ResponseCache cache(options(1 << 20));
+  const auto now = Clock::now();
+  cache.put(Payload("a"), Payload("response"), now);
+  EXPECT_TRUE(cache.get(Payload("a"), now + std::chrono::seconds(9)));
+  EXPECT_FALSE(cache.get(Payload("a"), now + std::chrono::seconds(10)));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(ResponseCache, LeastRecentlyUsedAreEvicted) {
+  ResponseCache cache(options(1 << 20));
+  cache.put(Payload("a"), Payload(std::string(1000, 'x')));
+  const auto entryBytes = cache.bytes();
+
+  ResponseCache small(options(3 * entryBytes));
+  small.put(Payload("a"), Payload(std::string(1000, 'x')));
+  small.put(Payload("b"), Payload(std::string(1000, 'x')));
+  small.put(Payload("c"), Payload(std::string(1000, 'x')));
+  EXPECT_TRUE(small.get(Payload("a")));
+  small.put(Payload("d"), Payload(std::string(1000, 'x')));
+
+  EXPECT_EQ(1u, small.evictions());
+  EXPECT_LE(small.bytes(), 3 * entryBytes);
+  EXPECT_TRUE(small.get(Payload("a")));
+  EXPECT_FALSE(small.get(Payload("b")));
+  EXPECT_TRUE(small.get(Payload("d")));
+}
+
+TEST(ResponseCache, ResponsesLargerThanAShardAreNotCached) {
+  ResponseCache cache(options(1 << 20, 4));
+  cache.put(Payload("a"), Payload(std::string(1 << 19, 'x')));
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(ResponseCache, SlicedResponsesAreCompacted) {
+  ResponseCache cache(options(1 << 20));
+  auto buffer = folly::IOBuf::create(64 << 10);
+  buffer->append(64 << 10);
+  buffer->trimEnd((64 << 10) - 10);
+  cache.put(Payload("a"), Payload(std::move(buffer)));
+  EXPECT_LT(cache.bytes(), 1024u);
+}
+
+TEST(CachingResponder, AnswersFromTheCache) {
+  auto upstream = std::make_shared<EchoResponder>();
+  auto cache = std::make_shared<ResponseCache>(options(1 << 20));
+  CachingResponder responder(upstream, cache);
+
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("a"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("a"), 3)->subscribe(second);
+
+  EXPECT_EQ(1, upstream->calls);
+  EXPECT_EQ(std::vector<std::string>{"a"}, first->responses);
+  EXPECT_EQ(std::vector<std::string>{"a"}, second->responses);
+  EXPECT_EQ(1u, cache->hits());
+}
+
+TEST(CachingResponder, ErrorsAreNotCached) {
+  auto upstream = std::make_shared<EchoResponder>();
+  auto cache = std::make_shared<ResponseCache>(options(1 << 20));
+  CachingResponder responder(upstream, cache);
+
+  auto first = make_ref<CollectingObserver>();
+  auto second = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(Payload("fail"), 1)->subscribe(first);
+  responder.handleRequestResponse(Payload("fail"), 3)->subscribe(second);
+
+  EXPECT_EQ(2, upstream->calls);
+  EXPECT_EQ(1, first->errors);
+  EXPECT_EQ(1, second->errors);
+  EXPECT_EQ(0u, cache->size());
+}
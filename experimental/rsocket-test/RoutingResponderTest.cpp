@@ -0,0 +1,112 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "rsocket/RouteTable.h"
+#include "rsocket/RoutingResponder.h"
+#include "src/CompositeMetadata.h"
+
+using namespace rsocket;
+using namespace reactivesocket;
+using namespace yarpl;
+
+namespace {
+
+/// Answers every request with its name.
+class NamedResponder : public RSocketResponder {
+ public:
+  explicit NamedResponder(std::string name) : name_(std::move(name)) {}
+
+  Reference<single::Single<Payload>> handleRequestResponse(Payload, StreamId)
+      override {
+    return single::Single<Payload>::create(
+        [name = name_](Reference<single::SingleObserver<Payload>> observer) {
+          observer->onSubscribe(single::SingleSubscriptions::empty());
+          observer->onSuccess(Payload(name));
+        });
+  }
+
+ private:
+  const std::string name_;
+};
+
+class CollectingObserver : public single::SingleObserver<Payload> {
+ public:
+  void onSuccess(Payload response) override {
+    responses.push_back(response.moveDataToString());
+    single::SingleObserver<Payload>::onSuccess(Payload());
+  }
+
+  void onError(std::exception_ptr ex) override {
+    try {
+      std::rethrow_exception(ex);
+    } catch (const NoRouteException& e) {
+      errors.push_back(e.what());
+    }
+    single::SingleObserver<Payload>::onError(ex);
+  }
+
+  std::vector<std::string> responses;
+  std::vector<std::string> errors;
+};
+
+Payload routed(folly::StringPiece route) {
+  return Payload(
+      folly::IOBuf::copyBuffer("data"),
+      CompositeMetadataBuilder().addRoute({route}).build());
+}
+}
+
+TEST(RouteTable, FindsEveryRoute) {
+  for (size_t count : {0, 1, 2, 10, 1000, 10000}) {
+    std::vector<std::string> routes;
+    for (size_t i = 0; i < count; ++i) {
+      routes.push_back("service" + std::to_string(i) + ".method");
+    }
+    RouteTable table(routes);
+    EXPECT_EQ(count, table.size());
+    for (size_t i = 0; i < count; ++i) {
+      auto index = table.find(routes[i]);
+      ASSERT_TRUE(index) << routes[i];
+      EXPECT_EQ(i, *index);
+    }
+    EXPECT_FALSE(table.find("unknown"));
+    EXPECT_FALSE(table.find(""));
+  }
+}
+
+TEST(RouteTable, DuplicateRoutes) {
+  EXPECT_THROW(RouteTable({"a", "b", "a"}), std::invalid_argument);
+}
+
+TEST(RoutingResponder, DispatchesOnTheRoute) {
+  RoutingResponder responder(
+      {{"a", std::make_shared<NamedResponder>("a")},
+       {"b", std::make_shared<NamedResponder>("b")}});
+
+  auto observer = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(routed("b"), 1)->subscribe(observer);
+  responder.handleRequestResponse(routed("a"), 3)->subscribe(observer);
+  EXPECT_EQ((std::vector<std::string>{"b", "a"}), observer->responses);
+
+  responder.handleRequestResponse(routed("c"), 5)->subscribe(observer);
+  responder.handleRequestResponse(Payload("data"), 7)->subscribe(observer);
+  EXPECT_EQ(
+      (std::vector<std::string>{"no route c", "no route (none)"}),
+      observer->errors);
+}
+
+TEST(RoutingResponder, Fallback) {
+  RoutingResponder responder(
+      {{"a", std::make_shared<NamedResponder>("a")}},
+      std::make_shared<NamedResponder>("fallback"));
+
+  auto observer = make_ref<CollectingObserver>();
+  responder.handleRequestResponse(routed("c"), 1)->subscribe(observer);
+  responder.handleRequestResponse(Payload("data"), 3)->subscribe(observer);
+  EXPECT_EQ(
+      (std::vector<std::string>{"fallback", "fallback"}), observer->responses);
+}
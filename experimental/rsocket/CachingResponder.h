@@ -0,0 +1,54 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <memory>
+
+#include "rsocket/RSocketResponder.h"
+#include "rsocket/ResponseCache.h"
+
+namespace rsocket {
+
+/**
+ * Decorates an RSocketResponder so that request/responses are answered from
+ * a ResponseCache when it has a live response for the same request. The
+ * successful responses of the decorated responder are added to the cache,
+ * errors are not cached.
+ *
+ * The cache can be shared by the responders of all connections. The other
+ * interaction models are passed through.
+ */
+class CachingResponder : public RSocketResponder {
+ public:
+  CachingResponder(
+      std::shared_ptr<RSocketResponder> responder,
+      std::shared_ptr<ResponseCache> cache);
+
+  yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+  handleRequestResponse(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestStream(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestChannel(
+      reactivesocket::Payload request,
+      yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+          requestStream,
+      reactivesocket::StreamId streamId) override;
+
+  void handleFireAndForget(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+ private:
+  class Filler;
+
+  const std::shared_ptr<RSocketResponder> responder_;
+  const std::shared_ptr<ResponseCache> cache_;
+};
+}
@@ -0,0 +1,87 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <functional>
+#include <memory>
+
+#include "rsocket/RSocketResponder.h"
+
+namespace rsocket {
+
+/**
+ * Decorates an RSocketResponder so that identical requests in flight at the
+ * same time, on any connection, share a single call to it.
+ *
+ * Requests are identified by a key the application computes from the
+ * payload; equal keys must mean interchangeable responses. Requests for which
+ * the key function returns none are passed through.
+ *
+ * - A requestResponse joins the call in flight until the response arrives,
+ *   every waiter gets a clone of the response.
+ * - A requestStream joins the call in flight until the first item is
+ *   emitted, so that every subscriber sees the whole stream. The stream is
+ *   multicast and paced by the slowest subscriber: the decorated responder is
+ *   only asked for the items every subscriber has requested. No subscriber
+ *   gets more items than it requested, those emitted before it asked for
+ *   them are held for it.
+ *
+ * A waiter which cancels leaves the call to the others, the call is cancelled
+ * with the last waiter. Signals are delivered to every waiter on the
+ * EventBase it subscribed on, or inline when it subscribed outside of one.
+ * Channels and fire-and-forget requests are passed through.
+ */
+class CoalescingResponder : public RSocketResponder {
+ public:
+  using KeyFunction =
+      std::function<folly::Optional<uint64_t>(const reactivesocket::Payload&)>;
+
+  CoalescingResponder(
+      std::shared_ptr<RSocketResponder> responder,
+      KeyFunction key);
+  ~CoalescingResponder();
+
+  yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+  handleRequestResponse(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestStream(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestChannel(
+      reactivesocket::Payload request,
+      yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+          requestStream,
+      reactivesocket::StreamId streamId) override;
+
+  void handleFireAndForget(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  /**
+   * Calls made to the decorated responder.
+   */
+  uint64_t upstreamCalls() const;
+
+  /**
+   * Requests which joined a call in flight instead of making one.
+   */
+  uint64_t coalescedRequests() const;
+
+ private:
+  struct Calls;
+  class ResponseCall;
+  class StreamCall;
+
+  const std::shared_ptr<RSocketResponder> responder_;
+  const KeyFunction key_;
+  /// Shared with the calls in flight, which may outlive the decorator.
+  const std::shared_ptr<Calls> calls_;
+};
+}
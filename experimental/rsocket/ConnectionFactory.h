@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <folly/ExceptionWrapper.h>
+
 #include "src/DuplexConnection.h"
 
 namespace folly {
@@ -13,6 +15,8 @@ namespace rsocket {
 using OnConnect = std::function<
     void(std::unique_ptr<reactivesocket::DuplexConnection>, folly::EventBase&)>;
 
+using OnConnectError = std::function<void(folly::exception_wrapper)>;
+
 /**
  * Common interface for a client to create connections and turn them into
  * DuplexConnections.
@@ -40,8 +44,26 @@ class ConnectionFactory {
    *
    * Resource creation depends on the particular implementation.
    *
+   * Exactly one of the callbacks is invoked, onConnectError when no
+   * connection could be made.
+   *
    * @param onConnect
+   * @param onConnectError may be empty
+   */
+  virtual void connect(
+      OnConnect onConnect,
+      OnConnectError onConnectError = nullptr) = 0;
+
+  /**
+   * EventBase on which connections from this factory will be delivered, if it
+   * is known before connect() is called.
+   *
+   * This is what allows RSocketClient::fastConnect() to set up an RSocket and
+   * accept requests while the transport is still connecting. Implementations
+   * that cannot tell ahead of time return nullptr.
    */
-  virtual void connect(OnConnect onConnect) = 0;
+  virtual folly::EventBase* getEventBase() {
+    return nullptr;
+  }
 };
 }
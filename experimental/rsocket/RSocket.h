@@ -3,6 +3,7 @@
 #pragma once
 
 #include "rsocket/RSocketClient.h"
+#include "rsocket/RSocketClientPool.h"
 #include "rsocket/RSocketServer.h"
 
 namespace rsocket {
@@ -16,10 +17,28 @@ class RSocket {
    * Create an RSocketClient that can be used to open RSocket connections.
    * @param connectionFactory factory of DuplexConnections on the desired
    * transport, such as TcpClientConnectionFactory
+   * @param stats receives the events of every connection of the client
    * @return RSocketClient which can then make RSocket connections.
    */
   static std::unique_ptr<RSocketClient> createClient(
-      std::unique_ptr<ConnectionFactory>);
+      std::unique_ptr<ConnectionFactory>,
+      std::shared_ptr<reactivesocket::Stats> stats =
+          reactivesocket::Stats::noop());
+
+  /**
+   * Create an RSocketClientPool balancing requests over several connections.
+   * @param connectionFactories one factory per pooled connection, which may
+   * point at the same or at different endpoints
+   * @param stats receives the events of every pooled connection
+   * @param compression offered at SETUP by every pooled connection
+   * @return RSocketClientPool which can then make RSocket connections.
+   */
+  static std::unique_ptr<RSocketClientPool> createClientPool(
+      std::vector<std::unique_ptr<ConnectionFactory>>,
+      std::shared_ptr<reactivesocket::Stats> stats =
+          reactivesocket::Stats::noop(),
+      reactivesocket::CompressionOptions compression =
+          reactivesocket::CompressionOptions());
 
   // TODO duplex client that takes a requestHandler
   // TODO ConnectionSetupPayload arguments such as MimeTypes, Keepalive, etc
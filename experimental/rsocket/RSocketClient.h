@@ -2,6 +2,10 @@
 
 #pragma once
 
+#include <mutex>
+#include <vector>
+
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include "rsocket/ConnectionFactory.h"
 #include "rsocket/RSocketRequester.h"
@@ -16,7 +20,10 @@ namespace rsocket {
  */
 class RSocketClient {
  public:
-  explicit RSocketClient(std::unique_ptr<ConnectionFactory>);
+  explicit RSocketClient(
+      std::unique_ptr<ConnectionFactory>,
+      std::shared_ptr<reactivesocket::Stats> stats =
+          reactivesocket::Stats::noop());
   ~RSocketClient(); // implementing for logging right now
   RSocketClient(const RSocketClient&) = delete; // copy
   RSocketClient(RSocketClient&&) = delete; // move
@@ -39,15 +46,50 @@ class RSocketClient {
    *
    * To destruct a single RSocketRequester sooner than the RSocketClient
    * call RSocketRequester.close().
+   *
+   * The Future fails with the connect error when no connection could be made.
    */
   folly::Future<std::shared_ptr<RSocketRequester>> connect();
 
-  // TODO implement version supporting fast start (send SETUP and requests
-  // without waiting for transport to connect and ack)
-  //  std::shared_ptr<RSocketRequester> fastConnect();
+  /*
+   * Connect without waiting for the transport and return the RSocket
+   * immediately.
+   *
+   * Requests issued before the transport is connected are buffered and
+   * written right behind the SETUP frame once it is, which saves short-lived
+   * clients the connect round trip and the Future hop before their first
+   * request.
+   *
+   * Requires a ConnectionFactory which knows its EventBase up front (see
+   * ConnectionFactory::getEventBase). As with connect(), the returned
+   * RSocketRequester is retained by the RSocketClient instance.
+   *
+   * When the transport fails to connect, the buffered requests fail with the
+   * connect error and the RSocketRequester is closed.
+   */
+  std::shared_ptr<RSocketRequester> fastConnect();
+
+  /*
+   * Offers the codecs to the server at SETUP by the connections made
+   * afterwards, which compress their payloads once the server confirmed one
+   * of them, see reactivesocket::PayloadCompression. Compression needs
+   * composite metadata, the metadata mime type of such connections is
+   * reactivesocket::kCompositeMetadataMimeType.
+   */
+  void setCompression(reactivesocket::CompressionOptions compression) {
+    compression_ = std::move(compression);
+  }
 
  private:
+
   std::unique_ptr<ConnectionFactory> lazyConnection_;
-  std::vector<std::shared_ptr<RSocketRequester>> rsockets_;
+  std::shared_ptr<reactivesocket::Stats> stats_;
+  reactivesocket::CompressionOptions compression_;
+  /// Appended to by fastConnect() on the calling thread and by connect() on
+  /// the EventBase of the connection.
+  folly::Synchronized<
+      std::vector<std::shared_ptr<RSocketRequester>>,
+      std::mutex>
+      rsockets_;
 };
 }
@@ -0,0 +1,115 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <chrono>
+
+#include <folly/futures/Future.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/RSocketRequester.h"
+#include "src/PayloadCompression.h"
+#include "src/Stats.h"
+
+namespace rsocket {
+
+/**
+ * Client keeping a pool of RSocket connections and load balancing requests
+ * across them. Returned from RSocket::createClientPool.
+ *
+ * Every connection is made with its own ConnectionFactory, so a pool can span
+ * several endpoints, or several EventBase threads talking to the same
+ * endpoint.
+ *
+ * Each request goes to the cheaper of two randomly picked connections
+ * ("power of two choices"). The cost of a connection is its EWMA latency
+ * scaled by the number of requests outstanding on it. A connection which
+ * closes is taken out of rotation and replaced by a new connection from the
+ * same ConnectionFactory. So is a connection whose server drains, as soon as
+ * the server asks for new requests to go elsewhere.
+ *
+ * A connection which fails to connect is retried after minReconnectDelay,
+ * the delay doubling with every further failure up to maxReconnectDelay.
+ *
+ * Every connection reports to the same Stats and offers the codecs of
+ * compression at SETUP, as the connections of RSocketClient do.
+ */
+class RSocketClientPool {
+ public:
+  explicit RSocketClientPool(
+      std::vector<std::unique_ptr<ConnectionFactory>>,
+      std::shared_ptr<reactivesocket::Stats> stats =
+          reactivesocket::Stats::noop(),
+      reactivesocket::CompressionOptions compression =
+          reactivesocket::CompressionOptions(),
+      std::chrono::milliseconds minReconnectDelay =
+          std::chrono::milliseconds(100),
+      std::chrono::milliseconds maxReconnectDelay = std::chrono::seconds(30));
+  ~RSocketClientPool();
+  RSocketClientPool(const RSocketClientPool&) = delete; // copy
+  RSocketClientPool(RSocketClientPool&&) = delete; // move
+  RSocketClientPool& operator=(const RSocketClientPool&) = delete; // copy
+  RSocketClientPool& operator=(RSocketClientPool&&) = delete; // move
+
+  /*
+   * Connect all pooled connections.
+   *
+   * The returned Future completes once every connection has been attempted
+   * for the first time, and fails with the connect error when none of them
+   * could be established. Connections which failed keep being retried in the
+   * background. Requests issued before that are balanced across the
+   * connections which are already up.
+   */
+  folly::Future<folly::Unit> connect();
+
+  /**
+   * Same as RSocketRequester::requestStream on one of the pooled connections.
+   */
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  requestStream(reactivesocket::Payload request);
+
+  /**
+   * Same as RSocketRequester::requestChannel on one of the pooled connections.
+   */
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  requestChannel(
+      yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+          requests);
+
+  /**
+   * Same as RSocketRequester::requestResponse on one of the pooled
+   * connections.
+   */
+  yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+  requestResponse(reactivesocket::Payload request);
+
+  /**
+   * Same as RSocketRequester::fireAndForget on one of the pooled connections.
+   */
+  yarpl::Reference<yarpl::single::Single<void>> fireAndForget(
+      reactivesocket::Payload request);
+
+  /**
+   * Same as RSocketRequester::metadataPush on one of the pooled connections.
+   */
+  void metadataPush(std::unique_ptr<folly::IOBuf> metadata);
+
+  /**
+   * Number of connections in the pool, connected or not.
+   */
+  size_t size() const;
+
+  /**
+   * Number of connections currently able to take requests.
+   */
+  size_t connectedCount() const;
+
+ private:
+  class Member;
+
+  std::shared_ptr<Member> select(
+      std::shared_ptr<RSocketRequester>& requester) const;
+
+  std::vector<std::shared_ptr<Member>> members_;
+};
+}
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/io/async/EventBase.h>
 
 #include "yarpl/Flowable.h"
@@ -50,10 +51,17 @@ class RSocketRequester {
    * Interaction model details can be found at
    * https://github.com/ReactiveSocket/reactivesocket/blob/master/Protocol.md#request-stream
    *
+   * When the deadline passes, the stream is cancelled and the subscriber
+   * gets DeadlineExceededException, see RequestDeadline.
+   *
    * @param payload
+   * @param deadline
    */
   yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
-  requestStream(reactivesocket::Payload request);
+  requestStream(
+      reactivesocket::Payload request,
+      reactivesocket::RequestDeadline deadline =
+          reactivesocket::RequestDeadline());
 
   /**
     * Start a channel (streams in both directions).
@@ -61,12 +69,18 @@ class RSocketRequester {
     * Interaction model details can be found at
     * https://github.com/ReactiveSocket/reactivesocket/blob/master/Protocol.md#request-channel
     *
+    * When the deadline passes, the channel is cancelled in both directions
+    * and the subscriber gets DeadlineExceededException, see RequestDeadline.
+    *
     * @param request
+    * @param deadline
     */
   yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
   requestChannel(
       yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
-          requests);
+          requests,
+      reactivesocket::RequestDeadline deadline =
+          reactivesocket::RequestDeadline());
 
   /**
    * Send a single request and get a single response.
@@ -74,10 +88,17 @@ class RSocketRequester {
    * Interaction model details can be found at
    * https://github.com/ReactiveSocket/reactivesocket/blob/master/Protocol.md#stream-sequences-request-response
    *
+   * When the deadline passes, the request is cancelled and the observer
+   * gets DeadlineExceededException, see RequestDeadline.
+   *
    * @param payload
+   * @param deadline
    */
   yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
-  requestResponse(reactivesocket::Payload request);
+  requestResponse(
+      reactivesocket::Payload request,
+      reactivesocket::RequestDeadline deadline =
+          reactivesocket::RequestDeadline());
 
   /**
    * Send a single Payload with no response.
@@ -103,11 +124,28 @@ class RSocketRequester {
    */
   void metadataPush(std::unique_ptr<folly::IOBuf> metadata);
 
+  /**
+   * Whether the peer is draining, see RSocketServer::drain. It takes no new
+   * requests then and rejects those sent regardless with RejectedException.
+   */
+  bool isPeerDraining() const;
+
  private:
+  /**
+   * Multi-producer, single-consumer queue of work destined for the EventBase.
+   *
+   * Requests submitted from application threads are pushed onto a lock-free
+   * list and only the submission that finds the list empty schedules a drain
+   * on the EventBase, so a burst of requests costs a single wakeup.
+   */
+  class SubmissionQueue;
+
   RSocketRequester(
       std::unique_ptr<reactivesocket::ReactiveSocket> srs,
       folly::EventBase& eventBase);
+
   std::shared_ptr<reactivesocket::ReactiveSocket> reactiveSocket_;
   folly::EventBase& eventBase_;
+  std::shared_ptr<SubmissionQueue> submissionQueue_;
 };
 }
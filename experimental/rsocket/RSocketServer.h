@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <mutex>
 
 #include <folly/Baton.h>
@@ -58,6 +59,24 @@ class RSocketServer {
    */
   void unpark();
 
+  /**
+   * Shut the server down gracefully: stop accepting connections, ask the
+   * connected clients to send new requests elsewhere and wait for the
+   * requests in flight to finish.  Connections still open after the timeout
+   * are closed.
+   *
+   * Clients which announced in SETUP that they honour leases, as
+   * RSocketClient and RSocketClientPool do, are asked with a LEASE frame
+   * granting no requests.  RSocketClientPool takes such a connection out of
+   * rotation.  Other clients are sent nothing, they are not known to
+   * understand the frame.  A request sent after the connection stopped
+   * taking them fails with RejectedException, which guarantees it was not
+   * processed.
+   *
+   * This method will block the calling thread.
+   */
+  void drain(std::chrono::milliseconds timeout);
+
   // TODO version supporting RESUME
   //  void start(
   //      std::function<std::shared_ptr<RequestHandler>(
@@ -74,10 +93,18 @@ class RSocketServer {
  private:
   void addSocket(std::unique_ptr<reactivesocket::ReactiveSocket>);
   void removeSocket(reactivesocket::ReactiveSocket*);
+  /// Drains the socket on its executor, unless it is gone by then.
+  void drainSocket(reactivesocket::ReactiveSocket*);
+
+  /// Stops the ConnectionAcceptor, which can be stopped only once.
+  void stopAccepting();
+  /// Closes all ReactiveSockets and waits until they are closed.
+  void closeSockets();
 
   //////////////////////////////////////////////////////////////////////////////
 
   std::unique_ptr<ConnectionAcceptor> lazyAcceptor_;
+  bool acceptorStopped_{false};
   reactivesocket::ServerConnectionAcceptor acceptor_;
   std::shared_ptr<reactivesocket::ConnectionHandler> connectionHandler_;
 
@@ -86,6 +113,8 @@ class RSocketServer {
       std::unordered_set<std::unique_ptr<reactivesocket::ReactiveSocket>>,
       std::mutex>
       sockets_;
+  /// Set by drain(), guarded by sockets_.
+  bool draining_{false};
 
   folly::Baton<> waiting_;
   folly::Optional<folly::Baton<>> shutdown_;
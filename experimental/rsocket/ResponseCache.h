@@ -0,0 +1,100 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "src/Payload.h"
+
+namespace rsocket {
+
+/**
+ * Responses of request/responses keyed by their request, for CachingResponder.
+ *
+ * The key is the data and the metadata of the request; a cached response is
+ * only returned for a request with the same bytes. Responses expire after the
+ * TTL and the least recently used ones are evicted to stay within the byte
+ * budget, which accounts for the requests, the responses and the bookkeeping.
+ *
+ * The cache is split into shards, each with its own lock and its share of the
+ * budget, so that it can be shared by the connections of all server threads.
+ * Cached responses are handed out as clones of their IOBufs, which the frame
+ * serializer chains into the PAYLOAD frame without copying.
+ */
+class ResponseCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    /// Upper bound of the memory used by the entries of the cache.
+    size_t maxBytes{64 << 20};
+    std::chrono::milliseconds ttl{std::chrono::seconds(1)};
+    /// Rounded up to a power of two.
+    size_t shards{16};
+  };
+
+  explicit ResponseCache(Options options);
+  ResponseCache();
+  ~ResponseCache();
+
+  /**
+   * The response cached for the request, if it did not expire yet.
+   */
+  folly::Optional<reactivesocket::Payload> get(
+      const reactivesocket::Payload& request,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Caches the response of the request until now + ttl. Responses which do
+   * not fit in a shard are not cached.
+   */
+  void put(
+      const reactivesocket::Payload& request,
+      reactivesocket::Payload response,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Memory used by the entries of the cache.
+   */
+  size_t bytes() const;
+
+  /**
+   * Number of entries, expired ones included until they are found or evicted.
+   */
+  size_t size() const;
+
+  uint64_t hits() const {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t misses() const {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t evictions() const {
+    return evictions_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * The hash the cache is keyed by, of the data and the metadata.
+   */
+  static uint64_t hash(const reactivesocket::Payload& request);
+
+ private:
+  class Shard;
+
+  Shard& shardOf(uint64_t hash);
+
+  const std::chrono::milliseconds ttl_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+};
+}
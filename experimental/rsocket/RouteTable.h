@@ -0,0 +1,53 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <string>
+#include <vector>
+
+namespace rsocket {
+
+/**
+ * Immutable set of route names compiled into a perfect hash.
+ *
+ * Looking a route up hashes it once and compares it with the one route
+ * stored in the slot it hashes to, whatever the number of routes. The table
+ * is built with hash and displace: the routes are grouped into buckets by
+ * their hash, and every bucket gets the seed which places its routes into
+ * free slots.
+ */
+class RouteTable {
+ public:
+  /**
+   * Throws std::invalid_argument on duplicate routes.
+   */
+  explicit RouteTable(std::vector<std::string> routes);
+
+  /**
+   * The index of the route in the vector the table was built from.
+   */
+  folly::Optional<size_t> find(folly::StringPiece route) const;
+
+  size_t size() const {
+    return routes_.size();
+  }
+
+ private:
+  static constexpr uint32_t kEmpty = ~uint32_t(0);
+
+  static uint64_t hash(folly::StringPiece route);
+  static uint64_t slotHash(uint64_t hash, uint32_t seed);
+  bool build(const std::vector<uint64_t>& hashes, size_t slots);
+
+  std::vector<std::string> routes_;
+  /// The seed of every bucket.
+  std::vector<uint32_t> seeds_;
+  /// The index of the route in every slot, kEmpty for the free ones.
+  std::vector<uint32_t> slots_;
+  uint64_t bucketMask_{0};
+  uint64_t slotMask_{0};
+};
+}
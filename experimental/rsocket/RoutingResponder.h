@@ -0,0 +1,83 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rsocket/RSocketResponder.h"
+#include "rsocket/RouteTable.h"
+
+namespace rsocket {
+
+/**
+ * Delivered to the requester of a route no responder is registered for.
+ */
+class NoRouteException : public std::runtime_error {
+ public:
+  explicit NoRouteException(const std::string& route)
+      : std::runtime_error("no route " + route) {}
+};
+
+/**
+ * Dispatches the requests of a connection to the responders registered for
+ * their routes.
+ *
+ * The route of a request is the first tag of the routing entry
+ * (message/x.rsocket.routing.v0) of its composite metadata, see
+ * src/CompositeMetadata.h; the connection is expected to have been set up
+ * with kCompositeMetadataMimeType as its metadata mime type. The metadata is
+ * only parsed up to the routing entry and is not copied. The routes are
+ * compiled into a RouteTable, so dispatching costs the same for any number of
+ * routes.
+ *
+ * Requests without a route or with an unknown one go to the fallback
+ * responder, or fail with NoRouteException when there is none.
+ */
+class RoutingResponder : public RSocketResponder {
+ public:
+  using Routes =
+      std::vector<std::pair<std::string, std::shared_ptr<RSocketResponder>>>;
+
+  explicit RoutingResponder(
+      Routes routes,
+      std::shared_ptr<RSocketResponder> fallback = nullptr);
+
+  yarpl::Reference<yarpl::single::Single<reactivesocket::Payload>>
+  handleRequestResponse(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestStream(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+  handleRequestChannel(
+      reactivesocket::Payload request,
+      yarpl::Reference<yarpl::flowable::Flowable<reactivesocket::Payload>>
+          requestStream,
+      reactivesocket::StreamId streamId) override;
+
+  void handleFireAndForget(
+      reactivesocket::Payload request,
+      reactivesocket::StreamId streamId) override;
+
+  /**
+   * The responder the request is dispatched to, null when there is none.
+   */
+  RSocketResponder* route(const reactivesocket::Payload& request) const;
+
+ private:
+  std::string describeRoute(const reactivesocket::Payload& request) const;
+
+  const RouteTable table_;
+  /// Indexed like the routes of the table.
+  std::vector<std::shared_ptr<RSocketResponder>> responders_;
+  const std::shared_ptr<RSocketResponder> fallback_;
+};
+}
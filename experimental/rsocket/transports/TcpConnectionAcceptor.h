@@ -3,6 +3,8 @@
 #pragma once
 
 #include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/SSLContext.h>
+#include <chrono>
 #include "rsocket/ConnectionAcceptor.h"
 
 namespace folly {
@@ -27,6 +29,17 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
 
     /// Number of connections to buffer before accept handlers process them.
     int backlog{10};
+
+    /// Speak TLS when set, with the certificate and key of the context. The
+    /// clients can resume their sessions: start() turns on the session cache
+    /// and the tickets of this very context (see enableSessionResumption()),
+    /// so a context shared with other servers resumes their sessions too. See
+    /// enableKernelTls() to have the kernel encrypt the writes.
+    std::shared_ptr<folly::SSLContext> sslContext;
+
+    /// Connections which have not completed the TLS handshake by then are
+    /// closed.
+    std::chrono::milliseconds handshakeTimeout{5000};
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -47,7 +60,8 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
           folly::EventBase&)>) override;
 
   /**
-   * Shutdown the AsyncServerSocket and associated listener thread.
+   * Shutdown the AsyncServerSocket and associated listener thread, and close
+   * the connections still in their TLS handshake.
    */
   void stop() override;
 
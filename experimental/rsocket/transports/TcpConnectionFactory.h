@@ -6,6 +6,7 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "rsocket/ConnectionFactory.h"
+#include "rsocket/transports/Tls.h"
 
 #include "src/DuplexConnection.h"
 
@@ -15,21 +16,43 @@ namespace rsocket {
  * TCP implementation of ConnectionFactory for use with RSocket::createClient().
  *
  * Creation of this does nothing.  The `start` method kicks off work.
+ *
+ * Speaks TLS when given an SSLContext. The session of the last connection is
+ * resumed by the next one, which saves reconnects, RSocket resumption
+ * included, the full handshake. See enableKernelTls() to have the kernel
+ * encrypt the writes.
  */
 class TcpConnectionFactory : public ConnectionFactory {
  public:
-  explicit TcpConnectionFactory(folly::SocketAddress);
+  explicit TcpConnectionFactory(
+      folly::SocketAddress,
+      std::shared_ptr<folly::SSLContext> sslContext = nullptr);
   virtual ~TcpConnectionFactory();
 
   /**
    * Connect to server defined in constructor.
    *
-   * Each call to connect() creates a new AsyncSocket.
+   * Each call to connect() creates a new AsyncSocket.  Failures to connect or
+   * to complete the TLS handshake are passed to the OnConnectError.
+   */
+  void connect(OnConnect, OnConnectError = nullptr) override;
+
+  /**
+   * All connections are delivered on the same worker EventBase.
+   */
+  folly::EventBase* getEventBase() override;
+
+  /**
+   * The number of TLS connections which resumed the session of the previous
+   * one.
    */
-  void connect(OnConnect) override;
+  size_t resumedTlsSessions();
 
  private:
   folly::SocketAddress address_;
+  std::shared_ptr<folly::SSLContext> sslContext_;
+  /// Used on the worker thread, which is stopped first.
+  TlsSessionCache sessionCache_;
   folly::ScopedEventBaseThread worker_;
 };
 }
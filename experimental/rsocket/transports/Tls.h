@@ -0,0 +1,62 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/io/async/AsyncSSLSocket.h>
+#include <folly/io/async/SSLContext.h>
+#include <memory>
+
+namespace rsocket {
+
+/**
+ * Helpers shared by the TLS mode of TcpConnectionFactory and
+ * TcpConnectionAcceptor.
+ */
+
+/**
+ * Asks OpenSSL to hand the symmetric crypto of the connections of the context
+ * to the kernel (kTLS) once the handshake is done, so that writes of IOBuf
+ * chains are not copied through a user space encryption buffer.
+ *
+ * Returns false when this OpenSSL has no kTLS support, the connections then
+ * encrypt in user space. Whether a given connection got kTLS also depends on
+ * the kernel and the negotiated cipher, see kernelTlsActive().
+ */
+bool enableKernelTls(folly::SSLContext& context);
+
+/**
+ * Whether the writes of the socket are encrypted by the kernel.
+ */
+bool kernelTlsActive(const folly::AsyncSSLSocket& socket);
+
+/**
+ * Lets the clients of a server context resume their sessions, either from
+ * the session cache of the context or with session tickets, so that they
+ * reconnect without a full handshake.
+ *
+ * Changes the options of the context itself, i.e. of every server using it.
+ */
+void enableSessionResumption(folly::SSLContext& serverContext);
+
+/**
+ * The session of a client connection to resume the next connection with.
+ * Only touched on the EventBase of the connections.
+ */
+class TlsSessionCache {
+ public:
+  /// Remembers the session of an established connection.
+  void update(folly::AsyncSSLSocket& socket);
+
+  /// Resumes the remembered session, if any, on a new connection.
+  void apply(folly::AsyncSSLSocket& socket) const;
+
+  /// The number of connections which resumed their session.
+  size_t resumed() const {
+    return resumed_;
+  }
+
+ private:
+  std::shared_ptr<SSL_SESSION> session_;
+  size_t resumed_{0};
+};
+}
@@ -17,6 +17,8 @@
 namespace yarpl {
 namespace flowable {
 
+class Flowables;
+
 template <typename T>
 class Flowable : public virtual Refcounted {
  public:
@@ -105,7 +107,8 @@ class Flowable : public virtual Refcounted {
    * The emitter can invoke up to \b requested calls to `onNext()`, and can
    * optionally make a final call to `onComplete()` or `onError()`; returns
    * the actual number of `onNext()` calls; and whether the subscription is
-   * finished (completed/in error).
+   * finished (completed/in error).  The subscriber may cancel from within
+   * `onNext()`, the emitter is not invoked again once it did.
    *
    * \return a handle to a flowable that will use the emitter.
    */
@@ -120,6 +123,15 @@ class Flowable : public virtual Refcounted {
   static auto create(Emitter&& emitter);
 
  private:
+  // The sources of Flowables stop emitting as soon as they are cancelled.
+  friend class Flowables;
+
+  /**
+   * Whether the subscription was cancelled, given the subscriber an emitter
+   * created by Flowables was invoked with, and only that one.
+   */
+  static bool isCancelled(Subscriber<T>& subscriber);
+
   virtual std::tuple<int64_t, bool> emit(Subscriber<T>&, int64_t) {
     return std::make_tuple(static_cast<int64_t>(0), false);
   }
@@ -170,6 +182,10 @@ class Flowable : public virtual Refcounted {
       process();
     }
 
+    bool isCancelled() const {
+      return requested_.load(std::memory_order_relaxed) == CANCELED;
+    }
+
     // Subscriber methods.
     void onSubscribe(Reference<Subscription>) override {
       // Not actually expected to be called.
@@ -300,6 +316,12 @@ auto Flowable<T>::create(Emitter&& emitter) {
       new Flowable<T>::EmitterWrapper<Emitter>(std::forward<Emitter>(emitter)));
 }
 
+template <typename T>
+bool Flowable<T>::isCancelled(Subscriber<T>& subscriber) {
+  // emitters are only ever invoked from SynchronousSubscription::process
+  return static_cast<SynchronousSubscription&>(subscriber).isCancelled();
+}
+
 template <typename T>
 template <typename Function>
 auto Flowable<T>::map(Function&& function) {
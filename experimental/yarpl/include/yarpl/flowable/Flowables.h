@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
 #include <limits>
 #include <vector>
 
@@ -9,17 +10,54 @@
 namespace yarpl {
 namespace flowable {
 
+namespace details {
+
+/// Upper bound on the items a pull-based source emits per emit() call.  An
+/// unbounded request(n) is served in batches of this size, so that the
+/// SynchronousSubscription loop gets to observe a request(n) in between.
+/// A cancellation is observed after every item.
+constexpr int64_t kMaxEmitBatch = 1024;
+
+/// Flowable which gives every subscription its own copy of the emitter, so
+/// that a stateful source (a cursor, a generator) restarts for each
+/// subscriber instead of being shared between them.
+template <typename T, typename Emitter>
+class PerSubscriptionFlowable : public Flowable<T> {
+ public:
+  explicit PerSubscriptionFlowable(Emitter emitter)
+      : emitter_(std::move(emitter)) {}
+
+  void subscribe(Reference<Subscriber<T>> subscriber) override {
+    Flowable<T>::create(Emitter(emitter_))->subscribe(std::move(subscriber));
+  }
+
+ private:
+  const Emitter emitter_;
+};
+
+template <typename T, typename Emitter>
+Reference<Flowable<T>> perSubscription(Emitter emitter) {
+  return Reference<Flowable<T>>(
+      new PerSubscriptionFlowable<T, Emitter>(std::move(emitter)));
+}
+
+} // details
+
 class Flowables {
  public:
   static Reference<Flowable<int64_t>> range(int64_t start, int64_t end) {
-    auto lambda = [ start, end, i = start ](
+    auto lambda = [ end, i = start ](
         Subscriber<int64_t> & subscriber, int64_t requested) mutable {
+      auto const batch = std::min(requested, details::kMaxEmitBatch);
       int64_t emitted = 0;
       bool done = false;
 
-      while (i < end && emitted < requested) {
+      while (i < end && emitted < batch) {
         subscriber.onNext(i++);
         ++emitted;
+        if (Flowable<int64_t>::isCancelled(subscriber)) {
+          return std::make_tuple(emitted, false);
+        }
       }
 
       if (i >= end) {
@@ -27,39 +65,72 @@ class Flowables {
         done = true;
       }
 
-      return std::make_tuple(requested, done);
+      return std::make_tuple(emitted, done);
     };
 
-    return Flowable<int64_t>::create(std::move(lambda));
+    return details::perSubscription<int64_t>(std::move(lambda));
   }
 
-  template <typename T>
-  static Reference<Flowable<T>> just(const T& value) {
-    auto lambda = [value](Subscriber<T>& subscriber, int64_t) {
-      // # requested should be > 0.  Ignoring the actual parameter.
-      subscriber.onNext(value);
-      subscriber.onComplete();
-      return std::make_tuple(static_cast<int64_t>(1), true);
+  /**
+   * Infinite flowable emitting the values returned by `generator()`.
+   *
+   * The generator is invoked exactly once per requested item, from within
+   * request(n), and its result is moved to the subscriber.  It is no longer
+   * invoked once the subscription is cancelled, from within onNext too.
+   * Each subscription works on its own copy of the generator.
+   */
+  template <typename T, typename Generator>
+  static Reference<Flowable<T>> fromGenerator(Generator generator) {
+    auto lambda = [generator = std::move(generator)](
+        Subscriber<T> & subscriber, int64_t requested) mutable {
+      auto const batch = std::min(requested, details::kMaxEmitBatch);
+      int64_t emitted = 0;
+      while (emitted < batch) {
+        subscriber.onNext(generator());
+        ++emitted;
+        if (Flowable<T>::isCancelled(subscriber)) {
+          break;
+        }
+      }
+      return std::make_tuple(emitted, false);
     };
 
-    return Flowable<T>::create(std::move(lambda));
+    return details::perSubscription<T>(std::move(lambda));
   }
 
-  template <typename T>
-  static Reference<Flowable<T>> justN(std::initializer_list<T> list) {
-    std::vector<T> vec(list);
-
-    auto lambda = [ v = std::move(vec), i = size_t{0} ](
-        Subscriber<T> & subscriber, int64_t requested) mutable {
+  /**
+   * Flowable emitting the elements of a container, in iteration order, and
+   * completing after the last one.  The elements are copied to subscribers,
+   * each subscription iterates the container from the beginning.
+   */
+  template <
+      typename Container,
+      typename T = typename std::decay<
+          decltype(*std::begin(std::declval<Container&>()))>::type>
+  static Reference<Flowable<T>> fromIterable(Container container) {
+    using Iterator = decltype(std::begin(std::declval<Container&>()));
+    // The iterator starts on the first emit, once the container has been
+    // copied for the subscription.
+    auto lambda =
+        [ container = std::move(container), it = Iterator(), started = false ](
+            Subscriber<T> & subscriber, int64_t requested) mutable {
+      if (!started) {
+        it = std::begin(container);
+        started = true;
+      }
+      auto const batch = std::min(requested, details::kMaxEmitBatch);
       int64_t emitted = 0;
       bool done = false;
 
-      while (i < v.size() && emitted < requested) {
-        subscriber.onNext(v[i++]);
+      while (it != std::end(container) && emitted < batch) {
+        subscriber.onNext(*it++);
         ++emitted;
+        if (Flowable<T>::isCancelled(subscriber)) {
+          return std::make_tuple(emitted, false);
+        }
       }
 
-      if (i == v.size()) {
+      if (it == std::end(container)) {
         subscriber.onComplete();
         done = true;
       }
@@ -67,9 +138,26 @@ class Flowables {
       return std::make_tuple(emitted, done);
     };
 
+    return details::perSubscription<T>(std::move(lambda));
+  }
+
+  template <typename T>
+  static Reference<Flowable<T>> just(const T& value) {
+    auto lambda = [value](Subscriber<T>& subscriber, int64_t) {
+      // # requested should be > 0.  Ignoring the actual parameter.
+      subscriber.onNext(value);
+      subscriber.onComplete();
+      return std::make_tuple(static_cast<int64_t>(1), true);
+    };
+
     return Flowable<T>::create(std::move(lambda));
   }
 
+  template <typename T>
+  static Reference<Flowable<T>> justN(std::initializer_list<T> list) {
+    return fromIterable(std::vector<T>(list));
+  }
+
   template <
       typename T,
       typename OnSubscribe,
@@ -1,3 +1,4 @@
+#include <limits>
 #include <vector>
 #include <type_traits>
 
@@ -73,6 +74,35 @@ class CollectingSubscriber : public Subscriber<T> {
   int64_t requestCount_;
 };
 
+/// Requests items without bound, and cancels from within the onNext of the
+/// given item.
+template <typename T>
+class CancellingSubscriber : public Subscriber<T> {
+ public:
+  explicit CancellingSubscriber(int64_t cancelAt) : cancelAt_(cancelAt) {}
+
+  void onSubscribe(Reference<Subscription> subscription) override {
+    subscription_ = subscription;
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(T) override {
+    if (++received_ == cancelAt_) {
+      subscription_->cancel();
+      subscription_.reset();
+    }
+  }
+
+  int64_t received() const {
+    return received_;
+  }
+
+ private:
+  const int64_t cancelAt_;
+  int64_t received_{0};
+  Reference<Subscription> subscription_;
+};
+
 /// Construct a pipeline with a collecting subscriber against the supplied
 /// flowable.  Return the items that were sent to the subscriber.  If some
 /// exception was sent, the exception is thrown.
@@ -149,6 +179,86 @@ TEST(FlowableTest, Range) {
   EXPECT_EQ(std::size_t{0}, Refcounted::objects());
 }
 
+TEST(FlowableTest, RangeResubscribe) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  auto flowable = Flowables::range(0, 3);
+  EXPECT_EQ(run(flowable), std::vector<int64_t>({0, 1, 2}));
+  EXPECT_EQ(run(flowable), std::vector<int64_t>({0, 1, 2}));
+  flowable.reset();
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
+TEST(FlowableTest, FromGenerator) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  auto flowable =
+      Flowables::fromGenerator<int>([i = 0]() mutable { return i++; });
+  EXPECT_EQ(run(flowable->take(4)), std::vector<int>({0, 1, 2, 3}));
+  // every subscription gets its own generator
+  EXPECT_EQ(run(flowable->take(2)), std::vector<int>({0, 1}));
+  flowable.reset();
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
+TEST(FlowableTest, FromGeneratorEmitsRequested) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  int generated = 0;
+  auto flowable =
+      Flowables::fromGenerator<int>([&generated] { return generated++; })
+          ->take(5);
+  EXPECT_EQ(run(std::move(flowable), 5), std::vector<int>({0, 1, 2, 3, 4}));
+  // nothing is generated ahead of demand
+  EXPECT_EQ(generated, 5);
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
+TEST(FlowableTest, FromGeneratorStopsOnCancelFromOnNext) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  int generated = 0;
+  auto subscriber = make_ref<CancellingSubscriber<int>>(3);
+  Flowables::fromGenerator<int>([&generated] { return generated++; })
+      ->subscribe(subscriber);
+  EXPECT_EQ(3, subscriber->received());
+  EXPECT_EQ(3, generated);
+  subscriber.reset();
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
+TEST(FlowableTest, RangeStopsOnCancelFromOnNext) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  auto subscriber = make_ref<CancellingSubscriber<int64_t>>(3);
+  Flowables::range(0, 100)->subscribe(subscriber);
+  EXPECT_EQ(3, subscriber->received());
+  subscriber.reset();
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
+TEST(FlowableTest, FromIterable) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  EXPECT_EQ(
+      run(Flowables::fromIterable(std::vector<std::string>({"a", "b", "c"}))),
+      std::vector<std::string>({"a", "b", "c"}));
+  EXPECT_EQ(
+      run(Flowables::fromIterable(std::vector<int>({1, 2, 3, 4, 5}))->take(2)),
+      std::vector<int>({1, 2}));
+  EXPECT_EQ(
+      run(Flowables::fromIterable(std::vector<int>())), std::vector<int>());
+}
+
+TEST(FlowableTest, FromIterableResubscribe) {
+  ASSERT_EQ(std::size_t{0}, Refcounted::objects());
+  auto flowable = Flowables::fromIterable(std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(run(flowable->take(2)), std::vector<int>({1, 2}));
+  // every subscription iterates from the beginning
+  EXPECT_EQ(run(flowable), std::vector<int>({1, 2, 3}));
+
+  auto subscriber = make_ref<CancellingSubscriber<int>>(2);
+  flowable->subscribe(subscriber);
+  EXPECT_EQ(2, subscriber->received());
+  subscriber.reset();
+  flowable.reset();
+  EXPECT_EQ(std::size_t{0}, Refcounted::objects());
+}
+
 TEST(FlowableTest, RangeWithMap) {
   ASSERT_EQ(std::size_t{0}, Refcounted::objects());
   auto flowable = Flowables::range(1, 4)
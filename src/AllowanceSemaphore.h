@@ -63,6 +63,10 @@ class AllowanceSemaphore {
     return value_;
   }
 
+  ValueType value() const {
+    return value_;
+  }
+
   static ValueType max() {
     return std::numeric_limits<ValueType>::max();
   }
@@ -4,6 +4,7 @@
 #include <folly/Random.h>
 #include <folly/String.h>
 #include <folly/io/IOBuf.h>
+#include <array>
 #include <random>
 
 namespace reactivesocket {
@@ -82,12 +83,22 @@ ResumeIdentificationToken::ResumeIdentificationToken() {}
 
 ResumeIdentificationToken ResumeIdentificationToken::generateNew() {
   constexpr size_t kSize = 16;
-  std::vector<uint8_t> data;
-  data.reserve(kSize);
-  for (size_t i = 0; i < kSize; i++) {
-    data.push_back(static_cast<uint8_t>(folly::Random::rand32()));
+  // the tokens of a thread are cut from a batch of secure random bytes, one
+  // call to the secure generator per 64 tokens rather than a call per byte
+  constexpr size_t kBatchSize = 64 * kSize;
+  struct Batch {
+    std::array<uint8_t, kBatchSize> bytes;
+    size_t next{kBatchSize};
+  };
+  static thread_local Batch batch;
+
+  if (batch.next == kBatchSize) {
+    folly::Random::secureRandom(batch.bytes.data(), kBatchSize);
+    batch.next = 0;
   }
-  return ResumeIdentificationToken(std::move(data));
+  const auto begin = batch.bytes.begin() + batch.next;
+  batch.next += kSize;
+  return ResumeIdentificationToken(std::vector<uint8_t>(begin, begin + kSize));
 }
 
 void ResumeIdentificationToken::set(std::vector<uint8_t> newBits) {
@@ -65,6 +65,25 @@ enum class StreamType {
   FNF,
 };
 
+/// Direction of REQUEST_N credit of a stream, as seen from the local end.
+enum class FlowControlDirection : uint8_t {
+  /// Credit granted by the local consumer to the remote publisher.
+  INBOUND,
+  /// Credit granted by the remote consumer to the local publisher.
+  OUTBOUND,
+};
+
+/// Buffers in which a connection holds frames, see MemoryAccountant.
+enum class MemoryBuffer : uint8_t {
+  /// Frames waiting for the transport to accept more writes.
+  PENDING_WRITES,
+  /// Frames read before there was anything to process them, and the bytes of
+  /// frames which have not been read whole yet.
+  PENDING_READS,
+  /// Frames written while the connection was disconnected or resuming.
+  STREAM_OUTPUT,
+};
+
 std::string to_string(StreamCompletionSignal);
 std::ostream& operator<<(std::ostream&, StreamCompletionSignal);
 
@@ -74,10 +93,31 @@ class StreamInterruptedException : public std::runtime_error {
   int terminatingSignal;
 };
 
+/// Delivered to the subscriber of a request whose RequestDeadline passed.
+class DeadlineExceededException : public std::runtime_error {
+ public:
+  DeadlineExceededException() : std::runtime_error("deadline exceeded") {}
+};
+
+/// Delivered to the subscriber of a stream whose peer sent a payload which
+/// decompresses to more than CompressionOptions::maxUncompressedSize.
+class PayloadTooLargeException : public std::runtime_error {
+ public:
+  PayloadTooLargeException() : std::runtime_error("payload too large") {}
+};
+
+/// Delivered to the subscriber of a request the responder rejected, which
+/// guarantees the request was not processed and so can be retried elsewhere.
+class RejectedException : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
 class ResumeIdentificationToken {
  public:
   /// Creates an empty token.
   ResumeIdentificationToken();
+  /// A random 16 byte token, cheap enough to generate per connection.
   static ResumeIdentificationToken generateNew();
 
   const std::vector<uint8_t>& data() const {
@@ -0,0 +1,233 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/CompositeMetadata.h"
+#include <array>
+#include <stdexcept>
+
+namespace reactivesocket {
+
+namespace {
+/// Longest mime type which fits the entry header.
+constexpr size_t kMaxMimeTypeLength = 128;
+constexpr size_t kMaxEntryLength = (1 << 24) - 1;
+constexpr uint8_t kWellKnownFlag = 0x80;
+
+struct WellKnownMimeType {
+  uint8_t id;
+  folly::StringPiece mimeType;
+};
+
+constexpr WellKnownMimeType kWellKnownMimeTypes[] = {
+    {0x00, "application/avro"},
+    {0x01, "application/cbor"},
+    {0x02, "application/graphql"},
+    {0x03, "application/gzip"},
+    {0x04, "application/javascript"},
+    {0x05, "application/json"},
+    {0x06, "application/octet-stream"},
+    {0x07, "application/pdf"},
+    {0x08, "application/vnd.apache.thrift.binary"},
+    {0x09, "application/vnd.google.protobuf"},
+    {0x0A, "application/xml"},
+    {0x0B, "application/zip"},
+    {0x0C, "audio/aac"},
+    {0x0D, "audio/mp3"},
+    {0x0E, "audio/mp4"},
+    {0x0F, "audio/mpeg3"},
+    {0x10, "audio/mpeg"},
+    {0x11, "audio/ogg"},
+    {0x12, "audio/opus"},
+    {0x13, "audio/vorbis"},
+    {0x14, "image/bmp"},
+    {0x15, "image/gif"},
+    {0x16, "image/heic-sequence"},
+    {0x17, "image/heic"},
+    {0x18, "image/heif-sequence"},
+    {0x19, "image/heif"},
+    {0x1A, "image/jpeg"},
+    {0x1B, "image/png"},
+    {0x1C, "image/tiff"},
+    {0x1D, "multipart/mixed"},
+    {0x1E, "text/css"},
+    {0x1F, "text/csv"},
+    {0x20, "text/html"},
+    {0x21, "text/plain"},
+    {0x22, "text/xml"},
+    {0x23, "video/H264"},
+    {0x24, "video/H265"},
+    {0x25, "video/VP8"},
+    {0x7A, "message/x.rsocket.mime-type.v0"},
+    {0x7B, "message/x.rsocket.accept-mime-types.v0"},
+    {0x7C, "message/x.rsocket.authentication.v0"},
+    {0x7D, "message/x.rsocket.tracing-zipkin.v0"},
+    {0x7E, "message/x.rsocket.routing.v0"},
+    {0x7F, "message/x.rsocket.composite-metadata.v0"},
+};
+
+/// The mime types indexed by id.
+const std::array<folly::StringPiece, 128>& mimeTypesById() {
+  static const auto mimeTypes = [] {
+    std::array<folly::StringPiece, 128> mimeTypes;
+    for (const auto& wellKnown : kWellKnownMimeTypes) {
+      mimeTypes[wellKnown.id] = wellKnown.mimeType;
+    }
+    return mimeTypes;
+  }();
+  return mimeTypes;
+}
+}
+
+folly::Optional<uint8_t> wellKnownMimeTypeId(folly::StringPiece mimeType) {
+  for (const auto& wellKnown : kWellKnownMimeTypes) {
+    if (wellKnown.mimeType == mimeType) {
+      return wellKnown.id;
+    }
+  }
+  return folly::none;
+}
+
+folly::StringPiece wellKnownMimeType(uint8_t id) {
+  return id < 128 ? mimeTypesById()[id] : folly::StringPiece();
+}
+
+CompositeMetadataReader::CompositeMetadataReader(const folly::IOBuf& metadata)
+    : cursor_(&metadata), entry_(&metadata) {}
+
+bool CompositeMetadataReader::next() {
+  if (malformed_ || cursor_.isAtEnd()) {
+    return false;
+  }
+  malformed_ = true;
+
+  const auto header = cursor_.read<uint8_t>();
+  if (header & kWellKnownFlag) {
+    mimeTypeId_ = static_cast<uint8_t>(header & ~kWellKnownFlag);
+    mimeType_.clear();
+  } else {
+    mimeTypeId_ = folly::none;
+    const size_t mimeTypeLength = header + 1;
+    if (!cursor_.canAdvance(mimeTypeLength)) {
+      return false;
+    }
+    if (cursor_.length() >= mimeTypeLength) {
+      mimeType_ = folly::StringPiece(
+          reinterpret_cast<const char*>(cursor_.data()), mimeTypeLength);
+      cursor_.skip(mimeTypeLength);
+    } else {
+      mimeTypeCopy_ = cursor_.readFixedString(mimeTypeLength);
+      mimeType_ = mimeTypeCopy_;
+    }
+  }
+
+  if (!cursor_.canAdvance(3)) {
+    return false;
+  }
+  length_ = static_cast<size_t>(cursor_.read<uint8_t>()) << 16;
+  length_ |= cursor_.readBE<uint16_t>();
+  if (!cursor_.canAdvance(length_)) {
+    return false;
+  }
+  entry_ = cursor_;
+  cursor_.skip(length_);
+
+  malformed_ = false;
+  return true;
+}
+
+bool CompositeMetadataReader::mimeTypeIs(folly::StringPiece mimeType) const {
+  if (mimeTypeId_) {
+    return wellKnownMimeType(*mimeTypeId_) == mimeType;
+  }
+  return mimeType_ == mimeType;
+}
+
+std::string CompositeMetadataReader::mimeType() const {
+  return mimeTypeId_ ? wellKnownMimeType(*mimeTypeId_).str() : mimeType_.str();
+}
+
+std::unique_ptr<folly::IOBuf> CompositeMetadataReader::clone() const {
+  std::unique_ptr<folly::IOBuf> bytes;
+  auto cursor = entry_;
+  cursor.clone(bytes, length_);
+  return bytes;
+}
+
+CompositeMetadataBuilder& CompositeMetadataBuilder::add(
+    folly::StringPiece mimeType,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  if (mimeType.empty() || mimeType.size() > kMaxMimeTypeLength) {
+    throw std::invalid_argument("mime type length out of range");
+  }
+  for (auto c : mimeType) {
+    if (static_cast<unsigned char>(c) >= 0x80) {
+      throw std::invalid_argument("mime type is not ASCII");
+    }
+  }
+  const auto length = metadata ? metadata->computeChainDataLength() : 0;
+  if (length > kMaxEntryLength) {
+    throw std::invalid_argument("composite metadata entry too long");
+  }
+
+  auto header = folly::IOBuf::create(1 + mimeType.size() + 3);
+  folly::io::Appender appender(header.get(), 0);
+  if (auto id = wellKnownMimeTypeId(mimeType)) {
+    appender.write<uint8_t>(kWellKnownFlag | *id);
+  } else {
+    appender.write<uint8_t>(static_cast<uint8_t>(mimeType.size() - 1));
+    appender.push(
+        reinterpret_cast<const uint8_t*>(mimeType.data()), mimeType.size());
+  }
+  appender.write<uint8_t>(static_cast<uint8_t>(length >> 16));
+  appender.writeBE<uint16_t>(static_cast<uint16_t>(length));
+
+  queue_.append(std::move(header));
+  if (length > 0) {
+    queue_.append(std::move(metadata));
+  }
+  return *this;
+}
+
+CompositeMetadataBuilder& CompositeMetadataBuilder::addRoute(
+    std::initializer_list<folly::StringPiece> tags) {
+  size_t length = 0;
+  for (auto tag : tags) {
+    if (tag.size() > 0xFF) {
+      throw std::invalid_argument("route tag longer than 255 bytes");
+    }
+    length += 1 + tag.size();
+  }
+  auto route = folly::IOBuf::create(length);
+  folly::io::Appender appender(route.get(), 0);
+  for (auto tag : tags) {
+    appender.write<uint8_t>(static_cast<uint8_t>(tag.size()));
+    appender.push(reinterpret_cast<const uint8_t*>(tag.data()), tag.size());
+  }
+  return add(kRoutingMimeType, std::move(route));
+}
+
+folly::Optional<folly::StringPiece> readRoute(
+    const folly::IOBuf& metadata,
+    std::string& scratch) {
+  CompositeMetadataReader reader(metadata);
+  while (reader.next()) {
+    if (!reader.mimeTypeIs(kRoutingMimeType)) {
+      continue;
+    }
+    if (reader.length() == 0) {
+      return folly::none;
+    }
+    auto cursor = reader.cursor();
+    const size_t tagLength = cursor.read<uint8_t>();
+    if (1 + tagLength > reader.length()) {
+      return folly::none;
+    }
+    if (cursor.length() >= tagLength) {
+      return folly::StringPiece(
+          reinterpret_cast<const char*>(cursor.data()), tagLength);
+    }
+    scratch = cursor.readFixedString(tagLength);
+    return folly::StringPiece(scratch);
+  }
+  return folly::none;
+}
+}
@@ -0,0 +1,111 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <memory>
+#include <string>
+
+namespace reactivesocket {
+
+/// Metadata mime type of the connections whose metadata are composite.
+constexpr folly::StringPiece kCompositeMetadataMimeType{
+    "message/x.rsocket.composite-metadata.v0"};
+/// Mime type of the routing entry of composite metadata, a sequence of tags
+/// each prefixed with its length as one byte.
+constexpr folly::StringPiece kRoutingMimeType{"message/x.rsocket.routing.v0"};
+
+/// The id of a well known mime type of composite metadata, none for the
+/// others.
+folly::Optional<uint8_t> wellKnownMimeTypeId(folly::StringPiece mimeType);
+
+/// The well known mime type of the id, empty for unknown ids.
+folly::StringPiece wellKnownMimeType(uint8_t id);
+
+/// Iterates over the entries of composite metadata without copying them.
+///
+/// Each entry is its mime type, either the id of a well known one or the
+/// ASCII string, followed by the length of the entry as a 24 bit big endian
+/// integer and the bytes of the entry.
+///
+///   CompositeMetadataReader reader(*request.metadata);
+///   while (reader.next()) {
+///     if (reader.mimeTypeIs(kRoutingMimeType)) { ... reader.cursor() ... }
+///   }
+class CompositeMetadataReader {
+ public:
+  explicit CompositeMetadataReader(const folly::IOBuf& metadata);
+
+  /// Moves to the next entry. Returns false at the end of the metadata or
+  /// when the rest of it is malformed.
+  bool next();
+
+  /// The rest of the metadata did not parse.
+  bool malformed() const {
+    return malformed_;
+  }
+
+  /// Whether the current entry has the mime type, which is compared by id
+  /// for the well known ones.
+  bool mimeTypeIs(folly::StringPiece mimeType) const;
+
+  /// The mime type of the current entry.
+  std::string mimeType() const;
+
+  /// Cursor at the bytes of the current entry.
+  folly::io::Cursor cursor() const {
+    return entry_;
+  }
+
+  /// Length of the current entry.
+  size_t length() const {
+    return length_;
+  }
+
+  /// The bytes of the current entry, sharing the buffers of the metadata.
+  std::unique_ptr<folly::IOBuf> clone() const;
+
+ private:
+  folly::io::Cursor cursor_;
+  folly::io::Cursor entry_;
+  size_t length_{0};
+  /// Set for the well known mime types, mimeType_ is set otherwise.
+  folly::Optional<uint8_t> mimeTypeId_;
+  folly::StringPiece mimeType_;
+  /// Holds the mime type when it spans buffers.
+  std::string mimeTypeCopy_;
+  bool malformed_{false};
+};
+
+/// Builds composite metadata. The entries are chained, not copied.
+class CompositeMetadataBuilder {
+ public:
+  /// Adds an entry. Throws std::invalid_argument when the mime type is not 1
+  /// to 128 ASCII characters or the entry is longer than 2^24 - 1 bytes.
+  CompositeMetadataBuilder& add(
+      folly::StringPiece mimeType,
+      std::unique_ptr<folly::IOBuf> metadata);
+
+  /// Adds a routing entry with the tags.
+  CompositeMetadataBuilder& addRoute(
+      std::initializer_list<folly::StringPiece> tags);
+
+  std::unique_ptr<folly::IOBuf> build() {
+    return queue_.move();
+  }
+
+ private:
+  folly::IOBufQueue queue_{folly::IOBufQueue::cacheChainLength()};
+};
+
+/// The first tag of the routing entry of composite metadata, none when there
+/// is no routing entry or the metadata is malformed. The tag points into the
+/// metadata, or into `scratch` when it spans buffers.
+folly::Optional<folly::StringPiece> readRoute(
+    const folly::IOBuf& metadata,
+    std::string& scratch);
+}
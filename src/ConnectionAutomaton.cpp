@@ -10,16 +10,31 @@
 #include "src/ClientResumeStatusCallback.h"
 #include "src/ConnectionSetupPayload.h"
 #include "src/DuplexConnection.h"
+#include "src/FrameCapture.h"
+#include "src/FrameTrace.h"
 #include "src/FrameTransport.h"
+#include "src/Logging.h"
+#include "src/MemoryAccountant.h"
+#include "src/PayloadCompression.h"
+#include "src/RequestDeadline.h"
 #include "src/RequestHandler.h"
 #include "src/ResumeCache.h"
 #include "src/Stats.h"
 #include "src/StreamState.h"
+#include "src/TaskProfiler.h"
 #include "src/automata/ChannelResponder.h"
 #include "src/automata/StreamAutomatonBase.h"
 
 namespace reactivesocket {
 
+namespace {
+/// The data of the KEEPALIVE sent by ConnectionAutomaton::drain, which the
+/// peer echoes back.
+std::unique_ptr<folly::IOBuf> drainMarker() {
+  return folly::IOBuf::copyBuffer("drain");
+}
+}
+
 ConnectionAutomaton::ConnectionAutomaton(
     folly::Executor& executor,
     ReactiveSocket* reactiveSocket,
@@ -27,11 +42,10 @@ ConnectionAutomaton::ConnectionAutomaton(
     std::shared_ptr<Stats> stats,
     std::unique_ptr<KeepaliveTimer> keepaliveTimer,
     ReactiveSocketMode mode)
-    : ExecutorBase(executor),
+    : ExecutorBase(executor, stats),
       reactiveSocket_(reactiveSocket),
       stats_(stats),
       mode_(mode),
-      resumeCache_(std::make_shared<ResumeCache>(stats)),
       streamState_(std::make_shared<StreamState>(*stats)),
       requestHandler_(std::move(requestHandler)),
       keepaliveTimer_(std::move(keepaliveTimer)),
@@ -47,7 +61,7 @@ ConnectionAutomaton::~ConnectionAutomaton() {
   // automatons destroyed on different threads can be the last ones referencing
   // this.
 
-  VLOG(6) << "~ConnectionAutomaton";
+  RSOCKET_VLOG(6) << "~ConnectionAutomaton";
   // We rely on SubscriptionPtr and SubscriberPtr to dispatch appropriate
   // terminal signals.
   DCHECK(!resumeCallback_);
@@ -60,6 +74,41 @@ void ConnectionAutomaton::setResumable(bool resumable) {
   DCHECK(isDisconnectedOrClosed()); // we allow to set this flag before we are
   // connected
   remoteResumeable_ = isResumable_ = resumable;
+  // connections which can not resume track no frames
+  if (!resumable) {
+    resumeCache_.reset();
+  } else if (!resumeCache_) {
+    resumeCache_ = std::make_shared<ResumeCache>(stats_);
+  }
+}
+
+void ConnectionAutomaton::setCompression(const CompressionOptions& options) {
+  debugCheckCorrectExecutor();
+  DCHECK(isDisconnectedOrClosed());
+  startCompression(options);
+}
+
+void ConnectionAutomaton::startCompression(const CompressionOptions& options) {
+  if (options.codecs.empty() || !options.compositeMetadata) {
+    compression_.reset();
+    return;
+  }
+  compression_ = std::make_unique<PayloadCompression>(options);
+  if (mode_ == ReactiveSocketMode::SERVER) {
+    // the codecs are the offer of the client, which learns the one picked
+    // from confirmCompression
+    compression_->setCodec(PayloadCompression::choose(options.codecs));
+    RSOCKET_VLOG(3) << "compressing payloads with "
+                    << to_string(compression_->codec());
+  }
+}
+
+void ConnectionAutomaton::confirmCompression() {
+  debugCheckCorrectExecutor();
+  DCHECK(mode_ == ReactiveSocketMode::SERVER);
+  if (compression_ && compression_->codec() != CompressionCodec::NONE) {
+    metadataPush(PayloadCompression::confirmation(compression_->codec()));
+  }
 }
 
 bool ConnectionAutomaton::connect(
@@ -78,13 +127,14 @@ bool ConnectionAutomaton::connect(
         return false;
       }
     } else {
-      frameSerializer_ =
+      auto frameSerializer =
           FrameSerializer::createFrameSerializer(protocolVersion);
-      if (!frameSerializer_) {
+      if (!frameSerializer) {
         DCHECK(false);
         frameTransport->close(std::runtime_error("invaid protocol version"));
         return false;
       }
+      setFrameSerializer(std::move(frameSerializer));
     }
   }
 
@@ -102,6 +152,10 @@ bool ConnectionAutomaton::connect(
   // frameTransport_.
   auto frameTransportCopy = frameTransport_;
 
+  if (memoryAccountant_) {
+    frameTransport_->setMemoryAccountant(memoryAccountant_);
+  }
+
   // Keep a reference to this, as processing frames might close the
   // ReactiveSocket instance.
   auto copyThis = shared_from_this();
@@ -133,12 +187,15 @@ std::shared_ptr<FrameTransport> ConnectionAutomaton::detachFrameTransport() {
   }
 
   frameTransport_->setFrameProcessor(nullptr);
+  if (memoryAccountant_) {
+    frameTransport_->setMemoryAccountant(nullptr);
+  }
   return std::move(frameTransport_);
 }
 
 void ConnectionAutomaton::disconnect(folly::exception_wrapper ex) {
   debugCheckCorrectExecutor();
-  VLOG(6) << "disconnect";
+  RSOCKET_VLOG(6) << "disconnect";
   if (isDisconnectedOrClosed()) {
     return;
   }
@@ -166,7 +223,7 @@ void ConnectionAutomaton::close(
   reactiveSocket_ = nullptr;
   stats_->socketClosed(signal);
 
-  VLOG(6) << "close";
+  RSOCKET_VLOG(6) << "close";
 
   if (resumeCallback_) {
     resumeCallback_->onResumeError(
@@ -184,9 +241,22 @@ void ConnectionAutomaton::close(
   requestHandler_->socketOnClosed(ex);
 
   closeStreams(signal);
+  // the timer belongs to the EventBase, which the destructor may outlive
+  streamDeadlines_.clear();
+  deadlineTimer_.reset();
   closeFrameTransport(std::move(ex), signal);
 }
 
+void ConnectionAutomaton::connectFailed(folly::exception_wrapper ex) {
+  debugCheckCorrectExecutor();
+  DCHECK(!frameTransport_);
+
+  for (auto& stream : streamState_->streams_) {
+    stream.second->connectFailed(ex);
+  }
+  close(std::move(ex), StreamCompletionSignal::CONNECTION_ERROR);
+}
+
 void ConnectionAutomaton::closeFrameTransport(
     folly::exception_wrapper ex,
     StreamCompletionSignal signal) {
@@ -214,6 +284,9 @@ void ConnectionAutomaton::closeFrameTransport(
       signal == StreamCompletionSignal::CONNECTION_ERROR
           ? std::move(ex)
           : folly::exception_wrapper());
+  if (memoryAccountant_) {
+    frameTransport_->setMemoryAccountant(nullptr);
+  }
   frameTransport_ = nullptr;
 }
 
@@ -230,8 +303,8 @@ void ConnectionAutomaton::disconnectOrCloseWithError(Frame_ERROR&& errorFrame) {
 
 void ConnectionAutomaton::closeWithError(Frame_ERROR&& error) {
   debugCheckCorrectExecutor();
-  VLOG(3) << "closeWithError "
-          << error.payload_.data->cloneAsValue().moveToFbString();
+  RSOCKET_VLOG(3) << "closeWithError "
+                  << error.payload_.data->cloneAsValue().moveToFbString();
 
   StreamCompletionSignal signal;
   switch (error.errorCode_) {
@@ -297,7 +370,7 @@ void ConnectionAutomaton::endStream(
     StreamId streamId,
     StreamCompletionSignal signal) {
   debugCheckCorrectExecutor();
-  VLOG(6) << "endStream";
+  RSOCKET_VLOG(6) << "endStream";
   // The signal must be idempotent.
   if (!endStreamInternal(streamId, signal)) {
     return;
@@ -312,7 +385,7 @@ void ConnectionAutomaton::endStream(
 bool ConnectionAutomaton::endStreamInternal(
     StreamId streamId,
     StreamCompletionSignal signal) {
-  VLOG(6) << "endStreamInternal";
+  RSOCKET_VLOG(6) << "endStreamInternal";
   auto it = streamState_->streams_.find(streamId);
   if (it == streamState_->streams_.end()) {
     // Unsubscribe handshake initiated by the connection, we're done.
@@ -321,7 +394,14 @@ bool ConnectionAutomaton::endStreamInternal(
   // Remove from the map before notifying the automaton.
   auto automaton = std::move(it->second);
   streamState_->streams_.erase(it);
+  if (!streamDeadlines_.empty()) {
+    // cancels the timeout
+    streamDeadlines_.erase(streamId);
+  }
   automaton->endStream(signal);
+  if (drainAcknowledged_) {
+    closeIfDrained();
+  }
   return true;
 }
 
@@ -356,7 +436,7 @@ void ConnectionAutomaton::processFrame(std::unique_ptr<folly::IOBuf> frame) {
   auto thisPtr = this->shared_from_this();
   runInExecutor([ thisPtr, frame = std::move(frame) ]() mutable {
     thisPtr->processFrameImpl(std::move(frame));
-  });
+  }, "ConnectionAutomaton::processFrame");
 }
 
 void ConnectionAutomaton::processFrameImpl(
@@ -372,23 +452,26 @@ void ConnectionAutomaton::processFrameImpl(
     return;
   }
 
-  auto frameType = frameSerializer_->peekFrameType(*frame);
-  stats_->frameRead(frameType);
+  FrameHeader header;
+  const bool validHeader = peekFrameHeader(*frame, header);
+  stats_->frameRead(header.type_);
 
   // TODO(tmont): If a frame is invalid, it will still be tracked. However, we
   // actually want that. We want to keep
   // each side in sync, even if a frame is invalid.
-  resumeCache_->trackReceivedFrame(*frame, frameType);
+  if (resumeCache_) {
+    resumeCache_->trackReceivedFrame(*frame, header.type_);
+  }
 
-  auto streamIdPtr = frameSerializer_->peekStreamId(*frame);
-  if (!streamIdPtr) {
+  if (!validHeader) {
     // Failed to deserialize the frame.
     closeWithError(Frame_ERROR::invalidFrame());
     return;
   }
-  auto streamId = *streamIdPtr;
-  if (streamId == 0) {
-    handleConnectionFrame(frameType, std::move(frame));
+  traceFrame(FrameDirection::INBOUND, header, *frame);
+  TaskProfile::tagCurrent(header.streamId_, header.type_);
+  if (header.streamId_ == 0) {
+    handleConnectionFrame(header.type_, std::move(frame));
     return;
   }
 
@@ -402,7 +485,7 @@ void ConnectionAutomaton::processFrameImpl(
     return;
   }
 
-  handleStreamFrame(streamId, frameType, std::move(frame));
+  handleStreamFrame(header, std::move(frame));
 }
 
 void ConnectionAutomaton::onTerminal(folly::exception_wrapper ex) {
@@ -410,7 +493,7 @@ void ConnectionAutomaton::onTerminal(folly::exception_wrapper ex) {
   auto movedEx = folly::makeMoveWrapper(ex);
   runInExecutor([thisPtr, movedEx]() mutable {
     thisPtr->onTerminalImpl(movedEx.move());
-  });
+  }, "ConnectionAutomaton::onTerminal");
 }
 
 void ConnectionAutomaton::onTerminalImpl(folly::exception_wrapper ex) {
@@ -434,7 +517,16 @@ void ConnectionAutomaton::handleConnectionFrame(
         return;
       }
 
-      resumeCache_->resetUpToPosition(frame.position_);
+      if (resumeCache_) {
+        resumeCache_->resetUpToPosition(frame.position_);
+      }
+      if (draining_ && !drainAcknowledged_ &&
+          !(frame.header_.flags_ & FrameFlags::KEEPALIVE_RESPOND) &&
+          frame.data_ && folly::IOBufEqual()(*frame.data_, *drainMarker())) {
+        drainAcknowledged_ = true;
+        closeIfDrained();
+        return;
+      }
       if (mode_ == ReactiveSocketMode::SERVER) {
         if (!!(frame.header_.flags_ & FrameFlags::KEEPALIVE_RESPOND)) {
           sendKeepalive(FrameFlags::EMPTY, std::move(frame.data_));
@@ -444,8 +536,22 @@ void ConnectionAutomaton::handleConnectionFrame(
         }
       } else {
         if (!!(frame.header_.flags_ & FrameFlags::KEEPALIVE_RESPOND)) {
-          closeWithError(Frame_ERROR::connectionError(
-              "client received keepalive with respond flag"));
+          if (!peerDraining_) {
+            closeWithError(Frame_ERROR::connectionError(
+                "client received keepalive with respond flag"));
+            return;
+          }
+          // the draining server takes the answer as the last of the requests
+          // made under the old lease, so it goes after the requests already
+          // queued on the executor
+          runInExecutor([
+            self = shared_from_this(),
+            data = std::move(frame.data_)
+          ]() mutable {
+            if (!self->isDisconnectedOrClosed()) {
+              self->sendKeepalive(FrameFlags::EMPTY, std::move(data));
+            }
+          });
         } else if (keepaliveTimer_) {
           keepaliveTimer_->keepaliveReceived();
         }
@@ -462,20 +568,19 @@ void ConnectionAutomaton::handleConnectionFrame(
       } else {
         remoteResumeable_ = false;
       }
-      if (!!(frame.header_.flags_ & FrameFlags::LEASE)) {
-        // TODO(yschimke) We don't have the correct lease and wait logic above
-        // yet
-        LOG(ERROR) << "ignoring setup frame with lease";
-      }
-
+      // TODO(yschimke) We don't have the correct lease and wait logic above
+      // yet, the only lease sent is the one of drain()
       ConnectionSetupPayload setupPayload;
       frame.moveToSetupPayload(setupPayload);
+      peerHonorsLease_ = setupPayload.honorsLease;
 
       // this should be already set to the correct version
       if (frameSerializer_->protocolVersion() != setupPayload.protocolVersion) {
         closeWithError(Frame_ERROR::badSetupFrame("invalid protocol version"));
         return;
       }
+      startCompression(setupPayload.compression);
+      confirmCompression();
 
       requestHandler_->handleSetupPayload(
           *reactiveSocket_, std::move(setupPayload));
@@ -483,9 +588,15 @@ void ConnectionAutomaton::handleConnectionFrame(
     }
     case FrameType::METADATA_PUSH: {
       Frame_METADATA_PUSH frame;
-      if (deserializeFrameOrError(frame, std::move(payload))) {
-        requestHandler_->handleMetadataPush(std::move(frame.metadata_));
+      if (!deserializeFrameOrError(frame, std::move(payload))) {
+        return;
+      }
+      if (mode_ == ReactiveSocketMode::CLIENT && compression_ &&
+          frame.metadata_ &&
+          compression_->takeConfirmation(*frame.metadata_)) {
+        return;
       }
+      requestHandler_->handleMetadataPush(std::move(frame.metadata_));
       return;
     }
     case FrameType::RESUME: {
@@ -516,6 +627,7 @@ void ConnectionAutomaton::handleConnectionFrame(
         return;
       }
       if (resumeCallback_) {
+        DCHECK(resumeCache_);
         if (resumeCache_->isPositionAvailable(frame.position_)) {
           resumeCallback_->onResumeOk();
           resumeCallback_.reset();
@@ -551,8 +663,17 @@ void ConnectionAutomaton::handleConnectionFrame(
           StreamCompletionSignal::ERROR);
       return;
     }
+    case FrameType::LEASE: {
+      Frame_LEASE frame;
+      if (!deserializeFrameOrError(frame, std::move(payload))) {
+        return;
+      }
+      // requests are not metered, only a lease of no requests is honoured,
+      // it is sent by a peer which drains
+      peerDraining_ = frame.numberOfRequests_ == 0;
+      return;
+    }
     case FrameType::RESERVED:
-    case FrameType::LEASE:
     case FrameType::REQUEST_RESPONSE:
     case FrameType::REQUEST_FNF:
     case FrameType::REQUEST_STREAM:
@@ -568,17 +689,24 @@ void ConnectionAutomaton::handleConnectionFrame(
 }
 
 void ConnectionAutomaton::handleStreamFrame(
-    StreamId streamId,
-    FrameType frameType,
+    const FrameHeader& header,
     std::unique_ptr<folly::IOBuf> serializedFrame) {
-  auto it = streamState_->streams_.find(streamId);
+  auto it = streamState_->streams_.find(header.streamId_);
   if (it == streamState_->streams_.end()) {
-    handleUnknownStream(streamId, frameType, std::move(serializedFrame));
+    handleUnknownStream(
+        header.streamId_, header.type_, std::move(serializedFrame));
     return;
   }
   auto &automaton = it->second;
 
-  switch (frameType) {
+  if (memoryAccountant_ &&
+      memoryAccountant_->exceedsStreamCap(
+          serializedFrame->computeChainDataLength())) {
+    errorStreamOverMemoryCap(header.streamId_);
+    return;
+  }
+
+  switch (header.type_) {
     case FrameType::REQUEST_N: {
       Frame_REQUEST_N frameRequestN;
       if (!deserializeFrameOrError(frameRequestN,
@@ -593,11 +721,33 @@ void ConnectionAutomaton::handleStreamFrame(
       break;
     }
     case FrameType::PAYLOAD: {
+      if (frameSerializerV1_0_) {
+        // the payload keeps the received buffer, rather than cloning the
+        // metadata and the data out of it
+        PayloadFrameView frameView;
+        if (!frameSerializerV1_0_->deserializeFrom(
+                frameView, std::move(serializedFrame))) {
+          closeWithError(Frame_ERROR::invalidFrame());
+          return;
+        }
+        auto payload = frameView.takePayload();
+        if (!decompress(payload, header.streamId_, header.type_)) {
+          return;
+        }
+        automaton->handlePayload(std::move(payload),
+                                 frameView.header_.flagsComplete(),
+                                 frameView.header_.flagsNext());
+        break;
+      }
       Frame_PAYLOAD framePayload;
       if (!deserializeFrameOrError(framePayload,
                                    std::move(serializedFrame))) {
         return;
       }
+      if (!decompress(
+              framePayload.payload_, header.streamId_, header.type_)) {
+        return;
+      }
       automaton->handlePayload(std::move(framePayload.payload_),
                                framePayload.header_.flagsComplete(),
                                framePayload.header_.flagsNext());
@@ -609,8 +759,13 @@ void ConnectionAutomaton::handleStreamFrame(
                                    std::move(serializedFrame))) {
         return;
       }
-      automaton->handleError(
-          std::runtime_error(frameError.payload_.moveDataToString()));
+      auto message = frameError.payload_.moveDataToString();
+      if (frameError.errorCode_ == ErrorCode::REJECTED) {
+        automaton->handleError(
+            folly::make_exception_wrapper<RejectedException>(message));
+      } else {
+        automaton->handleError(std::runtime_error(message));
+      }
       break;
     }
     case FrameType::REQUEST_CHANNEL:
@@ -646,11 +801,22 @@ void ConnectionAutomaton::handleUnknownStream(
       !streamsFactory_.registerNewPeerStreamId(streamId)) {
     return;
   }
+  if (drainAcknowledged_ &&
+      (frameType == FrameType::REQUEST_CHANNEL ||
+       frameType == FrameType::REQUEST_STREAM ||
+       frameType == FrameType::REQUEST_RESPONSE)) {
+    // the peer ignored the lease, a fire-and-forget is still taken as it
+    // does not hold the connection open
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::rejected(streamId, Payload("draining"))));
+    return;
+  }
 
   switch (frameType) {
     case FrameType::REQUEST_CHANNEL: {
       Frame_REQUEST_CHANNEL frame;
-      if (!deserializeFrameOrError(frame, std::move(serializedFrame))) {
+      if (!deserializeFrameOrError(frame, std::move(serializedFrame)) ||
+          !decompress(frame.payload_, streamId, frameType)) {
         return;
       }
       auto automaton = streamsFactory_.createChannelResponder(
@@ -662,7 +828,8 @@ void ConnectionAutomaton::handleUnknownStream(
     }
     case FrameType::REQUEST_STREAM: {
       Frame_REQUEST_STREAM frame;
-      if (!deserializeFrameOrError(frame, std::move(serializedFrame))) {
+      if (!deserializeFrameOrError(frame, std::move(serializedFrame)) ||
+          !decompress(frame.payload_, streamId, frameType)) {
         return;
       }
       auto automaton = streamsFactory_.createStreamResponder(
@@ -673,7 +840,8 @@ void ConnectionAutomaton::handleUnknownStream(
     }
     case FrameType::REQUEST_RESPONSE: {
       Frame_REQUEST_RESPONSE frame;
-      if (!deserializeFrameOrError(frame, std::move(serializedFrame))) {
+      if (!deserializeFrameOrError(frame, std::move(serializedFrame)) ||
+          !decompress(frame.payload_, streamId, frameType)) {
         return;
       }
       auto automaton =
@@ -684,7 +852,8 @@ void ConnectionAutomaton::handleUnknownStream(
     }
     case FrameType::REQUEST_FNF: {
       Frame_REQUEST_FNF frame;
-      if (!deserializeFrameOrError(frame, std::move(serializedFrame))) {
+      if (!deserializeFrameOrError(frame, std::move(serializedFrame)) ||
+          !decompress(frame.payload_, streamId, frameType)) {
         return;
       }
       // no stream tracking is necessary
@@ -722,7 +891,9 @@ void ConnectionAutomaton::sendKeepalive(
     std::unique_ptr<folly::IOBuf> data) {
   debugCheckCorrectExecutor();
   Frame_KEEPALIVE pingFrame(
-      flags, resumeCache_->impliedPosition(), std::move(data));
+      flags,
+      resumeCache_ ? resumeCache_->impliedPosition() : 0,
+      std::move(data));
   outputFrameOrEnqueue(
       frameSerializer_->serializeOut(std::move(pingFrame), remoteResumeable_));
 }
@@ -742,18 +913,25 @@ void ConnectionAutomaton::tryClientResume(
   reconnect(std::move(frameTransport), std::move(resumeCallback));
 }
 
+void ConnectionAutomaton::setPeerHonorsLease(bool honorsLease) {
+  debugCheckCorrectExecutor();
+  DCHECK(isDisconnectedOrClosed());
+  peerHonorsLease_ = honorsLease;
+}
+
 Frame_RESUME ConnectionAutomaton::createResumeFrame(
     const ResumeIdentificationToken& token) const {
+  // a connection which was not resumable resumes from the start
   return Frame_RESUME(
       token,
-      resumeCache_->impliedPosition(),
-      resumeCache_->lastResetPosition(),
+      resumeCache_ ? resumeCache_->impliedPosition() : 0,
+      resumeCache_ ? resumeCache_->lastResetPosition() : 0,
       frameSerializer_->protocolVersion());
 }
 
 bool ConnectionAutomaton::isPositionAvailable(ResumePosition position) {
   debugCheckCorrectExecutor();
-  return resumeCache_->isPositionAvailable(position);
+  return resumeCache_ && resumeCache_->isPositionAvailable(position);
 }
 
 bool ConnectionAutomaton::resumeFromPositionOrClose(
@@ -764,6 +942,11 @@ bool ConnectionAutomaton::resumeFromPositionOrClose(
   DCHECK(!isDisconnectedOrClosed());
   DCHECK(mode_ == ReactiveSocketMode::SERVER);
 
+  if (!resumeCache_) {
+    closeWithError(Frame_ERROR::connectionError("RS not resumable"));
+    return false;
+  }
+
   bool clientPositionExist = (clientPosition == kUnspecifiedResumePosition) ||
       resumeCache_->canResumeFrom(clientPosition);
 
@@ -788,7 +971,7 @@ bool ConnectionAutomaton::resumeFromPositionOrClose(
 void ConnectionAutomaton::resumeFromPosition(ResumePosition position) {
   DCHECK(!resumeCallback_);
   DCHECK(!isDisconnectedOrClosed());
-  DCHECK(resumeCache_->isPositionAvailable(position));
+  DCHECK(resumeCache_ && resumeCache_->isPositionAvailable(position));
 
   resumeStreams();
   resumeCache_->sendFramesFromPosition(position, *frameTransport_);
@@ -808,17 +991,159 @@ void ConnectionAutomaton::outputFrameOrEnqueue(
   // if we are resuming we cant send any frames until we receive RESUME_OK
   if (!isDisconnectedOrClosed() && !resumeCallback_) {
     outputFrame(std::move(frame));
-  } else {
+    return;
+  }
+
+  // only the live streams are held to their cap, which also keeps the ERROR
+  // frame of a terminated stream from being accounted again
+  FrameHeader header;
+  if (!memoryAccountant_ || !memoryAccountant_->limits().streamBytes ||
+      !peekFrameHeader(*frame, header) ||
+      !streamState_->streams_.count(header.streamId_)) {
     streamState_->enqueueOutputPendingFrame(std::move(frame));
+    return;
+  }
+  const auto streamBytes = streamState_->enqueueOutputPendingFrame(
+      std::move(frame), header.streamId_);
+  if (memoryAccountant_->exceedsStreamCap(streamBytes)) {
+    errorStreamOverMemoryCap(header.streamId_);
+  }
+}
+
+void ConnectionAutomaton::errorStreamOverMemoryCap(StreamId streamId) {
+  RSOCKET_VLOG(2) << "stream " << streamId << " exceeded its memory cap";
+  stats_->streamMemoryCapExceeded();
+  endStreamInternal(streamId, StreamCompletionSignal::ERROR);
+  writeCloseStream(
+      streamId,
+      StreamCompletionSignal::ERROR,
+      Payload("stream memory cap exceeded"));
+}
+
+void ConnectionAutomaton::setMemoryLimits(const MemoryLimits& limits) {
+  debugCheckCorrectExecutor();
+  memoryAccountant_ = std::make_shared<MemoryAccountant>(limits, stats_);
+  streamState_->setMemoryAccountant(memoryAccountant_);
+  if (frameTransport_) {
+    frameTransport_->setMemoryAccountant(memoryAccountant_);
+  }
+}
+
+class ConnectionAutomaton::StreamDeadline
+    : public folly::HHWheelTimer::Callback {
+ public:
+  StreamDeadline(ConnectionAutomaton& connection, StreamId streamId)
+      : connection_(connection), streamId_(streamId) {}
+
+  void timeoutExpired() noexcept override {
+    connection_.streamDeadlineExceeded(streamId_);
+  }
+
+  void callbackCanceled() noexcept override {}
+
+ private:
+  ConnectionAutomaton& connection_;
+  const StreamId streamId_;
+};
+
+void ConnectionAutomaton::setStreamDeadline(
+    StreamId streamId,
+    const RequestDeadline& deadline) {
+  debugCheckCorrectExecutor();
+  if (!deadline || !streamState_->streams_.count(streamId)) {
+    // no deadline, or the stream has already ended
+    return;
+  }
+  if (!deadlineTimer_) {
+    auto eventBase = dynamic_cast<folly::EventBase*>(&executor());
+    if (!eventBase) {
+      LOG_FIRST_N(WARNING, 1)
+          << "stream deadlines need the connection to run on an EventBase";
+      return;
+    }
+    deadlineTimer_ = folly::HHWheelTimer::newTimer(eventBase);
+  }
+  auto& timeout = streamDeadlines_[streamId];
+  if (!timeout) {
+    timeout = std::make_unique<StreamDeadline>(*this, streamId);
+  }
+  deadlineTimer_->scheduleTimeout(
+      timeout.get(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline.remaining()));
+}
+
+void ConnectionAutomaton::streamDeadlineExceeded(StreamId streamId) {
+  // the timeout is running, it is destroyed once it returns
+  auto it = streamDeadlines_.find(streamId);
+  DCHECK(it != streamDeadlines_.end());
+  auto timeout = std::move(it->second);
+  streamDeadlines_.erase(it);
+
+  auto stream = streamState_->streams_.find(streamId);
+  if (stream != streamState_->streams_.end()) {
+    auto automaton = stream->second;
+    automaton->failStream(
+        folly::make_exception_wrapper<DeadlineExceededException>());
+  }
+}
+
+void ConnectionAutomaton::drain() {
+  debugCheckCorrectExecutor();
+  if (draining_ || isClosed_) {
+    return;
+  }
+  if (!frameSerializer_) {
+    // no SETUP yet, there are no requests to wait for
+    close(folly::exception_wrapper(), StreamCompletionSignal::CONNECTION_END);
+    return;
+  }
+  RSOCKET_VLOG(3) << "draining";
+  draining_ = true;
+
+  // only a 1.0 server may send a KEEPALIVE asking for an answer
+  if (mode_ != ReactiveSocketMode::SERVER || !peerHonorsLease_ ||
+      frameSerializer_->protocolVersion() < ProtocolVersion(1, 0)) {
+    drainAcknowledged_ = true;
+    closeIfDrained();
+    return;
   }
+  outputFrameOrEnqueue(frameSerializer_->serializeOut(
+      Frame_LEASE(Frame_LEASE::kMaxTtl, 0)));
+  sendKeepalive(FrameFlags::KEEPALIVE_RESPOND, drainMarker());
+}
+
+void ConnectionAutomaton::closeIfDrained() {
+  if (isClosed_ || !streamState_->streams_.empty()) {
+    return;
+  }
+  // the last stream may be ending from within its own signals
+  runInExecutor([self = shared_from_this()] {
+    if (!self->isClosed_ && self->streamState_->streams_.empty()) {
+      RSOCKET_VLOG(3) << "drained";
+      self->close(
+          folly::exception_wrapper(), StreamCompletionSignal::CONNECTION_END);
+    }
+  });
 }
 
 void ConnectionAutomaton::requestFireAndForget(Payload request) {
+  Stats::Clock::time_point issuedAt;
+  if (stats_->latencyTrackingEnabled()) {
+    issuedAt = Stats::Clock::now();
+    stats_->requestIssued(StreamType::FNF, issuedAt);
+  }
+  if (compression_) {
+    compression_->compress(request);
+  }
   Frame_REQUEST_FNF frame(
       streamsFactory().getNextStreamId(),
       FrameFlags::EMPTY,
       std::move(std::move(request)));
   outputFrameOrEnqueue(frameSerializer_->serializeOut(std::move(frame)));
+  if (issuedAt != Stats::Clock::time_point()) {
+    stats_->requestWritten(StreamType::FNF, issuedAt, Stats::Clock::now());
+  }
 }
 
 void ConnectionAutomaton::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
@@ -826,15 +1151,55 @@ void ConnectionAutomaton::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
       Frame_METADATA_PUSH(std::move(metadata))));
 }
 
+bool ConnectionAutomaton::decompress(
+    Payload& payload,
+    StreamId streamId,
+    FrameType frameType) {
+  if (!compression_) {
+    return true;
+  }
+  switch (compression_->decompress(payload)) {
+    case PayloadCompression::Status::OK:
+      return true;
+    case PayloadCompression::Status::CORRUPT:
+      closeWithError(
+          Frame_ERROR::connectionError("invalid compressed payload"));
+      return false;
+    case PayloadCompression::Status::TOO_LARGE:
+      break;
+  }
+
+  if (frameType == FrameType::PAYLOAD) {
+    auto it = streamState_->streams_.find(streamId);
+    if (it != streamState_->streams_.end()) {
+      auto automaton = it->second;
+      automaton->failStream(
+          folly::make_exception_wrapper<PayloadTooLargeException>());
+    }
+  } else if (frameType != FrameType::REQUEST_FNF) {
+    // a new request, which has no stream to fail yet
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::error(streamId, Payload("payload too large"))));
+  }
+  return false;
+}
+
 void ConnectionAutomaton::outputFrame(std::unique_ptr<folly::IOBuf> frame) {
   DCHECK(!isDisconnectedOrClosed());
 
-  auto frameType = frameSerializer_->peekFrameType(*frame);
-  stats_->frameWritten(frameType);
+  FrameHeader header;
+  const bool validHeader = peekFrameHeader(*frame, header);
+  stats_->frameWritten(header.type_);
+  if (validHeader) {
+    traceFrame(FrameDirection::OUTBOUND, header, *frame);
+  }
 
   if (isResumable_) {
-    auto streamIdPtr = frameSerializer_->peekStreamId(*frame);
-    resumeCache_->trackSentFrame(*frame, frameType, streamIdPtr);
+    resumeCache_->trackSentFrame(
+        *frame,
+        header.type_,
+        validHeader ? folly::Optional<StreamId>(header.streamId_)
+                    : folly::none);
   }
   frameTransport_->outputFrameOrEnqueue(std::move(frame));
 }
@@ -854,6 +1219,26 @@ bool ConnectionAutomaton::isClosed() const {
   return isClosed_;
 }
 
+FlowControlSnapshot ConnectionAutomaton::flowControlSnapshot() const {
+  debugCheckCorrectExecutor();
+  FlowControlSnapshot snapshot;
+  snapshot.streams.reserve(streamState_->streams_.size());
+  for (const auto& stream : streamState_->streams_) {
+    snapshot.streams.emplace_back();
+    stream.second->flowControl(snapshot.streams.back());
+  }
+  snapshot.pendingFrames = streamState_->outputPendingFrames();
+  snapshot.pendingBytes = streamState_->outputPendingBytes();
+  if (frameTransport_) {
+    std::tie(snapshot.pendingWriteFrames, snapshot.pendingWriteBytes) =
+        frameTransport_->pendingWrites();
+  }
+  if (isResumable_) {
+    snapshot.unacknowledgedBytes = resumeCache_->size();
+  }
+  return snapshot;
+}
+
 DuplexConnection* ConnectionAutomaton::duplexConnection() const {
   debugCheckCorrectExecutor();
   return frameTransport_ ? frameTransport_->duplexConnection() : nullptr;
@@ -886,6 +1271,8 @@ void ConnectionAutomaton::setFrameSerializer(
   // serializer is not interchangeable, it would screw up resumability
   // CHECK(!frameSerializer_);
   frameSerializer_ = std::move(frameSerializer);
+  frameSerializerV1_0_ =
+      dynamic_cast<FrameSerializerV1_0*>(frameSerializer_.get());
 }
 
 void ConnectionAutomaton::setUpFrame(
@@ -893,8 +1280,26 @@ void ConnectionAutomaton::setUpFrame(
     ConnectionSetupPayload setupPayload) {
   auto protocolVersion = getSerializerProtocolVersion();
 
+  // made resumable after it was constructed
+  if (setupPayload.resumable && setupPayload.token.data().empty()) {
+    setupPayload.token = ResumeIdentificationToken::generateNew();
+  }
+  // the offer is a composite metadata entry, which a server that does not
+  // know of compression would pass on to the application as it is
+  if (setupPayload.compression.compositeMetadata &&
+      !setupPayload.compression.codecs.empty()) {
+    PayloadCompression::attachOffer(
+        setupPayload.compression.codecs, setupPayload.payload);
+  }
+
+  auto flags =
+      setupPayload.resumable ? FrameFlags::RESUME_ENABLE : FrameFlags::EMPTY;
+  if (setupPayload.honorsLease) {
+    flags |= FrameFlags::LEASE;
+  }
+
   Frame_SETUP frame(
-      setupPayload.resumable ? FrameFlags::RESUME_ENABLE : FrameFlags::EMPTY,
+      flags,
       protocolVersion.major,
       protocolVersion.minor,
       getKeepaliveTime(),
@@ -925,6 +1330,9 @@ void ConnectionAutomaton::writeNewStream(
     uint32_t initialRequestN,
     Payload payload,
     bool completed) {
+  if (compression_) {
+    compression_->compress(payload);
+  }
   switch (streamType) {
     case StreamType::CHANNEL:
       outputFrameOrEnqueue(frameSerializer_->serializeOut(Frame_REQUEST_CHANNEL(
@@ -964,6 +1372,9 @@ void ConnectionAutomaton::writePayload(
     StreamId streamId,
     Payload payload,
     bool complete) {
+  if (compression_) {
+    compression_->compress(payload);
+  }
   Frame_PAYLOAD frame(
       streamId,
       FrameFlags::NEXT | (complete ? FrameFlags::COMPLETE : FrameFlags::EMPTY),
@@ -1033,8 +1444,9 @@ bool ConnectionAutomaton::ensureOrAutodetectFrameSerializer(
     return false;
   }
 
-  VLOG(2) << "detected protocol version" << serializer->protocolVersion();
-  frameSerializer_ = std::move(serializer);
+  RSOCKET_VLOG(2) << "detected protocol version"
+                  << serializer->protocolVersion();
+  setFrameSerializer(std::move(serializer));
   return true;
 }
 } // reactivesocket
@@ -2,15 +2,20 @@
 
 #pragma once
 
+#include <folly/io/async/HHWheelTimer.h>
+#include <atomic>
 #include <list>
 #include <memory>
+#include <unordered_map>
 #include "src/AllowanceSemaphore.h"
 #include "src/Common.h"
 #include "src/DuplexConnection.h"
 #include "src/Executor.h"
+#include "src/FlowControlSnapshot.h"
 #include "src/Frame.h"
 #include "src/FrameProcessor.h"
 #include "src/FrameSerializer.h"
+#include "src/versions/FrameSerializer_v1_0.h"
 #include "src/Payload.h"
 #include "src/StreamsFactory.h"
 #include "src/StreamsHandler.h"
@@ -24,11 +29,16 @@ class DuplexConnection;
 class Frame_ERROR;
 class FrameTransport;
 class KeepaliveTimer;
+class MemoryAccountant;
+class PayloadCompression;
+struct MemoryLimits;
+class RequestDeadline;
 class RequestHandler;
 class ResumeCache;
 class Stats;
 class StreamState;
 class SocketParameters;
+struct CompressionOptions;
 
 class FrameSink {
  public:
@@ -89,6 +99,12 @@ class ConnectionAutomaton final
   /// StreamAutomatonBase attached to this ConnectionAutomaton.
   void close(folly::exception_wrapper, StreamCompletionSignal);
 
+  /// Closes a disconnected client whose transport could not be connected.
+  ///
+  /// The streams requested while disconnected fail with the connect error
+  /// rather than with a StreamInterruptedException.
+  void connectFailed(folly::exception_wrapper ex);
+
   std::shared_ptr<FrameTransport> detachFrameTransport();
 
   /// Terminate underlying connection and connect new connection
@@ -136,6 +152,16 @@ class ConnectionAutomaton final
   void sendKeepalive(std::unique_ptr<folly::IOBuf> data) override;
 
   void setResumable(bool resumable);
+  /// Compresses the payloads of the connection when the options have codecs:
+  /// those the client offers, or those the client offered to the server.
+  /// Set before the connection is connected, like setResumable.
+  void setCompression(const CompressionOptions& options);
+  /// Tells the client which of the codecs it offered the server compresses
+  /// with. Called by the server once connected.
+  void confirmCompression();
+  /// Whether the client announced in SETUP that it honours LEASE frames,
+  /// see drain().
+  void setPeerHonorsLease(bool honorsLease);
   Frame_RESUME createResumeFrame(const ResumeIdentificationToken& token) const;
 
   bool isPositionAvailable(ResumePosition position);
@@ -148,7 +174,9 @@ class ConnectionAutomaton final
   bool deserializeFrameOrError(
       TFrame& frame,
       std::unique_ptr<folly::IOBuf> payload) {
-    if (frameSerializer_->deserializeFrom(frame, std::move(payload))) {
+    if (frameSerializerV1_0_
+            ? frameSerializerV1_0_->deserializeFrom(frame, std::move(payload))
+            : frameSerializer_->deserializeFrom(frame, std::move(payload))) {
       return true;
     } else {
       closeWithError(Frame_ERROR::invalidFrame());
@@ -161,8 +189,11 @@ class ConnectionAutomaton final
       bool resumable,
       TFrame& frame,
       std::unique_ptr<folly::IOBuf> payload) {
-    if (frameSerializer_->deserializeFrom(
-            frame, std::move(payload), resumable)) {
+    if (frameSerializerV1_0_
+            ? frameSerializerV1_0_->deserializeFrom(
+                  frame, std::move(payload), resumable)
+            : frameSerializer_->deserializeFrom(
+                  frame, std::move(payload), resumable)) {
       return true;
     } else {
       closeWithError(Frame_ERROR::invalidFrame());
@@ -170,6 +201,12 @@ class ConnectionAutomaton final
     }
   }
 
+  bool peekFrameHeader(const folly::IOBuf& frame, FrameHeader& header) {
+    return frameSerializerV1_0_
+        ? frameSerializerV1_0_->peekFrameHeader(frame, header)
+        : frameSerializer_->peekFrameHeader(frame, header);
+  }
+
   bool resumeFromPositionOrClose(
       ResumePosition serverPosition,
       ResumePosition clientPosition);
@@ -201,10 +238,45 @@ class ConnectionAutomaton final
 
   void setFrameSerializer(std::unique_ptr<FrameSerializer>);
 
-  Stats& stats() {
+  Stats& stats() override {
     return *stats_;
   }
 
+  /// Returns the REQUEST_N credit of every live stream in both directions,
+  /// how long the streams have been starved of it, and what is queued on
+  /// the connection.  Meant for debugging and tuning, the cost is linear in
+  /// the number of streams.
+  FlowControlSnapshot flowControlSnapshot() const;
+
+  /// Caps the memory the connection buffers, see MemoryLimits.
+  void setMemoryLimits(const MemoryLimits& limits);
+
+  /// Fails the stream with DeadlineExceededException when the deadline
+  /// passes before the stream ends, see StreamAutomatonBase::failStream.
+  ///
+  /// The deadlines of a connection share a timer wheel, which needs the
+  /// connection to run on an EventBase; on any other executor the deadline
+  /// is not enforced.
+  void setStreamDeadline(StreamId streamId, const RequestDeadline& deadline);
+
+  /// Stops taking requests from the peer and closes the connection once the
+  /// streams in flight end.
+  ///
+  /// A client which honours leases and speaks protocol 1.0 is sent a LEASE
+  /// of no requests, followed by a KEEPALIVE which it answers only after it
+  /// has seen the lease. Requests received before the answer are still
+  /// served, later ones are rejected.  Any other peer may close the
+  /// connection on either frame, so it is sent nothing and new requests are
+  /// rejected right away.  Closing the connection when it does not drain in
+  /// time is up to the caller.
+  void drain();
+
+  /// Whether the peer granted no requests, as it does when it drains.  Safe
+  /// to call from any thread.
+  bool isPeerDraining() const {
+    return peerDraining_;
+  }
+
  private:
   /// Performs the same actions as ::endStream without propagating closure
   /// signal to the underlying connection.
@@ -227,8 +299,7 @@ class ConnectionAutomaton final
   void handleConnectionFrame(FrameType frameType,
                              std::unique_ptr<folly::IOBuf>);
   void handleStreamFrame(
-      StreamId streamId,
-      FrameType frameType,
+      const FrameHeader& header,
       std::unique_ptr<folly::IOBuf> frame);
   void handleUnknownStream(
       StreamId streamId,
@@ -243,8 +314,23 @@ class ConnectionAutomaton final
   void sendKeepalive(FrameFlags flags, std::unique_ptr<folly::IOBuf> data);
 
   void resumeFromPosition(ResumePosition position);
+  void startCompression(const CompressionOptions& options);
+  /// Decompresses a received payload of the stream, see PayloadCompression.
+  /// Returns false when it can not: corrupt data close the connection, data
+  /// too large once decompressed fail the stream. A new request has no
+  /// stream yet and is answered with an ERROR, a fire-and-forget is dropped.
+  bool decompress(Payload& payload, StreamId streamId, FrameType frameType);
   void outputFrame(std::unique_ptr<folly::IOBuf>);
 
+  /// Terminates a stream which exceeded MemoryLimits::streamBytes.
+  void errorStreamOverMemoryCap(StreamId streamId);
+
+  class StreamDeadline;
+  void streamDeadlineExceeded(StreamId streamId);
+
+  /// Closes the connection when it is draining and has no streams left.
+  void closeIfDrained();
+
   void debugCheckCorrectExecutor() const;
 
   void pauseStreams();
@@ -274,12 +360,35 @@ class ConnectionAutomaton final
   bool isResumable_{false};
   bool remoteResumeable_{false};
   bool isClosed_{false};
-
+  /// See setPeerHonorsLease.
+  bool peerHonorsLease_{false};
+  /// Set by drain().
+  bool draining_{false};
+  /// Set when the peer answered the KEEPALIVE sent by drain(), every request
+  /// it sent before it saw the lease has been received by then.  Set right
+  /// away when the peer is not sent the lease.
+  bool drainAcknowledged_{false};
+  std::atomic<bool> peerDraining_{false};
+
+  /// Only resumable connections have one.
   std::shared_ptr<ResumeCache> resumeCache_;
   std::shared_ptr<StreamState> streamState_;
   std::shared_ptr<RequestHandler> requestHandler_;
   std::shared_ptr<FrameTransport> frameTransport_;
+  /// Set when the connection has MemoryLimits.
+  std::shared_ptr<MemoryAccountant> memoryAccountant_;
   std::unique_ptr<FrameSerializer> frameSerializer_;
+  /// frameSerializer_ when it is the 1.0 one, to parse the incoming frames
+  /// without virtual calls.
+  FrameSerializerV1_0* frameSerializerV1_0_{nullptr};
+  /// Set when the client offered compression at SETUP.
+  std::unique_ptr<PayloadCompression> compression_;
+
+  /// Created with the first stream deadline, destroyed by close() on the
+  /// EventBase.
+  folly::HHWheelTimer::UniquePtr deadlineTimer_;
+  std::unordered_map<StreamId, std::unique_ptr<StreamDeadline>>
+      streamDeadlines_;
 
   std::list<std::function<void()>> onConnectListeners_;
   std::list<ErrorCallback> onDisconnectListeners_;
@@ -7,6 +7,7 @@
 #include "src/Common.h"
 #include "src/FrameSerializer.h"
 #include "src/Payload.h"
+#include "src/PayloadCompression.h"
 
 namespace reactivesocket {
 
@@ -17,6 +18,13 @@ class SocketParameters {
 
   bool resumable;
   ProtocolVersion protocolVersion;
+  /// Codecs offered by the client at SETUP, see PayloadCompression. Only
+  /// offered when the metadata mime type is kCompositeMetadataMimeType.
+  CompressionOptions compression;
+  /// The client honours LEASE frames, which it tells the server with the
+  /// LEASE flag of SETUP.  Only such a client is asked to go elsewhere when
+  /// the server drains, see ConnectionAutomaton::drain.
+  bool honorsLease{false};
 };
 
 // TODO: rename this and the whole file to SetupParams
@@ -27,19 +35,22 @@ class ConnectionSetupPayload : public SocketParameters {
       std::string _dataMimeType = "",
       Payload _payload = Payload(),
       bool _resumable = false,
-      const ResumeIdentificationToken& _token =
-          ResumeIdentificationToken::generateNew(),
+      const ResumeIdentificationToken& _token = ResumeIdentificationToken(),
       ProtocolVersion _protocolVersion =
           FrameSerializer::getCurrentProtocolVersion())
       : SocketParameters(_resumable, _protocolVersion),
         metadataMimeType(std::move(_metadataMimeType)),
         dataMimeType(std::move(_dataMimeType)),
         payload(std::move(_payload)),
-        token(_token) {}
+        token(
+            _resumable && _token.data().empty()
+                ? ResumeIdentificationToken::generateNew()
+                : _token) {}
 
   std::string metadataMimeType;
   std::string dataMimeType;
   Payload payload;
+  /// Only generated for resumable connections, when none is given.
   ResumeIdentificationToken token;
 };
 
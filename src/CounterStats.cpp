@@ -0,0 +1,192 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/CounterStats.h"
+#include <folly/Conv.h>
+#include <folly/json.h>
+#include <sstream>
+
+namespace reactivesocket {
+
+namespace {
+size_t indexOf(FrameType frameType) {
+  return static_cast<size_t>(frameType) % CounterStats::kFrameTypes;
+}
+
+/// Name of a frame type, including those unknown to this version.
+std::string frameTypeName(size_t index) {
+  auto frameType = static_cast<FrameType>(index);
+  switch (frameType) {
+    case FrameType::RESERVED:
+    case FrameType::SETUP:
+    case FrameType::LEASE:
+    case FrameType::KEEPALIVE:
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+    case FrameType::REQUEST_N:
+    case FrameType::CANCEL:
+    case FrameType::PAYLOAD:
+    case FrameType::ERROR:
+    case FrameType::METADATA_PUSH:
+    case FrameType::RESUME:
+    case FrameType::RESUME_OK:
+    case FrameType::EXT:
+      return to_string(frameType);
+  }
+  return "UNKNOWN_" + folly::to<std::string>(index);
+}
+
+folly::dynamic framesToDynamic(
+    const std::array<uint64_t, CounterStats::kFrameTypes>& frames) {
+  auto result = folly::dynamic::object();
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frames[i]) {
+      result[frameTypeName(i)] = frames[i];
+    }
+  }
+  return result;
+}
+}
+
+CounterStats::Block::Block() {
+  for (auto& counter : counters_) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+}
+
+void CounterStats::Block::mergeInto(Block& other) const {
+  for (size_t i = 0; i < COUNTERS; ++i) {
+    other.counters_[i].fetch_add(
+        counters_[i].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+}
+
+void CounterStats::socketCreated() {
+  add(SOCKETS_CREATED);
+}
+
+void CounterStats::socketDisconnected() {
+  add(SOCKETS_DISCONNECTED);
+}
+
+void CounterStats::socketClosed(StreamCompletionSignal) {
+  add(SOCKETS_CLOSED);
+}
+
+void CounterStats::duplexConnectionCreated(
+    const std::string&,
+    DuplexConnection*) {
+  add(DUPLEX_CONNECTIONS_CREATED);
+}
+
+void CounterStats::duplexConnectionClosed(
+    const std::string&,
+    DuplexConnection*) {
+  add(DUPLEX_CONNECTIONS_CLOSED);
+}
+
+void CounterStats::bytesWritten(size_t bytes) {
+  add(BYTES_WRITTEN, static_cast<int64_t>(bytes));
+}
+
+void CounterStats::bytesRead(size_t bytes) {
+  add(BYTES_READ, static_cast<int64_t>(bytes));
+}
+
+void CounterStats::frameWritten(FrameType frameType) {
+  add(FRAMES_WRITTEN + indexOf(frameType));
+}
+
+void CounterStats::frameRead(FrameType frameType) {
+  add(FRAMES_READ + indexOf(frameType));
+}
+
+void CounterStats::resumeBufferChanged(
+    int framesCountDelta,
+    int dataSizeDelta) {
+  auto& block = blocks_.local();
+  block.add(RESUME_BUFFER_FRAMES, framesCountDelta);
+  block.add(RESUME_BUFFER_BYTES, dataSizeDelta);
+}
+
+void CounterStats::streamBufferChanged(
+    int64_t framesCountDelta,
+    int64_t dataSizeDelta) {
+  auto& block = blocks_.local();
+  block.add(STREAM_BUFFER_FRAMES, framesCountDelta);
+  block.add(STREAM_BUFFER_BYTES, dataSizeDelta);
+}
+
+CounterStats::Snapshot CounterStats::snapshot() const {
+  Block total;
+  blocks_.aggregate(total);
+
+  auto get = [&](size_t counter) {
+    return total.counters_[counter].load(std::memory_order_relaxed);
+  };
+  Snapshot snapshot;
+  snapshot.socketsCreated = get(SOCKETS_CREATED);
+  snapshot.socketsDisconnected = get(SOCKETS_DISCONNECTED);
+  snapshot.socketsClosed = get(SOCKETS_CLOSED);
+  snapshot.duplexConnectionsCreated = get(DUPLEX_CONNECTIONS_CREATED);
+  snapshot.duplexConnectionsClosed = get(DUPLEX_CONNECTIONS_CLOSED);
+  snapshot.bytesWritten = get(BYTES_WRITTEN);
+  snapshot.bytesRead = get(BYTES_READ);
+  for (size_t i = 0; i < kFrameTypes; ++i) {
+    snapshot.framesWritten[i] = get(FRAMES_WRITTEN + i);
+    snapshot.framesRead[i] = get(FRAMES_READ + i);
+  }
+  snapshot.resumeBufferFrames = get(RESUME_BUFFER_FRAMES);
+  snapshot.resumeBufferBytes = get(RESUME_BUFFER_BYTES);
+  snapshot.streamBufferFrames = get(STREAM_BUFFER_FRAMES);
+  snapshot.streamBufferBytes = get(STREAM_BUFFER_BYTES);
+  return snapshot;
+}
+
+folly::dynamic CounterStats::Snapshot::toDynamic() const {
+  return folly::dynamic::object("sockets_created", socketsCreated)(
+      "sockets_disconnected", socketsDisconnected)(
+      "sockets_closed", socketsClosed)(
+      "duplex_connections_created", duplexConnectionsCreated)(
+      "duplex_connections_closed", duplexConnectionsClosed)(
+      "bytes_written", bytesWritten)("bytes_read", bytesRead)(
+      "frames_written", framesToDynamic(framesWritten))(
+      "frames_read", framesToDynamic(framesRead))(
+      "resume_buffer_frames", resumeBufferFrames)(
+      "resume_buffer_bytes", resumeBufferBytes)(
+      "stream_buffer_frames", streamBufferFrames)(
+      "stream_buffer_bytes", streamBufferBytes);
+}
+
+std::string CounterStats::Snapshot::toJson() const {
+  return folly::toJson(toDynamic());
+}
+
+std::string CounterStats::Snapshot::toString() const {
+  std::ostringstream os;
+  auto frames = [&](const char* name,
+                    const std::array<uint64_t, kFrameTypes>& counts) {
+    for (size_t i = 0; i < counts.size(); ++i) {
+      if (counts[i]) {
+        os << name << '.' << frameTypeName(i) << ' ' << counts[i] << '\n';
+      }
+    }
+  };
+  os << "sockets_created " << socketsCreated << '\n'
+     << "sockets_disconnected " << socketsDisconnected << '\n'
+     << "sockets_closed " << socketsClosed << '\n'
+     << "duplex_connections_created " << duplexConnectionsCreated << '\n'
+     << "duplex_connections_closed " << duplexConnectionsClosed << '\n'
+     << "bytes_written " << bytesWritten << '\n'
+     << "bytes_read " << bytesRead << '\n';
+  frames("frames_written", framesWritten);
+  frames("frames_read", framesRead);
+  os << "resume_buffer_frames " << resumeBufferFrames << '\n'
+     << "resume_buffer_bytes " << resumeBufferBytes << '\n'
+     << "stream_buffer_frames " << streamBufferFrames << '\n'
+     << "stream_buffer_bytes " << streamBufferBytes << '\n';
+  return os.str();
+}
+}
@@ -0,0 +1,109 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/dynamic.h>
+#include <array>
+#include <atomic>
+#include "src/Frame.h"
+#include "src/Stats.h"
+#include "src/ThreadShards.h"
+
+namespace reactivesocket {
+
+/// Stats counting events and frames by FrameType.
+///
+/// Every thread counts into its own cache line padded block of counters (see
+/// ThreadShards), so a hook is a thread local lookup and a plain relaxed
+/// load and store, with no contention between EventBase threads.  The blocks
+/// are merged whenever a snapshot is taken, counts of threads which have
+/// exited included.
+class CounterStats : public Stats {
+ public:
+  /// Frame types are 6 bits on the wire.
+  static constexpr size_t kFrameTypes = 64;
+
+  struct Snapshot {
+    uint64_t socketsCreated{0};
+    uint64_t socketsDisconnected{0};
+    uint64_t socketsClosed{0};
+    uint64_t duplexConnectionsCreated{0};
+    uint64_t duplexConnectionsClosed{0};
+    uint64_t bytesWritten{0};
+    uint64_t bytesRead{0};
+    std::array<uint64_t, kFrameTypes> framesWritten{};
+    std::array<uint64_t, kFrameTypes> framesRead{};
+    /// Current size of the resume and stream buffers.
+    int64_t resumeBufferFrames{0};
+    int64_t resumeBufferBytes{0};
+    int64_t streamBufferFrames{0};
+    int64_t streamBufferBytes{0};
+
+    /// One "name value" line per counter, frame types never seen omitted.
+    std::string toString() const;
+    folly::dynamic toDynamic() const;
+    std::string toJson() const;
+  };
+
+  Snapshot snapshot() const;
+
+  void socketCreated() override;
+  void socketDisconnected() override;
+  void socketClosed(StreamCompletionSignal) override;
+  void duplexConnectionCreated(const std::string&, DuplexConnection*)
+      override;
+  void duplexConnectionClosed(const std::string&, DuplexConnection*)
+      override;
+  void bytesWritten(size_t bytes) override;
+  void bytesRead(size_t bytes) override;
+  void frameWritten(FrameType frameType) override;
+  void frameRead(FrameType frameType) override;
+  void resumeBufferChanged(int framesCountDelta, int dataSizeDelta) override;
+  void streamBufferChanged(int64_t framesCountDelta, int64_t dataSizeDelta)
+      override;
+
+ private:
+  enum Counter : size_t {
+    SOCKETS_CREATED,
+    SOCKETS_DISCONNECTED,
+    SOCKETS_CLOSED,
+    DUPLEX_CONNECTIONS_CREATED,
+    DUPLEX_CONNECTIONS_CLOSED,
+    BYTES_WRITTEN,
+    BYTES_READ,
+    RESUME_BUFFER_FRAMES,
+    RESUME_BUFFER_BYTES,
+    STREAM_BUFFER_FRAMES,
+    STREAM_BUFFER_BYTES,
+    FRAMES_WRITTEN,
+    FRAMES_READ = FRAMES_WRITTEN + kFrameTypes,
+    COUNTERS = FRAMES_READ + kFrameTypes,
+  };
+
+  static constexpr size_t kCacheLine = 64;
+
+  /// Counters written by a single thread.
+  struct Block {
+    Block();
+
+    void add(size_t counter, int64_t delta) {
+      auto& value = counters_[counter];
+      value.store(
+          value.load(std::memory_order_relaxed) + delta,
+          std::memory_order_relaxed);
+    }
+
+    void mergeInto(Block& other) const;
+
+    char leftPadding_[kCacheLine];
+    std::array<std::atomic<int64_t>, COUNTERS> counters_;
+    char rightPadding_[kCacheLine];
+  };
+
+  void add(size_t counter, int64_t delta = 1) {
+    blocks_.local().add(counter, delta);
+  }
+
+  mutable ThreadShards<Block> blocks_;
+};
+}
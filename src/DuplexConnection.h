@@ -11,6 +11,8 @@ class IOBuf;
 
 namespace reactivesocket {
 
+class MemoryAccountant;
+
 /// Represents a connection of the underlying protocol, on top of which
 /// the ReactiveSocket is layered. The underlying protocol MUST provide an
 /// ordered, guaranteed, bidirectional transport of frames. Moreover, the frame
@@ -46,5 +48,9 @@ class DuplexConnection {
   /// connection MUST manage the lifetime of provided Subscriber.
   virtual std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
   getOutput() = 0;
+
+  /// Lets a connection which buffers partially received frames charge them to
+  /// the accountant of the ReactiveSocket, nullptr detaches the accountant.
+  virtual void setMemoryAccountant(std::shared_ptr<MemoryAccountant>) {}
 };
 }
@@ -1,11 +1,14 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include <folly/Memory.h>
+#include <folly/ThreadId.h>
 #include <folly/futures/InlineExecutor.h>
 #include <folly/futures/QueuedImmediateExecutor.h>
 #include <folly/io/IOBuf.h>
 #include "src/StackTraceUtils.h"
+#include "src/Stats.h"
 #include "src/SubscriberBase.h"
+#include "src/TaskProfiler.h"
 
 namespace reactivesocket {
 
@@ -23,9 +26,61 @@ folly::Executor& inlineExecutor() {
   return executor;
 }
 
-ExecutorBase::ExecutorBase(folly::Executor& executor) : executor_(executor) {}
+ExecutorBase::ExecutorBase(
+    folly::Executor& executor,
+    std::shared_ptr<Stats> stats)
+    : executor_(executor) {
+  if (stats && stats->latencyTrackingEnabled()) {
+    latencyStats_ = stats;
+  }
+  if (stats && stats->taskProfilingSampling() > 0) {
+    profilingStats_ = std::move(stats);
+  }
+}
+
+namespace {
+/// Tasks scheduled by this thread, for sampling.
+thread_local uint32_t scheduledTasks{0};
+}
 
-void ExecutorBase::runInExecutor(folly::Func func) {
-  executor_.add(std::move(func));
+void ExecutorBase::runInExecutor(folly::Func func, const char* name) {
+  if (profilingStats_ &&
+      ++scheduledTasks % profilingStats_->taskProfilingSampling() == 0) {
+    executor_.add([
+      func = std::move(func),
+      stats = profilingStats_,
+      latencyStats = latencyStats_,
+      name,
+      queuedAt = Stats::Clock::now()
+    ]() mutable {
+      TaskProfile profile;
+      profile.name = name;
+      profile.queuedAt = queuedAt;
+      profile.startedAt = Stats::Clock::now();
+      if (latencyStats) {
+        latencyStats->executorQueueingDelay(profile.queueDelay());
+      }
+      {
+        TaskProfile::Scope scope(profile);
+        func();
+      }
+      profile.runTime = Stats::Clock::now() - profile.startedAt;
+      profile.threadId = folly::getCurrentThreadID();
+      stats->taskProfiled(profile);
+    });
+    return;
+  }
+  if (!latencyStats_) {
+    executor_.add(std::move(func));
+    return;
+  }
+  executor_.add([
+    func = std::move(func),
+    stats = latencyStats_,
+    queuedAt = Stats::Clock::now()
+  ]() mutable {
+    stats->executorQueueingDelay(Stats::Clock::now() - queuedAt);
+    func();
+  });
 }
 } // reactivesocket
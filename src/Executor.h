@@ -7,15 +7,23 @@
 
 namespace reactivesocket {
 
+class Stats;
+
 folly::Executor& defaultExecutor();
 folly::Executor& inlineExecutor();
 
 class ExecutorBase {
  public:
-  explicit ExecutorBase(folly::Executor& executor);
+  /// When given Stats with latency tracking enabled, the time every task
+  /// spends queued in the executor is reported to it, and when given Stats
+  /// with task profiling enabled, the sampled tasks are.
+  explicit ExecutorBase(
+      folly::Executor& executor,
+      std::shared_ptr<Stats> stats = nullptr);
 
  protected:
-  void runInExecutor(folly::Func func);
+  /// The name, a string literal, identifies the task in the TaskProfile.
+  void runInExecutor(folly::Func func, const char* name = "task");
 
   folly::Executor& executor() const {
     return executor_;
@@ -23,6 +31,10 @@ class ExecutorBase {
 
  private:
   folly::Executor& executor_;
+  /// Set only when queueing delay should be reported.
+  std::shared_ptr<Stats> latencyStats_;
+  /// Set only when tasks should be profiled.
+  std::shared_ptr<Stats> profilingStats_;
 };
 
 } // reactivesocket
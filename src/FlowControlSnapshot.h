@@ -0,0 +1,45 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include "src/Common.h"
+
+namespace reactivesocket {
+
+/// Flow control state of a single stream, see
+/// ConnectionAutomaton::flowControlSnapshot.
+///
+/// Credit of AllowanceSemaphore::max() is unbounded.  Starvation is counted
+/// from the first time the credit in a direction runs out, the ongoing
+/// period included.
+struct StreamFlowControl {
+  StreamId streamId{0};
+  /// Credit the remote publisher may still use: requested less received.
+  size_t inboundCredit{0};
+  /// Part of inboundCredit not sent to the remote end in REQUEST_N yet.
+  size_t inboundCreditUnsent{0};
+  /// Credit the local publisher may still use: received less sent.
+  size_t outboundCredit{0};
+  std::chrono::nanoseconds inboundStarved{0};
+  std::chrono::nanoseconds outboundStarved{0};
+};
+
+/// Snapshot of the flow control state of a connection, see
+/// ConnectionAutomaton::flowControlSnapshot.
+struct FlowControlSnapshot {
+  /// One entry per live stream.
+  std::vector<StreamFlowControl> streams;
+  /// Frames queued while the connection is not connected.
+  size_t pendingFrames{0};
+  size_t pendingBytes{0};
+  /// Frames waiting for the DuplexConnection to accept more writes.
+  size_t pendingWriteFrames{0};
+  size_t pendingWriteBytes{0};
+  /// Bytes written but not yet acknowledged by the remote end, known only
+  /// for resumable connections.
+  size_t unacknowledgedBytes{0};
+};
+}
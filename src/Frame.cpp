@@ -5,6 +5,7 @@
 #include <folly/Optional.h>
 #include <folly/io/Cursor.h>
 #include <bitset>
+#include "src/CompositeMetadata.h"
 #include "src/ConnectionSetupPayload.h"
 
 namespace reactivesocket {
@@ -142,6 +143,32 @@ std::ostream& operator<<(std::ostream& os, const Frame_PAYLOAD& frame) {
   return os << frame.header_ << ", (" << frame.payload_;
 }
 
+Payload PayloadFrameView::takePayload() {
+  std::unique_ptr<folly::IOBuf> metadata;
+  if (hasMetadata()) {
+    folly::io::Cursor cur(frame_.get());
+    cur.skip(metadataOffset_);
+    cur.clone(metadata, metadataLength_);
+  }
+
+  auto data = std::move(frame_);
+  if (dataLength_ == 0) {
+    return Payload(nullptr, std::move(metadata));
+  }
+  // the data is the tail of the chain, drop whatever precedes it
+  auto skip = dataOffset_;
+  while (skip > 0) {
+    if (skip >= data->length()) {
+      skip -= data->length();
+      data = data->pop();
+    } else {
+      data->trimStart(skip);
+      skip = 0;
+    }
+  }
+  return Payload(std::move(data), std::move(metadata));
+}
+
 Frame_ERROR Frame_ERROR::unexpectedFrame() {
   return Frame_ERROR(
       0, ErrorCode::CONNECTION_ERROR, Payload("unexpected frame"));
@@ -172,6 +199,11 @@ Frame_ERROR Frame_ERROR::applicationError(
       streamId, ErrorCode::APPLICATION_ERROR, std::move(payload));
 }
 
+Frame_ERROR Frame_ERROR::rejected(StreamId streamId, Payload&& payload) {
+  DCHECK(streamId) << "streamId MUST be non-0";
+  return Frame_ERROR(streamId, ErrorCode::REJECTED, std::move(payload));
+}
+
 std::ostream& operator<<(std::ostream& os, const Frame_ERROR& frame) {
   return os << frame.header_ << ", " << frame.errorCode_ << ", "
             << frame.payload_;
@@ -193,7 +225,16 @@ void Frame_SETUP::moveToSetupPayload(ConnectionSetupPayload& setupPayload) {
   setupPayload.payload = std::move(payload_);
   setupPayload.token = std::move(token_);
   setupPayload.resumable = !!(header_.flags_ & FrameFlags::RESUME_ENABLE);
+  setupPayload.honorsLease = !!(header_.flags_ & FrameFlags::LEASE);
   setupPayload.protocolVersion = ProtocolVersion(versionMajor_, versionMinor_);
+  setupPayload.compression.compositeMetadata =
+      setupPayload.metadataMimeType == kCompositeMetadataMimeType;
+  // the metadata of other mime types are the application's, whatever they
+  // look like
+  if (setupPayload.compression.compositeMetadata) {
+    setupPayload.compression.codecs =
+        PayloadCompression::takeOffer(setupPayload.payload);
+  }
 }
 
 std::ostream& operator<<(std::ostream& os, const Frame_LEASE& frame) {
@@ -371,6 +371,29 @@ class Frame_PAYLOAD {
 };
 std::ostream& operator<<(std::ostream&, const Frame_PAYLOAD&);
 
+/// A received PAYLOAD frame parsed in place: the metadata and the data are
+/// only located in the received buffer, nothing is cloned or allocated until
+/// the payload is taken.
+class PayloadFrameView {
+ public:
+  bool hasMetadata() const {
+    return !!(header_.flags_ & FrameFlags::METADATA);
+  }
+
+  /// Hands the frame over as a Payload. The data is the received IOBuf with
+  /// the frame header and the metadata trimmed off, only the metadata, when
+  /// present, costs a new IOBuf sharing the received buffer.
+  Payload takePayload();
+
+  FrameHeader header_;
+  std::unique_ptr<folly::IOBuf> frame_;
+  /// Offsets from the start of the frame.
+  size_t metadataOffset_{0};
+  size_t metadataLength_{0};
+  size_t dataOffset_{0};
+  size_t dataLength_{0};
+};
+
 class Frame_ERROR {
  public:
   constexpr static const FrameFlags AllowedFlags = FrameFlags::METADATA;
@@ -387,6 +410,7 @@ class Frame_ERROR {
   static Frame_ERROR connectionError(const std::string& message);
   static Frame_ERROR error(StreamId streamId, Payload&& payload);
   static Frame_ERROR applicationError(StreamId streamId, Payload&& payload);
+  static Frame_ERROR rejected(StreamId streamId, Payload&& payload);
 
   FrameHeader header_;
   ErrorCode errorCode_{};
@@ -491,8 +515,9 @@ class Frame_LEASE {
         ttl_(ttl),
         numberOfRequests_(numberOfRequests),
         metadata_(std::move(metadata)) {
+    // a lease of no requests asks the peer to send its requests elsewhere,
+    // see ConnectionAutomaton::drain
     DCHECK(ttl_ > 0);
-    DCHECK(numberOfRequests_ > 0);
     DCHECK(ttl_ <= kMaxTtl);
     DCHECK(numberOfRequests_ <= kMaxNumRequests);
   }
@@ -0,0 +1,239 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/FrameCapture.h"
+#include <folly/Exception.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+#include <cstring>
+#include <ostream>
+
+namespace reactivesocket {
+
+constexpr char FrameCaptureFormat::kMagic[8];
+constexpr size_t FrameCaptureWriter::kDefaultMaxQueuedBytes;
+
+std::ostream& operator<<(std::ostream& os, FrameDirection direction) {
+  switch (direction) {
+    case FrameDirection::INBOUND:
+      return os << "INBOUND";
+    case FrameDirection::OUTBOUND:
+      return os << "OUTBOUND";
+  }
+  return os << "UNKNOWN_DIRECTION";
+}
+
+FrameCaptureWriter::FrameCaptureWriter(
+    const std::string& path,
+    size_t maxQueuedBytes)
+    : start_(std::chrono::steady_clock::now()),
+      maxQueuedBytes_(maxQueuedBytes),
+      file_(std::fopen(path.c_str(), "wb")) {
+  if (!file_) {
+    folly::throwSystemError("fopen ", path);
+  }
+  FrameCaptureFormat::FileHeader header;
+  std::memcpy(header.magic, FrameCaptureFormat::kMagic, sizeof(header.magic));
+  writeBytes(&header, sizeof(header));
+  thread_ = std::thread([this] { run(); });
+}
+
+FrameCaptureWriter::~FrameCaptureWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queued_.notify_one();
+  thread_.join();
+  std::fclose(file_);
+}
+
+void FrameCaptureWriter::write(
+    FrameDirection direction,
+    const folly::IOBuf& frame) {
+  QueuedFrame queued;
+  queued.header = FrameCaptureFormat::RecordHeader{};
+  queued.header.offsetNanos =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count();
+  queued.header.length =
+      static_cast<uint32_t>(frame.computeChainDataLength());
+  queued.header.direction = direction;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queuedBytes_ + queued.header.length > maxQueuedBytes_) {
+      ++dropped_;
+      LOG_EVERY_N(WARNING, 1000)
+          << "frame capture is behind, dropped " << dropped_ << " frames";
+      return;
+    }
+    queuedBytes_ += queued.header.length;
+    ++queuedFrames_;
+    // shares the buffers with the connection, they are not copied
+    queued.frame = frame.clone();
+    queue_.push_back(std::move(queued));
+  }
+  queued_.notify_one();
+}
+
+void FrameCaptureWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto target = queuedFrames_;
+  written_.wait(lock, [&] { return writtenFrames_ >= target; });
+}
+
+size_t FrameCaptureWriter::dropped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+
+void FrameCaptureWriter::run() {
+  std::vector<QueuedFrame> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    batch.swap(queue_);
+    lock.unlock();
+
+    size_t bytes = 0;
+    for (const auto& queued : batch) {
+      writeFrame(queued);
+      bytes += queued.header.length;
+    }
+    // a capture cut short by a crash keeps every batch written
+    std::fflush(file_);
+    const auto frames = batch.size();
+    batch.clear();
+
+    lock.lock();
+    queuedBytes_ -= bytes;
+    writtenFrames_ += frames;
+    written_.notify_all();
+  }
+}
+
+void FrameCaptureWriter::writeFrame(const QueuedFrame& queued) {
+  static const char kPadding[FrameCaptureFormat::kAlignment] = {};
+  const auto length = queued.header.length;
+  writeBytes(&queued.header, sizeof(queued.header));
+  for (auto range : *queued.frame) {
+    writeBytes(range.data(), range.size());
+  }
+  writeBytes(kPadding, FrameCaptureFormat::padded(length) - length);
+}
+
+void FrameCaptureWriter::writeBytes(const void* data, size_t size) {
+  // a failed write only costs the capture, never the connection
+  if (size && std::fwrite(data, size, 1, file_) != 1) {
+    LOG_EVERY_N(ERROR, 1000) << "frame capture write failed: "
+                             << folly::errnoStr(errno);
+  }
+}
+
+FrameCaptureReader::FrameCaptureReader(const std::string& path)
+    : mapping_(path.c_str()) {
+  auto range = mapping_.range();
+  if (range.size() < sizeof(FrameCaptureFormat::FileHeader) ||
+      std::memcmp(
+          range.data(),
+          FrameCaptureFormat::kMagic,
+          sizeof(FrameCaptureFormat::kMagic)) != 0) {
+    throw std::runtime_error(path + " is not a frame capture");
+  }
+  rewind();
+}
+
+void FrameCaptureReader::rewind() {
+  remaining_ = mapping_.range();
+  remaining_.advance(sizeof(FrameCaptureFormat::FileHeader));
+}
+
+bool FrameCaptureReader::next(Record& record) {
+  if (remaining_.size() < sizeof(FrameCaptureFormat::RecordHeader)) {
+    return false;
+  }
+  // records are aligned, the header can be read in place
+  const auto& header =
+      *reinterpret_cast<const FrameCaptureFormat::RecordHeader*>(
+          remaining_.data());
+  const auto size = sizeof(header) + FrameCaptureFormat::padded(header.length);
+  if (remaining_.size() < size) {
+    remaining_.clear();
+    return false;
+  }
+  record.offset = std::chrono::nanoseconds(header.offsetNanos);
+  record.direction = header.direction;
+  record.frame =
+      folly::ByteRange(remaining_.data() + sizeof(header), header.length);
+  remaining_.advance(size);
+  return true;
+}
+
+class CapturingDuplexConnection::CapturingSubscriber
+    : public Subscriber<std::unique_ptr<folly::IOBuf>> {
+ public:
+  CapturingSubscriber(
+      std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> inner,
+      std::shared_ptr<FrameCaptureWriter> writer,
+      FrameDirection direction)
+      : inner_(std::move(inner)),
+        writer_(std::move(writer)),
+        direction_(direction) {}
+
+  void onSubscribe(std::shared_ptr<Subscription> subscription) noexcept
+      override {
+    inner_->onSubscribe(std::move(subscription));
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> frame) noexcept override {
+    writer_->write(direction_, *frame);
+    inner_->onNext(std::move(frame));
+  }
+
+  void onComplete() noexcept override {
+    inner_->onComplete();
+  }
+
+  void onError(folly::exception_wrapper ex) noexcept override {
+    inner_->onError(std::move(ex));
+  }
+
+ private:
+  const std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> inner_;
+  const std::shared_ptr<FrameCaptureWriter> writer_;
+  const FrameDirection direction_;
+};
+
+CapturingDuplexConnection::CapturingDuplexConnection(
+    std::unique_ptr<DuplexConnection> connection,
+    std::shared_ptr<FrameCaptureWriter> writer)
+    : connection_(std::move(connection)), writer_(std::move(writer)) {
+  CHECK(connection_);
+  CHECK(writer_);
+}
+
+void CapturingDuplexConnection::setInput(
+    std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> framesSink) {
+  CHECK(!input_);
+  input_ = std::make_shared<CapturingSubscriber>(
+      std::move(framesSink), writer_, FrameDirection::INBOUND);
+  connection_->setInput(input_);
+}
+
+std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
+CapturingDuplexConnection::getOutput() {
+  output_ = std::make_shared<CapturingSubscriber>(
+      connection_->getOutput(), writer_, FrameDirection::OUTBOUND);
+  return output_;
+}
+
+void CapturingDuplexConnection::setMemoryAccountant(
+    std::shared_ptr<MemoryAccountant> memoryAccountant) {
+  connection_->setMemoryAccountant(std::move(memoryAccountant));
+}
+}
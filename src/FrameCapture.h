@@ -0,0 +1,164 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/MemoryMapping.h>
+#include <folly/Range.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "src/DuplexConnection.h"
+
+namespace folly {
+class IOBuf;
+}
+
+namespace reactivesocket {
+
+enum class FrameDirection : uint8_t {
+  INBOUND,
+  OUTBOUND,
+};
+
+std::ostream& operator<<(std::ostream&, FrameDirection);
+
+/// Binary file of serialized frames, each stamped with the time it passed
+/// through the connection.
+///
+/// The file is a FileHeader followed by records, each a RecordHeader and the
+/// frame (without the frame length field), padded to kAlignment. All fields
+/// are in host byte order, so that the file can be memory mapped and read in
+/// place on the machine it was captured on.
+struct FrameCaptureFormat {
+  static constexpr size_t kAlignment = 8;
+  static constexpr char kMagic[8] = {'R', 'S', 'F', 'R', 'C', 'A', 'P', '1'};
+
+  struct FileHeader {
+    char magic[8];
+  };
+
+  struct RecordHeader {
+    /// Since the capture started.
+    uint64_t offsetNanos;
+    uint32_t length;
+    FrameDirection direction;
+    uint8_t reserved[3];
+  };
+
+  static size_t padded(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+  }
+};
+
+/// Appends frames to a capture file, may be shared by several connections.
+///
+/// write() only queues the frame, a thread of the writer writes the queue to
+/// the file, so that connections never wait on the disk. Frames which would
+/// take the queue over maxQueuedBytes are dropped, a capture with gaps is
+/// better than a stalled connection.
+class FrameCaptureWriter {
+ public:
+  static constexpr size_t kDefaultMaxQueuedBytes = 64 << 20;
+
+  /// Throws std::system_error when the file cannot be created.
+  explicit FrameCaptureWriter(
+      const std::string& path,
+      size_t maxQueuedBytes = kDefaultMaxQueuedBytes);
+  /// Writes the frames still queued.
+  ~FrameCaptureWriter();
+
+  FrameCaptureWriter(const FrameCaptureWriter&) = delete;
+  FrameCaptureWriter& operator=(const FrameCaptureWriter&) = delete;
+
+  void write(FrameDirection direction, const folly::IOBuf& frame);
+
+  /// Blocks until the frames written so far are in the file.
+  void flush();
+
+  /// Frames dropped because the queue was full.
+  size_t dropped() const;
+
+ private:
+  struct QueuedFrame {
+    FrameCaptureFormat::RecordHeader header;
+    std::unique_ptr<folly::IOBuf> frame;
+  };
+
+  void run();
+  void writeFrame(const QueuedFrame& queued);
+  void writeBytes(const void* data, size_t size);
+
+  const std::chrono::steady_clock::time_point start_;
+  const size_t maxQueuedBytes_;
+  std::FILE* file_;
+
+  mutable std::mutex mutex_;
+  /// Wakes the thread when there are frames to write or it has to stop.
+  std::condition_variable queued_;
+  /// Wakes flush() when a batch of frames is in the file.
+  std::condition_variable written_;
+  std::vector<QueuedFrame> queue_;
+  /// Of the frames queued or being written.
+  size_t queuedBytes_{0};
+  uint64_t queuedFrames_{0};
+  uint64_t writtenFrames_{0};
+  size_t dropped_{0};
+  bool stopping_{false};
+
+  std::thread thread_;
+};
+
+/// Reads a capture file through a read-only memory mapping.
+class FrameCaptureReader {
+ public:
+  struct Record {
+    std::chrono::nanoseconds offset;
+    FrameDirection direction;
+    /// Points into the mapping, valid for the lifetime of the reader.
+    folly::ByteRange frame;
+  };
+
+  /// Throws std::system_error when the file cannot be mapped and
+  /// std::runtime_error when it is not a capture file.
+  explicit FrameCaptureReader(const std::string& path);
+
+  /// Returns false at the end of the capture. A record truncated by a
+  /// capturing process which did not exit cleanly ends the capture too.
+  bool next(Record& record);
+  void rewind();
+
+ private:
+  folly::MemoryMapping mapping_;
+  folly::ByteRange remaining_;
+};
+
+/// Decorates a DuplexConnection, writing every frame read from or written to
+/// it to a FrameCaptureWriter.
+class CapturingDuplexConnection : public DuplexConnection {
+ public:
+  CapturingDuplexConnection(
+      std::unique_ptr<DuplexConnection> connection,
+      std::shared_ptr<FrameCaptureWriter> writer);
+
+  void setInput(std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
+                    framesSink) override;
+
+  std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> getOutput()
+      override;
+
+  void setMemoryAccountant(std::shared_ptr<MemoryAccountant>) override;
+
+ private:
+  class CapturingSubscriber;
+
+  std::unique_ptr<DuplexConnection> connection_;
+  std::shared_ptr<FrameCaptureWriter> writer_;
+  std::shared_ptr<CapturingSubscriber> input_;
+  std::shared_ptr<CapturingSubscriber> output_;
+};
+}
@@ -28,6 +28,12 @@ class FrameSerializer {
   virtual FrameType peekFrameType(const folly::IOBuf& in) = 0;
   virtual folly::Optional<StreamId> peekStreamId(const folly::IOBuf& in) = 0;
 
+  /// Reads the type, flags and stream id of a frame in a single pass.
+  ///
+  /// Returns false if the header is truncated or invalid, the type is filled
+  /// in whenever it could be read (FrameType::RESERVED otherwise).
+  virtual bool peekFrameHeader(const folly::IOBuf& in, FrameHeader& header) = 0;
+
   virtual std::unique_ptr<folly::IOBuf> serializeOut(
       Frame_REQUEST_STREAM&&) = 0;
   virtual std::unique_ptr<folly::IOBuf> serializeOut(
@@ -0,0 +1,71 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/FrameTrace.h"
+#include <folly/String.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <mutex>
+#include "src/FrameCapture.h"
+
+DEFINE_int32(
+    rs_frame_trace_sampling,
+    0,
+    "trace one in every N frames of all connections, 0 disables the trace");
+
+namespace reactivesocket {
+
+constexpr size_t FrameTraceRecord::kMaxPrefix;
+
+namespace {
+
+class LoggingFrameTraceSink : public FrameTraceSink {
+ public:
+  void onFrame(const FrameTraceRecord& record) override {
+    LOG(INFO) << "frame " << record.direction << " " << record.header
+              << " length=" << record.length
+              << " prefix=" << folly::hexlify(record.prefix);
+  }
+};
+
+std::mutex sinkMutex;
+std::shared_ptr<FrameTraceSink> sink;
+
+std::shared_ptr<FrameTraceSink> currentSink() {
+  std::lock_guard<std::mutex> lock(sinkMutex);
+  if (!sink) {
+    sink = std::make_shared<LoggingFrameTraceSink>();
+  }
+  return sink;
+}
+}
+
+void setFrameTraceSink(std::shared_ptr<FrameTraceSink> newSink) {
+  std::lock_guard<std::mutex> lock(sinkMutex);
+  sink = std::move(newSink);
+}
+
+namespace detail {
+
+void traceFrameSampled(
+    FrameDirection direction,
+    const FrameHeader& header,
+    const folly::IOBuf& frame) {
+  // the connections of a thread share the counter, so the busier ones are
+  // sampled more
+  static thread_local uint32_t skipped = 0;
+  if (++skipped < static_cast<uint32_t>(FLAGS_rs_frame_trace_sampling)) {
+    return;
+  }
+  skipped = 0;
+
+  FrameTraceRecord record;
+  record.direction = direction;
+  record.header = header;
+  record.length = frame.computeChainDataLength();
+  // only the first buffer of the chain, so that nothing is copied
+  record.prefix = folly::ByteRange(
+      frame.data(), std::min(frame.length(), FrameTraceRecord::kMaxPrefix));
+  currentSink()->onFrame(record);
+}
+}
+}
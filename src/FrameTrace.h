@@ -0,0 +1,61 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Likely.h>
+#include <folly/Range.h>
+#include <folly/portability/GFlags.h>
+#include <memory>
+#include "src/Frame.h"
+
+DECLARE_int32(rs_frame_trace_sampling);
+
+namespace reactivesocket {
+
+enum class FrameDirection : uint8_t;
+
+/// A frame sampled by the frame trace.
+struct FrameTraceRecord {
+  /// How many bytes of the frame are in the prefix, at most.
+  static constexpr size_t kMaxPrefix = 32;
+
+  FrameDirection direction;
+  FrameHeader header;
+  /// Of the whole frame, without the frame length field.
+  size_t length{0};
+  /// The first bytes of the frame, valid only during the call to the sink.
+  folly::ByteRange prefix;
+};
+
+/// Receives the frames sampled from all connections.
+class FrameTraceSink {
+ public:
+  virtual ~FrameTraceSink() = default;
+
+  /// Called on the executor of the connection, must not block.
+  virtual void onFrame(const FrameTraceRecord& record) = 0;
+};
+
+/// Replaces the sink, nullptr restores the default one which logs every
+/// record as a single line.
+void setFrameTraceSink(std::shared_ptr<FrameTraceSink> sink);
+
+namespace detail {
+void traceFrameSampled(
+    FrameDirection direction,
+    const FrameHeader& header,
+    const folly::IOBuf& frame);
+}
+
+/// Passes one in every --rs_frame_trace_sampling frames to the sink.  This
+/// replaces hex dumps of every frame for debugging: it can be turned on at
+/// run time in any build, and costs a test of the flag per frame while off.
+inline void traceFrame(
+    FrameDirection direction,
+    const FrameHeader& header,
+    const folly::IOBuf& frame) {
+  if (UNLIKELY(FLAGS_rs_frame_trace_sampling > 0)) {
+    detail::traceFrameSampled(direction, header, frame);
+  }
+}
+}
@@ -4,6 +4,8 @@
 #include <folly/ExceptionWrapper.h>
 #include "src/DuplexConnection.h"
 #include "src/Frame.h"
+#include "src/Logging.h"
+#include "src/MemoryAccountant.h"
 
 namespace reactivesocket {
 
@@ -12,8 +14,15 @@ FrameTransport::FrameTransport(std::unique_ptr<DuplexConnection> connection)
   CHECK(connection_);
 }
 
+constexpr size_t FrameTransport::kReadWindow;
+
 FrameTransport::~FrameTransport() {
-  VLOG(6) << "~FrameTransport";
+  RSOCKET_VLOG(6) << "~FrameTransport";
+  if (memoryAccountant_) {
+    memoryAccountant_->release(
+        MemoryBuffer::PENDING_WRITES, pendingWritesBytes_);
+    memoryAccountant_->release(MemoryBuffer::PENDING_READS, pendingReadsBytes_);
+  }
 }
 
 void FrameTransport::connect() {
@@ -57,15 +66,34 @@ void FrameTransport::setFrameProcessor(
   drainOutputFramesQueue();
   if (frameProcessor_) {
     while (!pendingReads_.empty()) {
-      auto frame = std::move(pendingReads_.front());
-      pendingReads_.pop_front();
-      frameProcessor_->processFrame(std::move(frame));
+      frameProcessor_->processFrame(dequeuePendingRead());
     }
     if (pendingTerminal_) {
       terminateFrameProcessor(std::move(*pendingTerminal_));
       pendingTerminal_ = folly::none;
     }
   }
+  requestReads();
+}
+
+void FrameTransport::setMemoryAccountant(
+    std::shared_ptr<MemoryAccountant> memoryAccountant) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+  if (memoryAccountant_) {
+    memoryAccountant_->release(
+        MemoryBuffer::PENDING_WRITES, pendingWritesBytes_);
+    memoryAccountant_->release(MemoryBuffer::PENDING_READS, pendingReadsBytes_);
+  }
+  memoryAccountant_ = std::move(memoryAccountant);
+  if (memoryAccountant_) {
+    memoryAccountant_->charge(MemoryBuffer::PENDING_WRITES, pendingWritesBytes_);
+    memoryAccountant_->charge(MemoryBuffer::PENDING_READS, pendingReadsBytes_);
+  }
+  if (connection_) {
+    connection_->setMemoryAccountant(memoryAccountant_);
+  }
+  requestReads();
 }
 
 void FrameTransport::close(folly::exception_wrapper ex) {
@@ -106,17 +134,36 @@ void FrameTransport::onSubscribe(
   CHECK(!connectionInputSub_);
   CHECK(frameProcessor_);
   connectionInputSub_ = std::move(subscription);
-  connectionInputSub_->request(std::numeric_limits<size_t>::max());
+  requestReads();
 }
 
 void FrameTransport::onNext(std::unique_ptr<folly::IOBuf> frame) noexcept {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
 
+  if (readDemand_ > 0) {
+    --readDemand_;
+  }
   if (connection_ && frameProcessor_) {
     frameProcessor_->processFrame(std::move(frame));
   } else {
-    pendingReads_.emplace_back(std::move(frame));
+    enqueuePendingRead(std::move(frame));
+  }
+  requestReads();
+}
+
+void FrameTransport::requestReads() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+  // Reading in windows rather than requesting everything up front lets the
+  // connection stop reading, and so push back on the peer, while the memory
+  // accountant is over its cap.
+  if (!connectionInputSub_ || readDemand_ > kReadWindow / 2 ||
+      (memoryAccountant_ && memoryAccountant_->shouldPauseReads())) {
+    return;
   }
+  const auto n = kReadWindow - readDemand_;
+  readDemand_ = kReadWindow;
+  connectionInputSub_->request(n);
 }
 
 void FrameTransport::terminateFrameProcessor(folly::exception_wrapper ex) {
@@ -133,18 +180,18 @@ void FrameTransport::terminateFrameProcessor(folly::exception_wrapper ex) {
   }
 
   if (frameProcessor) {
-    VLOG(3) << this << " terminating frame processor ex=" << ex.what();
+    RSOCKET_VLOG(3) << this << " terminating frame processor ex=" << ex.what();
     frameProcessor->onTerminal(std::move(ex));
   }
 }
 
 void FrameTransport::onComplete() noexcept {
-  VLOG(6) << "onComplete";
+  RSOCKET_VLOG(6) << "onComplete";
   terminateFrameProcessor(folly::exception_wrapper());
 }
 
 void FrameTransport::onError(folly::exception_wrapper ex) noexcept {
-  VLOG(6) << "onError" << ex.what();
+  RSOCKET_VLOG(6) << "onError" << ex.what();
   terminateFrameProcessor(std::move(ex));
 }
 
@@ -166,7 +213,7 @@ void FrameTransport::request(size_t n) noexcept {
 }
 
 void FrameTransport::cancel() noexcept {
-  VLOG(6) << "cancel";
+  RSOCKET_VLOG(6) << "cancel";
   terminateFrameProcessor(folly::exception_wrapper());
 }
 
@@ -195,7 +242,7 @@ void FrameTransport::outputFrameOrEnqueue(std::unique_ptr<folly::IOBuf> frame) {
   // We either have no allowance to perform the operation, or the queue has
   // not been drained (e.g. we're looping in ::request).
   // or we are disconnected
-  pendingWrites_.emplace_back(std::move(frame));
+  enqueuePendingWrite(std::move(frame));
 }
 
 void FrameTransport::drainOutputFramesQueue() {
@@ -204,15 +251,55 @@ void FrameTransport::drainOutputFramesQueue() {
   if (connection_) {
     // Drain the queue or the allowance.
     while (!pendingWrites_.empty() && writeAllowance_.tryAcquire()) {
-      auto frame = std::move(pendingWrites_.front());
+      auto frame = dequeuePendingWrite();
       // TODO: temporary disabling VLOG as we don't know the correct
       // frame serializer here. There is refactoring of this class planned
       // which will allow enabling it again.
       // VLOG(3) << this << " flushing frame " << FrameHeader::peekType(*frame);
-      pendingWrites_.pop_front();
       connectionOutput_->onNext(std::move(frame));
     }
   }
+  requestReads();
+}
+
+void FrameTransport::enqueuePendingWrite(std::unique_ptr<folly::IOBuf> frame) {
+  const auto length = frame->computeChainDataLength();
+  pendingWritesBytes_ += length;
+  if (memoryAccountant_) {
+    memoryAccountant_->charge(MemoryBuffer::PENDING_WRITES, length);
+  }
+  pendingWrites_.emplace_back(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameTransport::dequeuePendingWrite() {
+  auto frame = std::move(pendingWrites_.front());
+  pendingWrites_.pop_front();
+  const auto length = frame->computeChainDataLength();
+  pendingWritesBytes_ -= length;
+  if (memoryAccountant_) {
+    memoryAccountant_->release(MemoryBuffer::PENDING_WRITES, length);
+  }
+  return frame;
+}
+
+void FrameTransport::enqueuePendingRead(std::unique_ptr<folly::IOBuf> frame) {
+  const auto length = frame->computeChainDataLength();
+  pendingReadsBytes_ += length;
+  if (memoryAccountant_) {
+    memoryAccountant_->charge(MemoryBuffer::PENDING_READS, length);
+  }
+  pendingReads_.emplace_back(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameTransport::dequeuePendingRead() {
+  auto frame = std::move(pendingReads_.front());
+  pendingReads_.pop_front();
+  const auto length = frame->computeChainDataLength();
+  pendingReadsBytes_ -= length;
+  if (memoryAccountant_) {
+    memoryAccountant_->release(MemoryBuffer::PENDING_READS, length);
+  }
+  return frame;
 }
 
 DuplexConnection* FrameTransport::duplexConnection() const {
@@ -220,4 +307,9 @@ DuplexConnection* FrameTransport::duplexConnection() const {
   return connection_.get();
 }
 
+std::pair<size_t, size_t> FrameTransport::pendingWrites() const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return {pendingWrites_.size(), pendingWritesBytes_};
+}
+
 } // reactivesocket
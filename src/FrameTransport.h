@@ -18,6 +18,7 @@
 namespace reactivesocket {
 
 class DuplexConnection;
+class MemoryAccountant;
 
 class FrameTransport :
     /// Registered as an input in the DuplexConnection.
@@ -31,6 +32,11 @@ class FrameTransport :
 
   void setFrameProcessor(std::shared_ptr<FrameProcessor>);
 
+  /// Charges the queued frames to the accountant, as well as the frames the
+  /// connection has not read whole yet, and stops reading from the
+  /// connection while the accountant says so.
+  void setMemoryAccountant(std::shared_ptr<MemoryAccountant>);
+
   /// Enqueues provided frame to be written to the underlying connection.
   /// Enqueuing a terminal frame does not end the stream.
   ///
@@ -48,6 +54,10 @@ class FrameTransport :
 
   DuplexConnection* duplexConnection() const;
 
+  /// Number and total size of frames waiting for the connection to accept
+  /// more writes.
+  std::pair<size_t, size_t> pendingWrites() const;
+
  private:
   void connect();
 
@@ -61,6 +71,18 @@ class FrameTransport :
 
   void drainOutputFramesQueue();
 
+  /// Tops the demand on the connection input up to kReadWindow frames, once
+  /// half of it has been received and unless reads are paused.
+  void requestReads();
+
+  void enqueuePendingWrite(std::unique_ptr<folly::IOBuf> frame);
+  std::unique_ptr<folly::IOBuf> dequeuePendingWrite();
+  void enqueuePendingRead(std::unique_ptr<folly::IOBuf> frame);
+  std::unique_ptr<folly::IOBuf> dequeuePendingRead();
+
+  /// Frames requested from the connection input at a time.
+  static constexpr size_t kReadWindow = 256;
+
   void terminateFrameProcessor(folly::exception_wrapper);
 
   // TODO(t15924567): Recursive locks are evil! This should instead use a
@@ -82,6 +104,13 @@ class FrameTransport :
 
   std::deque<std::unique_ptr<folly::IOBuf>> pendingWrites_;
   std::deque<std::unique_ptr<folly::IOBuf>> pendingReads_;
+  /// Total data length of the frames in pendingWrites_ and pendingReads_.
+  size_t pendingWritesBytes_{0};
+  size_t pendingReadsBytes_{0};
   folly::Optional<folly::exception_wrapper> pendingTerminal_;
+
+  std::shared_ptr<MemoryAccountant> memoryAccountant_;
+  /// Frames requested from the connection input and not received yet.
+  size_t readDemand_{0};
 };
 } // reactivesocket
@@ -0,0 +1,112 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace reactivesocket {
+
+/// Log-linear histogram of unsigned values, modelled after HdrHistogram.
+///
+/// A value is bucketed by its highest set bit and the kSubBucketBits bits
+/// below it, which bounds the error of any reported value to 1/kSubBuckets
+/// (~3%) of that value.  Values above kMaxValue are clamped.
+///
+/// ::record and ::merge are wait-free, but only a single thread may write to
+/// a histogram at a time.  Readers may run concurrently with the writer and
+/// observe a slightly stale state.
+class HdrHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+  static constexpr int kMaxValueBits = 40;
+  static constexpr uint64_t kMaxValue = (uint64_t(1) << kMaxValueBits) - 1;
+  static constexpr size_t kBuckets =
+      kSubBuckets * (kMaxValueBits - kSubBucketBits + 1);
+
+  HdrHistogram() {
+    for (auto& count : counts_) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+  HdrHistogram(const HdrHistogram&) = delete;
+  HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+  void record(uint64_t value) noexcept {
+    increment(counts_[bucketOf(value)], 1);
+  }
+
+  /// Adds all values recorded in the other histogram to this one.
+  void merge(const HdrHistogram& other) noexcept {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      if (auto count = other.counts_[i].load(std::memory_order_relaxed)) {
+        increment(counts_[i], count);
+      }
+    }
+  }
+
+  uint64_t count() const noexcept {
+    uint64_t total = 0;
+    for (auto& count : counts_) {
+      total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /// Returns the highest value equivalent to the one at the given percentile
+  /// (0, 100], or 0 if the histogram is empty.
+  uint64_t percentile(double percentile) const noexcept {
+    auto total = count();
+    if (total == 0) {
+      return 0;
+    }
+    auto rank = static_cast<uint64_t>(percentile / 100 * total + 0.5);
+    rank = rank == 0 ? 1 : rank;
+    uint64_t seen = 0;
+    size_t last = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      if (auto count = counts_[i].load(std::memory_order_relaxed)) {
+        last = i;
+        seen += count;
+        if (seen >= rank) {
+          break;
+        }
+      }
+    }
+    return highestEquivalentValue(last);
+  }
+
+  static size_t bucketOf(uint64_t value) noexcept {
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    if (value > kMaxValue) {
+      value = kMaxValue;
+    }
+    const int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    return static_cast<size_t>(
+        kSubBuckets * (shift + 1) + ((value >> shift) - kSubBuckets));
+  }
+
+  static uint64_t highestEquivalentValue(size_t bucket) noexcept {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    const auto shift = bucket / kSubBuckets - 1;
+    const auto top = kSubBuckets + bucket % kSubBuckets;
+    return ((top + 1) << shift) - 1;
+  }
+
+ private:
+  /// Plain load and store, the histogram has a single writer.
+  static void increment(std::atomic<uint64_t>& count, uint64_t n) noexcept {
+    count.store(
+        count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, kBuckets> counts_;
+};
+}
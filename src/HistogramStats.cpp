@@ -0,0 +1,113 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/HistogramStats.h"
+#include <glog/logging.h>
+
+namespace reactivesocket {
+
+namespace {
+size_t indexOf(StreamType streamType) {
+  return static_cast<size_t>(streamType);
+}
+
+uint64_t toNanos(Stats::Clock::duration duration) {
+  auto nanos =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  // The clock is monotonic, but the timestamps may come from different
+  // threads.
+  return nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+}
+}
+
+HistogramStats::Shard::Shard() {
+  for (auto& issued : issued_) {
+    issued.store(0, std::memory_order_relaxed);
+  }
+}
+
+void HistogramStats::Shard::mergeInto(Shard& other) const {
+  for (size_t type = 0; type < kStreamTypes; ++type) {
+    other.issued_[type].fetch_add(
+        issued_[type].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    for (size_t latency = 0; latency < kLatencies; ++latency) {
+      other.latencies_[type][latency].merge(latencies_[type][latency]);
+    }
+  }
+  other.queueing_.merge(queueing_);
+}
+
+void HistogramStats::requestIssued(StreamType streamType, Clock::time_point) {
+  auto& issued = shards_.local().issued_[indexOf(streamType)];
+  issued.store(
+      issued.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void HistogramStats::requestWritten(
+    StreamType streamType,
+    Clock::time_point issued,
+    Clock::time_point written) {
+  record(streamType, Latency::WRITTEN, issued, written);
+}
+
+void HistogramStats::responseRead(
+    StreamType streamType,
+    Clock::time_point issued,
+    Clock::time_point read) {
+  record(streamType, Latency::READ, issued, read);
+}
+
+void HistogramStats::responseDelivered(
+    StreamType streamType,
+    Clock::time_point issued,
+    Clock::time_point delivered) {
+  record(streamType, Latency::DELIVERED, issued, delivered);
+}
+
+void HistogramStats::executorQueueingDelay(Clock::duration delay) {
+  shards_.local().queueing_.record(toNanos(delay));
+}
+
+void HistogramStats::record(
+    StreamType streamType,
+    Latency latency,
+    Clock::time_point from,
+    Clock::time_point to) {
+  shards_.local()
+      .latencies_[indexOf(streamType)][static_cast<size_t>(latency)]
+      .record(toNanos(to - from));
+}
+
+std::unique_ptr<HistogramStats::Shard> HistogramStats::aggregate() const {
+  auto total = std::make_unique<Shard>();
+  shards_.aggregate(*total);
+  return total;
+}
+
+HistogramStats::Summary HistogramStats::summarize(
+    const HdrHistogram& histogram) {
+  Summary summary;
+  summary.count = histogram.count();
+  summary.p50 = std::chrono::nanoseconds(histogram.percentile(50));
+  summary.p99 = std::chrono::nanoseconds(histogram.percentile(99));
+  summary.p999 = std::chrono::nanoseconds(histogram.percentile(99.9));
+  return summary;
+}
+
+uint64_t HistogramStats::requestsIssued(StreamType streamType) const {
+  return aggregate()->issued_[indexOf(streamType)].load(
+      std::memory_order_relaxed);
+}
+
+HistogramStats::Summary HistogramStats::latency(
+    StreamType streamType,
+    Latency latency) const {
+  DCHECK(indexOf(streamType) < kStreamTypes);
+  return summarize(aggregate()->latencies_[indexOf(streamType)]
+                                          [static_cast<size_t>(latency)]);
+}
+
+HistogramStats::Summary HistogramStats::queueingDelay() const {
+  return summarize(aggregate()->queueing_);
+}
+}
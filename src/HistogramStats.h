@@ -0,0 +1,93 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include "src/HdrHistogram.h"
+#include "src/Stats.h"
+#include "src/ThreadShards.h"
+
+namespace reactivesocket {
+
+/// Stats recording request latencies into per-thread HdrHistograms.
+///
+/// Every thread records into its own set of histograms (see ThreadShards), so
+/// the hooks take no locks and execute no read-modify-write instructions;
+/// summaries aggregate all threads on demand.  Counts recorded by threads
+/// which have exited are kept.  The counter hooks of Stats are no-ops.
+class HistogramStats : public Stats {
+ public:
+  /// The event a latency is measured to, from the time a request is issued.
+  enum class Latency : uint8_t {
+    WRITTEN,
+    READ,
+    DELIVERED,
+  };
+
+  struct Summary {
+    uint64_t count{0};
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds p999{0};
+  };
+
+  /// Number of requests of the given interaction model issued so far.
+  uint64_t requestsIssued(StreamType streamType) const;
+  Summary latency(StreamType streamType, Latency latency) const;
+  Summary queueingDelay() const;
+
+  bool latencyTrackingEnabled() const override {
+    return true;
+  }
+  void requestIssued(StreamType, Clock::time_point) override;
+  void requestWritten(StreamType, Clock::time_point, Clock::time_point)
+      override;
+  void responseRead(StreamType, Clock::time_point, Clock::time_point) override;
+  void responseDelivered(StreamType, Clock::time_point, Clock::time_point)
+      override;
+  void executorQueueingDelay(Clock::duration) override;
+
+  void socketCreated() override {}
+  void socketDisconnected() override {}
+  void socketClosed(StreamCompletionSignal) override {}
+  void duplexConnectionCreated(const std::string&, DuplexConnection*)
+      override {}
+  void duplexConnectionClosed(const std::string&, DuplexConnection*) override {
+  }
+  void bytesWritten(size_t) override {}
+  void bytesRead(size_t) override {}
+  void frameWritten(FrameType) override {}
+  void frameRead(FrameType) override {}
+  void resumeBufferChanged(int, int) override {}
+  void streamBufferChanged(int64_t, int64_t) override {}
+
+ private:
+  static constexpr size_t kStreamTypes = 4;
+  static constexpr size_t kLatencies = 3;
+
+  /// Histograms written by a single thread.
+  struct Shard {
+    Shard();
+
+    void mergeInto(Shard& other) const;
+
+    std::array<std::atomic<uint64_t>, kStreamTypes> issued_;
+    std::array<std::array<HdrHistogram, kLatencies>, kStreamTypes> latencies_;
+    HdrHistogram queueing_;
+  };
+
+  void record(
+      StreamType streamType,
+      Latency latency,
+      Clock::time_point from,
+      Clock::time_point to);
+
+  /// Returns a Shard with the counts of all threads.
+  std::unique_ptr<Shard> aggregate() const;
+  static Summary summarize(const HdrHistogram& histogram);
+
+  mutable ThreadShards<Shard> shards_;
+};
+}
@@ -0,0 +1,22 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <glog/logging.h>
+#include <climits>
+
+/// The highest VLOG level compiled into the library.  Release builds leave
+/// out the levels above 2, which log every frame or stream event and would
+/// otherwise cost a branch on every frame even when disabled at run time.
+/// Frames can still be looked at in release builds with the sampled frame
+/// trace, see FrameTrace.h.
+#ifndef RSOCKET_MAX_VLOG
+#ifdef NDEBUG
+#define RSOCKET_MAX_VLOG 2
+#else
+#define RSOCKET_MAX_VLOG INT_MAX
+#endif
+#endif
+
+/// VLOG which compiles to nothing above RSOCKET_MAX_VLOG.
+#define RSOCKET_VLOG(level) VLOG_IF(level, (level) <= RSOCKET_MAX_VLOG)
@@ -0,0 +1,60 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/MemoryAccountant.h"
+#include <glog/logging.h>
+#include "src/Stats.h"
+
+namespace reactivesocket {
+
+constexpr size_t MemoryAccountant::kBuffers;
+
+MemoryAccountant::MemoryAccountant(
+    MemoryLimits limits,
+    std::shared_ptr<Stats> stats)
+    : limits_(limits), stats_(std::move(stats)) {
+  CHECK(stats_);
+  for (auto& used : used_) {
+    used.store(0, std::memory_order_relaxed);
+  }
+}
+
+void MemoryAccountant::charge(MemoryBuffer buffer, size_t bytes) {
+  const auto delta = static_cast<int64_t>(bytes);
+  used_[static_cast<size_t>(buffer)].fetch_add(
+      delta, std::memory_order_relaxed);
+  total_.fetch_add(delta, std::memory_order_relaxed);
+  stats_->bufferedBytesChanged(buffer, delta);
+}
+
+void MemoryAccountant::release(MemoryBuffer buffer, size_t bytes) {
+  const auto delta = static_cast<int64_t>(bytes);
+  used_[static_cast<size_t>(buffer)].fetch_sub(
+      delta, std::memory_order_relaxed);
+  total_.fetch_sub(delta, std::memory_order_relaxed);
+  stats_->bufferedBytesChanged(buffer, -delta);
+}
+
+size_t MemoryAccountant::used() const {
+  return static_cast<size_t>(total_.load(std::memory_order_relaxed));
+}
+
+size_t MemoryAccountant::used(MemoryBuffer buffer) const {
+  return static_cast<size_t>(
+      used_[static_cast<size_t>(buffer)].load(std::memory_order_relaxed));
+}
+
+bool MemoryAccountant::shouldPauseReads() {
+  if (limits_.connectionBytes == 0) {
+    return false;
+  }
+  const auto used = this->used();
+  const bool paused = readsPaused_.load(std::memory_order_relaxed);
+  const bool pause = paused ? used >= limits_.connectionBytes / 2
+                            : used >= limits_.connectionBytes;
+  if (pause != paused) {
+    readsPaused_.store(pause, std::memory_order_relaxed);
+    stats_->readsPaused(pause);
+  }
+  return pause;
+}
+}
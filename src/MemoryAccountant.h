@@ -0,0 +1,76 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include "src/Common.h"
+
+namespace reactivesocket {
+
+class Stats;
+
+/// Caps on the memory a connection buffers on behalf of its peer, 0 disables
+/// a cap.
+struct MemoryLimits {
+  /// Bytes of frames the connection buffers, in any MemoryBuffer. The
+  /// connection stops reading from its transport once it reaches the cap and
+  /// resumes once it is back under half of it.
+  size_t connectionBytes{0};
+  /// Bytes a single stream may hold: the size of a frame received on it, or
+  /// of its frames written while the connection is disconnected. The stream
+  /// is terminated with an error when it exceeds the cap.
+  ///
+  /// A framed transport refuses a frame over either cap as soon as it reads
+  /// its length, and closes the connection, as the frame could not be
+  /// buffered to be dispatched to its stream.
+  size_t streamBytes{0};
+};
+
+/// Accounts the bytes a connection buffers against its MemoryLimits and
+/// reports them to Stats.
+///
+/// Shared by a ConnectionAutomaton with its StreamState and FrameTransport,
+/// which may charge it from different threads.
+class MemoryAccountant {
+ public:
+  MemoryAccountant(MemoryLimits limits, std::shared_ptr<Stats> stats);
+
+  const MemoryLimits& limits() const {
+    return limits_;
+  }
+
+  void charge(MemoryBuffer buffer, size_t bytes);
+  void release(MemoryBuffer buffer, size_t bytes);
+
+  /// Bytes buffered in total and in the given buffer.
+  size_t used() const;
+  size_t used(MemoryBuffer buffer) const;
+
+  /// Whether the connection should stop reading: true from the moment the
+  /// buffered bytes reach the connection cap until they drop under half of
+  /// it.
+  bool shouldPauseReads();
+
+  bool exceedsStreamCap(size_t bytes) const {
+    return limits_.streamBytes != 0 && bytes > limits_.streamBytes;
+  }
+
+  /// Whether a frame of the given size is over either cap, so that it may not
+  /// be buffered at all.
+  bool exceedsFrameCap(size_t bytes) const {
+    return exceedsStreamCap(bytes) ||
+        (limits_.connectionBytes != 0 && bytes > limits_.connectionBytes);
+  }
+
+ private:
+  static constexpr size_t kBuffers = 3;
+
+  const MemoryLimits limits_;
+  const std::shared_ptr<Stats> stats_;
+  std::array<std::atomic<int64_t>, kBuffers> used_;
+  std::atomic<int64_t> total_{0};
+  std::atomic<bool> readsPaused_{false};
+};
+}
@@ -1,6 +1,7 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include "src/NullRequestHandler.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 namespace reactivesocket {
 
@@ -35,8 +36,8 @@ void NullRequestHandler::handleRequestStream(
 void NullRequestHandler::handleRequestResponse(
     Payload /*request*/,
     StreamId /*streamId*/,
-    const Reference<Subscriber<Payload>>& response) noexcept {
-  response->onSubscribe(make_ref<NullSubscription>());
+    const Reference<yarpl::single::SingleObserver<Payload>>& response) noexcept {
+  response->onSubscribe(yarpl::single::SingleSubscriptions::empty());
   response->onError(std::make_exception_ptr(std::runtime_error("NullRequestHandler")));
 }
 
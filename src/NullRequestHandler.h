@@ -48,7 +48,8 @@ class NullRequestHandler : public RequestHandler {
   void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) noexcept override;
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          response) noexcept override;
 
   void handleFireAndForgetRequest(
       Payload request,
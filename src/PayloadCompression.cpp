@@ -0,0 +1,264 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/PayloadCompression.h"
+#include <folly/io/Compression.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <algorithm>
+#include <limits>
+#include "src/CompositeMetadata.h"
+#include "src/Logging.h"
+#include "src/Payload.h"
+
+namespace reactivesocket {
+
+namespace {
+/// The header of a compressed payload: the codec as one byte and the length
+/// of the uncompressed data as a 32 bit big endian integer.
+constexpr size_t kHeaderSize = 5;
+
+folly::io::CodecType codecType(CompressionCodec codec) {
+  switch (codec) {
+    case CompressionCodec::ZSTD:
+      return folly::io::CodecType::ZSTD;
+    case CompressionCodec::LZ4:
+      // the uncompressed length is part of the compressed data
+      return folly::io::CodecType::LZ4_VARINT_SIZE;
+    case CompressionCodec::NONE:
+    default:
+      return folly::io::CodecType::NO_COMPRESSION;
+  }
+}
+
+bool isKnown(CompressionCodec codec) {
+  return codec == CompressionCodec::ZSTD || codec == CompressionCodec::LZ4;
+}
+
+/// Length of a composite metadata entry of kCompressionMimeType, which is
+/// not a well known mime type.
+size_t entryLength(size_t length) {
+  return 1 + kCompressionMimeType.size() + 3 + length;
+}
+
+/// Moves to the first entry, returns whether it is one of
+/// kCompressionMimeType.
+bool readEntry(CompositeMetadataReader& reader) {
+  return reader.next() && reader.mimeTypeIs(kCompressionMimeType);
+}
+
+/// Drops the first bytes of metadata, all of them leave no metadata.
+void trimStart(std::unique_ptr<folly::IOBuf>& metadata, size_t length) {
+  if (metadata->length() >= length) {
+    metadata->trimStart(length);
+  } else {
+    folly::IOBufQueue queue;
+    queue.append(std::move(metadata));
+    queue.trimStart(length);
+    metadata = queue.move();
+  }
+  if (!metadata || metadata->computeChainDataLength() == 0) {
+    metadata = nullptr;
+  }
+}
+}
+
+std::string to_string(CompressionCodec codec) {
+  switch (codec) {
+    case CompressionCodec::NONE:
+      return "NONE";
+    case CompressionCodec::ZSTD:
+      return "ZSTD";
+    case CompressionCodec::LZ4:
+      return "LZ4";
+  }
+  return "UNKNOWN";
+}
+
+PayloadCompression::PayloadCompression(const CompressionOptions& options)
+    : offered_(options.codecs),
+      minSize_(options.minSize),
+      level_(options.level),
+      maxUncompressedSize_(options.maxUncompressedSize),
+      compositeMetadata_(options.compositeMetadata) {}
+
+PayloadCompression::~PayloadCompression() = default;
+
+void PayloadCompression::setCodec(CompressionCodec codec) {
+  DCHECK(codec == CompressionCodec::NONE || isSupported(codec));
+  codec_ = codec;
+}
+
+bool PayloadCompression::isSupported(CompressionCodec codec) {
+  switch (codec) {
+    case CompressionCodec::NONE:
+      return true;
+    case CompressionCodec::ZSTD:
+    case CompressionCodec::LZ4:
+      return folly::io::hasCodec(codecType(codec));
+  }
+  return false;
+}
+
+CompressionCodec PayloadCompression::choose(
+    const std::vector<CompressionCodec>& codecs) {
+  for (auto codec : codecs) {
+    if (isKnown(codec) && isSupported(codec)) {
+      return codec;
+    }
+  }
+  return CompressionCodec::NONE;
+}
+
+folly::io::Codec* PayloadCompression::codecFor(CompressionCodec codec) {
+  auto& slot = codec == CompressionCodec::ZSTD ? zstd_ : lz4_;
+  if (!slot) {
+    slot = folly::io::getCodec(
+        codecType(codec),
+        level_ ? level_ : folly::io::COMPRESSION_LEVEL_DEFAULT);
+  }
+  return slot.get();
+}
+
+void PayloadCompression::compress(Payload& payload) {
+  if (codec_ == CompressionCodec::NONE || !compositeMetadata_ ||
+      !payload.data) {
+    return;
+  }
+  const auto length = payload.data->computeChainDataLength();
+  if (length == 0 || length < minSize_ ||
+      length > std::numeric_limits<uint32_t>::max()) {
+    return;
+  }
+
+  std::unique_ptr<folly::IOBuf> compressed;
+  try {
+    compressed = codecFor(codec_)->compress(payload.data.get());
+  } catch (const std::exception& ex) {
+    LOG_FIRST_N(ERROR, 1) << "sending payload uncompressed, "
+                          << to_string(codec_) << " failed: " << ex.what();
+    return;
+  }
+  if (compressed->computeChainDataLength() >= length) {
+    return;
+  }
+
+  auto header = folly::IOBuf::create(kHeaderSize);
+  folly::io::Appender appender(header.get(), 0);
+  appender.write<uint8_t>(static_cast<uint8_t>(codec_));
+  appender.writeBE<uint32_t>(static_cast<uint32_t>(length));
+  auto metadata = CompositeMetadataBuilder()
+                      .add(kCompressionMimeType, std::move(header))
+                      .build();
+  if (payload.metadata) {
+    metadata->prependChain(std::move(payload.metadata));
+  }
+  payload.metadata = std::move(metadata);
+  payload.data = std::move(compressed);
+}
+
+PayloadCompression::Status PayloadCompression::decompress(Payload& payload) {
+  if (!compositeMetadata_ || !payload.metadata) {
+    return Status::OK;
+  }
+  CompositeMetadataReader reader(*payload.metadata);
+  if (!readEntry(reader)) {
+    return Status::OK;
+  }
+  if (reader.length() != kHeaderSize || !payload.data) {
+    return Status::CORRUPT;
+  }
+  auto cursor = reader.cursor();
+  const auto codec = static_cast<CompressionCodec>(cursor.read<uint8_t>());
+  const uint64_t length = cursor.readBE<uint32_t>();
+  if (!isKnown(codec) || !isSupported(codec)) {
+    return Status::CORRUPT;
+  }
+  if (length > maxUncompressedSize_) {
+    RSOCKET_VLOG(1) << "payload would decompress to " << length << " bytes";
+    return Status::TOO_LARGE;
+  }
+  trimStart(payload.metadata, entryLength(kHeaderSize));
+
+  try {
+    payload.data = codecFor(codec)->uncompress(payload.data.get(), length);
+  } catch (const std::exception& ex) {
+    RSOCKET_VLOG(1) << "invalid " << to_string(codec)
+                    << " payload: " << ex.what();
+    return Status::CORRUPT;
+  }
+  return Status::OK;
+}
+
+void PayloadCompression::attachOffer(
+    const std::vector<CompressionCodec>& codecs,
+    Payload& setupPayload) {
+  auto offer = folly::IOBuf::create(codecs.size());
+  for (auto codec : codecs) {
+    if (isKnown(codec) && isSupported(codec)) {
+      offer->writableTail()[0] = static_cast<uint8_t>(codec);
+      offer->append(1);
+    }
+  }
+  if (offer->empty()) {
+    return;
+  }
+  auto metadata = CompositeMetadataBuilder()
+                      .add(kCompressionMimeType, std::move(offer))
+                      .build();
+  if (setupPayload.metadata) {
+    metadata->prependChain(std::move(setupPayload.metadata));
+  }
+  setupPayload.metadata = std::move(metadata);
+}
+
+std::vector<CompressionCodec> PayloadCompression::takeOffer(
+    Payload& setupPayload) {
+  std::vector<CompressionCodec> codecs;
+  if (!setupPayload.metadata) {
+    return codecs;
+  }
+  CompositeMetadataReader reader(*setupPayload.metadata);
+  if (!readEntry(reader)) {
+    return codecs;
+  }
+  auto cursor = reader.cursor();
+  codecs.reserve(reader.length());
+  for (size_t i = 0; i < reader.length(); ++i) {
+    codecs.push_back(static_cast<CompressionCodec>(cursor.read<uint8_t>()));
+  }
+  trimStart(setupPayload.metadata, entryLength(reader.length()));
+  return codecs;
+}
+
+std::unique_ptr<folly::IOBuf> PayloadCompression::confirmation(
+    CompressionCodec codec) {
+  auto confirmed = folly::IOBuf::create(1);
+  confirmed->writableTail()[0] = static_cast<uint8_t>(codec);
+  confirmed->append(1);
+  return CompositeMetadataBuilder()
+      .add(kCompressionMimeType, std::move(confirmed))
+      .build();
+}
+
+bool PayloadCompression::takeConfirmation(const folly::IOBuf& metadata) {
+  CompositeMetadataReader reader(metadata);
+  if (!readEntry(reader)) {
+    return false;
+  }
+  if (reader.length() != 1) {
+    RSOCKET_VLOG(1) << "invalid compression confirmation";
+    return true;
+  }
+  const auto codec =
+      static_cast<CompressionCodec>(reader.cursor().read<uint8_t>());
+  if (std::find(offered_.begin(), offered_.end(), codec) == offered_.end() ||
+      !isKnown(codec) || !isSupported(codec)) {
+    RSOCKET_VLOG(1) << "server confirmed codec "
+                    << static_cast<int>(codec) << " which was not offered";
+    return true;
+  }
+  RSOCKET_VLOG(3) << "compressing payloads with " << to_string(codec);
+  codec_ = codec;
+  return true;
+}
+}
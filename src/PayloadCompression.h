@@ -0,0 +1,147 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace folly {
+class IOBuf;
+namespace io {
+class Codec;
+}
+}
+
+namespace reactivesocket {
+
+struct Payload;
+
+/// Mime type of the composite metadata entries of payload compression, see
+/// PayloadCompression.
+constexpr folly::StringPiece kCompressionMimeType{
+    "message/x.rsocket.compression.v0"};
+
+/// Codecs payload data can be compressed with, as identified on the wire.
+enum class CompressionCodec : uint8_t {
+  NONE = 0,
+  ZSTD = 1,
+  LZ4 = 2,
+};
+
+std::string to_string(CompressionCodec);
+
+/// Payload compression of a connection, negotiated at SETUP.
+struct CompressionOptions {
+  /// The codecs the client offers, in order of preference. No compression
+  /// when empty.
+  std::vector<CompressionCodec> codecs;
+  /// Payload data shorter than that are sent as they are.
+  size_t minSize{1024};
+  /// Codec specific, the default level of the codec when 0.
+  int level{0};
+  /// Received payload data which would decompress to more are not
+  /// decompressed, their stream fails instead. Bounds what a peer can make
+  /// the connection allocate with a few bytes of compressed data.
+  size_t maxUncompressedSize{(1 << 24) - 1};
+  /// Whether the metadata of the connection are composite metadata, which
+  /// the header of a compressed payload is added to. Compression needs them:
+  /// without, the codecs are neither offered nor taken from the SETUP frame
+  /// and no payload is compressed or decompressed. Set from the metadata mime
+  /// type of the SETUP frame.
+  bool compositeMetadata{false};
+};
+
+/// Compresses the data of the payloads written to a connection and
+/// decompresses the data of the payloads read from it.
+///
+/// Every part of the protocol is a composite metadata entry of mime type
+/// kCompressionMimeType, so only connections whose SETUP metadata mime type
+/// is kCompositeMetadataMimeType compress:
+/// - the client offers the codecs it supports, in order of preference, as
+///   the first entry of the SETUP metadata, which the server strips before
+///   the application sees it,
+/// - the server picks the first offered codec it supports and confirms it in
+///   a METADATA_PUSH, which is not passed on to the application either,
+/// - the metadata of a compressed payload start with its header, the codec
+///   and the uncompressed length of the data.
+///
+/// The server compresses from the start, the client once the server
+/// confirmed the codec, so a server without compression, which never
+/// confirms, gets no compressed payloads. Payloads which are sent as they
+/// are stay untouched, they cost neither bytes nor allocations.
+///
+/// Not thread safe, used on the EventBase of the connection.
+class PayloadCompression {
+ public:
+  /// Compresses nothing until a codec is set, see setCodec.
+  explicit PayloadCompression(const CompressionOptions& options);
+  ~PayloadCompression();
+
+  CompressionCodec codec() const {
+    return codec_;
+  }
+
+  /// Compresses the payloads with the codec from now on.
+  void setCodec(CompressionCodec codec);
+
+  /// Whether this build can compress and decompress with the codec.
+  static bool isSupported(CompressionCodec codec);
+
+  /// The first of the codecs which is supported, NONE when none is.
+  static CompressionCodec choose(const std::vector<CompressionCodec>& codecs);
+
+  /// Compresses the data of the payload when they are long enough and
+  /// compress to fewer bytes, and adds the header to its metadata.
+  void compress(Payload& payload);
+
+  enum class Status {
+    OK,
+    /// The data are corrupt or compressed with an unsupported codec.
+    CORRUPT,
+    /// The data would decompress to more than maxUncompressedSize.
+    TOO_LARGE,
+  };
+
+  /// Decompresses the data of a payload whose metadata start with the header
+  /// and strips the header. The uncompressed length of the header is checked
+  /// before any decompression, the codec decompresses no more than that.
+  /// Payloads are left as they are when the metadata of the connection are
+  /// not composite metadata.
+  Status decompress(Payload& payload);
+
+  /// Prefixes the SETUP metadata with the offer of the supported codecs. The
+  /// SETUP metadata mime type has to be kCompositeMetadataMimeType.
+  static void attachOffer(
+      const std::vector<CompressionCodec>& codecs,
+      Payload& setupPayload);
+
+  /// Strips the offer off SETUP metadata of kCompositeMetadataMimeType and
+  /// returns the codecs offered, none when the client did not offer
+  /// compression.
+  static std::vector<CompressionCodec> takeOffer(Payload& setupPayload);
+
+  /// The metadata of the METADATA_PUSH which confirms the codec.
+  static std::unique_ptr<folly::IOBuf> confirmation(CompressionCodec codec);
+
+  /// Sets the codec when the metadata of a METADATA_PUSH confirm one of the
+  /// codecs offered. Returns whether the metadata are a confirmation, which
+  /// is not meant for the application.
+  bool takeConfirmation(const folly::IOBuf& metadata);
+
+ private:
+  folly::io::Codec* codecFor(CompressionCodec codec);
+
+  CompressionCodec codec_{CompressionCodec::NONE};
+  const std::vector<CompressionCodec> offered_;
+  const size_t minSize_;
+  const int level_;
+  const size_t maxUncompressedSize_;
+  const bool compositeMetadata_;
+  /// Created on first use.
+  std::unique_ptr<folly::io::Codec> zstd_;
+  std::unique_ptr<folly::io::Codec> lz4_;
+};
+}
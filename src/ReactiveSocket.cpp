@@ -9,6 +9,7 @@
 #include <folly/io/async/EventBase.h>
 
 #include "src/ClientResumeStatusCallback.h"
+#include "src/CompositeMetadata.h"
 #include "src/ConnectionAutomaton.h"
 #include "src/FrameTransport.h"
 #include "src/RequestHandler.h"
@@ -122,29 +123,32 @@ ReactiveSocket::disconnectedServer(
 }
 
 yarpl::Reference<yarpl::flowable::Subscriber<Payload>> ReactiveSocket::requestChannel(
-    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+    const RequestDeadline& deadline) {
   debugCheckCorrectExecutor();
   checkNotClosed();
   return connection_->streamsFactory().createChannelRequester(
-      std::move(responseSink));
+      std::move(responseSink), deadline);
 }
 
 void ReactiveSocket::requestStream(
     Payload request,
-    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+    const RequestDeadline& deadline) {
   debugCheckCorrectExecutor();
   checkNotClosed();
   connection_->streamsFactory().createStreamRequester(
-      std::move(request), std::move(responseSink));
+      std::move(request), std::move(responseSink), deadline);
 }
 
 void ReactiveSocket::requestResponse(
     Payload payload,
-    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    yarpl::Reference<yarpl::single::SingleObserver<Payload>> responseSink,
+    const RequestDeadline& deadline) {
   debugCheckCorrectExecutor();
   checkNotClosed();
   connection_->streamsFactory().createRequestResponseRequester(
-      std::move(payload), std::move(responseSink));
+      std::move(payload), std::move(responseSink), deadline);
 }
 
 void ReactiveSocket::requestFireAndForget(Payload request) {
@@ -167,6 +171,9 @@ void ReactiveSocket::clientConnect(
   debugCheckCorrectExecutor();
   checkNotClosed();
   connection_->setResumable(setupPayload.resumable);
+  setupPayload.compression.compositeMetadata =
+      setupPayload.metadataMimeType == kCompositeMetadataMimeType;
+  connection_->setCompression(setupPayload.compression);
 
   if (setupPayload.protocolVersion != ProtocolVersion::Unknown) {
     CHECK_EQ(
@@ -182,8 +189,11 @@ void ReactiveSocket::serverConnect(
     const SocketParameters& socketParams) {
   debugCheckCorrectExecutor();
   connection_->setResumable(socketParams.resumable);
+  connection_->setCompression(socketParams.compression);
+  connection_->setPeerHonorsLease(socketParams.honorsLease);
   connection_->connect(
       std::move(frameTransport), true, socketParams.protocolVersion);
+  connection_->confirmCompression();
 }
 
 void ReactiveSocket::close() {
@@ -192,6 +202,11 @@ void ReactiveSocket::close() {
       folly::exception_wrapper(), StreamCompletionSignal::SOCKET_CLOSED);
 }
 
+void ReactiveSocket::connectFailed(folly::exception_wrapper ex) {
+  debugCheckCorrectExecutor();
+  connection_->connectFailed(std::move(ex));
+}
+
 void ReactiveSocket::disconnect() {
   debugCheckCorrectExecutor();
   checkNotClosed();
@@ -276,9 +291,28 @@ void ReactiveSocket::debugCheckCorrectExecutor() const {
       dynamic_cast<folly::EventBase*>(&executor_)->isInEventBaseThread());
 }
 
+FlowControlSnapshot ReactiveSocket::flowControlSnapshot() const {
+  debugCheckCorrectExecutor();
+  return connection_->flowControlSnapshot();
+}
+
+void ReactiveSocket::setMemoryLimits(const MemoryLimits& limits) {
+  debugCheckCorrectExecutor();
+  connection_->setMemoryLimits(limits);
+}
+
 bool ReactiveSocket::isClosed() {
   debugCheckCorrectExecutor();
   return connection_->isClosed();
 }
 
+void ReactiveSocket::drain() {
+  debugCheckCorrectExecutor();
+  connection_->drain();
+}
+
+bool ReactiveSocket::isPeerDraining() const {
+  return connection_->isPeerDraining();
+}
+
 } // reactivesocket
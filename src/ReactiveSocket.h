@@ -5,10 +5,14 @@
 #include <memory>
 #include "src/Common.h"
 #include "src/ConnectionSetupPayload.h"
+#include "src/FlowControlSnapshot.h"
+#include "src/MemoryAccountant.h"
 #include "src/Payload.h"
+#include "src/RequestDeadline.h"
 #include "src/Stats.h"
 #include "yarpl/flowable/Subscriber.h"
 #include "yarpl/flowable/Subscription.h"
+#include "yarpl/single/SingleObserver.h"
 
 namespace folly {
 class Executor;
@@ -73,16 +77,22 @@ class ReactiveSocket {
       std::shared_ptr<Stats> stats = Stats::noop(),
       ProtocolVersion protocolVersion = ProtocolVersion::Unknown);
 
+  /// See RequestDeadline for what happens when the deadline passes, the
+  /// requests are cancelled too.
   yarpl::Reference<yarpl::flowable::Subscriber<Payload>> requestChannel(
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
+  /// See RequestDeadline for what happens when the deadline passes.
   void requestStream(
       Payload payload,
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
   void requestResponse(
       Payload payload,
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::single::SingleObserver<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
   void requestFireAndForget(Payload request);
 
@@ -99,6 +109,10 @@ class ReactiveSocket {
   void close();
   void disconnect();
 
+  /// Closes a disconnectedClient() whose transport failed to connect, failing
+  /// the requests buffered meanwhile with the error.
+  void connectFailed(folly::exception_wrapper ex);
+
   void closeConnectionError(const std::string& reason);
 
   std::shared_ptr<FrameTransport> detachFrameTransport();
@@ -123,6 +137,22 @@ class ReactiveSocket {
   DuplexConnection* duplexConnection() const;
   bool isClosed();
 
+  /// See ConnectionAutomaton::flowControlSnapshot.
+  FlowControlSnapshot flowControlSnapshot() const;
+
+  /// Caps the memory the socket buffers on behalf of its peer, see
+  /// MemoryLimits.
+  void setMemoryLimits(const MemoryLimits& limits);
+
+  /// Stops taking new requests from the peer, which is asked to send them
+  /// elsewhere when it honours leases, and closes the socket once the
+  /// requests in flight end.  See ConnectionAutomaton::drain.
+  void drain();
+
+  /// Whether the peer is draining and takes no new requests.  Safe to call
+  /// from any thread.
+  bool isPeerDraining() const;
+
  private:
   ReactiveSocket(
       ReactiveSocketMode mode,
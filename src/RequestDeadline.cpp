@@ -0,0 +1,62 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/RequestDeadline.h"
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <algorithm>
+#include <limits>
+#include "src/CompositeMetadata.h"
+#include "src/Payload.h"
+
+namespace reactivesocket {
+
+namespace {
+constexpr size_t kBudgetSize = sizeof(uint32_t);
+/// Length of the entry: the mime type, which is not a well known one, with
+/// its length, the 24 bit length of the budget and the budget.
+constexpr size_t kEntrySize = 1 + kDeadlineMimeType.size() + 3 + kBudgetSize;
+}
+
+RequestDeadline::Clock::duration RequestDeadline::remaining() const {
+  if (!*this) {
+    return Clock::duration::max();
+  }
+  return std::max(time_ - Clock::now(), Clock::duration::zero());
+}
+
+void RequestDeadline::attachTo(Payload& request) const {
+  const auto budget =
+      std::chrono::duration_cast<std::chrono::milliseconds>(remaining());
+  auto entry = folly::IOBuf::create(kBudgetSize);
+  folly::io::Appender appender(entry.get(), 0);
+  appender.writeBE<uint32_t>(static_cast<uint32_t>(std::min<int64_t>(
+      budget.count(), std::numeric_limits<uint32_t>::max())));
+  auto metadata = CompositeMetadataBuilder()
+                      .add(kDeadlineMimeType, std::move(entry))
+                      .build();
+  if (request.metadata) {
+    metadata->prependChain(std::move(request.metadata));
+  }
+  request.metadata = std::move(metadata);
+}
+
+RequestDeadline RequestDeadline::takeFrom(Payload& request) {
+  if (!request.metadata) {
+    return RequestDeadline();
+  }
+  CompositeMetadataReader reader(*request.metadata);
+  if (!reader.next() || !reader.mimeTypeIs(kDeadlineMimeType) ||
+      reader.length() != kBudgetSize) {
+    return RequestDeadline();
+  }
+  const auto budget =
+      std::chrono::milliseconds(reader.cursor().readBE<uint32_t>());
+
+  folly::IOBufQueue metadata;
+  metadata.append(std::move(request.metadata));
+  metadata.trimStart(kEntrySize);
+  // the request had no metadata of its own
+  request.metadata = metadata.empty() ? nullptr : metadata.move();
+  return RequestDeadline::in(budget);
+}
+}
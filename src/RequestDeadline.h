@@ -0,0 +1,79 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/Range.h>
+#include <chrono>
+
+namespace reactivesocket {
+
+struct Payload;
+
+/// Mime type of the composite metadata entry of a propagated RequestDeadline,
+/// the remaining budget in milliseconds as a big endian uint32.
+constexpr folly::StringPiece kDeadlineMimeType{"message/x.rsocket.deadline.v0"};
+
+/// Point in time a request has to be answered by.
+///
+/// When the deadline of a request passes, the requester cancels the stream,
+/// which sends CANCEL to the responder, and fails the subscriber with
+/// DeadlineExceededException. A default constructed deadline never passes.
+///
+/// The deadline can also be propagated to the responder, as the remaining
+/// budget in a composite metadata entry of kDeadlineMimeType put first in
+/// the metadata of the request, which are then expected to be composite
+/// metadata too (see CompositeMetadataReader). A responder which expects
+/// propagated deadlines takes them out of the request with ::takeFrom, and
+/// can use ::remaining to shed work which would not be done in time.
+class RequestDeadline {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// No deadline.
+  RequestDeadline() = default;
+
+  static RequestDeadline at(Clock::time_point time, bool propagate = false) {
+    return RequestDeadline(time, propagate);
+  }
+
+  static RequestDeadline in(Clock::duration timeout, bool propagate = false) {
+    return RequestDeadline(Clock::now() + timeout, propagate);
+  }
+
+  explicit operator bool() const {
+    return time_ != Clock::time_point::max();
+  }
+
+  Clock::time_point time() const {
+    return time_;
+  }
+
+  /// Zero once the deadline has passed, Clock::duration::max() for no
+  /// deadline.
+  Clock::duration remaining() const;
+
+  bool expired() const {
+    return remaining() == Clock::duration::zero();
+  }
+
+  bool propagate() const {
+    return propagate_;
+  }
+
+  /// Puts the remaining budget first in the metadata of the request.
+  void attachTo(Payload& request) const;
+
+  /// Strips the budget attached by the requester off the metadata of the
+  /// request and returns the deadline it makes on this host. Returns no
+  /// deadline, and leaves the metadata as they are, when their first entry
+  /// is not a well formed budget.
+  static RequestDeadline takeFrom(Payload& request);
+
+ private:
+  RequestDeadline(Clock::time_point time, bool propagate)
+      : time_(time), propagate_(propagate) {}
+
+  Clock::time_point time_{Clock::time_point::max()};
+  bool propagate_{false};
+};
+}
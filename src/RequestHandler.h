@@ -7,6 +7,7 @@
 #include "src/Payload.h"
 #include "yarpl/flowable/Subscriber.h"
 #include "yarpl/flowable/Subscription.h"
+#include "yarpl/single/SingleObserver.h"
 
 namespace reactivesocket {
 
@@ -33,7 +34,8 @@ class RequestHandler {
   virtual void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) noexcept = 0;
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          response) noexcept = 0;
 
   /// Handles a new fire-and-forget request sent by the other end.
   virtual void handleFireAndForgetRequest(
@@ -7,6 +7,7 @@
 #include "src/ConnectionAutomaton.h"
 #include "src/Frame.h"
 #include "src/FrameTransport.h"
+#include "src/Logging.h"
 
 namespace {
 
@@ -48,7 +49,7 @@ void ResumeCache::trackReceivedFrame(
     const folly::IOBuf& serializedFrame,
     const FrameType frameType) {
   if (shouldTrackFrame(frameType)) {
-    VLOG(6) << "received frame " << frameType;
+    RSOCKET_VLOG(6) << "received frame " << frameType;
     // TODO(tmont): this could be expensive, find a better way to get length
     impliedPosition_ += serializedFrame.computeChainDataLength();
   }
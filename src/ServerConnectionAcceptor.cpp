@@ -7,6 +7,7 @@
 #include "src/FrameProcessor.h"
 #include "src/FrameSerializer.h"
 #include "src/FrameTransport.h"
+#include "src/Logging.h"
 #include "src/Stats.h"
 
 #include <iostream>
@@ -192,7 +193,8 @@ ServerConnectionAcceptor::getOrAutodetectFrameSerializer(
     return nullptr;
   }
 
-  VLOG(2) << "detected protocol version" << serializer->protocolVersion();
+  RSOCKET_VLOG(2) << "detected protocol version"
+                  << serializer->protocolVersion();
   return std::move(serializer);
 }
 
@@ -3,12 +3,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
 #include <string>
 #include "src/Common.h"
 
 namespace reactivesocket {
 
 class DuplexConnection;
+struct TaskProfile;
 
 class Stats {
  public:
@@ -35,5 +37,72 @@ class Stats {
   virtual void streamBufferChanged(
       int64_t framesCountDelta,
       int64_t dataSizeDelta) = 0;
+
+  /// @{
+  /// Latency of requests issued by the socket.
+  ///
+  /// Every hook receives the time the request was issued at together with the
+  /// time of the reported event, so that an implementation can record the
+  /// latency without keeping any per-stream state.  None of the hooks below
+  /// is called, and no clock is read, unless latencyTrackingEnabled() returns
+  /// true at the time the socket (or the request) is created.
+  using Clock = std::chrono::steady_clock;
+
+  virtual bool latencyTrackingEnabled() const {
+    return false;
+  }
+
+  /// A requester stream automaton (or a fire-and-forget frame) was created.
+  virtual void requestIssued(StreamType, Clock::time_point /* issued */) {}
+  /// The first frame of a request was handed to the connection.
+  virtual void requestWritten(
+      StreamType,
+      Clock::time_point /* issued */,
+      Clock::time_point /* written */) {}
+  /// The first response frame of a request was read off the connection.
+  virtual void responseRead(
+      StreamType,
+      Clock::time_point /* issued */,
+      Clock::time_point /* read */) {}
+  /// The first response of a request was delivered to the subscriber.
+  virtual void responseDelivered(
+      StreamType,
+      Clock::time_point /* issued */,
+      Clock::time_point /* delivered */) {}
+  /// A task spent the given time queued in ExecutorBase::runInExecutor.
+  virtual void executorQueueingDelay(Clock::duration) {}
+  /// @}
+
+  /// @{
+  /// Credit starvation of streams, i.e. periods during which a publisher
+  /// could not send for lack of REQUEST_N credit.  A period is reported when
+  /// it ends, and only one in creditStarvationSampling() periods is reported
+  /// at all; none when it returns 0.
+  virtual uint32_t creditStarvationSampling() const {
+    return 0;
+  }
+  virtual void creditStarvation(
+      FlowControlDirection,
+      Clock::duration /* starved */) {}
+  /// @}
+
+  /// @{
+  /// Profiling of the tasks scheduled by ExecutorBase::runInExecutor, see
+  /// TaskProfiler. One in taskProfilingSampling() tasks is timed and reported
+  /// once it has run, none when it returns 0.
+  virtual uint32_t taskProfilingSampling() const {
+    return 0;
+  }
+  virtual void taskProfiled(const TaskProfile&) {}
+  /// @}
+
+  /// @{
+  /// Memory buffered by connections with MemoryLimits, see MemoryAccountant.
+  virtual void bufferedBytesChanged(MemoryBuffer, int64_t /* delta */) {}
+  /// A connection stopped reading, having reached its cap, or resumed.
+  virtual void readsPaused(bool /* paused */) {}
+  /// A stream was terminated for exceeding its cap.
+  virtual void streamMemoryCapExceeded() {}
+  /// @}
 };
 }
@@ -2,6 +2,7 @@
 
 #include "src/StreamState.h"
 
+#include "src/MemoryAccountant.h"
 #include "src/Stats.h"
 
 namespace reactivesocket {
@@ -12,12 +13,28 @@ StreamState::~StreamState() {
   onClearFrames();
 }
 
-void StreamState::enqueueOutputPendingFrame(
-    std::unique_ptr<folly::IOBuf> frame) {
+uint64_t StreamState::enqueueOutputPendingFrame(
+    std::unique_ptr<folly::IOBuf> frame,
+    StreamId streamId) {
   auto length = frame->computeChainDataLength();
   stats_.streamBufferChanged(1, static_cast<int64_t>(length));
+  if (memoryAccountant_) {
+    memoryAccountant_->charge(MemoryBuffer::STREAM_OUTPUT, length);
+  }
   dataLength_ += length;
   outputFrames_.push_back(std::move(frame));
+  return streamId != 0 ? dataLengthByStream_[streamId] += length : 0;
+}
+
+void StreamState::setMemoryAccountant(
+    std::shared_ptr<MemoryAccountant> memoryAccountant) {
+  if (memoryAccountant_) {
+    memoryAccountant_->release(MemoryBuffer::STREAM_OUTPUT, dataLength_);
+  }
+  memoryAccountant_ = std::move(memoryAccountant);
+  if (memoryAccountant_) {
+    memoryAccountant_->charge(MemoryBuffer::STREAM_OUTPUT, dataLength_);
+  }
 }
 
 std::deque<std::unique_ptr<folly::IOBuf>>
@@ -31,7 +48,11 @@ void StreamState::onClearFrames() {
   if (numFrames != 0) {
     stats_.streamBufferChanged(
         -static_cast<int64_t>(numFrames), -static_cast<int64_t>(dataLength_));
+    if (memoryAccountant_) {
+      memoryAccountant_->release(MemoryBuffer::STREAM_OUTPUT, dataLength_);
+    }
     dataLength_ = 0;
+    dataLengthByStream_.clear();
   }
 }
 }
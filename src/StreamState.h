@@ -12,6 +12,7 @@
 namespace reactivesocket {
 
 class ConnectionAutomaton;
+class MemoryAccountant;
 class Stats;
 class StreamAutomatonBase;
 using StreamId = uint32_t;
@@ -21,10 +22,24 @@ class StreamState {
   explicit StreamState(Stats& stats);
   ~StreamState();
 
-  void enqueueOutputPendingFrame(std::unique_ptr<folly::IOBuf> frame);
+  /// Returns the total data length of the queued frames of the stream the
+  /// frame belongs to, 0 for frames of the connection (stream 0).
+  uint64_t enqueueOutputPendingFrame(
+      std::unique_ptr<folly::IOBuf> frame,
+      StreamId streamId = 0);
 
   std::deque<std::unique_ptr<folly::IOBuf>> moveOutputPendingFrames();
 
+  size_t outputPendingFrames() const {
+    return outputFrames_.size();
+  }
+
+  uint64_t outputPendingBytes() const {
+    return dataLength_;
+  }
+
+  void setMemoryAccountant(std::shared_ptr<MemoryAccountant> memoryAccountant);
+
   std::unordered_map<StreamId, yarpl::Reference<StreamAutomatonBase>> streams_;
 
  private:
@@ -32,9 +47,12 @@ class StreamState {
   void onClearFrames();
 
   Stats& stats_;
+  std::shared_ptr<MemoryAccountant> memoryAccountant_;
 
   /// Total data length of all IOBufs in outputFrames_.
   uint64_t dataLength_{0};
+  /// The same, by stream.
+  std::unordered_map<StreamId, uint64_t> dataLengthByStream_;
 
   std::deque<std::unique_ptr<folly::IOBuf>> outputFrames_;
 };
@@ -25,32 +25,44 @@ StreamsFactory::StreamsFactory(
                     even-numbered stream identifiers*/) {}
 
 Reference<yarpl::flowable::Subscriber<Payload>> StreamsFactory::createChannelRequester(
-    Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+    const RequestDeadline& deadline) {
   ChannelRequester::Parameters params(connection_.shared_from_this(), getNextStreamId());
-  auto automaton = yarpl::make_ref<ChannelRequester>(params);
+  auto automaton = yarpl::make_ref<ChannelRequester>(params, deadline);
   connection_.addStream(params.streamId, automaton);
   automaton->subscribe(std::move(responseSink));
+  connection_.setStreamDeadline(params.streamId, deadline);
   return automaton;
 }
 
 void StreamsFactory::createStreamRequester(
     Payload request,
-    Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+    const RequestDeadline& deadline) {
+  if (deadline.propagate()) {
+    deadline.attachTo(request);
+  }
   StreamRequester::Parameters params(connection_.shared_from_this(), getNextStreamId());
   auto automaton =
       yarpl::make_ref<StreamRequester>(params, std::move(request));
   connection_.addStream(params.streamId, automaton);
   automaton->subscribe(std::move(responseSink));
+  connection_.setStreamDeadline(params.streamId, deadline);
 }
 
 void StreamsFactory::createRequestResponseRequester(
     Payload payload,
-    Reference<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    Reference<yarpl::single::SingleObserver<Payload>> responseSink,
+    const RequestDeadline& deadline) {
+  if (deadline.propagate()) {
+    deadline.attachTo(payload);
+  }
   RequestResponseRequester::Parameters params(connection_.shared_from_this(), getNextStreamId());
   auto automaton =
       yarpl::make_ref<RequestResponseRequester>(params, std::move(payload));
   connection_.addStream(params.streamId, automaton);
   automaton->subscribe(std::move(responseSink));
+  connection_.setStreamDeadline(params.streamId, deadline);
 }
 
 StreamId StreamsFactory::getNextStreamId() {
@@ -95,7 +107,7 @@ Reference<yarpl::flowable::Subscriber<Payload>> StreamsFactory::createStreamResp
   return automaton;
 }
 
-Reference<yarpl::flowable::Subscriber<Payload>>
+Reference<yarpl::single::SingleObserver<Payload>>
 StreamsFactory::createRequestResponseResponder(
     StreamId streamId) {
   RequestResponseResponder::Parameters params(connection_.shared_from_this(), streamId);
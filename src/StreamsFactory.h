@@ -3,8 +3,10 @@
 #pragma once
 
 #include "src/Common.h"
+#include "src/RequestDeadline.h"
 #include "yarpl/flowable/Subscriber.h"
 #include "yarpl/flowable/Subscription.h"
+#include "yarpl/single/SingleObserver.h"
 
 namespace folly {
 class Executor;
@@ -21,15 +23,18 @@ class StreamsFactory {
   StreamsFactory(ConnectionAutomaton& connection, ReactiveSocketMode mode);
 
   yarpl::Reference<yarpl::flowable::Subscriber<Payload>> createChannelRequester(
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
   void createStreamRequester(
       Payload request,
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
   void createRequestResponseRequester(
       Payload payload,
-      yarpl::Reference<yarpl::flowable::Subscriber<Payload>> responseSink);
+      yarpl::Reference<yarpl::single::SingleObserver<Payload>> responseSink,
+      const RequestDeadline& deadline = RequestDeadline());
 
   // TODO: the return type should not be the automaton type, but something
   // generic
@@ -41,8 +46,8 @@ class StreamsFactory {
       uint32_t initialRequestN,
       StreamId streamId);
 
-  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> createRequestResponseResponder(
-      StreamId streamId);
+  yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+  createRequestResponseResponder(StreamId streamId);
 
   bool registerNewPeerStreamId(StreamId streamId);
   StreamId getNextStreamId();
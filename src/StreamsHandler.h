@@ -8,6 +8,7 @@
 namespace reactivesocket {
 
 class FrameSerializer;
+class Stats;
 
 ///
 /// StreamsWriter is the interface for writing stream related frames
@@ -37,5 +38,8 @@ class StreamsWriter {
   virtual void onStreamClosed(
       StreamId streamId,
       StreamCompletionSignal signal) = 0;
+
+  /// Stats of the connection, the streams are written to.
+  virtual Stats& stats() = 0;
 };
 }
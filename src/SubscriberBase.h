@@ -52,21 +52,25 @@ class SubscriberBaseT : public Subscriber<T>,
 
     void request(size_t n) noexcept override final {
       if (auto parent = parentSubscriber_.lock()) {
-        parent->runInExecutor([parent, n]() {
-          if (!parent->cancelled_) {
-            parent->originalSubscription_->request(n);
-          }
-        });
+        parent->runInExecutor(
+            [parent, n]() {
+              if (!parent->cancelled_) {
+                parent->originalSubscription_->request(n);
+              }
+            },
+            "SubscriberBase::request");
       }
     }
 
     void cancel() noexcept override final {
       if (auto parent = parentSubscriber_.lock()) {
         if (!parent->cancelled_.exchange(true)) {
-          parent->runInExecutor([parent]() {
-            parent->originalSubscription_->cancel();
-            parent->originalSubscription_ = nullptr;
-          });
+          parent->runInExecutor(
+              [parent]() {
+                parent->originalSubscription_->cancel();
+                parent->originalSubscription_ = nullptr;
+              },
+              "SubscriberBase::cancel");
         }
       }
     }
@@ -108,7 +112,7 @@ class SubscriberBaseT : public Subscriber<T>,
         thisPtr->onSubscribeImpl(std::make_shared<SubscriptionShimImpl>(
             thisPtr->shared_from_this()));
       }
-    });
+    }, "SubscriberBase::onSubscribe");
   }
 
   void onNext(T payload) noexcept override final {
@@ -118,7 +122,7 @@ class SubscriberBaseT : public Subscriber<T>,
       if (!thisPtr->cancelled_) {
         thisPtr->onNextImpl(movedPayload.move());
       }
-    });
+    }, "SubscriberBase::onNext");
   }
 
   void onComplete() noexcept override final {
@@ -131,7 +135,7 @@ class SubscriberBaseT : public Subscriber<T>,
         thisPtr->originalSubscription_->cancel();
         thisPtr->originalSubscription_ = nullptr;
       }
-    });
+    }, "SubscriberBase::onComplete");
   }
 
   void onError(folly::exception_wrapper ex) noexcept override final {
@@ -145,7 +149,7 @@ class SubscriberBaseT : public Subscriber<T>,
         thisPtr->originalSubscription_->cancel();
         thisPtr->originalSubscription_ = nullptr;
       }
-    });
+    }, "SubscriberBase::onError");
   }
 
  protected:
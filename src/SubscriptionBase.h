@@ -25,14 +25,14 @@ class SubscriptionBase : public Subscription,
     auto thisPtr = this->shared_from_this();
     runInExecutor([thisPtr, n]() {
       thisPtr->requestImpl(n);
-    });
+    }, "SubscriptionBase::request");
   }
 
   void cancel() noexcept override final {
     auto thisPtr = this->shared_from_this();
     runInExecutor([thisPtr]() {
       thisPtr->cancelImpl();
-    });
+    }, "SubscriptionBase::cancel");
   }
 };
 
@@ -0,0 +1,92 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/TaskProfiler.h"
+#include <folly/Conv.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+#include <map>
+#include <ostream>
+
+namespace reactivesocket {
+
+namespace {
+thread_local TaskProfile* currentTask{nullptr};
+
+int64_t micros(TaskProfile::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+}
+
+void TaskProfile::tagCurrent(StreamId streamId, FrameType frameType) {
+  if (auto task = currentTask) {
+    task->streamId = streamId;
+    task->frameType = frameType;
+  }
+}
+
+TaskProfile::Scope::Scope(TaskProfile& profile) : previous_(currentTask) {
+  currentTask = &profile;
+}
+
+TaskProfile::Scope::~Scope() {
+  currentTask = previous_;
+}
+
+TaskProfiler::TaskProfiler(uint32_t sampling, size_t capacity)
+    : sampling_(sampling), capacity_(capacity) {
+  CHECK_GT(capacity_, 0);
+}
+
+void TaskProfiler::taskProfiled(const TaskProfile& profile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tasks_.size() < capacity_) {
+    tasks_.push_back(profile);
+    return;
+  }
+  tasks_[next_] = profile;
+  next_ = (next_ + 1) % capacity_;
+}
+
+std::vector<TaskProfile> TaskProfiler::tasks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<TaskProfile> tasks;
+  tasks.reserve(tasks_.size());
+  tasks.insert(tasks.end(), tasks_.begin() + next_, tasks_.end());
+  tasks.insert(tasks.end(), tasks_.begin(), tasks_.begin() + next_);
+  return tasks;
+}
+
+void TaskProfiler::writeChromeTrace(std::ostream& os) const {
+  auto events = folly::dynamic::array();
+  for (const auto& task : tasks()) {
+    auto args = folly::dynamic::object("queue_us", micros(task.queueDelay()));
+    if (task.streamId != 0) {
+      args["stream"] = task.streamId;
+      args["frame"] = to_string(task.frameType);
+    }
+    events.push_back(folly::dynamic::object("name", task.name)("cat", "rsocket")(
+        "ph", "X")("ts", micros(task.startedAt.time_since_epoch()))(
+        "dur", micros(task.runTime))("pid", 0)("tid", task.threadId)(
+        "args", std::move(args)));
+  }
+  os << folly::toJson(folly::dynamic::object("traceEvents", std::move(events))(
+            "displayTimeUnit", "ns"));
+}
+
+void TaskProfiler::writeFoldedStacks(std::ostream& os) const {
+  std::map<std::string, int64_t> stacks;
+  for (const auto& task : tasks()) {
+    auto stack = std::string(task.name);
+    if (task.streamId != 0) {
+      stack += ';' + to_string(task.frameType) + ";stream_" +
+          folly::to<std::string>(task.streamId);
+    }
+    stacks[stack] += micros(task.runTime);
+  }
+  for (const auto& stack : stacks) {
+    os << stack.first << ' ' << stack.second << '\n';
+  }
+}
+}
@@ -0,0 +1,96 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+#include "src/Stats.h"
+
+namespace reactivesocket {
+
+/// A task run through ExecutorBase::runInExecutor, see
+/// Stats::taskProfilingSampling.
+struct TaskProfile {
+  using Clock = Stats::Clock;
+
+  /// What the task does, a string literal given to runInExecutor.
+  const char* name{""};
+  /// The stream and the frame the task worked on, when it tagged itself with
+  /// TaskProfile::tagCurrent; stream 0 otherwise.
+  StreamId streamId{0};
+  FrameType frameType{};
+  Clock::time_point queuedAt;
+  Clock::time_point startedAt;
+  Clock::duration runTime{};
+  uint64_t threadId{0};
+
+  Clock::duration queueDelay() const {
+    return startedAt - queuedAt;
+  }
+
+  /// Attributes the task running on this thread, if it is being profiled, to
+  /// a stream. Cheap enough for the hot path: a thread local load when no
+  /// task is being profiled.
+  static void tagCurrent(StreamId streamId, FrameType frameType);
+
+  /// Makes the profile the one tagCurrent writes to, for its lifetime.
+  class Scope {
+   public:
+    explicit Scope(TaskProfile& profile);
+    ~Scope();
+
+   private:
+    TaskProfile* const previous_;
+  };
+};
+
+/// Stats keeping the last profiled tasks in a ring buffer, for exporting as
+/// a Chrome trace (chrome://tracing, Perfetto) or as folded stacks for
+/// flamegraph.pl.
+///
+/// Every sampling-th task is profiled. The counter hooks of Stats are no-ops.
+class TaskProfiler : public Stats {
+ public:
+  explicit TaskProfiler(uint32_t sampling = 1, size_t capacity = 1 << 16);
+
+  /// The profiled tasks, oldest first.
+  std::vector<TaskProfile> tasks() const;
+
+  /// Chrome trace event format: one complete event per task on the thread it
+  /// ran on, with the stream, the frame type and the queue delay as
+  /// arguments.
+  void writeChromeTrace(std::ostream& os) const;
+  /// "task;frame type;stream id run time in microseconds" lines, summed over
+  /// the identical stacks.
+  void writeFoldedStacks(std::ostream& os) const;
+
+  uint32_t taskProfilingSampling() const override {
+    return sampling_;
+  }
+  void taskProfiled(const TaskProfile& profile) override;
+
+  void socketCreated() override {}
+  void socketDisconnected() override {}
+  void socketClosed(StreamCompletionSignal) override {}
+  void duplexConnectionCreated(const std::string&, DuplexConnection*)
+      override {}
+  void duplexConnectionClosed(const std::string&, DuplexConnection*) override {
+  }
+  void bytesWritten(size_t) override {}
+  void bytesRead(size_t) override {}
+  void frameWritten(FrameType) override {}
+  void frameRead(FrameType) override {}
+  void resumeBufferChanged(int, int) override {}
+  void streamBufferChanged(int64_t, int64_t) override {}
+
+ private:
+  const uint32_t sampling_;
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::vector<TaskProfile> tasks_;
+  /// Where the next task goes once tasks_ is full.
+  size_t next_{0};
+};
+}
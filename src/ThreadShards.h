@@ -0,0 +1,62 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/ThreadLocal.h>
+#include <mutex>
+
+namespace reactivesocket {
+
+/// Per-thread shards of an accumulator, like the counters of CounterStats or
+/// the histograms of HistogramStats.
+///
+/// Every thread writes into its own Shard, taking no locks and contending
+/// with no other thread.  The shard of a thread which exits is folded into a
+/// retired one, so that its counts are kept.  Aggregating merges the retired
+/// shard and those of the live threads.
+///
+/// Shard must be default constructible and provide
+///   void mergeInto(Shard& other) const;
+/// which adds its counts to other, while the owning thread may be writing.
+template <typename Shard>
+class ThreadShards {
+ public:
+  ThreadShards() : shards_([this] { return new ThreadShard(this); }) {}
+
+  /// The shard of the calling thread.
+  Shard& local() {
+    return *shards_;
+  }
+
+  /// Adds the counts of all threads to total.
+  void aggregate(Shard& total) const {
+    // Holding the accessor keeps threads from exiting, which in turn makes
+    // sure no shard is counted both live and retired.
+    auto accessor = shards_.accessAllThreads();
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    retired_.mergeInto(total);
+    for (const auto& shard : accessor) {
+      shard.mergeInto(total);
+    }
+  }
+
+ private:
+  struct ThreadShard : Shard {
+    explicit ThreadShard(ThreadShards* parent) : parent_(parent) {}
+
+    /// Folds the counts into the retired shard, so they survive the thread.
+    ~ThreadShard() {
+      std::lock_guard<std::mutex> lock(parent_->retiredMutex_);
+      this->mergeInto(parent_->retired_);
+    }
+
+    ThreadShards* const parent_;
+  };
+  struct Tag {};
+
+  /// Counts of the exited threads, must be declared before shards_.
+  mutable std::mutex retiredMutex_;
+  Shard retired_;
+  mutable folly::ThreadLocal<ThreadShard, Tag> shards_;
+};
+}
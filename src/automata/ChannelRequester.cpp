@@ -24,6 +24,9 @@ void ChannelRequester::onNext(Payload request) noexcept {
   switch (state_) {
     case State::NEW: {
       state_ = State::REQUESTED;
+      if (deadline_.propagate()) {
+        deadline_.attachTo(request);
+      }
       // FIXME: find a root cause of this asymmetry; the problem here is that
       // the ConsumerBase::request might be delivered after the whole thing is
       // shut down, if one uses InlineConnection.
@@ -49,6 +52,8 @@ void ChannelRequester::onNext(Payload request) noexcept {
     case State::REQUESTED: {
       debugCheckOnNextOnError();
       writePayload(std::move(request), 0);
+      publisherPayloadSent();
+      creditChanged(FlowControlDirection::OUTBOUND, publisherStarved());
       break;
     }
     case State::CLOSED:
@@ -118,6 +123,15 @@ void ChannelRequester::cancel() noexcept {
   }
 }
 
+void ChannelRequester::failStream(folly::exception_wrapper ex) {
+  if (state_ == State::CLOSED) {
+    return;
+  }
+  ConsumerBase::onError(std::move(ex));
+  // ends the requests to the responder too, see endStream
+  cancel();
+}
+
 void ChannelRequester::endStream(StreamCompletionSignal signal) {
   switch (state_) {
     case State::NEW:
@@ -177,7 +191,15 @@ void ChannelRequester::handleError(folly::exception_wrapper errorPayload) {
 }
 
 void ChannelRequester::handleRequestN(uint32_t n) {
+  if (n) {
+    creditChanged(FlowControlDirection::OUTBOUND, false);
+  }
   PublisherBase::processRequestN(n);
 }
 
+void ChannelRequester::flowControl(StreamFlowControl& flowControl) const {
+  ConsumerBase::flowControl(flowControl);
+  flowControl.outboundCredit = publisherCredit();
+}
+
 } // reactivesocket
@@ -5,6 +5,7 @@
 #include <iosfwd>
 
 #include "src/Payload.h"
+#include "src/RequestDeadline.h"
 #include "src/SubscriberBase.h"
 #include "src/automata/ConsumerBase.h"
 #include "src/automata/PublisherBase.h"
@@ -21,8 +22,16 @@ class ChannelRequester : public ConsumerBase,
                          public PublisherBase,
                          public yarpl::flowable::Subscriber<Payload> {
  public:
-  explicit ChannelRequester(const ConsumerBase::Parameters& params)
-      : ConsumerBase(params), PublisherBase(0) {}
+  /// The deadline is attached to the first payload when it is propagated,
+  /// the connection enforces it.
+  explicit ChannelRequester(
+      const ConsumerBase::Parameters& params,
+      const RequestDeadline& deadline = RequestDeadline())
+      : ConsumerBase(params), PublisherBase(0), deadline_(deadline) {
+    requestIssued(StreamType::CHANNEL);
+  }
+
+  void failStream(folly::exception_wrapper ex) override;
 
  private:
   void onSubscribe(yarpl::Reference<yarpl::flowable::Subscription> subscription) noexcept override;
@@ -39,6 +48,7 @@ class ChannelRequester : public ConsumerBase,
   void handleError(folly::exception_wrapper errorPayload) override;
 
   void endStream(StreamCompletionSignal) override;
+  void flowControl(StreamFlowControl&) const override;
 
   /// State of the Channel requester.
   enum class State : uint8_t {
@@ -49,6 +59,7 @@ class ChannelRequester : public ConsumerBase,
   /// An allowance accumulated before the stream is initialised.
   /// Remaining part of the allowance is forwarded to the ConsumerBase.
   AllowanceSemaphore initialResponseAllowance_;
+  const RequestDeadline deadline_;
 };
 
 } // reactivesocket
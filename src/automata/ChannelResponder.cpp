@@ -22,6 +22,8 @@ void ChannelResponder::onNext(Payload response) noexcept {
   switch (state_) {
     case State::RESPONDING: {
       writePayload(std::move(response), false);
+      publisherPayloadSent();
+      creditChanged(FlowControlDirection::OUTBOUND, publisherStarved());
       break;
     }
     case State::CLOSED:
@@ -123,6 +125,9 @@ void ChannelResponder::onNextPayloadFrame(
       break;
   }
 
+  if (requestN) {
+    creditChanged(FlowControlDirection::OUTBOUND, false);
+  }
   processRequestN(requestN);
   processPayload(std::move(payload), next);
 
@@ -143,6 +148,14 @@ void ChannelResponder::handleCancel() {
 }
 
 void ChannelResponder::handleRequestN(uint32_t n) {
+  if (n) {
+    creditChanged(FlowControlDirection::OUTBOUND, false);
+  }
   PublisherBase::processRequestN(n);
 }
+
+void ChannelResponder::flowControl(StreamFlowControl& flowControl) const {
+  ConsumerBase::flowControl(flowControl);
+  flowControl.outboundCredit = publisherCredit();
+}
 }
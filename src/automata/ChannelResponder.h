@@ -45,6 +45,7 @@ class ChannelResponder : public ConsumerBase,
       bool next);
 
   void endStream(StreamCompletionSignal) override;
+  void flowControl(StreamFlowControl&) const override;
 
   /// State of the Channel responder.
   enum class State : uint8_t {
@@ -26,9 +26,16 @@ void ConsumerBase::subscribe(Reference<yarpl::flowable::Subscriber<Payload>> sub
 void ConsumerBase::generateRequest(size_t n) {
   allowance_.release(n);
   pendingAllowance_.release(n);
+  creditChanged(FlowControlDirection::INBOUND, !allowance_);
   sendRequests();
 }
 
+void ConsumerBase::flowControl(StreamFlowControl& flowControl) const {
+  Base::flowControl(flowControl);
+  flowControl.inboundCredit = allowance_.value();
+  flowControl.inboundCreditUnsent = pendingAllowance_.value();
+}
+
 void ConsumerBase::endStream(StreamCompletionSignal signal) {
   if (auto subscriber = std::move(consumingSubscriber_)) {
     if (signal == StreamCompletionSignal::COMPLETE ||
@@ -42,6 +49,16 @@ void ConsumerBase::endStream(StreamCompletionSignal signal) {
   Base::endStream(signal);
 }
 
+void ConsumerBase::connectFailed(folly::exception_wrapper ex) {
+  onError(std::move(ex));
+}
+
+void ConsumerBase::failStream(folly::exception_wrapper ex) {
+  auto message = ex.what().toStdString();
+  onError(std::move(ex));
+  errorStream(std::move(message));
+}
+
 void ConsumerBase::pauseStream(RequestHandler& requestHandler) {
   if (consumingSubscriber_) {
     requestHandler.onSubscriberPaused(consumingSubscriber_);
@@ -55,12 +72,17 @@ void ConsumerBase::resumeStream(RequestHandler& requestHandler) {
 }
 
 void ConsumerBase::processPayload(Payload&& payload, bool onNext) {
+  responseRead();
   if (payload || onNext) {
     // Frames carry application-level payloads are taken into account when
     // figuring out flow control allowance.
     if (allowance_.tryAcquire()) {
       sendRequests();
+      responseDelivered();
       consumingSubscriber_->onNext(std::move(payload));
+      // Checked after onNext, which is where subscribers tend to request
+      // more.
+      creditChanged(FlowControlDirection::INBOUND, !allowance_);
     } else {
       handleFlowControlError();
       return;
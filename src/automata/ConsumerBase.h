@@ -30,6 +30,7 @@ class ConsumerBase : public StreamAutomatonBase, public yarpl::flowable::Subscri
   /// count towards the limit of allowance the remote PublisherBase may use.
   void addImplicitAllowance(size_t n) {
     allowance_.release(n);
+    creditChanged(FlowControlDirection::INBOUND, !allowance_);
   }
 
   /// @{
@@ -38,10 +39,16 @@ class ConsumerBase : public StreamAutomatonBase, public yarpl::flowable::Subscri
   void generateRequest(size_t n);
   /// @}
 
+  void flowControl(StreamFlowControl& flowControl) const override;
+
  protected:
   /// @{
   void endStream(StreamCompletionSignal signal) override;
 
+  void connectFailed(folly::exception_wrapper ex) override;
+
+  void failStream(folly::exception_wrapper ex) override;
+
   void pauseStream(RequestHandler& requestHandler) override;
 
   void resumeStream(RequestHandler& requestHandler) override;
@@ -20,7 +20,7 @@ enum class StreamCompletionSignal;
 class PublisherBase {
  public:
   explicit PublisherBase(uint32_t initialRequestN)
-      : initialRequestN_(initialRequestN) {}
+      : initialRequestN_(initialRequestN), credit_(initialRequestN) {}
 
   /// @{
   void publisherSubscribe(yarpl::Reference<yarpl::flowable::Subscription> subscription) {
@@ -41,6 +41,7 @@ class PublisherBase {
     if (!requestN) {
       return;
     }
+    credit_.release(requestN);
 
     // we might not have the subscription set yet as there can be REQUEST_N
     // frames scheduled on the executor before onSubscribe method
@@ -60,6 +61,21 @@ class PublisherBase {
     DCHECK(producingSubscription_);
   }
 
+  /// @{
+  /// Credit granted by the remote end, less payloads sent.
+  void publisherPayloadSent() {
+    credit_.tryAcquire();
+  }
+
+  bool publisherStarved() const {
+    return !credit_;
+  }
+
+  size_t publisherCredit() const {
+    return credit_.value();
+  }
+  /// @}
+
   /// @{
   void terminatePublisher(StreamCompletionSignal signal) {
     if (auto subscription = std::move(producingSubscription_)) {
@@ -81,5 +97,6 @@ class PublisherBase {
   /// Subscription once the stream ends.
   yarpl::Reference<yarpl::flowable::Subscription> producingSubscription_;
   AllowanceSemaphore initialRequestN_;
+  AllowanceSemaphore credit_;
 };
 }
@@ -2,7 +2,6 @@
 
 #include "src/automata/RequestResponseRequester.h"
 #include <folly/ExceptionWrapper.h>
-#include <folly/MoveWrapper.h>
 #include "src/Common.h"
 #include "src/ConnectionAutomaton.h"
 #include "src/RequestHandler.h"
@@ -10,30 +9,18 @@
 namespace reactivesocket {
 
 using namespace yarpl;
-using namespace yarpl::flowable;
+using namespace yarpl::single;
 
 void RequestResponseRequester::subscribe(
-    yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber) {
+    Reference<SingleObserver<Payload>> subscriber) {
   DCHECK(!isTerminated());
   DCHECK(!consumingSubscriber_);
   consumingSubscriber_ = std::move(subscriber);
-  consumingSubscriber_->onSubscribe(Reference<Subscription>(this));
-}
-
-void RequestResponseRequester::request(int64_t n) noexcept {
-  if (n == 0) {
-    return;
-  }
+  consumingSubscriber_->onSubscribe(Reference<SingleSubscription>(this));
 
   if (state_ == State::NEW) {
     state_ = State::REQUESTED;
     newStream(StreamType::REQUEST_RESPONSE, 1, std::move(initialPayload_));
-  } else {
-    if (auto subscriber = std::move(consumingSubscriber_)) {
-      subscriber->onError(std::make_exception_ptr(
-          std::runtime_error("cannot request more than 1 item")));
-    }
-    closeStream(StreamCompletionSignal::ERROR);
   }
 }
 
@@ -52,6 +39,22 @@ void RequestResponseRequester::cancel() noexcept {
   }
 }
 
+void RequestResponseRequester::failStream(folly::exception_wrapper ex) {
+  if (state_ == State::CLOSED) {
+    return;
+  }
+  if (auto subscriber = std::move(consumingSubscriber_)) {
+    subscriber->onError(ex.to_exception_ptr());
+  }
+  cancel();
+}
+
+void RequestResponseRequester::connectFailed(folly::exception_wrapper ex) {
+  if (auto subscriber = std::move(consumingSubscriber_)) {
+    subscriber->onError(ex.to_exception_ptr());
+  }
+}
+
 void RequestResponseRequester::endStream(StreamCompletionSignal signal) {
   switch (state_) {
     case State::NEW:
@@ -65,14 +68,14 @@ void RequestResponseRequester::endStream(StreamCompletionSignal signal) {
       break;
   }
   if (auto subscriber = std::move(consumingSubscriber_)) {
-    if (signal == StreamCompletionSignal::COMPLETE ||
-        signal == StreamCompletionSignal::CANCEL) { // TODO: remove CANCEL
-      subscriber->onComplete();
-    } else {
-      subscriber->onError(std::make_exception_ptr(StreamInterruptedException(static_cast<int>(signal))));
+    // COMPLETE is preceded by onSuccess and CANCEL originates from the
+    // observer itself, neither needs a terminal signal.
+    if (signal != StreamCompletionSignal::COMPLETE &&
+        signal != StreamCompletionSignal::CANCEL) {
+      subscriber->onError(std::make_exception_ptr(
+          StreamInterruptedException(static_cast<int>(signal))));
     }
   }
-  Subscription::release();
 }
 
 void RequestResponseRequester::handleError(
@@ -94,9 +97,11 @@ void RequestResponseRequester::handleError(
   }
 }
 
-void RequestResponseRequester:: handlePayload(Payload&& payload,
-                                              bool complete,
-                                              bool flagsNext) {
+void RequestResponseRequester::handlePayload(
+    Payload&& payload,
+    bool complete,
+    bool flagsNext) {
+  responseRead();
   switch (state_) {
     case State::NEW:
       // Cannot receive a frame before sending the initial request.
@@ -112,24 +117,21 @@ void RequestResponseRequester:: handlePayload(Payload&& payload,
       break;
   }
 
-  if (payload || flagsNext) {
-    consumingSubscriber_->onNext(std::move(payload));
-  } else if (!complete) {
+  if (!payload && !flagsNext && !complete) {
     errorStream("payload, NEXT or COMPLETE flag expected");
     return;
   }
+  // A COMPLETE without NEXT is an empty response.
+  if (auto subscriber = std::move(consumingSubscriber_)) {
+    responseDelivered();
+    subscriber->onSuccess(std::move(payload));
+  }
   closeStream(StreamCompletionSignal::COMPLETE);
 }
 
-void RequestResponseRequester::pauseStream(RequestHandler& requestHandler) {
-  if (consumingSubscriber_) {
-    requestHandler.onSubscriberPaused(consumingSubscriber_);
-  }
+void RequestResponseRequester::pauseStream(RequestHandler&) {
+  // A single response has no demand to throttle.
 }
 
-void RequestResponseRequester::resumeStream(RequestHandler& requestHandler) {
-  if (consumingSubscriber_) {
-    requestHandler.onSubscriberResumed(consumingSubscriber_);
-  }
-}
+void RequestResponseRequester::resumeStream(RequestHandler&) {}
 }
@@ -5,30 +5,37 @@
 #include <iosfwd>
 #include "src/Payload.h"
 #include "src/automata/StreamAutomatonBase.h"
-#include "yarpl/flowable/Subscription.h"
-#include "yarpl/flowable/Subscriber.h"
+#include "yarpl/single/SingleObserver.h"
+#include "yarpl/single/SingleSubscription.h"
 
 namespace reactivesocket {
 
 /// Implementation of stream automaton that represents a RequestResponse
 /// requester
 class RequestResponseRequester : public StreamAutomatonBase,
-                                 public yarpl::flowable::Subscription {
+                                 public yarpl::single::SingleSubscription {
   using Base = StreamAutomatonBase;
 
  public:
   explicit RequestResponseRequester(const Parameters& params, Payload payload)
       : Base(params),
-        initialPayload_(std::move(payload)) {}
+        initialPayload_(std::move(payload)) {
+    requestIssued(StreamType::REQUEST_RESPONSE);
+  }
 
-  void subscribe(yarpl::Reference<yarpl::flowable::Subscriber<Payload>> subscriber);
+  /// Delivers onSubscribe to the observer and, unless the observer cancelled
+  /// synchronously, sends the REQUEST_RESPONSE frame right away. A Single has
+  /// no demand signalling, so there is no request(1) round trip.
+  void subscribe(
+      yarpl::Reference<yarpl::single::SingleObserver<Payload>> subscriber);
 
  private:
-  void request(int64_t) noexcept override;
   void cancel() noexcept override;
 
   void handlePayload(Payload&& payload, bool complete, bool flagsNext) override;
   void handleError(folly::exception_wrapper errorPayload) override;
+  void failStream(folly::exception_wrapper ex) override;
+  void connectFailed(folly::exception_wrapper ex) override;
 
   void endStream(StreamCompletionSignal signal) override;
 
@@ -42,12 +49,12 @@ class RequestResponseRequester : public StreamAutomatonBase,
     CLOSED,
   } state_{State::NEW};
 
-  /// A Subscriber that will consume payloads.
+  /// An observer that will consume the response.
   /// This is responsible for delivering a terminal signal to the
-  /// Subscriber once the stream ends.
-  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> consumingSubscriber_;
+  /// observer once the stream ends.
+  yarpl::Reference<yarpl::single::SingleObserver<Payload>> consumingSubscriber_;
 
-  /// Initial payload which has to be sent with 1st request.
+  /// Initial payload which has to be sent with the request.
   Payload initialPayload_;
 };
 }
@@ -6,22 +6,23 @@
 namespace reactivesocket {
 
 using namespace yarpl;
-using namespace yarpl::flowable;
+using namespace yarpl::single;
 
 void RequestResponseResponder::onSubscribe(
-    Reference<yarpl::flowable::Subscription> subscription) noexcept {
+    Reference<SingleSubscription> subscription) noexcept {
   if (StreamAutomatonBase::isTerminated()) {
     subscription->cancel();
     return;
   }
-  publisherSubscribe(std::move(subscription));
+  DCHECK(!producingSubscription_);
+  producingSubscription_ = std::move(subscription);
 }
 
-void RequestResponseResponder::onNext(Payload response) noexcept {
-  debugCheckOnNextOnError();
+void RequestResponseResponder::onSuccess(Payload response) noexcept {
   switch (state_) {
     case State::RESPONDING: {
       state_ = State::CLOSED;
+      producingSubscription_ = nullptr;
       writePayload(std::move(response), true);
       closeStream(StreamCompletionSignal::COMPLETE);
       break;
@@ -31,23 +32,11 @@ void RequestResponseResponder::onNext(Payload response) noexcept {
   }
 }
 
-void RequestResponseResponder::onComplete() noexcept {
-  switch (state_) {
-    case State::RESPONDING: {
-      state_ = State::CLOSED;
-      completeStream();
-    } break;
-    case State::CLOSED:
-      break;
-  }
-}
-
-void RequestResponseResponder::onError(
-    const std::exception_ptr ex) noexcept {
-  debugCheckOnNextOnError();
+void RequestResponseResponder::onError(const std::exception_ptr ex) noexcept {
   switch (state_) {
     case State::RESPONDING: {
       state_ = State::CLOSED;
+      producingSubscription_ = nullptr;
       applicationError(folly::exceptionStr(ex).toStdString());
     } break;
     case State::CLOSED:
@@ -55,13 +44,11 @@ void RequestResponseResponder::onError(
   }
 }
 
-void RequestResponseResponder::pauseStream(RequestHandler& requestHandler) {
-  pausePublisherStream(requestHandler);
+void RequestResponseResponder::pauseStream(RequestHandler&) {
+  // A single response has no demand to throttle.
 }
 
-void RequestResponseResponder::resumeStream(RequestHandler& requestHandler) {
-  resumePublisherStream(requestHandler);
-}
+void RequestResponseResponder::resumeStream(RequestHandler&) {}
 
 void RequestResponseResponder::endStream(StreamCompletionSignal signal) {
   switch (state_) {
@@ -74,7 +61,9 @@ void RequestResponseResponder::endStream(StreamCompletionSignal signal) {
     case State::CLOSED:
       break;
   }
-  terminatePublisher(signal);
+  if (auto subscription = std::move(producingSubscription_)) {
+    subscription->cancel();
+  }
   StreamAutomatonBase::endStream(signal);
 }
 
@@ -89,8 +78,4 @@ void RequestResponseResponder::handleCancel() {
   }
 }
 
-void RequestResponseResponder::handleRequestN(uint32_t n) {
-  PublisherBase::processRequestN(n);
-}
-
 } // reactivesocket
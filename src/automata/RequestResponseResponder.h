@@ -2,30 +2,28 @@
 
 #pragma once
 
-#include "src/automata/PublisherBase.h"
 #include "src/automata/StreamAutomatonBase.h"
-#include "yarpl/flowable/Subscriber.h"
+#include "yarpl/single/SingleObserver.h"
+#include "yarpl/single/SingleSubscription.h"
 
 namespace reactivesocket {
 
 /// Implementation of stream automaton that represents a RequestResponse
 /// responder
-class RequestResponseResponder : public StreamAutomatonBase,
-                                 public PublisherBase,
-                                 public yarpl::flowable::Subscriber<Payload> {
+class RequestResponseResponder
+    : public StreamAutomatonBase,
+      public yarpl::single::SingleObserver<Payload> {
  public:
   explicit RequestResponseResponder(const Parameters& params)
-      : StreamAutomatonBase(params),
-        PublisherBase(1) {}
+      : StreamAutomatonBase(params) {}
 
  private:
-  void onSubscribe(yarpl::Reference<yarpl::flowable::Subscription> subscription) noexcept override;
-  void onNext(Payload) noexcept override;
-  void onComplete() noexcept override;
+  void onSubscribe(yarpl::Reference<yarpl::single::SingleSubscription>
+                       subscription) noexcept override;
+  void onSuccess(Payload) noexcept override;
   void onError(const std::exception_ptr) noexcept override;
 
   void handleCancel() override;
-  void handleRequestN(uint32_t n) override;
 
   void pauseStream(RequestHandler&) override;
   void resumeStream(RequestHandler&) override;
@@ -36,6 +34,10 @@ class RequestResponseResponder : public StreamAutomatonBase,
     RESPONDING,
     CLOSED,
   } state_{State::RESPONDING};
+
+  /// Cancels production of the response if the stream ends before the
+  /// response is delivered.
+  yarpl::Reference<yarpl::single::SingleSubscription> producingSubscription_;
 };
 
 } // reactivesocket
@@ -3,6 +3,7 @@
 #include "src/automata/StreamAutomatonBase.h"
 #include <folly/io/IOBuf.h>
 #include "src/ConnectionAutomaton.h"
+#include "src/Logging.h"
 #include "src/StreamsHandler.h"
 
 namespace reactivesocket {
@@ -10,25 +11,71 @@ namespace reactivesocket {
 void StreamAutomatonBase::handlePayload(Payload&& payload,
                                         bool complete,
                                         bool flagsNext) {
-  VLOG(4) << "Unexpected handlePayload";
+  RSOCKET_VLOG(4) << "Unexpected handlePayload";
 }
 
 void StreamAutomatonBase::handleRequestN(uint32_t n) {
-  VLOG(4) << "Unexpected handleRequestN";
+  RSOCKET_VLOG(4) << "Unexpected handleRequestN";
 }
 
 void StreamAutomatonBase::handleError(folly::exception_wrapper errorPayload) {
-  VLOG(4) << "Unexpected handleError";
+  RSOCKET_VLOG(4) << "Unexpected handleError";
 }
 
 void StreamAutomatonBase::handleCancel() {
-  VLOG(4) << "Unexpected handleCancel";
+  RSOCKET_VLOG(4) << "Unexpected handleCancel";
 }
 
+void StreamAutomatonBase::failStream(folly::exception_wrapper ex) {
+  errorStream(ex.what().toStdString());
+}
+
+void StreamAutomatonBase::connectFailed(folly::exception_wrapper) {}
+
 void StreamAutomatonBase::endStream(StreamCompletionSignal) {
   isTerminated_ = true;
 }
 
+void StreamAutomatonBase::flowControl(StreamFlowControl& flowControl) const {
+  const auto now = Stats::Clock::now();
+  auto starved = [&](FlowControlDirection direction) {
+    auto& starvation = starvation_[static_cast<size_t>(direction)];
+    auto total = starvation.total;
+    if (starvation.since != Stats::Clock::time_point()) {
+      total += now - starvation.since;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(total);
+  };
+  flowControl.streamId = streamId_;
+  flowControl.inboundStarved = starved(FlowControlDirection::INBOUND);
+  flowControl.outboundStarved = starved(FlowControlDirection::OUTBOUND);
+}
+
+void StreamAutomatonBase::creditStarvationChanged(
+    FlowControlDirection direction,
+    bool starved) {
+  auto& starvation = starvation_[static_cast<size_t>(direction)];
+  const auto now = Stats::Clock::now();
+  if (starved) {
+    starvation.since = now;
+    return;
+  }
+
+  const auto period = now - starvation.since;
+  starvation.since = Stats::Clock::time_point();
+  starvation.total += period;
+
+  auto& stats = writer_->stats();
+  if (auto sampling = stats.creditStarvationSampling()) {
+    // All streams of a connection run on the same thread, a thread local
+    // counter samples across them without synchronisation.
+    static thread_local uint32_t periods{0};
+    if (++periods % sampling == 0) {
+      stats.creditStarvation(direction, period);
+    }
+  }
+}
+
 void StreamAutomatonBase::newStream(
     StreamType streamType,
     uint32_t initialRequestN,
@@ -36,6 +83,36 @@ void StreamAutomatonBase::newStream(
     bool completed) {
   writer_->writeNewStream(
       streamId_, streamType, initialRequestN, std::move(payload), completed);
+  if (issuedAt_ != Stats::Clock::time_point() && !requestWritten_) {
+    requestWritten_ = true;
+    writer_->stats().requestWritten(
+        issuedType_, issuedAt_, Stats::Clock::now());
+  }
+}
+
+void StreamAutomatonBase::requestIssued(StreamType streamType) {
+  auto& stats = writer_->stats();
+  if (stats.latencyTrackingEnabled()) {
+    issuedType_ = streamType;
+    issuedAt_ = Stats::Clock::now();
+    stats.requestIssued(streamType, issuedAt_);
+  }
+}
+
+void StreamAutomatonBase::responseRead() {
+  if (issuedAt_ != Stats::Clock::time_point() && !responseRead_) {
+    responseRead_ = true;
+    writer_->stats().responseRead(issuedType_, issuedAt_, Stats::Clock::now());
+  }
+}
+
+void StreamAutomatonBase::responseDelivered() {
+  if (issuedAt_ != Stats::Clock::time_point()) {
+    writer_->stats().responseDelivered(
+        issuedType_, issuedAt_, Stats::Clock::now());
+    // Only the first response is of interest.
+    issuedAt_ = Stats::Clock::time_point();
+  }
 }
 
 void StreamAutomatonBase::writePayload(Payload&& payload, bool complete) {
@@ -2,10 +2,13 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <iosfwd>
 #include <memory>
 #include "src/Common.h"
+#include "src/FlowControlSnapshot.h"
+#include "src/Stats.h"
 #include <folly/ExceptionWrapper.h>
 #include <experimental/yarpl/include/yarpl/Refcounted.h>
 
@@ -47,6 +50,16 @@ class StreamAutomatonBase : public virtual yarpl::Refcounted {
   virtual void handleError(folly::exception_wrapper errorPayload);
   virtual void handleCancel();
 
+  /// Fails the stream on behalf of the connection, e.g. when its
+  /// RequestDeadline passed or a payload decompressed to too many bytes: the
+  /// local subscriber gets the exception and the peer learns that the stream
+  /// ended.
+  virtual void failStream(folly::exception_wrapper ex);
+
+  /// The transport of a disconnected client failed to connect, see
+  /// ConnectionAutomaton::connectFailed.  The stream ends right after.
+  virtual void connectFailed(folly::exception_wrapper ex);
+
   /// Indicates a terminal signal from the connection.
   ///
   /// This signal corresponds to Subscriber::{onComplete,onError} and
@@ -63,6 +76,9 @@ class StreamAutomatonBase : public virtual yarpl::Refcounted {
   virtual void pauseStream(RequestHandler& requestHandler) = 0;
   virtual void resumeStream(RequestHandler& requestHandler) = 0;
 
+  /// Fills in the flow control state of the stream.
+  virtual void flowControl(StreamFlowControl& flowControl) const;
+
  protected:
   bool isTerminated() const {
     return isTerminated_;
@@ -81,6 +97,27 @@ class StreamAutomatonBase : public virtual yarpl::Refcounted {
   void completeStream();
   void closeStream(StreamCompletionSignal signal);
 
+  /// @{
+  /// Latency tracking of a request initiated by this automaton.
+  ///
+  /// ::requestIssued starts tracking if the Stats of the connection ask for
+  /// it; each of the remaining calls is reported at most once and is a no-op
+  /// when tracking was not started.  The first frame written is reported by
+  /// ::newStream.
+  void requestIssued(StreamType streamType);
+  void responseRead();
+  void responseDelivered();
+  /// @}
+
+  /// Notes whether the publisher in the given direction has run out of
+  /// credit.  Cheap unless the state changes.
+  void creditChanged(FlowControlDirection direction, bool starved) {
+    auto& starvation = starvation_[static_cast<size_t>(direction)];
+    if (starved != (starvation.since != Stats::Clock::time_point())) {
+      creditStarvationChanged(direction, starved);
+    }
+  }
+
   /// A partially-owning pointer to the connection, the stream runs on.
   /// It is declared as const to allow only ctor to initialize it for thread
   /// safety of the dtor.
@@ -88,5 +125,23 @@ class StreamAutomatonBase : public virtual yarpl::Refcounted {
   const StreamId streamId_;
   // TODO: remove and nulify the writer_ instead
   bool isTerminated_{false};
+
+ private:
+  void creditStarvationChanged(FlowControlDirection direction, bool starved);
+
+  struct CreditStarvation {
+    /// Start of the ongoing starvation period, the epoch if there is none.
+    Stats::Clock::time_point since;
+    /// Total of the finished starvation periods.
+    Stats::Clock::duration total{0};
+  };
+  std::array<CreditStarvation, 2> starvation_;
+
+  /// Time the request was issued at, or the epoch when latency of this
+  /// automaton is not tracked (anymore).
+  Stats::Clock::time_point issuedAt_;
+  StreamType issuedType_{StreamType::REQUEST_RESPONSE};
+  bool requestWritten_{false};
+  bool responseRead_{false};
 };
 }
@@ -62,6 +62,14 @@ void StreamRequester::cancel() noexcept {
   }
 }
 
+void StreamRequester::failStream(folly::exception_wrapper ex) {
+  if (state_ == State::CLOSED) {
+    return;
+  }
+  Base::onError(std::move(ex));
+  cancel();
+}
+
 void StreamRequester::endStream(StreamCompletionSignal signal) {
   switch (state_) {
     case State::NEW:
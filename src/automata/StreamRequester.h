@@ -23,7 +23,9 @@ class StreamRequester : public ConsumerBase {
   // derived classes
   explicit StreamRequester(const Base::Parameters& params, Payload payload)
       : Base(params),
-        initialPayload_(std::move(payload)) {}
+        initialPayload_(std::move(payload)) {
+    requestIssued(StreamType::STREAM);
+  }
 
  private:
   // implementation from ConsumerBase::SubscriptionBase
@@ -34,6 +36,7 @@ class StreamRequester : public ConsumerBase {
                      bool complete,
                      bool flagsNext) override;
   void handleError(folly::exception_wrapper errorPayload) override;
+  void failStream(folly::exception_wrapper ex) override;
 
   void endStream(StreamCompletionSignal) override;
 
@@ -22,6 +22,8 @@ void StreamResponder::onNext(Payload response) noexcept {
   switch (state_) {
     case State::RESPONDING: {
       writePayload(std::move(response), false);
+      publisherPayloadSent();
+      creditChanged(FlowControlDirection::OUTBOUND, publisherStarved());
       break;
     }
     case State::CLOSED:
@@ -87,6 +89,14 @@ void StreamResponder::handleCancel() {
 }
 
 void StreamResponder::handleRequestN(uint32_t n) {
+  if (n) {
+    creditChanged(FlowControlDirection::OUTBOUND, false);
+  }
   PublisherBase::processRequestN(n);
 }
+
+void StreamResponder::flowControl(StreamFlowControl& flowControl) const {
+  StreamAutomatonBase::flowControl(flowControl);
+  flowControl.outboundCredit = publisherCredit();
+}
 }
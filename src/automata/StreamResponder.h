@@ -33,6 +33,7 @@ class StreamResponder : public StreamAutomatonBase,
   void pauseStream(RequestHandler&) override;
   void resumeStream(RequestHandler&) override;
   void endStream(StreamCompletionSignal) override;
+  void flowControl(StreamFlowControl&) const override;
 
   /// State of the Subscription responder.
   enum class State : uint8_t {
@@ -0,0 +1,161 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include "src/folly/KeepaliveWheel.h"
+#include <folly/io/async/EventBaseLocal.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include "src/ConnectionAutomaton.h"
+#include "src/Frame.h"
+
+namespace reactivesocket {
+
+WheelKeepaliveTimer::WheelKeepaliveTimer(
+    std::shared_ptr<KeepaliveWheel> wheel,
+    std::chrono::milliseconds period)
+    : wheel_(std::move(wheel)),
+      period_(period),
+      periodTicks_(std::max<uint64_t>(
+          1,
+          (period.count() + wheel_->tick_.count() - 1) /
+              wheel_->tick_.count())) {}
+
+WheelKeepaliveTimer::~WheelKeepaliveTimer() {
+  stop();
+}
+
+std::chrono::milliseconds WheelKeepaliveTimer::keepaliveTime() {
+  return period_;
+}
+
+void WheelKeepaliveTimer::stop() {
+  if (connection_) {
+    wheel_->remove(*this);
+    connection_ = nullptr;
+  }
+  pending_ = false;
+}
+
+void WheelKeepaliveTimer::start(const std::shared_ptr<FrameSink>& connection) {
+  stop();
+  connection_ = connection;
+  wheel_->add(*this);
+}
+
+void WheelKeepaliveTimer::keepaliveReceived() {
+  pending_ = false;
+}
+
+KeepaliveWheel::KeepaliveWheel(
+    folly::EventBase& eventBase,
+    std::chrono::milliseconds tick)
+    : folly::AsyncTimeout(&eventBase),
+      eventBase_(eventBase),
+      tick_(tick),
+      start_(Clock::now()) {
+  CHECK_GT(tick_.count(), 0);
+}
+
+std::shared_ptr<KeepaliveWheel> KeepaliveWheel::forEventBase(
+    folly::EventBase& eventBase) {
+  DCHECK(eventBase.isInEventBaseThread());
+  static folly::EventBaseLocal<std::shared_ptr<KeepaliveWheel>> wheels;
+  auto create = [&] { return std::make_shared<KeepaliveWheel>(eventBase); };
+  return wheels.getOrCreateFn(eventBase, create);
+}
+
+std::unique_ptr<KeepaliveTimer> KeepaliveWheel::createTimer(
+    std::chrono::milliseconds period) {
+  return std::make_unique<WheelKeepaliveTimer>(shared_from_this(), period);
+}
+
+void KeepaliveWheel::add(WheelKeepaliveTimer& timer) {
+  DCHECK(eventBase_.isInEventBaseThread());
+  if (size_ == 0) {
+    // the wheel was idle, catch up with the time
+    const auto now = Clock::now();
+    lastTick_ = ticksSinceStart(now);
+    scheduleNextTick(now);
+  }
+  ++size_;
+  timer.dueTick_ = lastTick_ + timer.periodTicks_;
+  insert(timer);
+}
+
+void KeepaliveWheel::remove(WheelKeepaliveTimer& timer) {
+  DCHECK(eventBase_.isInEventBaseThread());
+  DCHECK_GT(size_, 0);
+  // the timer is not linked while its connection is being disconnected
+  timer.hook_.unlink();
+  if (--size_ == 0) {
+    cancelTimeout();
+  }
+}
+
+void KeepaliveWheel::insert(WheelKeepaliveTimer& timer) {
+  slots_[timer.dueTick_ % kSlots].push_back(timer);
+}
+
+void KeepaliveWheel::expireTimers(Clock::time_point now) {
+  // the connections may release the last timers, and with them the wheel
+  auto self = shared_from_this();
+
+  const auto tick = ticksSinceStart(now);
+  while (lastTick_ < tick && size_ > 0) {
+    expireTick(++lastTick_);
+  }
+  if (size_ > 0) {
+    scheduleNextTick(now);
+  } else {
+    lastTick_ = tick;
+  }
+}
+
+void KeepaliveWheel::expireTick(uint64_t tick) {
+  auto& slot = slots_[tick % kSlots];
+  expiring_.splice(expiring_.end(), slot);
+
+  // The connections may stop any timer, including the ones still expiring,
+  // so the list is consumed from its front.
+  while (!expiring_.empty()) {
+    auto& timer = expiring_.front();
+    expiring_.pop_front();
+
+    if (timer.dueTick_ > tick) {
+      // due in a later turn of the wheel
+      slot.push_back(timer);
+      continue;
+    }
+
+    auto connection = timer.connection_;
+    if (timer.pending_) {
+      timer.stop();
+      connection->disconnectOrCloseWithError(
+          Frame_ERROR::connectionError("no response to keepalive"));
+    } else {
+      timer.pending_ = true;
+      timer.dueTick_ = tick + timer.periodTicks_;
+      insert(timer);
+      connection->sendKeepalive();
+    }
+  }
+}
+
+void KeepaliveWheel::scheduleNextTick(Clock::time_point now) {
+  const auto next = start_ + tick_ * static_cast<int64_t>(lastTick_ + 1);
+  // rounded up, the timeout must not fire before the tick
+  const auto delay = next > now
+      ? std::chrono::duration_cast<std::chrono::milliseconds>(
+            next - now + std::chrono::milliseconds(1) -
+            std::chrono::nanoseconds(1))
+      : std::chrono::milliseconds(0);
+  scheduleTimeout(static_cast<uint32_t>(delay.count()));
+}
+
+uint64_t KeepaliveWheel::ticksSinceStart(Clock::time_point now) const {
+  return now > start_ ? (now - start_) / tick_ : 0;
+}
+
+void KeepaliveWheel::timeoutExpired() noexcept {
+  expireTimers(Clock::now());
+}
+}
@@ -0,0 +1,113 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#pragma once
+
+#include <folly/IntrusiveList.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include "src/Common.h"
+
+namespace reactivesocket {
+
+class KeepaliveWheel;
+
+/// KeepaliveTimer driven by a KeepaliveWheel shared with the other
+/// connections of the EventBase. Unlike FollyKeepaliveTimer it allocates
+/// nothing per keepalive period.
+///
+/// All methods must be called on the thread of the EventBase of the wheel.
+class WheelKeepaliveTimer : public KeepaliveTimer {
+ public:
+  WheelKeepaliveTimer(
+      std::shared_ptr<KeepaliveWheel> wheel,
+      std::chrono::milliseconds period);
+  ~WheelKeepaliveTimer();
+
+  std::chrono::milliseconds keepaliveTime() override;
+  void stop() override;
+  void start(const std::shared_ptr<FrameSink>& connection) override;
+  void keepaliveReceived() override;
+
+ private:
+  friend class KeepaliveWheel;
+
+  const std::shared_ptr<KeepaliveWheel> wheel_;
+  const std::chrono::milliseconds period_;
+  /// The period in ticks of the wheel, rounded up.
+  const uint64_t periodTicks_;
+  std::shared_ptr<FrameSink> connection_;
+  bool pending_{false};
+
+  /// The tick of the wheel the timer expires at.
+  uint64_t dueTick_{0};
+  folly::IntrusiveListHook hook_;
+};
+
+/// Hashed timer wheel expiring the WheelKeepaliveTimers of one EventBase.
+///
+/// The timers due in the same tick are expired in one pass, which sends
+/// their KEEPALIVE frames or disconnects the connections which did not
+/// answer the previous one. A timer expires up to one tick after its period,
+/// so the tick trades the precision of the keepalives for fewer wakeups.
+/// The wheel only schedules its timeout while it has timers.
+///
+/// Share one wheel between the connections of an EventBase, the one of
+/// forEventBase() or one created through std::make_shared; it has to be
+/// destroyed on the thread of the EventBase.
+class KeepaliveWheel : public std::enable_shared_from_this<KeepaliveWheel>,
+                       private folly::AsyncTimeout {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit KeepaliveWheel(
+      folly::EventBase& eventBase,
+      std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+
+  /// The wheel of the EventBase, created on first use and released with the
+  /// EventBase or the last of its timers, whichever comes last. Must be
+  /// called on the thread of the EventBase.
+  static std::shared_ptr<KeepaliveWheel> forEventBase(
+      folly::EventBase& eventBase);
+
+  std::unique_ptr<KeepaliveTimer> createTimer(std::chrono::milliseconds period);
+
+  /// Expires the timers due up to now. Called by the timeout of the wheel,
+  /// exposed for tests and benchmarks.
+  void expireTimers(Clock::time_point now);
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  friend class WheelKeepaliveTimer;
+
+  static constexpr size_t kSlots = 512;
+
+  using TimerList =
+      folly::IntrusiveList<WheelKeepaliveTimer, &WheelKeepaliveTimer::hook_>;
+
+  void add(WheelKeepaliveTimer& timer);
+  void remove(WheelKeepaliveTimer& timer);
+  void insert(WheelKeepaliveTimer& timer);
+  void expireTick(uint64_t tick);
+  void scheduleNextTick(Clock::time_point now);
+  uint64_t ticksSinceStart(Clock::time_point now) const;
+
+  void timeoutExpired() noexcept override;
+
+  folly::EventBase& eventBase_;
+  const std::chrono::milliseconds tick_;
+  const Clock::time_point start_;
+
+  /// The last tick whose timers were expired.
+  uint64_t lastTick_{0};
+  size_t size_{0};
+  std::array<TimerList, kSlots> slots_;
+  /// The timers of the tick being expired.
+  TimerList expiring_;
+};
+}
@@ -45,7 +45,18 @@ void FramedDuplexConnection::setInput(
   CHECK(!inputReader_);
   inputReader_ = std::make_shared<FramedReader>(
       std::move(framesSink), executor_, protocolVersion_);
+  if (memoryAccountant_) {
+    inputReader_->setMemoryAccountant(memoryAccountant_);
+  }
   connection_->setInput(inputReader_);
 }
 
+void FramedDuplexConnection::setMemoryAccountant(
+    std::shared_ptr<MemoryAccountant> memoryAccountant) {
+  memoryAccountant_ = std::move(memoryAccountant);
+  if (inputReader_) {
+    inputReader_->setMemoryAccountant(memoryAccountant_);
+  }
+}
+
 } // reactivesocket
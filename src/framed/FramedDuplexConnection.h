@@ -32,11 +32,14 @@ class FramedDuplexConnection : public virtual DuplexConnection {
   void setInput(std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
                     framesSink) override;
 
+  void setMemoryAccountant(std::shared_ptr<MemoryAccountant>) override;
+
  private:
   std::unique_ptr<DuplexConnection> connection_;
   std::shared_ptr<FramedReader> inputReader_;
   std::shared_ptr<FramedWriter> outputWriter_;
   std::shared_ptr<ProtocolVersion> protocolVersion_;
+  std::shared_ptr<MemoryAccountant> memoryAccountant_;
   folly::Executor& executor_;
 };
 
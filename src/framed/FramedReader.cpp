@@ -2,6 +2,7 @@
 
 #include "src/framed/FramedReader.h"
 #include <folly/io/Cursor.h>
+#include "src/MemoryAccountant.h"
 #include "src/versions/FrameSerializer_v0_1.h"
 #include "src/versions/FrameSerializer_v1_0.h"
 
@@ -11,6 +12,45 @@ constexpr auto kFrameLengthFieldLengthV0_1 = sizeof(int32_t);
 constexpr auto kFrameLengthFieldLengthV1_0 = 3; // bytes
 } // namespace
 
+constexpr size_t FramedReader::kStreamWindow;
+
+FramedReader::~FramedReader() {
+  if (memoryAccountant_) {
+    memoryAccountant_->release(MemoryBuffer::PENDING_READS, chargedBytes_);
+  }
+}
+
+void FramedReader::setMemoryAccountant(
+    std::shared_ptr<MemoryAccountant> memoryAccountant) {
+  auto thisPtr = shared_from_this();
+  runInExecutor(
+      [ thisPtr, memoryAccountant = std::move(memoryAccountant) ]() mutable {
+        if (thisPtr->memoryAccountant_) {
+          thisPtr->memoryAccountant_->release(
+              MemoryBuffer::PENDING_READS, thisPtr->chargedBytes_);
+        }
+        thisPtr->memoryAccountant_ = std::move(memoryAccountant);
+        thisPtr->chargedBytes_ = 0;
+        thisPtr->chargeQueuedBytes();
+      },
+      "FramedReader::setMemoryAccountant");
+}
+
+void FramedReader::chargeQueuedBytes() {
+  if (!memoryAccountant_) {
+    return;
+  }
+  const auto queued = payloadQueue_.chainLength();
+  if (queued > chargedBytes_) {
+    memoryAccountant_->charge(
+        MemoryBuffer::PENDING_READS, queued - chargedBytes_);
+  } else if (queued < chargedBytes_) {
+    memoryAccountant_->release(
+        MemoryBuffer::PENDING_READS, chargedBytes_ - queued);
+  }
+  chargedBytes_ = queued;
+}
+
 size_t FramedReader::getFrameSizeFieldLength() const {
   DCHECK(*protocolVersion_ != ProtocolVersion::Unknown);
   if (*protocolVersion_ < FrameSerializerV1_0::Version) {
@@ -74,12 +114,13 @@ void FramedReader::onSubscribeImpl(
 }
 
 void FramedReader::onNextImpl(std::unique_ptr<folly::IOBuf> payload) noexcept {
-  streamRequested_ = false;
+  if (streamDemand_ > 0) {
+    --streamDemand_;
+  }
 
   if (payload) {
-    VLOG(4) << "incoming bytes length=" << payload->length() << std::endl
-            << hexDump(payload->clone()->moveToFbString());
     payloadQueue_.append(std::move(payload));
+    chargeQueuedBytes();
     parseFrames();
   }
   requestStream();
@@ -112,6 +153,14 @@ void FramedReader::parseFrames() {
       break;
     }
 
+    // a frame which the connection could not hold is refused before its
+    // bytes are buffered, rather than once it has been read whole
+    if (memoryAccountant_ &&
+        memoryAccountant_->exceedsFrameCap(getPayloadSize(nextFrameSize))) {
+      onErrorImpl(std::runtime_error("frame exceeds memory cap"));
+      break;
+    }
+
     if (payloadQueue_.chainLength() <
         getFrameSizeWithLengthField(nextFrameSize)) {
       // need to accumulate more data
@@ -127,15 +176,15 @@ void FramedReader::parseFrames() {
 
     CHECK(allowance_.tryAcquire(1));
 
-    VLOG(4) << "parsed frame length=" << nextFrame->length() << std::endl
-            << hexDump(nextFrame->clone()->moveToFbString());
     frames_->onNext(std::move(nextFrame));
   }
   dispatchingFrames_ = false;
+  chargeQueuedBytes();
 }
 
 void FramedReader::onCompleteImpl() noexcept {
   payloadQueue_.move(); // equivalent to clear(), releases the buffers
+  chargeQueuedBytes();
   if (auto subscriber = std::move(frames_)) {
     subscriber->onComplete();
   }
@@ -146,6 +195,7 @@ void FramedReader::onCompleteImpl() noexcept {
 
 void FramedReader::onErrorImpl(folly::exception_wrapper ex) noexcept {
   payloadQueue_.move(); // equivalent to clear(), releases the buffers
+  chargeQueuedBytes();
   if (auto subscriber = std::move(frames_)) {
     subscriber->onError(std::move(ex));
   }
@@ -161,14 +211,20 @@ void FramedReader::requestImpl(size_t n) noexcept {
 }
 
 void FramedReader::requestStream() {
-  if (streamSubscription_ && allowance_.canAcquire()) {
-    streamRequested_ = true;
-    streamSubscription_->request(1);
+  // Keeps a window of reads requested while there is demand for frames, so
+  // that a transport which honours the demand does not stall between reads,
+  // and stops reading once the demand for frames is gone.
+  if (streamSubscription_ && allowance_.canAcquire() &&
+      streamDemand_ <= kStreamWindow / 2) {
+    const auto n = kStreamWindow - streamDemand_;
+    streamDemand_ = kStreamWindow;
+    streamSubscription_->request(n);
   }
 }
 
 void FramedReader::cancelImpl() noexcept {
   payloadQueue_.move(); // equivalent to clear(), releases the buffers
+  chargeQueuedBytes();
   if (auto subscription = std::move(streamSubscription_)) {
     subscription->cancel();
   }
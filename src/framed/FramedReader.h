@@ -11,6 +11,7 @@
 
 namespace reactivesocket {
 
+class MemoryAccountant;
 struct ProtocolVersion;
 
 class FramedReader : public SubscriberBaseT<std::unique_ptr<folly::IOBuf>>,
@@ -26,6 +27,11 @@ class FramedReader : public SubscriberBaseT<std::unique_ptr<folly::IOBuf>>,
         frames_(std::move(frames)),
         payloadQueue_(folly::IOBufQueue::cacheChainLength()),
         protocolVersion_(std::move(protocolVersion)) {}
+  ~FramedReader();
+
+  /// Charges the bytes of partially read frames to the accountant, and errors
+  /// out on a frame over its caps as soon as the frame length is read.
+  void setMemoryAccountant(std::shared_ptr<MemoryAccountant> memoryAccountant);
 
  private:
   // Subscriber methods
@@ -42,6 +48,12 @@ class FramedReader : public SubscriberBaseT<std::unique_ptr<folly::IOBuf>>,
   void parseFrames();
   void requestStream();
 
+  /// Brings the bytes charged to the accountant in line with payloadQueue_.
+  void chargeQueuedBytes();
+
+  /// Reads requested from the transport at a time.
+  static constexpr size_t kStreamWindow = 16;
+
   bool ensureOrAutodetectProtocolVersion();
 
   size_t getFrameSizeFieldLength() const;
@@ -58,11 +70,16 @@ class FramedReader : public SubscriberBaseT<std::unique_ptr<folly::IOBuf>>,
 
   AllowanceSemaphore allowance_{0};
 
-  bool streamRequested_{false};
+  /// Reads requested from the transport and not received yet.
+  size_t streamDemand_{0};
   bool dispatchingFrames_{false};
 
   folly::IOBufQueue payloadQueue_;
   std::shared_ptr<ProtocolVersion> protocolVersion_;
+
+  std::shared_ptr<MemoryAccountant> memoryAccountant_;
+  /// Bytes of payloadQueue_ charged to memoryAccountant_.
+  size_t chargedBytes_{0};
 };
 
 } // reactivesocket
@@ -2,6 +2,7 @@
 
 #include "src/framed/FramedWriter.h"
 #include <folly/io/Cursor.h>
+#include "src/Logging.h"
 #include "src/versions/FrameSerializer_v1_0.h"
 
 namespace reactivesocket {
@@ -68,17 +69,12 @@ std::unique_ptr<folly::IOBuf> FramedWriter::appendSize(
     payload->prepend(frameSizeFieldLength);
     folly::io::RWPrivateCursor cur(payload.get());
     writeFrameLength(cur, payloadLength, frameSizeFieldLength);
-    VLOG(4) << "writing frame length=" << payload->length() << std::endl
-            << hexDump(payload->clone()->moveToFbString());
     return payload;
   } else {
     auto newPayload = folly::IOBuf::createCombined(frameSizeFieldLength);
     folly::io::Appender appender(newPayload.get(), /* do not grow */ 0);
     writeFrameLength(appender, payloadLength, frameSizeFieldLength);
     newPayload->appendChain(std::move(payload));
-    VLOG(4) << "writing frame length=" << newPayload->computeChainDataLength()
-            << std::endl
-            << hexDump(newPayload->clone()->moveToFbString());
     return newPayload;
   }
 }
@@ -86,7 +82,7 @@ std::unique_ptr<folly::IOBuf> FramedWriter::appendSize(
 void FramedWriter::onNextImpl(std::unique_ptr<folly::IOBuf> payload) noexcept {
   auto sizedPayload = appendSize(std::move(payload));
   if (!sizedPayload) {
-    VLOG(1) << "payload too big";
+    RSOCKET_VLOG(1) << "payload too big";
     cancel();
     return;
   }
@@ -100,7 +96,7 @@ void FramedWriter::onNextMultiple(
   for (auto& payload : payloads) {
     auto sizedPayload = appendSize(std::move(payload));
     if (!sizedPayload) {
-      VLOG(1) << "payload too big";
+      RSOCKET_VLOG(1) << "payload too big";
       cancel();
       return;
     }
@@ -3,6 +3,7 @@
 #include "TcpDuplexConnection.h"
 #include <folly/ExceptionWrapper.h>
 #include <folly/io/IOBufQueue.h>
+#include "src/AllowanceSemaphore.h"
 #include "src/SubscriberBase.h"
 #include "src/SubscriptionBase.h"
 
@@ -18,7 +19,7 @@ class TcpReaderWriter : public ::folly::AsyncTransportWrapper::WriteCallback,
       folly::AsyncSocket::UniquePtr&& socket,
       folly::Executor& executor,
       std::shared_ptr<Stats> stats)
-      : ExecutorBase(executor),
+      : ExecutorBase(executor, stats),
         stats_(std::move(stats)),
         socket_(std::move(socket)) {}
 
@@ -31,9 +32,8 @@ class TcpReaderWriter : public ::folly::AsyncTransportWrapper::WriteCallback,
           inputSubscriber) {
     CHECK(!inputSubscriber_);
     inputSubscriber_ = std::move(inputSubscriber);
+    // reading starts once the input requests
     inputSubscriber_->onSubscribe(SubscriptionBase::shared_from_this());
-
-    socket_->setReadCB(this);
   }
 
   const std::shared_ptr<Stats> stats_;
@@ -58,7 +58,12 @@ class TcpReaderWriter : public ::folly::AsyncTransportWrapper::WriteCallback,
   }
 
   void requestImpl(size_t n) noexcept override {
-    // ignored for now, currently flow control is only at higher layers
+    // the demand is counted in reads, the size of which is up to the socket
+    readAllowance_.release(n);
+    if (!reading_ && inputSubscriber_ && readAllowance_.canAcquire()) {
+      reading_ = true;
+      socket_->setReadCB(this);
+    }
   }
 
   void cancelImpl() noexcept override {
@@ -119,10 +124,19 @@ class TcpReaderWriter : public ::folly::AsyncTransportWrapper::WriteCallback,
 
   void readBufferAvailable(
       std::unique_ptr<folly::IOBuf> readBuf) noexcept override {
+    readAllowance_.tryAcquire();
+    if (!readAllowance_.canAcquire()) {
+      // stop reading, leaving the peer to the TCP flow control, until the
+      // input requests more
+      reading_ = false;
+      socket_->setReadCB(nullptr);
+    }
     inputSubscriber_->onNext(std::move(readBuf));
   }
 
   folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
+  AllowanceSemaphore readAllowance_{0};
+  bool reading_{false};
   folly::AsyncSocket::UniquePtr socket_;
 
   std::shared_ptr<reactivesocket::Subscriber<std::unique_ptr<folly::IOBuf>>>
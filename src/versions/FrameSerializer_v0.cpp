@@ -322,6 +322,19 @@ folly::Optional<StreamId> FrameSerializerV0::peekStreamId(
   }
 }
 
+bool FrameSerializerV0::peekFrameHeader(
+    const folly::IOBuf& in,
+    FrameHeader& header) {
+  folly::io::Cursor cur(&in);
+  try {
+    FrameFlags_V0 flags;
+    deserializeHeaderFrom(cur, header, flags);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
 std::unique_ptr<folly::IOBuf> FrameSerializerV0::serializeOut(
     Frame_REQUEST_STREAM&& frame) {
   return serializeOutInternal(std::move(frame));
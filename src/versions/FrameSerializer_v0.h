@@ -15,6 +15,7 @@ class FrameSerializerV0 : public FrameSerializer {
 
   FrameType peekFrameType(const folly::IOBuf& in) override;
   folly::Optional<StreamId> peekStreamId(const folly::IOBuf& in) override;
+  bool peekFrameHeader(const folly::IOBuf& in, FrameHeader& header) override;
 
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_REQUEST_STREAM&&) override;
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_REQUEST_CHANNEL&&) override;
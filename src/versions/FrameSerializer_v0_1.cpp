@@ -2,6 +2,7 @@
 
 #include "src/versions/FrameSerializer_v0_1.h"
 #include <folly/io/Cursor.h>
+#include "src/Logging.h"
 
 namespace reactivesocket {
 
@@ -54,14 +55,14 @@ ProtocolVersion FrameSerializerV0_1::detectProtocolVersion(
     constexpr static const auto kSETUP = 0x0001;
     constexpr static const auto kRESUME = 0x000E;
 
-    VLOG(4) << "frameType=" << frameType << "streamId=" << streamId;
+    RSOCKET_VLOG(4) << "frameType=" << frameType << "streamId=" << streamId;
 
     if (frameType == kSETUP && streamId == 0) {
       auto majorVersion = cur.readBE<uint16_t>();
       auto minorVersion = cur.readBE<uint16_t>();
 
-      VLOG(4) << "majorVersion=" << majorVersion
-              << " minorVersion=" << minorVersion;
+      RSOCKET_VLOG(4) << "majorVersion=" << majorVersion
+                      << " minorVersion=" << minorVersion;
 
       if (majorVersion == 0 && (minorVersion == 0 || minorVersion == 1)) {
         return ProtocolVersion(majorVersion, minorVersion);
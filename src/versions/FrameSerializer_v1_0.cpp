@@ -1,7 +1,9 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include "src/versions/FrameSerializer_v1_0.h"
+#include <folly/Bits.h>
 #include <folly/io/Cursor.h>
+#include "src/Logging.h"
 
 namespace reactivesocket {
 
@@ -78,13 +80,7 @@ static void serializeMetadataInto(
   appender.insert(std::move(metadata));
 }
 
-std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::deserializeMetadataFrom(
-    folly::io::Cursor& cur,
-    FrameFlags flags) {
-  if (!(flags & FrameFlags::METADATA)) {
-    return nullptr;
-  }
-
+static uint32_t deserializeMetadataLengthFrom(folly::io::Cursor& cur) {
   uint32_t metadataLength = 0;
   metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
   metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
@@ -93,7 +89,17 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::deserializeMetadataFrom(
   if (metadataLength > kMaxMetadataLength) {
     throw std::runtime_error("Metadata is too big to deserialize");
   }
+  return metadataLength;
+}
 
+std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::deserializeMetadataFrom(
+    folly::io::Cursor& cur,
+    FrameFlags flags) {
+  if (!(flags & FrameFlags::METADATA)) {
+    return nullptr;
+  }
+
+  const auto metadataLength = deserializeMetadataLengthFrom(cur);
   std::unique_ptr<folly::IOBuf> metadata;
   cur.clone(metadata, metadataLength);
   return metadata;
@@ -184,6 +190,39 @@ FrameType FrameSerializerV1_0::peekFrameType(const folly::IOBuf& in) {
   }
 }
 
+static bool parseHeader(const uint8_t* bytes, FrameHeader& header) {
+  auto streamId = folly::Endian::big(folly::loadUnaligned<int32_t>(bytes));
+  uint16_t type = bytes[4]; // |Frame Type |I|M|
+  header.type_ = deserializeFrameType(type >> 2);
+  header.flags_ = static_cast<FrameFlags>(((type & 0x3) << 8) | bytes[5]);
+  if (streamId < 0) {
+    return false;
+  }
+  header.streamId_ = static_cast<StreamId>(streamId);
+  return true;
+}
+
+bool FrameSerializerV1_0::peekFrameHeader(
+    const folly::IOBuf& in,
+    FrameHeader& header) {
+  if (in.length() >= kFrameHeaderSize) {
+    // the header is in the first buffer of the chain, which is virtually
+    // always the case
+    return parseHeader(in.data(), header);
+  }
+
+  uint8_t bytes[kFrameHeaderSize];
+  folly::io::Cursor cur(&in);
+  auto length = cur.pullAtMost(bytes, sizeof(bytes));
+  if (length < kFrameHeaderSize) {
+    header.type_ = length > sizeof(int32_t)
+        ? deserializeFrameType(bytes[sizeof(int32_t)] >> 2)
+        : FrameType::RESERVED;
+    return false;
+  }
+  return parseHeader(bytes, header);
+}
+
 folly::Optional<StreamId> FrameSerializerV1_0::peekStreamId(
     const folly::IOBuf& in) {
   folly::io::Cursor cur(&in);
@@ -473,6 +512,29 @@ bool FrameSerializerV1_0::deserializeFrom(
   return true;
 }
 
+bool FrameSerializerV1_0::deserializeFrom(
+    PayloadFrameView& frame,
+    std::unique_ptr<folly::IOBuf> in) {
+  folly::io::Cursor cur(in.get());
+  try {
+    deserializeHeaderFrom(cur, frame.header_);
+    size_t offset = kFrameHeaderSize;
+    frame.metadataOffset_ = frame.metadataLength_ = 0;
+    if (frame.hasMetadata()) {
+      frame.metadataLength_ = deserializeMetadataLengthFrom(cur);
+      frame.metadataOffset_ = offset + kMedatadaLengthSize;
+      cur.skip(frame.metadataLength_);
+      offset = frame.metadataOffset_ + frame.metadataLength_;
+    }
+    frame.dataOffset_ = offset;
+    frame.dataLength_ = cur.totalLength();
+  } catch (...) {
+    return false;
+  }
+  frame.frame_ = std::move(in);
+  return true;
+}
+
 bool FrameSerializerV1_0::deserializeFrom(
     Frame_ERROR& frame,
     std::unique_ptr<folly::IOBuf> in) {
@@ -563,7 +625,7 @@ bool FrameSerializerV1_0::deserializeFrom(
     frame.ttl_ = static_cast<uint32_t>(ttl);
 
     auto numberOfRequests = cur.readBE<int32_t>();
-    if (numberOfRequests <= 0) {
+    if (numberOfRequests < 0) {
       throw std::runtime_error("invalid numberOfRequests value");
     }
     frame.numberOfRequests_ = static_cast<uint32_t>(numberOfRequests);
@@ -664,9 +726,9 @@ ProtocolVersion FrameSerializerV1_0::detectProtocolVersion(
     constexpr static const auto kSETUP = 0x01;
     constexpr static const auto kRESUME = 0x0D;
 
-    VLOG(4) << "frameType=" << frameType << "streamId=" << streamId
-            << " majorVersion=" << majorVersion
-            << " minorVersion=" << minorVersion;
+    RSOCKET_VLOG(4) << "frameType=" << frameType << "streamId=" << streamId
+                    << " majorVersion=" << majorVersion
+                    << " minorVersion=" << minorVersion;
 
     if (streamId == 0 && (frameType == kSETUP || frameType == kRESUME) &&
         majorVersion == FrameSerializerV1_0::Version.major &&
@@ -6,7 +6,9 @@
 
 namespace reactivesocket {
 
-class FrameSerializerV1_0 : public FrameSerializer {
+// final, so that the calls through a FrameSerializerV1_0 pointer are not
+// virtual
+class FrameSerializerV1_0 final : public FrameSerializer {
  public:
   constexpr static const ProtocolVersion Version = ProtocolVersion(1, 0);
   constexpr static const size_t kFrameHeaderSize = 6; // bytes
@@ -20,6 +22,7 @@ class FrameSerializerV1_0 : public FrameSerializer {
 
   FrameType peekFrameType(const folly::IOBuf& in) override;
   folly::Optional<StreamId> peekStreamId(const folly::IOBuf& in) override;
+  bool peekFrameHeader(const folly::IOBuf& in, FrameHeader& header) override;
 
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_REQUEST_STREAM&&) override;
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_REQUEST_CHANNEL&&) override;
@@ -59,6 +62,9 @@ class FrameSerializerV1_0 : public FrameSerializer {
   bool deserializeFrom(Frame_RESUME_OK&, std::unique_ptr<folly::IOBuf>)
       override;
 
+  /// Parses a PAYLOAD frame without cloning its metadata and data.
+  bool deserializeFrom(PayloadFrameView&, std::unique_ptr<folly::IOBuf>);
+
   static std::unique_ptr<folly::IOBuf> deserializeMetadataFrom(
       folly::io::Cursor& cur,
       FrameFlags flags);
@@ -7,6 +7,8 @@
 #include <folly/io/async/EventBase.h>
 
 #include "tck-test/TypedCommands.h"
+#include "yarpl/flowable/Subscription.h"
+#include "yarpl/single/SingleObserver.h"
 
 using namespace folly;
 using namespace yarpl;
@@ -14,6 +16,54 @@ using namespace yarpl;
 namespace reactivesocket {
 namespace tck {
 
+namespace {
+/// Feeds a request-response into a TestSubscriber so the marble based
+/// assertions work unchanged. The request is already in flight once the
+/// observer is subscribed, so request(n) from the test script is a no-op.
+class SingleToTestSubscriber : public yarpl::single::SingleObserver<Payload> {
+  class CancelOnlySubscription : public yarpl::flowable::Subscription {
+   public:
+    explicit CancelOnlySubscription(
+        Reference<yarpl::single::SingleSubscription> subscription)
+        : subscription_(std::move(subscription)) {}
+
+    void request(int64_t) noexcept override {}
+
+    void cancel() noexcept override {
+      if (auto subscription = std::move(subscription_)) {
+        subscription->cancel();
+      }
+    }
+
+   private:
+    Reference<yarpl::single::SingleSubscription> subscription_;
+  };
+
+ public:
+  explicit SingleToTestSubscriber(
+      Reference<yarpl::flowable::Subscriber<Payload>> subscriber)
+      : subscriber_(std::move(subscriber)) {}
+
+  void onSubscribe(
+      Reference<yarpl::single::SingleSubscription> subscription) override {
+    subscriber_->onSubscribe(
+        make_ref<CancelOnlySubscription>(std::move(subscription)));
+  }
+
+  void onSuccess(Payload payload) override {
+    subscriber_->onNext(std::move(payload));
+    subscriber_->onComplete();
+  }
+
+  void onError(std::exception_ptr ex) override {
+    subscriber_->onError(std::move(ex));
+  }
+
+ private:
+  Reference<yarpl::flowable::Subscriber<Payload>> subscriber_;
+};
+} // namespace
+
 TestInterpreter::TestInterpreter(
     const Test& test,
     ReactiveSocket& reactiveSocket)
@@ -72,7 +122,7 @@ void TestInterpreter::handleSubscribe(const SubscribeCommand& command) {
     auto testSubscriber = createTestSubscriber(command.id());
     reactiveSocket_->requestResponse(
         Payload(command.payloadData(), command.payloadMetadata()),
-        std::move(testSubscriber));
+        make_ref<SingleToTestSubscriber>(std::move(testSubscriber)));
   } else if (command.isRequestStreamType()) {
     auto testSubscriber = createTestSubscriber(command.id());
     reactiveSocket_->requestStream(
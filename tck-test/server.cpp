@@ -17,6 +17,8 @@
 #include "test/simple/StatsPrinter.h"
 
 #include "tck-test/MarbleProcessor.h"
+#include "yarpl/single/SingleObserver.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -90,6 +92,43 @@ class ServerSubscription : public yarpl::flowable::Subscription {
   std::shared_ptr<tck::MarbleProcessor> marbleProcessor_;
 };
 
+/// Lets the marble processor, which drives a Subscriber, produce the single
+/// response of a request-response interaction.
+class SingleResponseSubscriber : public yarpl::flowable::Subscriber<Payload> {
+ public:
+  explicit SingleResponseSubscriber(
+      yarpl::Reference<yarpl::single::SingleObserver<Payload>> response)
+      : response_(std::move(response)) {}
+
+  void onSubscribe(yarpl::Reference<yarpl::flowable::Subscription>
+                       subscription) noexcept override {
+    response_->onSubscribe(yarpl::single::SingleSubscriptions::create(
+        [subscription] { subscription->cancel(); }));
+    subscription->request(1);
+  }
+
+  void onNext(Payload payload) noexcept override {
+    if (auto response = std::move(response_)) {
+      response->onSuccess(std::move(payload));
+    }
+  }
+
+  void onComplete() noexcept override {
+    if (auto response = std::move(response_)) {
+      response->onSuccess(Payload());
+    }
+  }
+
+  void onError(std::exception_ptr ex) noexcept override {
+    if (auto response = std::move(response_)) {
+      response->onError(std::move(ex));
+    }
+  }
+
+ private:
+  yarpl::Reference<yarpl::single::SingleObserver<Payload>> response_;
+};
+
 class Callback : public AsyncServerSocket::AcceptCallback {
  public:
   explicit Callback(EventBase& eventBase) : eventBase_(eventBase) {}
@@ -188,8 +227,8 @@ class Callback : public AsyncServerSocket::AcceptCallback {
     void handleRequestResponse(
         Payload request,
         StreamId streamId,
-        const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>&
-            response) noexcept override {
+        const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+            singleResponse) noexcept override {
       LOG(INFO) << "handleRequestResponse " << request;
       std::string data = request.data->moveToFbString().toStdString();
       std::string metadata = request.metadata->moveToFbString().toStdString();
@@ -198,6 +237,8 @@ class Callback : public AsyncServerSocket::AcceptCallback {
         LOG(ERROR) << "No Handler found for the [data: " << data
                    << ", metadata:" << metadata << "]";
       } else {
+        yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response =
+            make_ref<SingleResponseSubscriber>(singleResponse);
         auto marbleProcessor =
             std::make_shared<tck::MarbleProcessor>(it->second, response);
         auto subscription =
@@ -0,0 +1,106 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+#include "src/CompositeMetadata.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+TEST(CompositeMetadataTest, RoundTrip) {
+  auto metadata = CompositeMetadataBuilder()
+                      .add("application/json", folly::IOBuf::copyBuffer("{}"))
+                      .add("x-custom/type", folly::IOBuf::copyBuffer("custom"))
+                      .addRoute({"service.method", "extra"})
+                      .build();
+
+  CompositeMetadataReader reader(*metadata);
+  ASSERT_TRUE(reader.next());
+  EXPECT_TRUE(reader.mimeTypeIs("application/json"));
+  EXPECT_EQ("application/json", reader.mimeType());
+  EXPECT_EQ("{}", reader.clone()->moveToFbString());
+
+  ASSERT_TRUE(reader.next());
+  EXPECT_TRUE(reader.mimeTypeIs("x-custom/type"));
+  EXPECT_FALSE(reader.mimeTypeIs("application/json"));
+  EXPECT_EQ(6u, reader.length());
+  EXPECT_EQ("custom", reader.cursor().readFixedString(reader.length()));
+
+  ASSERT_TRUE(reader.next());
+  EXPECT_TRUE(reader.mimeTypeIs(kRoutingMimeType));
+  EXPECT_FALSE(reader.next());
+  EXPECT_FALSE(reader.malformed());
+}
+
+TEST(CompositeMetadataTest, WellKnownMimeTypesAreEncodedAsIds) {
+  auto metadata = CompositeMetadataBuilder()
+                      .add("application/json", folly::IOBuf::copyBuffer("{}"))
+                      .build();
+  // id, 24 bit length, entry
+  EXPECT_EQ(1u + 3 + 2, metadata->computeChainDataLength());
+  EXPECT_EQ(0x85, metadata->data()[0]);
+  EXPECT_EQ(0x05, *wellKnownMimeTypeId("application/json"));
+  EXPECT_EQ("message/x.rsocket.routing.v0", wellKnownMimeType(0x7E));
+  EXPECT_FALSE(wellKnownMimeTypeId("x-custom/type"));
+}
+
+TEST(CompositeMetadataTest, ReadRoute) {
+  auto metadata = CompositeMetadataBuilder()
+                      .add("application/json", folly::IOBuf::copyBuffer("{}"))
+                      .addRoute({"service.method"})
+                      .build();
+  std::string scratch;
+  auto route = readRoute(*metadata, scratch);
+  ASSERT_TRUE(route);
+  EXPECT_EQ("service.method", *route);
+  // the route is read in place
+  EXPECT_TRUE(scratch.empty());
+
+  auto noRoute = CompositeMetadataBuilder()
+                     .add("application/json", folly::IOBuf::copyBuffer("{}"))
+                     .build();
+  EXPECT_FALSE(readRoute(*noRoute, scratch));
+}
+
+TEST(CompositeMetadataTest, ReadRouteAcrossBuffers) {
+  auto metadata =
+      CompositeMetadataBuilder().addRoute({"service.method"}).build();
+  // split the tag between two buffers
+  auto flat = metadata->cloneAsValue();
+  flat.coalesce();
+  auto head = folly::IOBuf::copyBuffer(flat.data(), 8);
+  head->prependChain(
+      folly::IOBuf::copyBuffer(flat.data() + 8, flat.length() - 8));
+
+  std::string scratch;
+  auto route = readRoute(*head, scratch);
+  ASSERT_TRUE(route);
+  EXPECT_EQ("service.method", *route);
+  EXPECT_EQ("service.method", scratch);
+}
+
+TEST(CompositeMetadataTest, Malformed) {
+  auto metadata = CompositeMetadataBuilder()
+                      .add("application/json", folly::IOBuf::copyBuffer("{}"))
+                      .build();
+  // the entry is cut short
+  metadata->coalesce();
+  metadata->trimEnd(1);
+
+  CompositeMetadataReader reader(*metadata);
+  EXPECT_FALSE(reader.next());
+  EXPECT_TRUE(reader.malformed());
+  std::string scratch;
+  EXPECT_FALSE(readRoute(*metadata, scratch));
+}
+
+TEST(CompositeMetadataTest, InvalidEntries) {
+  EXPECT_THROW(
+      CompositeMetadataBuilder().add("", nullptr), std::invalid_argument);
+  EXPECT_THROW(
+      CompositeMetadataBuilder().add(std::string(129, 'a'), nullptr),
+      std::invalid_argument);
+  EXPECT_THROW(
+      CompositeMetadataBuilder().addRoute({std::string(256, 'a')}),
+      std::invalid_argument);
+}
@@ -0,0 +1,140 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/json.h>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "src/CounterStats.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+TEST(CounterStatsTest, AggregatesAcrossThreads) {
+  CounterStats stats;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      stats.socketCreated();
+      for (int j = 0; j < 100; ++j) {
+        stats.frameWritten(FrameType::REQUEST_N);
+        stats.frameRead(FrameType::PAYLOAD);
+        stats.bytesRead(10);
+      }
+      stats.streamBufferChanged(2, 20);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // The exited threads' counts are retired, add some live ones too.
+  stats.frameRead(FrameType::PAYLOAD);
+  stats.streamBufferChanged(-1, -10);
+
+  auto snapshot = stats.snapshot();
+  EXPECT_EQ(4, snapshot.socketsCreated);
+  EXPECT_EQ(0, snapshot.socketsClosed);
+  EXPECT_EQ(4000, snapshot.bytesRead);
+  EXPECT_EQ(
+      400,
+      snapshot.framesWritten[static_cast<size_t>(FrameType::REQUEST_N)]);
+  EXPECT_EQ(
+      401, snapshot.framesRead[static_cast<size_t>(FrameType::PAYLOAD)]);
+  EXPECT_EQ(0, snapshot.framesRead[static_cast<size_t>(FrameType::SETUP)]);
+  EXPECT_EQ(7, snapshot.streamBufferFrames);
+  EXPECT_EQ(70, snapshot.streamBufferBytes);
+}
+
+TEST(CounterStatsTest, Export) {
+  CounterStats stats;
+  stats.frameWritten(FrameType::SETUP);
+  stats.frameRead(FrameType::EXT);
+  stats.bytesWritten(42);
+
+  auto snapshot = stats.snapshot();
+  auto text = snapshot.toString();
+  EXPECT_NE(std::string::npos, text.find("bytes_written 42\n"));
+  EXPECT_NE(std::string::npos, text.find("frames_written.SETUP 1\n"));
+  EXPECT_NE(std::string::npos, text.find("frames_read.EXT 1\n"));
+  EXPECT_EQ(std::string::npos, text.find("frames_read.PAYLOAD"));
+
+  auto json = folly::parseJson(snapshot.toJson());
+  EXPECT_EQ(42, json["bytes_written"].asInt());
+  EXPECT_EQ(1, json["frames_written"]["SETUP"].asInt());
+  EXPECT_EQ(1, json["frames_written"].size());
+  EXPECT_EQ(snapshot.toDynamic(), json);
+}
+
+TEST(CounterStatsTest, EveryHookHasItsCounter) {
+  CounterStats stats;
+  stats.socketCreated();
+  stats.socketCreated();
+  stats.socketDisconnected();
+  stats.socketClosed(StreamCompletionSignal::COMPLETE);
+  stats.duplexConnectionCreated("tcp", nullptr);
+  stats.duplexConnectionCreated("tcp", nullptr);
+  stats.duplexConnectionCreated("tcp", nullptr);
+  stats.duplexConnectionClosed("tcp", nullptr);
+  stats.bytesWritten(5);
+  stats.bytesRead(7);
+  stats.resumeBufferChanged(3, 300);
+  stats.resumeBufferChanged(-1, -100);
+  stats.streamBufferChanged(4, 40);
+
+  auto snapshot = stats.snapshot();
+  EXPECT_EQ(2, snapshot.socketsCreated);
+  EXPECT_EQ(1, snapshot.socketsDisconnected);
+  EXPECT_EQ(1, snapshot.socketsClosed);
+  EXPECT_EQ(3, snapshot.duplexConnectionsCreated);
+  EXPECT_EQ(1, snapshot.duplexConnectionsClosed);
+  EXPECT_EQ(5, snapshot.bytesWritten);
+  EXPECT_EQ(7, snapshot.bytesRead);
+  EXPECT_EQ(2, snapshot.resumeBufferFrames);
+  EXPECT_EQ(200, snapshot.resumeBufferBytes);
+  EXPECT_EQ(4, snapshot.streamBufferFrames);
+  EXPECT_EQ(40, snapshot.streamBufferBytes);
+  for (size_t i = 0; i < CounterStats::kFrameTypes; ++i) {
+    EXPECT_EQ(0, snapshot.framesWritten[i]);
+    EXPECT_EQ(0, snapshot.framesRead[i]);
+  }
+}
+
+TEST(CounterStatsTest, FrameTypesUnknownToThisVersion) {
+  CounterStats stats;
+  stats.frameRead(static_cast<FrameType>(0x20));
+
+  auto snapshot = stats.snapshot();
+  EXPECT_EQ(1, snapshot.framesRead[0x20]);
+  EXPECT_NE(
+      std::string::npos,
+      snapshot.toString().find("frames_read.UNKNOWN_32 1\n"));
+  EXPECT_EQ(1, snapshot.toDynamic()["frames_read"]["UNKNOWN_32"].asInt());
+}
+
+TEST(CounterStatsTest, SnapshotsWhileCounting) {
+  CounterStats stats;
+  constexpr int kThreads = 4;
+  constexpr int kFrames = 10000;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kFrames; ++j) {
+        stats.frameWritten(FrameType::PAYLOAD);
+      }
+    });
+  }
+
+  // a counter never goes back, whether its threads are live or have exited
+  const auto index = static_cast<size_t>(FrameType::PAYLOAD);
+  uint64_t last = 0;
+  for (int i = 0; i < 100; ++i) {
+    const auto frames = stats.snapshot().framesWritten[index];
+    EXPECT_LE(last, frames);
+    last = frames;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(kThreads * kFrames, stats.snapshot().framesWritten[index]);
+}
@@ -0,0 +1,166 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "src/FrameCapture.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+namespace {
+std::string toString(folly::ByteRange range) {
+  return std::string(reinterpret_cast<const char*>(range.data()), range.size());
+}
+}
+
+TEST(FrameCaptureTest, WriteAndRead) {
+  folly::test::TemporaryFile file;
+  {
+    FrameCaptureWriter writer(file.path().string());
+    writer.write(FrameDirection::INBOUND, *folly::IOBuf::copyBuffer("setup"));
+    auto chained = folly::IOBuf::copyBuffer("pay");
+    chained->prependChain(folly::IOBuf::copyBuffer("load"));
+    writer.write(FrameDirection::OUTBOUND, *chained);
+    writer.write(FrameDirection::INBOUND, *folly::IOBuf::create(0));
+  }
+
+  FrameCaptureReader reader(file.path().string());
+  FrameCaptureReader::Record record;
+  for (int pass = 0; pass < 2; ++pass) {
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(FrameDirection::INBOUND, record.direction);
+    EXPECT_EQ("setup", toString(record.frame));
+    auto previous = record.offset;
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(FrameDirection::OUTBOUND, record.direction);
+    EXPECT_EQ("payload", toString(record.frame));
+    EXPECT_GE(record.offset, previous);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_TRUE(record.frame.empty());
+    EXPECT_FALSE(reader.next(record));
+    reader.rewind();
+  }
+}
+
+TEST(FrameCaptureTest, WritesFromSeveralThreads) {
+  folly::test::TemporaryFile file;
+  FrameCaptureWriter writer(file.path().string());
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&writer, i] {
+      auto frame = folly::IOBuf::copyBuffer(std::string(i + 1, 'x'));
+      for (int j = 0; j < 1000; ++j) {
+        writer.write(FrameDirection::OUTBOUND, *frame);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  writer.flush();
+
+  FrameCaptureReader reader(file.path().string());
+  FrameCaptureReader::Record record;
+  std::vector<int> frames(4);
+  while (reader.next(record)) {
+    ASSERT_EQ(std::string(record.frame.size(), 'x'), toString(record.frame));
+    ++frames.at(record.frame.size() - 1);
+  }
+  EXPECT_EQ(std::vector<int>(4, 1000), frames);
+  EXPECT_EQ(0u, writer.dropped());
+}
+
+TEST(FrameCaptureTest, DropsFramesOverTheQueueLimit) {
+  folly::test::TemporaryFile file;
+  {
+    FrameCaptureWriter writer(file.path().string(), 10);
+    // the frame can never be queued, the others always fit
+    writer.write(FrameDirection::INBOUND, *folly::IOBuf::copyBuffer("first"));
+    writer.write(
+        FrameDirection::INBOUND, *folly::IOBuf::copyBuffer("too long frame"));
+    writer.flush();
+    writer.write(FrameDirection::INBOUND, *folly::IOBuf::copyBuffer("last"));
+    EXPECT_EQ(1u, writer.dropped());
+  }
+
+  FrameCaptureReader reader(file.path().string());
+  FrameCaptureReader::Record record;
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ("first", toString(record.frame));
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ("last", toString(record.frame));
+  EXPECT_FALSE(reader.next(record));
+}
+
+TEST(FrameCaptureTest, RejectsOtherFiles) {
+  folly::test::TemporaryFile file;
+  folly::writeFull(file.fd(), "not a capture", 13);
+  EXPECT_THROW(
+      FrameCaptureReader(file.path().string()), std::runtime_error);
+}
+
+TEST(FrameCaptureTest, CapturesBothDirections) {
+  /// Collects the frames it receives.
+  class CollectingSubscriber
+      : public Subscriber<std::unique_ptr<folly::IOBuf>> {
+   public:
+    void onSubscribe(std::shared_ptr<Subscription>) noexcept override {}
+    void onNext(std::unique_ptr<folly::IOBuf> frame) noexcept override {
+      frames.push_back(frame->moveToFbString().toStdString());
+    }
+    void onComplete() noexcept override {}
+    void onError(folly::exception_wrapper) noexcept override {}
+
+    std::vector<std::string> frames;
+  };
+
+  /// Keeps the input and collects the output.
+  class FakeConnection : public DuplexConnection {
+   public:
+    void setInput(std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
+                      framesSink) override {
+      input = std::move(framesSink);
+    }
+    std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> getOutput()
+        override {
+      return output;
+    }
+
+    std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> input;
+    std::shared_ptr<CollectingSubscriber> output{
+        std::make_shared<CollectingSubscriber>()};
+  };
+
+  folly::test::TemporaryFile file;
+  auto writer = std::make_shared<FrameCaptureWriter>(file.path().string());
+  auto fake = std::make_unique<FakeConnection>();
+  auto& inner = *fake;
+  CapturingDuplexConnection connection(std::move(fake), writer);
+
+  auto input = std::make_shared<CollectingSubscriber>();
+  connection.setInput(input);
+  connection.getOutput()->onNext(folly::IOBuf::copyBuffer("request"));
+  inner.input->onNext(folly::IOBuf::copyBuffer("response"));
+  inner.input->onComplete();
+
+  EXPECT_EQ(std::vector<std::string>{"request"}, inner.output->frames);
+  EXPECT_EQ(std::vector<std::string>{"response"}, input->frames);
+
+  writer->flush();
+  FrameCaptureReader reader(file.path().string());
+  FrameCaptureReader::Record record;
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ(FrameDirection::OUTBOUND, record.direction);
+  EXPECT_EQ("request", toString(record.frame));
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ(FrameDirection::INBOUND, record.direction);
+  EXPECT_EQ("response", toString(record.frame));
+  EXPECT_FALSE(reader.next(record));
+}
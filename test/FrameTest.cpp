@@ -7,6 +7,7 @@
 
 #include "src/Frame.h"
 #include "src/FrameSerializer.h"
+#include "src/versions/FrameSerializer_v1_0.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -233,6 +234,14 @@ TEST(FrameTest, Frame_LEASE) {
   EXPECT_EQ(numberOfRequests, frame.numberOfRequests_);
 }
 
+TEST(FrameTest, Frame_LEASE_NoRequests) {
+  auto frame = reserialize<Frame_LEASE>(Frame_LEASE::kMaxTtl, 0u);
+
+  expectHeader(FrameType::LEASE, FrameFlags::EMPTY, 0, frame);
+  EXPECT_EQ(Frame_LEASE::kMaxTtl, frame.ttl_);
+  EXPECT_EQ(0u, frame.numberOfRequests_);
+}
+
 TEST(FrameTest, Frame_REQUEST_RESPONSE) {
   uint32_t streamId = 42;
   FrameFlags flags = FrameFlags::METADATA;
@@ -300,3 +309,82 @@ TEST(FrameTest, Frame_RESUME_OK) {
   expectHeader(FrameType::RESUME_OK, flags, 0, frame);
   EXPECT_EQ(position, frame.position_);
 }
+
+TEST(FrameTest, PeekFrameHeader) {
+  for (auto version : {ProtocolVersion(0, 0),
+                       ProtocolVersion(0, 1),
+                       ProtocolVersion(1, 0)}) {
+    auto frameSerializer = FrameSerializer::createFrameSerializer(version);
+    ASSERT_TRUE(frameSerializer);
+    auto serialized = frameSerializer->serializeOut(Frame_PAYLOAD(
+        42, FrameFlags::NEXT | FrameFlags::COMPLETE, Payload("data")));
+
+    FrameHeader header;
+    ASSERT_TRUE(frameSerializer->peekFrameHeader(*serialized, header));
+    EXPECT_EQ(FrameType::PAYLOAD, header.type_);
+    EXPECT_EQ(FrameFlags::NEXT | FrameFlags::COMPLETE, header.flags_);
+    EXPECT_EQ(42, header.streamId_);
+
+    // the header split across the buffers of a chain
+    auto coalesced = serialized->cloneCoalesced();
+    auto chained = folly::IOBuf::copyBuffer(coalesced->data(), 3);
+    chained->prependChain(folly::IOBuf::copyBuffer(
+        coalesced->data() + 3, coalesced->length() - 3));
+    FrameHeader chainedHeader;
+    ASSERT_TRUE(frameSerializer->peekFrameHeader(*chained, chainedHeader));
+    EXPECT_EQ(header.type_, chainedHeader.type_);
+    EXPECT_EQ(header.flags_, chainedHeader.flags_);
+    EXPECT_EQ(header.streamId_, chainedHeader.streamId_);
+
+    FrameHeader truncatedHeader;
+    EXPECT_FALSE(frameSerializer->peekFrameHeader(
+        *folly::IOBuf::copyBuffer(coalesced->data(), 3), truncatedHeader));
+  }
+}
+
+TEST(FrameTest, PayloadFrameView) {
+  FrameSerializerV1_0 frameSerializer;
+  auto serialized = frameSerializer.serializeOut(Frame_PAYLOAD(
+      42, FrameFlags::NEXT, Payload("data", "metadata")))->cloneCoalesced();
+  const auto frameStart = serialized->data();
+
+  PayloadFrameView view;
+  ASSERT_TRUE(frameSerializer.deserializeFrom(view, serialized->clone()));
+  EXPECT_EQ(FrameType::PAYLOAD, view.header_.type_);
+  EXPECT_EQ(42, view.header_.streamId_);
+  EXPECT_TRUE(view.header_.flagsNext());
+  ASSERT_TRUE(view.hasMetadata());
+  EXPECT_EQ(8, view.metadataLength_);
+  EXPECT_EQ(4, view.dataLength_);
+
+  auto payload = view.takePayload();
+  EXPECT_EQ("metadata", payload.metadata->cloneAsValue().moveToFbString());
+  EXPECT_EQ("data", payload.cloneDataToString());
+  // the data is the received buffer, trimmed
+  EXPECT_EQ(frameStart + view.dataOffset_, payload.data->data());
+
+  // metadata and data spread over a chain
+  auto chained = folly::IOBuf::copyBuffer(serialized->data(), 12);
+  chained->prependChain(folly::IOBuf::copyBuffer(
+      serialized->data() + 12, serialized->length() - 12));
+  PayloadFrameView chainedView;
+  ASSERT_TRUE(frameSerializer.deserializeFrom(chainedView, std::move(chained)));
+  auto chainedPayload = chainedView.takePayload();
+  EXPECT_EQ(
+      "metadata", chainedPayload.metadata->cloneAsValue().moveToFbString());
+  EXPECT_EQ("data", chainedPayload.cloneDataToString());
+
+  // neither metadata nor data
+  PayloadFrameView emptyView;
+  ASSERT_TRUE(frameSerializer.deserializeFrom(
+      emptyView, frameSerializer.serializeOut(Frame_PAYLOAD::complete(42))));
+  EXPECT_FALSE(emptyView.hasMetadata());
+  auto emptyPayload = emptyView.takePayload();
+  EXPECT_FALSE(emptyPayload.metadata);
+  EXPECT_FALSE(emptyPayload.data);
+
+  // metadata longer than the frame
+  PayloadFrameView truncatedView;
+  EXPECT_FALSE(frameSerializer.deserializeFrom(
+      truncatedView, folly::IOBuf::copyBuffer(serialized->data(), 12)));
+}
@@ -0,0 +1,95 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "src/FrameCapture.h"
+#include "src/FrameTrace.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+namespace {
+/// Collects the records it receives.
+class CollectingSink : public FrameTraceSink {
+ public:
+  struct Collected {
+    FrameDirection direction;
+    FrameHeader header;
+    size_t length;
+    std::string prefix;
+  };
+
+  void onFrame(const FrameTraceRecord& record) override {
+    records.push_back(
+        {record.direction,
+         record.header,
+         record.length,
+         std::string(
+             reinterpret_cast<const char*>(record.prefix.data()),
+             record.prefix.size())});
+  }
+
+  std::vector<Collected> records;
+};
+
+class FrameTraceTest : public Test {
+ protected:
+  FrameTraceTest() : sink_(std::make_shared<CollectingSink>()) {
+    setFrameTraceSink(sink_);
+  }
+
+  ~FrameTraceTest() {
+    FLAGS_rs_frame_trace_sampling = 0;
+    setFrameTraceSink(nullptr);
+  }
+
+  std::shared_ptr<CollectingSink> sink_;
+};
+}
+
+TEST_F(FrameTraceTest, OffByDefault) {
+  auto frame = folly::IOBuf::copyBuffer("frame");
+  traceFrame(
+      FrameDirection::INBOUND,
+      FrameHeader(FrameType::PAYLOAD, FrameFlags::NEXT, 1),
+      *frame);
+  EXPECT_TRUE(sink_->records.empty());
+}
+
+TEST_F(FrameTraceTest, SamplesFrames) {
+  FLAGS_rs_frame_trace_sampling = 3;
+  auto frame = folly::IOBuf::copyBuffer("frame");
+  for (StreamId streamId = 1; streamId <= 9; ++streamId) {
+    traceFrame(
+        FrameDirection::OUTBOUND,
+        FrameHeader(FrameType::PAYLOAD, FrameFlags::NEXT, streamId),
+        *frame);
+  }
+
+  ASSERT_EQ(3u, sink_->records.size());
+  for (const auto& record : sink_->records) {
+    EXPECT_EQ(FrameDirection::OUTBOUND, record.direction);
+    EXPECT_EQ(FrameType::PAYLOAD, record.header.type_);
+    EXPECT_EQ(0u, record.header.streamId_ % 3);
+    EXPECT_EQ(5u, record.length);
+    EXPECT_EQ("frame", record.prefix);
+  }
+}
+
+TEST_F(FrameTraceTest, PrefixOfLargeFrames) {
+  FLAGS_rs_frame_trace_sampling = 1;
+  auto frame = folly::IOBuf::copyBuffer(std::string(100, 'a'));
+  frame->prependChain(folly::IOBuf::copyBuffer("tail"));
+  traceFrame(
+      FrameDirection::INBOUND,
+      FrameHeader(FrameType::PAYLOAD, FrameFlags::NEXT, 1),
+      *frame);
+
+  ASSERT_EQ(1u, sink_->records.size());
+  EXPECT_EQ(104u, sink_->records[0].length);
+  EXPECT_EQ(
+      std::string(FrameTraceRecord::kMaxPrefix, 'a'),
+      sink_->records[0].prefix);
+}
@@ -1,13 +1,54 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <folly/io/IOBuf.h>
+#include "src/DuplexConnection.h"
+#include "src/FrameProcessor.h"
 #include "src/FrameTransport.h"
+#include "src/MemoryAccountant.h"
 #include "src/NullRequestHandler.h"
 #include "test/InlineConnection.h"
+#include "test/MockStats.h"
+#include "test/streams/Mocks.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
 
+namespace {
+/// Hands the demand of its input and the frames written to it to mocks.
+class MockedDuplexConnection : public DuplexConnection {
+ public:
+  void setInput(std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>>
+                    framesSink) override {
+    input = std::move(framesSink);
+    input->onSubscribe(inputSubscription);
+  }
+
+  std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> getOutput()
+      override {
+    return output;
+  }
+
+  std::shared_ptr<Subscriber<std::unique_ptr<folly::IOBuf>>> input;
+  const std::shared_ptr<StrictMock<MockSubscription>> inputSubscription{
+      std::make_shared<StrictMock<MockSubscription>>()};
+  const std::shared_ptr<NiceMock<MockSubscriber<std::unique_ptr<folly::IOBuf>>>>
+      output{std::make_shared<
+          NiceMock<MockSubscriber<std::unique_ptr<folly::IOBuf>>>>()};
+};
+
+class CountingFrameProcessor : public FrameProcessor {
+ public:
+  void processFrame(std::unique_ptr<folly::IOBuf>) override {
+    ++frames;
+  }
+  void onTerminal(folly::exception_wrapper) override {}
+
+  size_t frames{0};
+};
+}
+
 TEST(FrameTransportTest, OnSubscribeAfterClose) {
   class NullSubscription : public reactivesocket::Subscription {
    public:
@@ -22,3 +63,43 @@ TEST(FrameTransportTest, OnSubscribeAfterClose) {
       .onSubscribe(std::make_shared<NullSubscription>());
   // if we got here, we passed all the checks in the onSubscribe method
 }
+
+TEST(FrameTransportTest, ReadsPauseAndResumeWithMemory) {
+  auto connection = std::make_unique<MockedDuplexConnection>();
+  auto& mocked = *connection;
+  MemoryLimits limits;
+  limits.connectionBytes = 100;
+  auto accountant = std::make_shared<MemoryAccountant>(
+      limits, std::make_shared<NiceMock<MockStats>>());
+  auto processor = std::make_shared<CountingFrameProcessor>();
+
+  auto transport = std::make_shared<FrameTransport>(std::move(connection));
+  transport->setMemoryAccountant(accountant);
+
+  EXPECT_CALL(*mocked.inputSubscription, request_(256));
+  transport->setFrameProcessor(processor);
+  Mock::VerifyAndClearExpectations(mocked.inputSubscription.get());
+
+  // the output does not accept writes yet, the frame fills the memory cap
+  transport->outputFrameOrEnqueue(
+      folly::IOBuf::copyBuffer(std::string(100, 'x')));
+  EXPECT_EQ(100, accountant->used());
+
+  // so the demand is not topped up as the frames are read
+  EXPECT_CALL(*mocked.inputSubscription, request_(_)).Times(0);
+  for (int i = 0; i < 200; ++i) {
+    mocked.input->onNext(folly::IOBuf::copyBuffer("frame"));
+  }
+  EXPECT_EQ(200, processor->frames);
+  Mock::VerifyAndClearExpectations(mocked.inputSubscription.get());
+
+  // until the frame has been written
+  EXPECT_CALL(*mocked.output, onNext_(_));
+  EXPECT_CALL(*mocked.inputSubscription, request_(200));
+  mocked.output->subscription()->request(1);
+  EXPECT_EQ(0, accountant->used());
+  Mock::VerifyAndClearExpectations(mocked.inputSubscription.get());
+
+  EXPECT_CALL(*mocked.inputSubscription, cancel_());
+  transport->close(folly::exception_wrapper());
+}
@@ -0,0 +1,93 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "src/HdrHistogram.h"
+#include "src/HistogramStats.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+TEST(HdrHistogramTest, BucketsPreserveRelativePrecision) {
+  for (uint64_t value : std::vector<uint64_t>{0,
+                                              1,
+                                              31,
+                                              32,
+                                              33,
+                                              1000,
+                                              123456789,
+                                              HdrHistogram::kMaxValue}) {
+    auto bucket = HdrHistogram::bucketOf(value);
+    ASSERT_LT(bucket, size_t(HdrHistogram::kBuckets));
+    auto highest = HdrHistogram::highestEquivalentValue(bucket);
+    EXPECT_GE(highest, value);
+    EXPECT_LE(highest - value, value / HdrHistogram::kSubBuckets);
+  }
+  EXPECT_EQ(
+      HdrHistogram::kBuckets - 1,
+      HdrHistogram::bucketOf(HdrHistogram::kMaxValue + 1));
+}
+
+TEST(HdrHistogramTest, Percentiles) {
+  HdrHistogram histogram;
+  EXPECT_EQ(0, histogram.percentile(50));
+
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(1000, histogram.count());
+  EXPECT_NEAR(500, histogram.percentile(50), 500 / HdrHistogram::kSubBuckets);
+  EXPECT_NEAR(990, histogram.percentile(99), 990 / HdrHistogram::kSubBuckets);
+  EXPECT_NEAR(
+      1000, histogram.percentile(99.9), 1000 / HdrHistogram::kSubBuckets);
+
+  HdrHistogram merged;
+  merged.merge(histogram);
+  merged.merge(histogram);
+  EXPECT_EQ(2000, merged.count());
+  EXPECT_EQ(histogram.percentile(50), merged.percentile(50));
+}
+
+TEST(HistogramStatsTest, AggregatesAcrossThreads) {
+  HistogramStats stats;
+  const auto issued = Stats::Clock::now();
+  const auto latency = std::chrono::microseconds(100);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        stats.requestIssued(StreamType::REQUEST_RESPONSE, issued);
+        stats.responseDelivered(
+            StreamType::REQUEST_RESPONSE, issued, issued + latency);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // The exited threads' counts are retired, add some live ones too.
+  stats.responseDelivered(StreamType::STREAM, issued, issued + latency);
+  stats.executorQueueingDelay(std::chrono::nanoseconds(10));
+
+  EXPECT_EQ(400, stats.requestsIssued(StreamType::REQUEST_RESPONSE));
+  EXPECT_EQ(0, stats.requestsIssued(StreamType::STREAM));
+
+  auto summary = stats.latency(
+      StreamType::REQUEST_RESPONSE, HistogramStats::Latency::DELIVERED);
+  EXPECT_EQ(400, summary.count);
+  EXPECT_GE(summary.p50, latency);
+  EXPECT_LE(summary.p999, latency * 33 / 32);
+
+  EXPECT_EQ(
+      1,
+      stats.latency(StreamType::STREAM, HistogramStats::Latency::DELIVERED)
+          .count);
+  EXPECT_EQ(
+      0,
+      stats.latency(StreamType::STREAM, HistogramStats::Latency::WRITTEN)
+          .count);
+  EXPECT_EQ(1, stats.queueingDelay().count);
+  EXPECT_EQ(std::chrono::nanoseconds(10), stats.queueingDelay().p50);
+}
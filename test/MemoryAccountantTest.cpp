@@ -0,0 +1,75 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/MemoryAccountant.h"
+#include "test/MockStats.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+TEST(MemoryAccountantTest, ChargeAndRelease) {
+  auto stats = std::make_shared<StrictMock<MockStats>>();
+  MemoryAccountant accountant(MemoryLimits(), stats);
+
+  EXPECT_CALL(*stats, bufferedBytesChanged(MemoryBuffer::PENDING_WRITES, 10));
+  accountant.charge(MemoryBuffer::PENDING_WRITES, 10);
+  EXPECT_CALL(*stats, bufferedBytesChanged(MemoryBuffer::STREAM_OUTPUT, 5));
+  accountant.charge(MemoryBuffer::STREAM_OUTPUT, 5);
+  EXPECT_EQ(15, accountant.used());
+  EXPECT_EQ(10, accountant.used(MemoryBuffer::PENDING_WRITES));
+  EXPECT_EQ(0, accountant.used(MemoryBuffer::PENDING_READS));
+
+  EXPECT_CALL(*stats, bufferedBytesChanged(MemoryBuffer::PENDING_WRITES, -4));
+  accountant.release(MemoryBuffer::PENDING_WRITES, 4);
+  EXPECT_EQ(11, accountant.used());
+
+  // no caps
+  EXPECT_FALSE(accountant.shouldPauseReads());
+  EXPECT_FALSE(accountant.exceedsStreamCap(1 << 30));
+}
+
+TEST(MemoryAccountantTest, PausesReadsUntilHalfOfTheCap) {
+  auto stats = std::make_shared<NiceMock<MockStats>>();
+  MemoryLimits limits;
+  limits.connectionBytes = 100;
+  MemoryAccountant accountant(limits, stats);
+
+  accountant.charge(MemoryBuffer::PENDING_WRITES, 99);
+  EXPECT_FALSE(accountant.shouldPauseReads());
+
+  EXPECT_CALL(*stats, readsPaused(true));
+  accountant.charge(MemoryBuffer::PENDING_READS, 1);
+  EXPECT_TRUE(accountant.shouldPauseReads());
+  EXPECT_TRUE(accountant.shouldPauseReads());
+
+  accountant.release(MemoryBuffer::PENDING_WRITES, 50);
+  EXPECT_TRUE(accountant.shouldPauseReads());
+
+  EXPECT_CALL(*stats, readsPaused(false));
+  accountant.release(MemoryBuffer::PENDING_WRITES, 1);
+  EXPECT_FALSE(accountant.shouldPauseReads());
+}
+
+TEST(MemoryAccountantTest, StreamCap) {
+  MemoryLimits limits;
+  limits.streamBytes = 64;
+  MemoryAccountant accountant(limits, std::make_shared<NiceMock<MockStats>>());
+  EXPECT_FALSE(accountant.exceedsStreamCap(64));
+  EXPECT_TRUE(accountant.exceedsStreamCap(65));
+}
+
+TEST(MemoryAccountantTest, FrameCap) {
+  MemoryLimits limits;
+  limits.connectionBytes = 100;
+  MemoryAccountant accountant(limits, std::make_shared<NiceMock<MockStats>>());
+  EXPECT_FALSE(accountant.exceedsFrameCap(100));
+  EXPECT_TRUE(accountant.exceedsFrameCap(101));
+
+  limits.streamBytes = 64;
+  MemoryAccountant streamAccountant(
+      limits, std::make_shared<NiceMock<MockStats>>());
+  EXPECT_FALSE(streamAccountant.exceedsFrameCap(64));
+  EXPECT_TRUE(streamAccountant.exceedsFrameCap(65));
+}
@@ -30,7 +30,7 @@ class MockRequestHandler : public RequestHandler {
       void(
           Payload& request,
           StreamId streamId,
-          const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>&));
+          const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&));
   MOCK_METHOD2(
       handleFireAndForgetRequest_,
       void(Payload& request, StreamId streamId));
@@ -63,7 +63,8 @@ class MockRequestHandler : public RequestHandler {
   void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) noexcept override {
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          response) noexcept override {
     handleRequestResponse_(request, streamId, response);
   }
 
@@ -31,5 +31,8 @@ class MockStats : public Stats {
   MOCK_METHOD1(frameRead, void(FrameType));
   MOCK_METHOD2(resumeBufferChanged, void(int, int));
   MOCK_METHOD2(streamBufferChanged, void(int64_t, int64_t));
+  MOCK_METHOD2(bufferedBytesChanged, void(MemoryBuffer, int64_t));
+  MOCK_METHOD1(readsPaused, void(bool));
+  MOCK_METHOD0(streamMemoryCapExceeded, void());
 };
 }
@@ -0,0 +1,316 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+#include "src/CompositeMetadata.h"
+#include "src/Payload.h"
+#include "src/PayloadCompression.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+namespace {
+/// The codecs of the build, tests of the others pass vacuously.
+std::vector<CompressionCodec> supportedCodecs() {
+  std::vector<CompressionCodec> codecs;
+  for (auto codec : {CompressionCodec::ZSTD, CompressionCodec::LZ4}) {
+    if (PayloadCompression::isSupported(codec)) {
+      codecs.push_back(codec);
+    }
+  }
+  return codecs;
+}
+
+CompressionOptions options(CompressionCodec codec, size_t minSize = 1024) {
+  CompressionOptions options;
+  options.codecs = {codec};
+  options.minSize = minSize;
+  options.compositeMetadata = true;
+  return options;
+}
+
+/// Compresses with the codec right away, like the server does.
+std::unique_ptr<PayloadCompression> compressing(
+    CompressionCodec codec,
+    size_t minSize = 1024,
+    bool compositeMetadata = true) {
+  auto opts = options(codec, minSize);
+  opts.compositeMetadata = compositeMetadata;
+  auto compression = std::make_unique<PayloadCompression>(opts);
+  compression->setCodec(PayloadCompression::choose(opts.codecs));
+  return compression;
+}
+
+std::string compressible(size_t length) {
+  std::string data;
+  while (data.size() < length) {
+    data += "the same few words over and over ";
+  }
+  data.resize(length);
+  return data;
+}
+}
+
+TEST(PayloadCompressionTest, RoundTrip) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec);
+    EXPECT_EQ(codec, compression->codec());
+
+    const auto data = compressible(64 << 10);
+    Payload payload(data);
+    compression->compress(payload);
+    EXPECT_LT(payload.data->computeChainDataLength(), data.size() / 2);
+    ASSERT_TRUE(payload.metadata);
+
+    ASSERT_EQ(
+        PayloadCompression::Status::OK, compression->decompress(payload));
+    EXPECT_EQ(data, payload.moveDataToString());
+    EXPECT_FALSE(payload.metadata);
+  }
+}
+
+TEST(PayloadCompressionTest, HeaderPrecedesCompositeMetadata) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec, 1024, true);
+
+    const auto data = compressible(64 << 10);
+    auto metadata = CompositeMetadataBuilder().addRoute({"route"}).build();
+    Payload payload(folly::IOBuf::copyBuffer(data), metadata->clone());
+    compression->compress(payload);
+    EXPECT_LT(payload.data->computeChainDataLength(), data.size() / 2);
+
+    // the header is an entry like any other
+    std::string scratch;
+    EXPECT_EQ("route", readRoute(*payload.metadata, scratch).value());
+
+    ASSERT_EQ(
+        PayloadCompression::Status::OK, compression->decompress(payload));
+    EXPECT_EQ(data, payload.moveDataToString());
+    EXPECT_TRUE(folly::IOBufEqual()(metadata, payload.metadata));
+  }
+}
+
+TEST(PayloadCompressionTest, NothingIsCompressedWithoutCompositeMetadata) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec, 1024, false);
+
+    const auto data = compressible(64 << 10);
+    Payload payload(data, "metadata");
+    compression->compress(payload);
+    EXPECT_EQ(data.size(), payload.data->computeChainDataLength());
+    EXPECT_EQ("metadata", payload.metadata->cloneAsValue().moveToFbString());
+
+    Payload withoutMetadata(data);
+    compression->compress(withoutMetadata);
+    EXPECT_EQ(data.size(), withoutMetadata.data->computeChainDataLength());
+    EXPECT_FALSE(withoutMetadata.metadata);
+  }
+}
+
+TEST(PayloadCompressionTest, OtherMetadataAreNotTakenForAHeader) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compressor = compressing(codec);
+    auto receiver = compressing(codec, 1024, false);
+
+    // metadata of the application which happen to look like a header
+    Payload payload(compressible(64 << 10));
+    compressor->compress(payload);
+    const auto metadata = payload.metadata->cloneAsValue().moveToFbString();
+    const auto length = payload.data->computeChainDataLength();
+    ASSERT_EQ(PayloadCompression::Status::OK, receiver->decompress(payload));
+    EXPECT_EQ(length, payload.data->computeChainDataLength());
+    EXPECT_EQ(metadata, payload.metadata->moveToFbString());
+  }
+}
+
+TEST(PayloadCompressionTest, ShortDataAreSentAsIs) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec);
+
+    const auto data = compressible(1000);
+    Payload payload(data);
+    const auto buffer = payload.data.get();
+    compression->compress(payload);
+    // neither a header nor a copy
+    EXPECT_EQ(buffer, payload.data.get());
+    EXPECT_FALSE(payload.metadata);
+
+    ASSERT_EQ(
+        PayloadCompression::Status::OK, compression->decompress(payload));
+    EXPECT_EQ(data, payload.moveDataToString());
+  }
+}
+
+TEST(PayloadCompressionTest, IncompressibleDataAreSentAsIs) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec, 0);
+
+    std::string data;
+    for (int i = 0; i < 16; ++i) {
+      data.push_back(static_cast<char>(i * 37));
+    }
+    Payload payload(data);
+    compression->compress(payload);
+    EXPECT_EQ(data.size(), payload.data->computeChainDataLength());
+    EXPECT_FALSE(payload.metadata);
+
+    ASSERT_EQ(
+        PayloadCompression::Status::OK, compression->decompress(payload));
+    EXPECT_EQ(data, payload.moveDataToString());
+  }
+}
+
+TEST(PayloadCompressionTest, ChainedData) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec);
+
+    const auto data = compressible(8 << 10);
+    auto chain = folly::IOBuf::copyBuffer(data.substr(0, 100));
+    chain->prependChain(folly::IOBuf::copyBuffer(data.substr(100)));
+    Payload payload(std::move(chain));
+    compression->compress(payload);
+
+    ASSERT_EQ(
+        PayloadCompression::Status::OK, compression->decompress(payload));
+    EXPECT_EQ(data, payload.moveDataToString());
+  }
+}
+
+TEST(PayloadCompressionTest, CorruptDataAreRejected) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec);
+
+    Payload payload(compressible(64 << 10));
+    compression->compress(payload);
+    auto data = payload.moveDataToString();
+    data.resize(data.size() / 2);
+    Payload corrupt(
+        folly::IOBuf::copyBuffer(data), std::move(payload.metadata));
+    EXPECT_EQ(
+        PayloadCompression::Status::CORRUPT,
+        compression->decompress(corrupt));
+  }
+
+  // codec 200, 4 bytes long
+  auto header = folly::IOBuf::copyBuffer(std::string("\xC8\0\0\0\4", 5));
+  Payload unknownCodec(
+      folly::IOBuf::copyBuffer("data"),
+      CompositeMetadataBuilder()
+          .add(kCompressionMimeType, std::move(header))
+          .build());
+  CompressionOptions compositeMetadata;
+  compositeMetadata.compositeMetadata = true;
+  PayloadCompression compression(compositeMetadata);
+  EXPECT_EQ(
+      PayloadCompression::Status::CORRUPT,
+      compression.decompress(unknownCodec));
+}
+
+TEST(PayloadCompressionTest, DataTooLargeAreNotDecompressed) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    auto compression = compressing(codec);
+    auto opts = options(codec);
+    opts.maxUncompressedSize = 32 << 10;
+    PayloadCompression receiver(opts);
+
+    Payload payload(compressible(32 << 10));
+    compression->compress(payload);
+    EXPECT_EQ(PayloadCompression::Status::OK, receiver.decompress(payload));
+    EXPECT_EQ(32u << 10, payload.data->computeChainDataLength());
+
+    payload = Payload(compressible((32 << 10) + 1));
+    compression->compress(payload);
+    const auto compressedLength = payload.data->computeChainDataLength();
+    EXPECT_EQ(
+        PayloadCompression::Status::TOO_LARGE, receiver.decompress(payload));
+    EXPECT_EQ(compressedLength, payload.data->computeChainDataLength());
+  }
+}
+
+TEST(PayloadCompressionTest, ClientCompressesOnceConfirmed) {
+  for (auto codec : supportedCodecs()) {
+    SCOPED_TRACE(to_string(codec));
+    PayloadCompression compression(options(codec));
+    EXPECT_EQ(CompressionCodec::NONE, compression.codec());
+
+    const auto data = compressible(4096);
+    Payload payload(data);
+    compression.compress(payload);
+    EXPECT_EQ(data.size(), payload.data->computeChainDataLength());
+
+    EXPECT_TRUE(compression.takeConfirmation(
+        *PayloadCompression::confirmation(codec)));
+    EXPECT_EQ(codec, compression.codec());
+    compression.compress(payload);
+    EXPECT_LT(payload.data->computeChainDataLength(), data.size() / 2);
+  }
+}
+
+TEST(PayloadCompressionTest, ConfirmationOfCodecNotOfferedIsIgnored) {
+  PayloadCompression compression(options(CompressionCodec::ZSTD));
+  EXPECT_TRUE(compression.takeConfirmation(
+      *PayloadCompression::confirmation(CompressionCodec::LZ4)));
+  EXPECT_EQ(CompressionCodec::NONE, compression.codec());
+
+  // metadata of the application are not taken for a confirmation
+  EXPECT_FALSE(
+      compression.takeConfirmation(*folly::IOBuf::copyBuffer("metadata")));
+}
+
+TEST(PayloadCompressionTest, UnsupportedCodecsAreNotChosen) {
+  EXPECT_EQ(
+      CompressionCodec::NONE,
+      PayloadCompression::choose({static_cast<CompressionCodec>(200)}));
+  for (auto codec : supportedCodecs()) {
+    EXPECT_EQ(
+        codec,
+        PayloadCompression::choose(
+            {static_cast<CompressionCodec>(200), CompressionCodec::NONE,
+             codec}));
+  }
+}
+
+TEST(PayloadCompressionTest, OfferRoundTrip) {
+  const auto codecs = supportedCodecs();
+  if (codecs.empty()) {
+    return;
+  }
+  Payload setup("data", "metadata");
+  PayloadCompression::attachOffer(codecs, setup);
+
+  EXPECT_EQ(codecs, PayloadCompression::takeOffer(setup));
+  EXPECT_EQ("metadata", setup.metadata->moveToFbString());
+}
+
+TEST(PayloadCompressionTest, OfferWithoutMetadata) {
+  const auto codecs = supportedCodecs();
+  if (codecs.empty()) {
+    return;
+  }
+  Payload setup(folly::IOBuf::copyBuffer("data"));
+  PayloadCompression::attachOffer(codecs, setup);
+
+  EXPECT_EQ(codecs, PayloadCompression::takeOffer(setup));
+  EXPECT_FALSE(setup.metadata);
+}
+
+TEST(PayloadCompressionTest, NothingSupportedIsNotOffered) {
+  Payload setup("data", "metadata");
+  PayloadCompression::attachOffer({static_cast<CompressionCodec>(200)}, setup);
+  EXPECT_EQ("metadata", setup.metadata->cloneAsValue().moveToFbString());
+}
+
+TEST(PayloadCompressionTest, MetadataWithoutOffer) {
+  Payload setup("data", "metadata");
+  EXPECT_TRUE(PayloadCompression::takeOffer(setup).empty());
+  EXPECT_EQ("metadata", setup.metadata->moveToFbString());
+}
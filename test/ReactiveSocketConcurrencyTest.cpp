@@ -18,6 +18,7 @@
 #include "test/InlineConnection.h"
 #include "test/MockRequestHandler.h"
 #include "test/streams/Mocks.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -57,14 +58,6 @@ class ClientSideConcurrencyTest : public testing::Test {
     serverSock = ReactiveSocket::fromServerConnection(
         defaultExecutor(), std::move(serverConn), std::move(serverHandler));
 
-    EXPECT_CALL(*clientInput, onSubscribe_(_))
-        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
-          clientInputSub = sub;
-          // request is called from the thread1
-          // but delivered on thread2
-          thread1.getEventBase()->runInEventBaseThreadAndWait(
-              [&]() { sub->request(2); });
-        }));
     // The request reaches the other end and triggers new responder to be set
     // up.
     EXPECT_CALL(serverHandlerRef, handleRequestResponse_(_, _, _))
@@ -72,9 +65,11 @@ class ClientSideConcurrencyTest : public testing::Test {
         .WillOnce(Invoke(
             [&](Payload& request,
                 StreamId streamId,
-                yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response) {
-              serverOutput = response;
-              serverOutput->onSubscribe(serverOutputSub);
+                yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                    response) {
+              response->onSubscribe(
+                  yarpl::single::SingleSubscriptions::empty());
+              response->onSuccess(Payload(originalPayload()));
             }));
     EXPECT_CALL(serverHandlerRef, handleRequestStream_(_, _, _))
         .Times(AtMost(1))
@@ -114,6 +109,17 @@ class ClientSideConcurrencyTest : public testing::Test {
 
               return serverInput;
             }));
+  }
+
+  void expectFlowableInteraction() {
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+          clientInputSub = sub;
+          // request is called from the thread1
+          // but delivered on thread2
+          thread1.getEventBase()->runInEventBaseThreadAndWait(
+              [&]() { sub->request(2); });
+        }));
 
     EXPECT_CALL(*serverOutputSub, request_(_))
         // The server delivers them immediately.
@@ -195,14 +201,23 @@ class ClientSideConcurrencyTest : public testing::Test {
 };
 
 TEST_F(ClientSideConcurrencyTest, DISABLED_RequestResponseTest) {
+  auto clientSingleInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  EXPECT_CALL(*clientSingleInput, onSubscribe_(_));
+  EXPECT_CALL(*clientSingleInput, onSuccess_(_)).WillOnce(Invoke([&](Payload&) {
+    EXPECT_TRUE(thread2.getEventBase()->isInEventBaseThread());
+    done();
+  }));
+
   thread2.getEventBase()->runInEventBaseThread([&] {
-    clientSock->requestResponse(Payload(originalPayload()), clientInput);
+    clientSock->requestResponse(Payload(originalPayload()), clientSingleInput);
   });
   wainUntilDone();
   LOG(INFO) << "test done";
 }
 
 TEST_F(ClientSideConcurrencyTest, DISABLED_RequestStreamTest) {
+  expectFlowableInteraction();
   thread2.getEventBase()->runInEventBaseThread([&] {
     clientSock->requestStream(Payload(originalPayload()), clientInput);
   });
@@ -211,6 +226,7 @@ TEST_F(ClientSideConcurrencyTest, DISABLED_RequestStreamTest) {
 
 TEST_F(ClientSideConcurrencyTest, DISABLED_RequestChannelTest) {
   clientTerminatesInteraction_ = false;
+  expectFlowableInteraction();
 
   yarpl::Reference<yarpl::flowable::Subscriber<Payload>> clientOutput;
   thread2.getEventBase()->runInEventBaseThreadAndWait([&clientOutput, this] {
@@ -269,11 +285,6 @@ class ServerSideConcurrencyTest : public testing::Test {
           SocketParameters(false, ProtocolVersion::Unknown));
     });
 
-    EXPECT_CALL(*clientInput, onSubscribe_(_))
-        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
-          clientInputSub = sub;
-          sub->request(3);
-        }));
     // The request reaches the other end and triggers new responder to be set
     // up.
     EXPECT_CALL(serverHandlerRef, handleRequestResponse_(_, _, _))
@@ -281,9 +292,14 @@ class ServerSideConcurrencyTest : public testing::Test {
         .WillOnce(Invoke(
             [&](Payload& request,
                 StreamId streamId,
-                const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) {
-              serverOutput = response;
-              serverOutput->onSubscribe(serverOutputSub);
+                const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+                    response) {
+              response->onSubscribe(
+                  yarpl::single::SingleSubscriptions::empty());
+              // the response is produced on thread1 but delivered on thread2
+              thread1.getEventBase()->runInEventBaseThreadAndWait([&]() {
+                response->onSuccess(Payload(originalPayload()));
+              });
             }));
     EXPECT_CALL(serverHandlerRef, handleRequestStream_(_, _, _))
         .Times(AtMost(1))
@@ -322,6 +338,14 @@ class ServerSideConcurrencyTest : public testing::Test {
 
               return serverInput;
             }));
+  }
+
+  void expectFlowableInteraction() {
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+          clientInputSub = sub;
+          sub->request(3);
+        }));
 
     EXPECT_CALL(*serverOutputSub, request_(_))
         // The server delivers them immediately.
@@ -412,18 +436,28 @@ class ServerSideConcurrencyTest : public testing::Test {
 
 // TODO(t17618830): please fix and enable
 TEST_F(ServerSideConcurrencyTest, DISABLED_RequestResponseTest) {
-  clientSock->requestResponse(Payload(originalPayload()), clientInput);
+  auto clientSingleInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  EXPECT_CALL(*clientSingleInput, onSubscribe_(_));
+  EXPECT_CALL(*clientSingleInput, onSuccess_(_)).WillOnce(Invoke([&](Payload&) {
+    EXPECT_TRUE(thread2.getEventBase()->isInEventBaseThread());
+    done();
+  }));
+
+  clientSock->requestResponse(Payload(originalPayload()), clientSingleInput);
   wainUntilDone();
 }
 
 // TODO(t17618830): please fix and enable
 TEST_F(ServerSideConcurrencyTest, DISABLED_RequestStreamTest) {
+  expectFlowableInteraction();
   clientSock->requestStream(Payload(originalPayload()), clientInput);
   wainUntilDone();
 }
 
 // TODO(t17618830): please fix and enable
 TEST_F(ServerSideConcurrencyTest, DISABLED_RequestChannelTest) {
+  expectFlowableInteraction();
   auto clientOutput = clientSock->requestChannel(clientInput);
 
   auto clientOutputSub = make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
@@ -506,18 +540,6 @@ class InitialRequestNDeliveredTest : public testing::Test {
                 response->onSubscribe(validatingSubscription);
               });
             }));
-    EXPECT_CALL(serverHandlerRef, handleRequestResponse_(_, _, _))
-        .Times(AtMost(1))
-        .WillOnce(Invoke(
-            [&](Payload& request,
-                StreamId streamId,
-                const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) {
-              thread2.getEventBase()->runInEventBaseThread([response, this] {
-                /* sleep override */ std::this_thread::sleep_for(
-                    std::chrono::milliseconds(5));
-                response->onSubscribe(validatingSubscription);
-              });
-            }));
 
     serverSocket = ReactiveSocket::fromServerConnection(
         eventBase_,
@@ -566,14 +588,6 @@ class InitialRequestNDeliveredTest : public testing::Test {
   FrameSerializerV0_1 frameSerializer;
 };
 
-TEST_F(InitialRequestNDeliveredTest, DISABLED_RequestResponse) {
-  expectedRequestN = 1;
-  Frame_REQUEST_RESPONSE requestFrame(kStreamId, FrameFlags::EMPTY, Payload());
-  testConnectionSub->onNext(
-      frameSerializer.serializeOut(std::move(requestFrame)));
-  loopEventBaseUntilDone();
-}
-
 TEST_F(InitialRequestNDeliveredTest, DISABLED_RequestStream) {
   Frame_REQUEST_STREAM requestFrame(
       kStreamId, FrameFlags::EMPTY, kRequestN, Payload());
@@ -48,14 +48,11 @@ TEST(ReactiveSocketResumabilityTest, Disconnect) {
       ConnectionSetupPayload("", "", Payload(), true),
       stats);
 
-  auto responseSubscriber = make_ref<yarpl::flowable::MockSubscriber<Payload>>();
-  EXPECT_CALL(*responseSubscriber, onSubscribe_(_))
-      .Times(1)
-      .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> subscription) {
-        subscription->request(std::numeric_limits<size_t>::max());
-      }));
+  auto responseSubscriber =
+      make_ref<yarpl::single::MockSingleObserver<Payload>>();
+  EXPECT_CALL(*responseSubscriber, onSubscribe_(_)).Times(1);
 
-  EXPECT_CALL(*responseSubscriber, onComplete_()).Times(0);
+  EXPECT_CALL(*responseSubscriber, onSuccess_(_)).Times(0);
   EXPECT_CALL(*responseSubscriber, onError_(_)).Times(0);
 
   socket->requestResponse(Payload(), responseSubscriber);
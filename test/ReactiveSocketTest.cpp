@@ -1,6 +1,7 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
 #include <folly/Baton.h>
+#include <folly/Conv.h>
 #include <folly/Memory.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
@@ -10,6 +11,7 @@
 #include <array>
 #include <chrono>
 #include <thread>
+#include "src/CompositeMetadata.h"
 #include "src/FrameTransport.h"
 #include "src/NullRequestHandler.h"
 #include "src/ReactiveSocket.h"
@@ -19,6 +21,8 @@
 #include "test/MockRequestHandler.h"
 #include "test/MockStats.h"
 #include "streams/Mocks.h"
+#include "yarpl/single/SingleObservers.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -447,6 +451,81 @@ auto clientSock = ReactiveSocket::fromClientConnection(
   clientSock->requestStream(Payload(originalPayload->clone()), clientInput);
 }
 
+TEST(ReactiveSocketTest, RequestStreamFlowControlSnapshot) {
+  auto clientConn = std::make_unique<InlineConnection>();
+  auto serverConn = std::make_unique<InlineConnection>();
+  clientConn->connectTo(*serverConn);
+
+  auto clientInput =
+      make_ref<NiceMock<yarpl::flowable::MockSubscriber<Payload>>>();
+  auto serverOutputSub =
+      make_ref<NiceMock<yarpl::flowable::MockSubscription>>();
+  yarpl::Reference<yarpl::flowable::Subscription> clientInputSub;
+  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> serverOutput;
+
+  auto clientSock = ReactiveSocket::fromClientConnection(
+      defaultExecutor(),
+      std::move(clientConn),
+      std::make_unique<NiceMock<MockRequestHandler>>(),
+      ConnectionSetupPayload("", "", Payload()));
+
+  auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+  EXPECT_CALL(*serverHandler, handleRequestStream_(_, _, _))
+      .WillOnce(Invoke(
+          [&](Payload&,
+              StreamId,
+              yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response) {
+            serverOutput = response;
+            serverOutput->onSubscribe(serverOutputSub);
+          }));
+  auto serverSock = ReactiveSocket::fromServerConnection(
+      defaultExecutor(), std::move(serverConn), std::move(serverHandler));
+
+  EXPECT_CALL(*clientInput, onSubscribe_(_))
+      .WillOnce(
+          Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+            clientInputSub = sub;
+            clientInputSub->request(3);
+          }));
+  clientSock->requestStream(Payload("foo"), clientInput);
+  ASSERT_TRUE(serverOutput);
+
+  serverOutput->onNext(Payload("bar"));
+
+  auto client = clientSock->flowControlSnapshot();
+  ASSERT_EQ(1, client.streams.size());
+  EXPECT_EQ(2, client.streams[0].inboundCredit);
+  EXPECT_EQ(0, client.streams[0].inboundCreditUnsent);
+  EXPECT_EQ(std::chrono::nanoseconds(0), client.streams[0].inboundStarved);
+  auto server = serverSock->flowControlSnapshot();
+  ASSERT_EQ(1, server.streams.size());
+  EXPECT_EQ(2, server.streams[0].outboundCredit);
+
+  // Use up all the credit.
+  serverOutput->onNext(Payload("bar"));
+  serverOutput->onNext(Payload("bar"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  client = clientSock->flowControlSnapshot();
+  EXPECT_EQ(0, client.streams[0].inboundCredit);
+  EXPECT_LE(std::chrono::milliseconds(1), client.streams[0].inboundStarved);
+  server = serverSock->flowControlSnapshot();
+  EXPECT_EQ(0, server.streams[0].outboundCredit);
+  EXPECT_LE(std::chrono::milliseconds(1), server.streams[0].outboundStarved);
+
+  // Replenishing the credit ends the starvation.
+  clientInputSub->request(1);
+  client = clientSock->flowControlSnapshot();
+  EXPECT_EQ(1, client.streams[0].inboundCredit);
+  auto starved = client.streams[0].inboundStarved;
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(
+      starved, clientSock->flowControlSnapshot().streams[0].inboundStarved);
+  EXPECT_EQ(1, serverSock->flowControlSnapshot().streams[0].outboundCredit);
+
+  clientInputSub->cancel();
+}
+
 TEST(ReactiveSocketTest, RequestStreamSendsOneRequest) {
   auto clientConn = std::make_unique<InlineConnection>();
   auto serverConn = std::make_unique<InlineConnection>();
@@ -599,10 +678,11 @@ TEST(ReactiveSocketTest, RequestResponse) {
   auto serverConn = std::make_unique<InlineConnection>();
   clientConn->connectTo(*serverConn);
 
-  auto clientInput = make_ref<StrictMock<yarpl::flowable::MockSubscriber<Payload>>>();
-  auto serverOutputSub = make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
-  yarpl::Reference<yarpl::flowable::Subscription> clientInputSub;
-  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> serverOutput;
+  auto clientInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  auto serverOutputSub =
+      make_ref<StrictMock<yarpl::single::MockSingleSubscription>>();
+  yarpl::Reference<yarpl::single::SingleObserver<Payload>> serverOutput;
 
 
   auto requestHandler = std::make_unique<StrictMock<MockRequestHandler>>();
@@ -629,14 +709,8 @@ TEST(ReactiveSocketTest, RequestResponse) {
 
   const auto originalPayload = folly::IOBuf::copyBuffer("foo");
 
-  // Client creates a subscription.
-  EXPECT_CALL(*clientInput, onSubscribe_(_))
-      .InSequence(s)
-      .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
-        clientInputSub = sub;
-        // Request payload immediately.
-        clientInputSub->request(1);
-      }));
+  // Client gets a subscription, the request is sent right after.
+  EXPECT_CALL(*clientInput, onSubscribe_(_)).InSequence(s);
 
   // The request reaches the other end and triggers new responder to be set up.
   EXPECT_CALL(
@@ -645,29 +719,18 @@ TEST(ReactiveSocketTest, RequestResponse) {
       .WillOnce(Invoke(
           [&](Payload& request,
               StreamId streamId,
-              yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response) {
+              yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                  response) {
             serverOutput = response;
             serverOutput->onSubscribe(serverOutputSub);
+            // The server delivers the response immediately.
+            serverOutput->onSuccess(Payload(originalPayload->clone()));
           }));
 
-  EXPECT_CALL(*serverOutputSub, request_(_))
-      .InSequence(s)
-      // The server deliver the response immediately.
-      .WillOnce(Invoke([&](size_t) {
-        serverOutput->onNext(Payload(originalPayload->clone()));
-      }));
-
-  // Client receives the only payload and closes the subscription in response.
-  EXPECT_CALL(*clientInput, onNext_(Equals(&originalPayload)))
-      .InSequence(s)
-      .WillOnce(Invoke([&](Payload&) { clientInputSub->cancel(); }));
-  // Client also receives onComplete() call since the response frame received
-  // had COMPELTE flag set
-  EXPECT_CALL(*clientInput, onComplete_()).InSequence(s);
-
-  EXPECT_CALL(*serverOutputSub, cancel_()).WillOnce(Invoke([&]() {
-    serverOutput->onComplete();
-  }));
+  // Client receives the only payload, no cancel or completion follows.
+  EXPECT_CALL(*clientInput, onSuccess_(Equals(&originalPayload)))
+      .InSequence(s);
+  EXPECT_CALL(*serverOutputSub, cancel_()).Times(0);
 
   // Kick off the magic.
   clientSock->requestResponse(Payload(originalPayload->clone()), clientInput);
@@ -706,18 +769,11 @@ TEST(ReactiveSocketTest, RequestResponseSendsOneRequest) {
 
   const auto originalPayload = folly::IOBuf::copyBuffer("foo");
 
-  auto responseSubscriber = make_ref<yarpl::flowable::MockSubscriber<Payload>>();
-  yarpl::Reference<yarpl::flowable::Subscription> clientInputSub;
-  EXPECT_CALL(*responseSubscriber, onSubscribe_(_))
-      .Times(1)
-      .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> subscription) {
-        clientInputSub = subscription;
-      }));
-  EXPECT_CALL(*testOutputSubscriber, onNext_(_)).Times(0);
-
-  socket->requestResponse(
-      Payload(originalPayload->clone()), responseSubscriber);
+  auto responseSubscriber =
+      make_ref<yarpl::single::MockSingleObserver<Payload>>();
+  EXPECT_CALL(*responseSubscriber, onSubscribe_(_)).Times(1);
 
+  // The only frame is sent on subscribe, no request(n) is needed.
   EXPECT_CALL(*testOutputSubscriber, onNext_(_))
       .Times(1)
       .WillOnce(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
@@ -730,13 +786,479 @@ TEST(ReactiveSocketTest, RequestResponseSendsOneRequest) {
         ASSERT_EQ("foo", request.payload_.moveDataToString());
       }));
 
-  clientInputSub->request(7);
+  socket->requestResponse(
+      Payload(originalPayload->clone()), responseSubscriber);
 
   socket->disconnect();
   socket->close();
   sub->onComplete();
 }
 
+TEST(ReactiveSocketTest, RequestResponseDeadline) {
+  folly::Baton<> clientError;
+  folly::Baton<> serverCancel;
+  folly::ScopedEventBaseThread th;
+  auto& eventBase = *th.getEventBase();
+
+  std::unique_ptr<ReactiveSocket> clientSock;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  auto clientInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  auto serverOutputSub =
+      make_ref<StrictMock<yarpl::single::MockSingleSubscription>>();
+  yarpl::Reference<yarpl::single::SingleObserver<Payload>> serverOutput;
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+
+    auto requestHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    clientSock = ReactiveSocket::fromClientConnection(
+        eventBase, std::move(clientConn), std::move(requestHandler));
+
+    auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+        .WillRepeatedly(Return(nullptr));
+    // The server gets the propagated deadline and never responds.
+    EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+        .WillOnce(Invoke(
+            [&](Payload& request,
+                StreamId,
+                yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                    response) {
+              auto deadline = RequestDeadline::takeFrom(request);
+              EXPECT_TRUE(deadline);
+              EXPECT_GT(deadline.remaining(), std::chrono::milliseconds(0));
+              EXPECT_EQ("meta", request.metadata->moveToFbString());
+              serverOutput = response;
+              serverOutput->onSubscribe(serverOutputSub);
+            }));
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(serverHandler));
+
+    EXPECT_CALL(*clientInput, onSubscribe_(_));
+    EXPECT_CALL(*clientInput, onError_(_))
+        .WillOnce(Invoke([&](std::exception_ptr ex) {
+          EXPECT_THROW(std::rethrow_exception(ex), DeadlineExceededException);
+          clientError.post();
+        }));
+    // The deadline cancels the request on the server.
+    EXPECT_CALL(*serverOutputSub, cancel_()).WillOnce(Invoke([&] {
+      serverCancel.post();
+    }));
+
+    clientSock->requestResponse(
+        Payload("data", "meta"),
+        clientInput,
+        RequestDeadline::in(std::chrono::milliseconds(50), true));
+  });
+
+  clientError.wait();
+  serverCancel.wait();
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    serverOutput = nullptr;
+    clientSock.reset();
+    serverSock.reset();
+  });
+}
+
+TEST(ReactiveSocketTest, RequestStreamDeadline) {
+  folly::Baton<> clientError;
+  folly::Baton<> serverCancel;
+  folly::ScopedEventBaseThread th;
+  auto& eventBase = *th.getEventBase();
+
+  std::unique_ptr<ReactiveSocket> clientSock;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  auto clientInput =
+      make_ref<StrictMock<yarpl::flowable::MockSubscriber<Payload>>>();
+  auto serverOutputSub =
+      make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
+  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> serverOutput;
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+
+    auto requestHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    clientSock = ReactiveSocket::fromClientConnection(
+        eventBase, std::move(clientConn), std::move(requestHandler));
+
+    auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+        .WillRepeatedly(Return(nullptr));
+    // The server gets the propagated deadline.
+    EXPECT_CALL(*serverHandler, handleRequestStream_(_, _, _))
+        .WillOnce(Invoke(
+            [&](Payload& request,
+                StreamId,
+                yarpl::Reference<yarpl::flowable::Subscriber<Payload>>
+                    response) {
+              auto deadline = RequestDeadline::takeFrom(request);
+              EXPECT_TRUE(deadline);
+              EXPECT_GT(deadline.remaining(), std::chrono::milliseconds(0));
+              EXPECT_EQ("meta", request.metadata->moveToFbString());
+              serverOutput = response;
+              serverOutput->onSubscribe(serverOutputSub);
+            }));
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(serverHandler));
+
+    // The server sends one of the payloads and never completes.
+    EXPECT_CALL(*serverOutputSub, request_(_)).WillOnce(Invoke([&](int64_t) {
+      serverOutput->onNext(Payload("response"));
+    }));
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke(
+            [](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+              sub->request(10);
+            }));
+    EXPECT_CALL(*clientInput, onNext_(_));
+    EXPECT_CALL(*clientInput, onError_(_))
+        .WillOnce(Invoke([&](std::exception_ptr ex) {
+          EXPECT_THROW(std::rethrow_exception(ex), DeadlineExceededException);
+          clientError.post();
+        }));
+    // The deadline cancels the stream on the server.
+    EXPECT_CALL(*serverOutputSub, cancel_()).WillOnce(Invoke([&] {
+      serverCancel.post();
+    }));
+
+    clientSock->requestStream(
+        Payload("data", "meta"),
+        clientInput,
+        RequestDeadline::in(std::chrono::milliseconds(50), true));
+  });
+
+  clientError.wait();
+  serverCancel.wait();
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    serverOutput = nullptr;
+    clientSock.reset();
+    serverSock.reset();
+  });
+}
+
+TEST(ReactiveSocketTest, RequestChannelDeadline) {
+  folly::Baton<> clientError;
+  folly::Baton<> clientRequestsCancel;
+  folly::Baton<> serverCancel;
+  folly::ScopedEventBaseThread th;
+  auto& eventBase = *th.getEventBase();
+
+  std::unique_ptr<ReactiveSocket> clientSock;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  auto clientInput =
+      make_ref<StrictMock<yarpl::flowable::MockSubscriber<Payload>>>();
+  auto clientOutputSub =
+      make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
+  auto serverInput =
+      make_ref<StrictMock<yarpl::flowable::MockSubscriber<Payload>>>();
+  auto serverOutputSub =
+      make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
+  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> clientOutput;
+  yarpl::Reference<yarpl::flowable::Subscriber<Payload>> serverOutput;
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+
+    auto requestHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    clientSock = ReactiveSocket::fromClientConnection(
+        eventBase, std::move(clientConn), std::move(requestHandler));
+
+    auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+        .WillRepeatedly(Return(nullptr));
+    // The server gets the deadline with the first payload of the channel and
+    // never responds.
+    EXPECT_CALL(*serverHandler, handleRequestChannel_(_, _, _))
+        .WillOnce(Invoke(
+            [&](Payload& request,
+                StreamId,
+                yarpl::Reference<yarpl::flowable::Subscriber<Payload>>
+                    response) {
+              auto deadline = RequestDeadline::takeFrom(request);
+              EXPECT_TRUE(deadline);
+              EXPECT_GT(deadline.remaining(), std::chrono::milliseconds(0));
+              EXPECT_EQ("meta", request.metadata->moveToFbString());
+              serverOutput = response;
+              serverOutput->onSubscribe(serverOutputSub);
+              return serverInput;
+            }));
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(serverHandler));
+
+    EXPECT_CALL(*serverOutputSub, request_(_)).Times(AnyNumber());
+    EXPECT_CALL(*serverInput, onSubscribe_(_));
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke(
+            [](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+              sub->request(1);
+            }));
+    // The client sends the first payload only.
+    EXPECT_CALL(*clientOutputSub, request_(1)).WillOnce(Invoke([&](int64_t) {
+      clientOutput->onNext(Payload("data", "meta"));
+    }));
+    EXPECT_CALL(*clientInput, onError_(_))
+        .WillOnce(Invoke([&](std::exception_ptr ex) {
+          EXPECT_THROW(std::rethrow_exception(ex), DeadlineExceededException);
+          clientError.post();
+        }));
+    // The deadline cancels the channel in both directions, on both ends.
+    EXPECT_CALL(*clientOutputSub, cancel_()).WillOnce(Invoke([&] {
+      clientRequestsCancel.post();
+    }));
+    EXPECT_CALL(*serverOutputSub, cancel_()).WillOnce(Invoke([&] {
+      serverCancel.post();
+    }));
+    EXPECT_CALL(*serverInput, onComplete_());
+
+    clientOutput = clientSock->requestChannel(
+        clientInput, RequestDeadline::in(std::chrono::milliseconds(50), true));
+    clientOutput->onSubscribe(clientOutputSub);
+  });
+
+  clientError.wait();
+  clientRequestsCancel.wait();
+  serverCancel.wait();
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    clientOutput = nullptr;
+    serverOutput = nullptr;
+    clientSock.reset();
+    serverSock.reset();
+  });
+}
+
+TEST(ReactiveSocketTest, DrainServesRequestsInFlight) {
+  constexpr size_t kRequests = 100;
+  constexpr size_t kRacingRequests = 10;
+  folly::Baton<> clientClosed;
+  folly::ScopedEventBaseThread th;
+  auto& eventBase = *th.getEventBase();
+
+  std::unique_ptr<ReactiveSocket> clientSock;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  std::vector<yarpl::Reference<yarpl::single::SingleObserver<Payload>>>
+      serverOutputs;
+  size_t succeeded = 0;
+  size_t failed = 0;
+  size_t rejected = 0;
+
+  auto request = [&] {
+    clientSock->requestResponse(
+        Payload("data"),
+        yarpl::single::SingleObservers::create<Payload>(
+            [&](Payload) { ++succeeded; },
+            [&](std::exception_ptr ex) {
+              try {
+                std::rethrow_exception(ex);
+              } catch (const RejectedException&) {
+                ++rejected;
+              } catch (...) {
+                ++failed;
+              }
+            }));
+  };
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+
+    ConnectionSetupPayload setupPayload;
+    setupPayload.honorsLease = true;
+    clientSock = ReactiveSocket::fromClientConnection(
+        eventBase,
+        std::move(clientConn),
+        std::make_unique<NiceMock<MockRequestHandler>>(),
+        std::move(setupPayload));
+    clientSock->onClosed(
+        [&](const folly::exception_wrapper&) { clientClosed.post(); });
+
+    auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+        .WillRepeatedly(Return(nullptr));
+    // The server holds on to every response, they are in flight.
+    EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+        .Times(kRequests + kRacingRequests)
+        .WillRepeatedly(Invoke(
+            [&](Payload&,
+                StreamId,
+                yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                    response) {
+              response->onSubscribe(
+                  yarpl::single::SingleSubscriptions::empty());
+              serverOutputs.push_back(response);
+            }));
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(serverHandler));
+
+    for (size_t i = 0; i < kRequests; ++i) {
+      request();
+    }
+    serverSock->drain();
+    EXPECT_TRUE(clientSock->isPeerDraining());
+
+    // The client has seen the lease but not answered it yet, like requests
+    // an application thread made before the lease arrived these are served.
+    for (size_t i = 0; i < kRacingRequests; ++i) {
+      request();
+    }
+  });
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    // The client acknowledged the lease, a request ignoring it is rejected.
+    request();
+    EXPECT_EQ(1u, rejected);
+    EXPECT_FALSE(serverSock->isClosed());
+
+    for (auto& output : serverOutputs) {
+      output->onSuccess(Payload("response"));
+    }
+    serverOutputs.clear();
+  });
+
+  // The server closes once the last response is out.
+  clientClosed.wait();
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    EXPECT_TRUE(serverSock->isClosed());
+    EXPECT_EQ(kRequests + kRacingRequests, succeeded);
+    EXPECT_EQ(0u, failed);
+    clientSock.reset();
+    serverSock.reset();
+  });
+}
+
+TEST(ReactiveSocketTest, DrainIsQuietForPeerWithoutLease) {
+  constexpr size_t kRequests = 10;
+  folly::Baton<> clientClosed;
+  folly::ScopedEventBaseThread th;
+  auto& eventBase = *th.getEventBase();
+
+  std::unique_ptr<ReactiveSocket> clientSock;
+  std::unique_ptr<ReactiveSocket> serverSock;
+  std::vector<yarpl::Reference<yarpl::single::SingleObserver<Payload>>>
+      serverOutputs;
+  size_t succeeded = 0;
+  size_t failed = 0;
+  size_t rejected = 0;
+
+  auto request = [&] {
+    clientSock->requestResponse(
+        Payload("data"),
+        yarpl::single::SingleObservers::create<Payload>(
+            [&](Payload) { ++succeeded; },
+            [&](std::exception_ptr ex) {
+              try {
+                std::rethrow_exception(ex);
+              } catch (const RejectedException&) {
+                ++rejected;
+              } catch (...) {
+                ++failed;
+              }
+            }));
+  };
+
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    auto clientConn = std::make_unique<InlineConnection>();
+    auto serverConn = std::make_unique<InlineConnection>();
+    clientConn->connectTo(*serverConn);
+
+    // The client does not announce that it honours leases.
+    clientSock = ReactiveSocket::fromClientConnection(
+        eventBase,
+        std::move(clientConn),
+        std::make_unique<NiceMock<MockRequestHandler>>());
+    clientSock->onClosed(
+        [&](const folly::exception_wrapper&) { clientClosed.post(); });
+
+    auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+    EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+        .WillRepeatedly(Return(nullptr));
+    EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+        .Times(kRequests)
+        .WillRepeatedly(Invoke(
+            [&](Payload&,
+                StreamId,
+                yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                    response) {
+              response->onSubscribe(
+                  yarpl::single::SingleSubscriptions::empty());
+              serverOutputs.push_back(response);
+            }));
+    serverSock = ReactiveSocket::fromServerConnection(
+        eventBase, std::move(serverConn), std::move(serverHandler));
+
+    for (size_t i = 0; i < kRequests; ++i) {
+      request();
+    }
+    serverSock->drain();
+
+    // Neither a LEASE nor a KEEPALIVE asking for an answer was sent, either
+    // of which an old client closes the connection on.
+    EXPECT_FALSE(clientSock->isPeerDraining());
+    EXPECT_FALSE(clientSock->isClosed());
+
+    // New requests are rejected right away.
+    request();
+    EXPECT_EQ(1u, rejected);
+    EXPECT_FALSE(serverSock->isClosed());
+
+    for (auto& output : serverOutputs) {
+      output->onSuccess(Payload("response"));
+    }
+    serverOutputs.clear();
+  });
+
+  clientClosed.wait();
+  eventBase.runInEventBaseThreadAndWait([&]() {
+    EXPECT_TRUE(serverSock->isClosed());
+    EXPECT_EQ(kRequests, succeeded);
+    EXPECT_EQ(0u, failed);
+    clientSock.reset();
+    serverSock.reset();
+  });
+}
+
+TEST(ReactiveSocketTest, ConnectFailedFailsBufferedRequests) {
+  auto clientSock = ReactiveSocket::disconnectedClient(
+      defaultExecutor(), std::make_unique<NiceMock<MockRequestHandler>>());
+
+  auto streamInput =
+      make_ref<NiceMock<yarpl::flowable::MockSubscriber<Payload>>>();
+  EXPECT_CALL(*streamInput, onSubscribe_(_))
+      .WillOnce(Invoke([](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+        sub->request(1);
+      }));
+  std::string streamError;
+  EXPECT_CALL(*streamInput, onError_(_))
+      .WillOnce(Invoke([&](std::exception_ptr ex) {
+        streamError = folly::exceptionStr(ex).toStdString();
+      }));
+  EXPECT_CALL(*streamInput, onComplete_()).Times(0);
+  clientSock->requestStream(Payload("stream"), streamInput);
+
+  std::string responseError;
+  clientSock->requestResponse(
+      Payload("response"),
+      yarpl::single::SingleObservers::create<Payload>(
+          [](Payload) { FAIL() << "unexpected response"; },
+          [&](std::exception_ptr ex) {
+            responseError = folly::exceptionStr(ex).toStdString();
+          }));
+
+  clientSock->connectFailed(
+      folly::make_exception_wrapper<std::runtime_error>("refused"));
+
+  EXPECT_TRUE(clientSock->isClosed());
+  EXPECT_THAT(streamError, HasSubstr("refused"));
+  EXPECT_THAT(responseError, HasSubstr("refused"));
+}
+
 TEST(ReactiveSocketTest, RequestFireAndForget) {
   // InlineConnection forwards appropriate calls in-line, hence the order of
   // mock calls will be deterministic.
@@ -825,6 +1347,192 @@ TEST(ReactiveSocketTest, RequestMetadataPush) {
   clientSock->metadataPush(originalPayload->clone());
 }
 
+TEST(ReactiveSocketTest, CompressionIsNegotiated) {
+  std::vector<CompressionCodec> codecs;
+  for (auto codec : {CompressionCodec::ZSTD, CompressionCodec::LZ4}) {
+    if (PayloadCompression::isSupported(codec)) {
+      codecs.push_back(codec);
+    }
+  }
+  if (codecs.empty()) {
+    return;
+  }
+  const std::string request(64 << 10, 'q');
+  const std::string response(64 << 10, 'r');
+
+  auto clientConn = std::make_unique<InlineConnection>();
+  auto serverConn = std::make_unique<InlineConnection>();
+  clientConn->connectTo(*serverConn);
+
+  // the confirmation of the codec is not passed on to the application
+  auto requestHandler = std::make_unique<StrictMock<MockRequestHandler>>();
+  EXPECT_CALL(*requestHandler, socketOnConnected()).Times(1);
+  EXPECT_CALL(*requestHandler, socketOnClosed(_)).Times(1);
+
+  ConnectionSetupPayload setupPayload(
+      kCompositeMetadataMimeType.str(),
+      "",
+      Payload(
+          folly::IOBuf::copyBuffer("data"),
+          CompositeMetadataBuilder().addRoute({"route"}).build()));
+  setupPayload.compression.codecs = codecs;
+  auto clientSock = ReactiveSocket::fromClientConnection(
+      defaultExecutor(),
+      std::move(clientConn),
+      std::move(requestHandler),
+      std::move(setupPayload));
+
+  auto serverHandler = std::make_unique<StrictMock<MockRequestHandler>>();
+  EXPECT_CALL(*serverHandler, socketOnConnected()).Times(1);
+  EXPECT_CALL(*serverHandler, socketOnClosed(_)).Times(1);
+  // nor is the offer
+  EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+      .WillOnce(Invoke([&](ReactiveSocket&, ConnectionSetupPayload& setup)
+                           -> std::shared_ptr<StreamState> {
+        EXPECT_EQ(codecs, setup.compression.codecs);
+        EXPECT_EQ(
+            CompositeMetadataBuilder().addRoute({"route"}).build()
+                ->moveToFbString(),
+            setup.payload.metadata->moveToFbString());
+        return nullptr;
+      }));
+  EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+      .WillOnce(Invoke(
+          [&](Payload& payload,
+              StreamId,
+              yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                  observer) {
+            EXPECT_FALSE(payload.metadata);
+            EXPECT_EQ(request, payload.moveDataToString());
+            observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+            observer->onSuccess(Payload(response));
+          }));
+
+  auto serverSock = ReactiveSocket::fromServerConnection(
+      defaultExecutor(), std::move(serverConn), std::move(serverHandler));
+
+  std::string received;
+  clientSock->requestResponse(
+      Payload(request),
+      yarpl::single::SingleObservers::create<Payload>([&](Payload payload) {
+        EXPECT_FALSE(payload.metadata);
+        received = payload.moveDataToString();
+      }));
+  EXPECT_EQ(response, received);
+}
+
+TEST(ReactiveSocketTest, CompressionNeedsCompositeMetadata) {
+  auto codec = PayloadCompression::choose(
+      {CompressionCodec::ZSTD, CompressionCodec::LZ4});
+  if (codec == CompressionCodec::NONE) {
+    return;
+  }
+  const std::string request(64 << 10, 'q');
+
+  auto clientConn = std::make_unique<InlineConnection>();
+  auto serverConn = std::make_unique<InlineConnection>();
+  clientConn->connectTo(*serverConn);
+
+  ConnectionSetupPayload setupPayload(
+      "text/plain", "", Payload("data", "metadata"));
+  setupPayload.compression.codecs = {codec};
+  auto clientSock = ReactiveSocket::fromClientConnection(
+      defaultExecutor(),
+      std::move(clientConn),
+      std::make_unique<NiceMock<MockRequestHandler>>(),
+      std::move(setupPayload));
+
+  auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+  // the metadata of the application are neither prefixed with an offer nor
+  // parsed for one
+  EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+      .WillOnce(Invoke([&](ReactiveSocket&, ConnectionSetupPayload& setup)
+                           -> std::shared_ptr<StreamState> {
+        EXPECT_TRUE(setup.compression.codecs.empty());
+        EXPECT_EQ("metadata", setup.payload.metadata->moveToFbString());
+        return nullptr;
+      }));
+  // and requests are sent as they are
+  EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+      .WillOnce(Invoke(
+          [&](Payload& payload,
+              StreamId,
+              yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                  observer) {
+            EXPECT_EQ("metadata", payload.metadata->moveToFbString());
+            EXPECT_EQ(request, payload.moveDataToString());
+            observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+            observer->onSuccess(Payload("response"));
+          }));
+  auto serverSock = ReactiveSocket::fromServerConnection(
+      defaultExecutor(), std::move(serverConn), std::move(serverHandler));
+
+  std::string received;
+  clientSock->requestResponse(
+      Payload(request, "metadata"),
+      yarpl::single::SingleObservers::create<Payload>(
+          [&](Payload payload) { received = payload.moveDataToString(); }));
+  EXPECT_EQ("response", received);
+}
+
+TEST(ReactiveSocketTest, PayloadTooLargeFailsItsStreamOnly) {
+  auto codec = PayloadCompression::choose(
+      {CompressionCodec::ZSTD, CompressionCodec::LZ4});
+  if (codec == CompressionCodec::NONE) {
+    return;
+  }
+
+  auto clientConn = std::make_unique<InlineConnection>();
+  auto serverConn = std::make_unique<InlineConnection>();
+  clientConn->connectTo(*serverConn);
+
+  ConnectionSetupPayload setupPayload(kCompositeMetadataMimeType.str());
+  setupPayload.compression.codecs = {codec};
+  setupPayload.compression.maxUncompressedSize = 32 << 10;
+  auto clientSock = ReactiveSocket::fromClientConnection(
+      defaultExecutor(),
+      std::move(clientConn),
+      std::make_unique<NiceMock<MockRequestHandler>>(),
+      std::move(setupPayload));
+
+  auto serverHandler = std::make_unique<NiceMock<MockRequestHandler>>();
+  EXPECT_CALL(*serverHandler, handleSetupPayload_(_, _))
+      .WillRepeatedly(Return(nullptr));
+  // answers with as many bytes as requested, compressed by the server
+  EXPECT_CALL(*serverHandler, handleRequestResponse_(_, _, _))
+      .WillRepeatedly(Invoke(
+          [&](Payload& payload,
+              StreamId,
+              yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                  observer) {
+            const auto length = folly::to<size_t>(payload.moveDataToString());
+            observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+            observer->onSuccess(Payload(std::string(length, 'r')));
+          }));
+  auto serverSock = ReactiveSocket::fromServerConnection(
+      defaultExecutor(), std::move(serverConn), std::move(serverHandler));
+
+  auto request = [&](size_t length) {
+    std::string result;
+    clientSock->requestResponse(
+        Payload(folly::to<std::string>(length)),
+        yarpl::single::SingleObservers::create<Payload>(
+            [&](Payload payload) {
+              result = folly::to<std::string>(
+                  payload.data->computeChainDataLength());
+            },
+            [&](std::exception_ptr ex) {
+              result = folly::exceptionStr(ex).toStdString();
+            }));
+    return result;
+  };
+
+  EXPECT_EQ("32768", request(32 << 10));
+  EXPECT_THAT(request(64 << 10), HasSubstr("PayloadTooLargeException"));
+  EXPECT_FALSE(clientSock->isClosed());
+  EXPECT_EQ("1024", request(1024));
+}
+
 TEST(ReactiveSocketTest, SetupData) {
   // InlineConnection forwards appropriate calls in-line, hence the order of
   // mock calls will be deterministic.
@@ -1163,7 +1871,9 @@ class ReactiveSocketIgnoreRequestTest : public testing::Test {
         defaultExecutor(),
         std::move(serverConn),
         std::make_unique<DefaultRequestHandler>());
+  }
 
+  void expectRequestIgnored() {
     // Client request.
     EXPECT_CALL(*clientInput, onSubscribe_(_))
         .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
@@ -1198,14 +1908,26 @@ class ReactiveSocketIgnoreRequestTest : public testing::Test {
 };
 
 TEST_F(ReactiveSocketIgnoreRequestTest, IgnoreRequestResponse) {
-  clientSock->requestResponse(Payload(originalPayload->clone()), clientInput);
+  auto clientSingleInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  EXPECT_CALL(*clientSingleInput, onSubscribe_(_));
+  EXPECT_CALL(*clientSingleInput, onSuccess_(_)).Times(0);
+  EXPECT_CALL(*clientSingleInput, onError_(_))
+      .WillOnce(Invoke([&](const std::exception_ptr& ex) {
+        LOG(INFO) << "expected error: " << folly::exceptionStr(ex);
+      }));
+
+  clientSock->requestResponse(
+      Payload(originalPayload->clone()), clientSingleInput);
 }
 
 TEST_F(ReactiveSocketIgnoreRequestTest, IgnoreRequestStream) {
+  expectRequestIgnored();
   clientSock->requestStream(Payload(originalPayload->clone()), clientInput);
 }
 
 TEST_F(ReactiveSocketIgnoreRequestTest, IgnoreRequestChannel) {
+  expectRequestIgnored();
   auto clientOutput = clientSock->requestChannel(clientInput);
 
   auto clientOutputSub = make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
@@ -1250,20 +1972,13 @@ class ReactiveSocketOnErrorOnShutdownTest : public testing::Test {
     serverSock = ReactiveSocket::fromServerConnection(
         defaultExecutor(), std::move(serverConn), std::move(serverHandler));
 
-    EXPECT_CALL(*clientInput, onSubscribe_(_))
-        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
-          clientInputSub = sub;
-          sub->request(2);
-        }));
-
     EXPECT_CALL(serverHandlerRef, handleRequestResponse_(_, _, _))
         .Times(AtMost(1))
         .WillOnce(Invoke([&](
             Payload& request,
             StreamId streamId,
-            yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response) {
-          serverOutput = response;
-          serverOutput->onSubscribe(serverOutputSub);
+            yarpl::Reference<yarpl::single::SingleObserver<Payload>> response) {
+          response->onSubscribe(serverSingleOutputSub);
           serverSock.reset(); // should close everything, but streams should end
           // with onError
         }));
@@ -1299,6 +2014,14 @@ class ReactiveSocketOnErrorOnShutdownTest : public testing::Test {
 
           return serverInput;
         }));
+  }
+
+  void expectFlowableOnError() {
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+          clientInputSub = sub;
+          sub->request(2);
+        }));
 
     EXPECT_CALL(*clientInput, onNext_(_)).Times(0);
     EXPECT_CALL(*clientInput, onComplete_()).Times(0);
@@ -1329,20 +2052,34 @@ class ReactiveSocketOnErrorOnShutdownTest : public testing::Test {
   yarpl::Reference<StrictMock<yarpl::flowable::MockSubscription>> serverOutputSub{
       make_ref<StrictMock<yarpl::flowable::MockSubscription>>()};
 
+  yarpl::Reference<StrictMock<yarpl::single::MockSingleSubscription>>
+      serverSingleOutputSub{
+          make_ref<StrictMock<yarpl::single::MockSingleSubscription>>()};
+
   yarpl::Reference<StrictMock<yarpl::flowable::MockSubscriber<Payload>>> serverInput{
       make_ref<StrictMock<yarpl::flowable::MockSubscriber<Payload>>>()};
   yarpl::Reference<yarpl::flowable::Subscription> serverInputSub;
 };
 
 TEST_F(ReactiveSocketOnErrorOnShutdownTest, DISABLED_RequestResponse) {
-  clientSock->requestResponse(Payload(originalPayload->clone()), clientInput);
+  auto clientSingleInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  EXPECT_CALL(*clientSingleInput, onSubscribe_(_));
+  EXPECT_CALL(*clientSingleInput, onSuccess_(_)).Times(0);
+  EXPECT_CALL(*clientSingleInput, onError_(_));
+  EXPECT_CALL(*serverSingleOutputSub, cancel_());
+
+  clientSock->requestResponse(
+      Payload(originalPayload->clone()), clientSingleInput);
 }
 
 TEST_F(ReactiveSocketOnErrorOnShutdownTest, DISABLED_RequestStream) {
+  expectFlowableOnError();
   clientSock->requestStream(Payload(originalPayload->clone()), clientInput);
 }
 
 TEST_F(ReactiveSocketOnErrorOnShutdownTest, DISABLED_RequestChannel) {
+  expectFlowableOnError();
   auto clientOutput = clientSock->requestChannel(clientInput);
 
   auto clientOutputSub = make_ref<StrictMock<yarpl::flowable::MockSubscription>>();
@@ -1445,21 +2182,17 @@ class ReactiveSocketEmptyPayloadTest : public testing::Test {
     serverSock = ReactiveSocket::fromServerConnection(
         defaultExecutor(), std::move(serverConn), std::move(serverHandler));
 
-    EXPECT_CALL(*clientInput, onSubscribe_(_))
-        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
-          clientInputSub = sub;
-          sub->request(2);
-        }));
-
     EXPECT_CALL(serverHandlerRef, handleRequestResponse_(_, _, _))
         .Times(AtMost(1))
         .WillOnce(Invoke(
             [&](Payload& request,
                 StreamId streamId,
-                yarpl::Reference<yarpl::flowable::Subscriber<Payload>> response) {
+                yarpl::Reference<yarpl::single::SingleObserver<Payload>>
+                    response) {
               CHECK(!request) << "incoming request is expected to be empty";
-              serverOutput = response;
-              serverOutput->onSubscribe(serverOutputSub);
+              response->onSubscribe(
+                  yarpl::single::SingleSubscriptions::empty());
+              response->onSuccess(Payload());
             }));
     EXPECT_CALL(serverHandlerRef, handleRequestStream_(_, _, _))
         .Times(AtMost(1))
@@ -1495,6 +2228,14 @@ class ReactiveSocketEmptyPayloadTest : public testing::Test {
 
               return serverInput;
             }));
+  }
+
+  void expectFlowableEmptyPayloads() {
+    EXPECT_CALL(*clientInput, onSubscribe_(_))
+        .WillOnce(Invoke([&](yarpl::Reference<yarpl::flowable::Subscription> sub) {
+          clientInputSub = sub;
+          sub->request(2);
+        }));
 
     EXPECT_CALL(*clientInput, onComplete_()).Times(1);
     EXPECT_CALL(*clientInput, onError_(_)).Times(1).WillOnce(Invoke([&](std::exception_ptr ex) {
@@ -1531,14 +2272,22 @@ class ReactiveSocketEmptyPayloadTest : public testing::Test {
 };
 
 TEST_F(ReactiveSocketEmptyPayloadTest, DISABLED_RequestResponse) {
-  clientSock->requestResponse(Payload(), clientInput);
+  auto clientSingleInput =
+      make_ref<StrictMock<yarpl::single::MockSingleObserver<Payload>>>();
+  EXPECT_CALL(*clientSingleInput, onSubscribe_(_));
+  EXPECT_CALL(*clientSingleInput, onSuccess_(_))
+      .WillOnce(Invoke([&](Payload& p) { CHECK(!p); }));
+
+  clientSock->requestResponse(Payload(), clientSingleInput);
 }
 
 TEST_F(ReactiveSocketEmptyPayloadTest, DISABLED_RequestStream) {
+  expectFlowableEmptyPayloads();
   clientSock->requestStream(Payload(), clientInput);
 }
 
 TEST_F(ReactiveSocketEmptyPayloadTest, DISABLED_RequestChannel) {
+  expectFlowableEmptyPayloads();
   auto clientOutput = clientSock->requestChannel(clientInput);
   auto clientOutputSub = make_ref<NiceMock<yarpl::flowable::MockSubscription>>();
 
@@ -0,0 +1,92 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <gtest/gtest.h>
+#include "src/CompositeMetadata.h"
+#include "src/Payload.h"
+#include "src/RequestDeadline.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+using namespace std::chrono;
+
+TEST(RequestDeadlineTest, NoDeadline) {
+  RequestDeadline deadline;
+  EXPECT_FALSE(deadline);
+  EXPECT_FALSE(deadline.expired());
+  EXPECT_EQ(RequestDeadline::Clock::duration::max(), deadline.remaining());
+}
+
+TEST(RequestDeadlineTest, Remaining) {
+  auto deadline = RequestDeadline::in(seconds(10));
+  EXPECT_TRUE(deadline);
+  EXPECT_FALSE(deadline.propagate());
+  EXPECT_GT(deadline.remaining(), seconds(9));
+  EXPECT_LE(deadline.remaining(), seconds(10));
+
+  auto passed = RequestDeadline::at(RequestDeadline::Clock::now() - seconds(1));
+  EXPECT_TRUE(passed.expired());
+  EXPECT_EQ(RequestDeadline::Clock::duration::zero(), passed.remaining());
+}
+
+TEST(RequestDeadlineTest, Propagation) {
+  Payload request("data", "metadata");
+  RequestDeadline::in(seconds(10), true).attachTo(request);
+
+  // the budget is the first composite metadata entry
+  CompositeMetadataReader reader(*request.metadata);
+  ASSERT_TRUE(reader.next());
+  EXPECT_TRUE(reader.mimeTypeIs(kDeadlineMimeType));
+  EXPECT_EQ(4u, reader.length());
+
+  auto deadline = RequestDeadline::takeFrom(request);
+  EXPECT_TRUE(deadline);
+  EXPECT_GT(deadline.remaining(), seconds(9));
+  EXPECT_EQ("metadata", request.metadata->moveToFbString());
+  EXPECT_EQ("data", request.moveDataToString());
+}
+
+TEST(RequestDeadlineTest, PropagationWithoutMetadata) {
+  Payload request("data");
+  RequestDeadline::in(seconds(10), true).attachTo(request);
+  ASSERT_TRUE(request.metadata);
+
+  EXPECT_TRUE(RequestDeadline::takeFrom(request));
+  EXPECT_FALSE(request.metadata);
+}
+
+TEST(RequestDeadlineTest, RequestsWithoutDeadline) {
+  Payload request("data", "metadata with no deadline");
+  EXPECT_FALSE(RequestDeadline::takeFrom(request));
+  EXPECT_EQ(
+      "metadata with no deadline", request.metadata->moveToFbString());
+
+  Payload empty;
+  EXPECT_FALSE(RequestDeadline::takeFrom(empty));
+}
+
+TEST(RequestDeadlineTest, PropagationWithCompositeMetadata) {
+  Payload request(
+      folly::IOBuf::copyBuffer("data"),
+      CompositeMetadataBuilder().addRoute({"route"}).build());
+  RequestDeadline::in(seconds(10), true).attachTo(request);
+
+  // the other entries can be read with the deadline in place
+  std::string scratch;
+  EXPECT_EQ("route", readRoute(*request.metadata, scratch).value());
+
+  EXPECT_TRUE(RequestDeadline::takeFrom(request));
+  EXPECT_EQ("route", readRoute(*request.metadata, scratch).value());
+  EXPECT_FALSE(RequestDeadline::takeFrom(request));
+}
+
+TEST(RequestDeadlineTest, MalformedDeadlinesAreIgnored) {
+  // an entry of the mime type with a budget of 2 bytes
+  Payload request(
+      folly::IOBuf::copyBuffer("data"),
+      CompositeMetadataBuilder()
+          .add(kDeadlineMimeType, folly::IOBuf::copyBuffer("12"))
+          .build());
+  const auto length = request.metadata->computeChainDataLength();
+  EXPECT_FALSE(RequestDeadline::takeFrom(request));
+  EXPECT_EQ(length, request.metadata->computeChainDataLength());
+}
@@ -2,7 +2,9 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <set>
 #include "src/Common.h"
+#include "src/ConnectionSetupPayload.h"
 #include "test/streams/Mocks.h"
 
 using namespace ::testing;
@@ -30,3 +32,24 @@ TEST(ResumeIdentificationTokenTest, ToString) {
   out << token;
   ASSERT_EQ("0x123456789abcdeffedcba98765432100", out.str());
 }
+
+TEST(ResumeIdentificationTokenTest, GenerateNew) {
+  std::set<ResumeIdentificationToken> tokens;
+  // more than one batch of random bytes
+  for (int i = 0; i < 1000; ++i) {
+    auto token = ResumeIdentificationToken::generateNew();
+    ASSERT_EQ(16u, token.data().size());
+    tokens.insert(std::move(token));
+  }
+  EXPECT_EQ(1000u, tokens.size());
+}
+
+TEST(ResumeIdentificationTokenTest, OnlyResumableSetupsGenerateTokens) {
+  EXPECT_TRUE(ConnectionSetupPayload().token.data().empty());
+  EXPECT_EQ(
+      16u, ConnectionSetupPayload("", "", Payload(), true).token.data().size());
+
+  auto token = ResumeIdentificationToken::generateNew();
+  EXPECT_EQ(
+      token, ConnectionSetupPayload("", "", Payload(), true, token).token);
+}
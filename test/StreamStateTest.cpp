@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "src/MemoryAccountant.h"
 #include "src/StreamState.h"
 #include "test/MockStats.h"
 
@@ -34,3 +35,35 @@ TEST_F(StreamStateTest, StatsUpdatedInDtor) {
       folly::IOBuf::copyBuffer(std::string(frameSize, 'x')));
   EXPECT_CALL(stats_, streamBufferChanged(-1, -frameSize));
 }
+
+TEST_F(StreamStateTest, MemoryAccounting) {
+  auto stats = std::make_shared<NiceMock<MockStats>>();
+  auto accountant = std::make_shared<MemoryAccountant>(MemoryLimits(), stats);
+  EXPECT_CALL(stats_, streamBufferChanged(_, _)).Times(AnyNumber());
+
+  state_.enqueueOutputPendingFrame(
+      folly::IOBuf::copyBuffer(std::string(7, 'x')));
+  state_.setMemoryAccountant(accountant);
+  EXPECT_EQ(7, accountant->used(MemoryBuffer::STREAM_OUTPUT));
+
+  EXPECT_EQ(
+      11,
+      state_.enqueueOutputPendingFrame(
+          folly::IOBuf::copyBuffer(std::string(11, 'x')), 3));
+  EXPECT_EQ(
+      24,
+      state_.enqueueOutputPendingFrame(
+          folly::IOBuf::copyBuffer(std::string(13, 'x')), 3));
+  EXPECT_EQ(
+      5,
+      state_.enqueueOutputPendingFrame(
+          folly::IOBuf::copyBuffer(std::string(5, 'x')), 5));
+  EXPECT_EQ(36, accountant->used());
+
+  state_.moveOutputPendingFrames();
+  EXPECT_EQ(0, accountant->used());
+  EXPECT_EQ(
+      2,
+      state_.enqueueOutputPendingFrame(
+          folly::IOBuf::copyBuffer(std::string(2, 'x')), 3));
+}
@@ -0,0 +1,102 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/json.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include "src/TaskProfiler.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+namespace {
+TaskProfile makeTask(
+    const char* name,
+    StreamId streamId,
+    std::chrono::microseconds runTime) {
+  TaskProfile task;
+  task.name = name;
+  task.streamId = streamId;
+  task.frameType = FrameType::REQUEST_N;
+  task.queuedAt = TaskProfile::Clock::now();
+  task.startedAt = task.queuedAt + std::chrono::microseconds(5);
+  task.runTime = runTime;
+  task.threadId = 7;
+  return task;
+}
+}
+
+TEST(TaskProfilerTest, KeepsTheLastTasks) {
+  TaskProfiler profiler(1, 3);
+  EXPECT_EQ(1, profiler.taskProfilingSampling());
+  for (StreamId streamId = 1; streamId <= 5; ++streamId) {
+    profiler.taskProfiled(
+        makeTask("task", streamId, std::chrono::microseconds(1)));
+  }
+
+  auto tasks = profiler.tasks();
+  ASSERT_EQ(3, tasks.size());
+  EXPECT_EQ(3, tasks[0].streamId);
+  EXPECT_EQ(4, tasks[1].streamId);
+  EXPECT_EQ(5, tasks[2].streamId);
+}
+
+TEST(TaskProfilerTest, TagsTheCurrentTask) {
+  TaskProfile outer;
+  TaskProfile inner;
+  // no task is being profiled
+  TaskProfile::tagCurrent(1, FrameType::PAYLOAD);
+  {
+    TaskProfile::Scope outerScope(outer);
+    {
+      TaskProfile::Scope innerScope(inner);
+      TaskProfile::tagCurrent(3, FrameType::REQUEST_N);
+    }
+    TaskProfile::tagCurrent(5, FrameType::CANCEL);
+  }
+  TaskProfile::tagCurrent(7, FrameType::PAYLOAD);
+
+  EXPECT_EQ(5, outer.streamId);
+  EXPECT_EQ(FrameType::CANCEL, outer.frameType);
+  EXPECT_EQ(3, inner.streamId);
+  EXPECT_EQ(FrameType::REQUEST_N, inner.frameType);
+}
+
+TEST(TaskProfilerTest, ChromeTrace) {
+  TaskProfiler profiler;
+  profiler.taskProfiled(
+      makeTask("processFrame", 3, std::chrono::microseconds(20)));
+  profiler.taskProfiled(makeTask("onTerminal", 0, std::chrono::microseconds(2)));
+
+  std::ostringstream os;
+  profiler.writeChromeTrace(os);
+  auto trace = folly::parseJson(os.str());
+  const auto& events = trace["traceEvents"];
+  ASSERT_EQ(2, events.size());
+
+  EXPECT_EQ("processFrame", events[0]["name"].asString());
+  EXPECT_EQ("X", events[0]["ph"].asString());
+  EXPECT_EQ(20, events[0]["dur"].asInt());
+  EXPECT_EQ(7, events[0]["tid"].asInt());
+  EXPECT_EQ(5, events[0]["args"]["queue_us"].asInt());
+  EXPECT_EQ(3, events[0]["args"]["stream"].asInt());
+  EXPECT_EQ("REQUEST_N", events[0]["args"]["frame"].asString());
+
+  EXPECT_EQ("onTerminal", events[1]["name"].asString());
+  EXPECT_EQ(nullptr, events[1]["args"].get_ptr("stream"));
+}
+
+TEST(TaskProfilerTest, FoldedStacks) {
+  TaskProfiler profiler;
+  profiler.taskProfiled(
+      makeTask("processFrame", 3, std::chrono::microseconds(20)));
+  profiler.taskProfiled(
+      makeTask("processFrame", 3, std::chrono::microseconds(10)));
+  profiler.taskProfiled(makeTask("onTerminal", 0, std::chrono::microseconds(2)));
+
+  std::ostringstream os;
+  profiler.writeFoldedStacks(os);
+  EXPECT_EQ(
+      "onTerminal 2\n"
+      "processFrame;REQUEST_N;stream_3 30\n",
+      os.str());
+}
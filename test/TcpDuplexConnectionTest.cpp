@@ -0,0 +1,61 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "src/tcp/TcpDuplexConnection.h"
+#include "test/streams/Mocks.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+TEST(TcpDuplexConnectionTest, ReadsPauseAndResumeWithDemand) {
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  folly::EventBase eventBase;
+  TcpDuplexConnection connection(
+      folly::AsyncSocket::UniquePtr(new folly::AsyncSocket(&eventBase, fds[0])),
+      inlineExecutor());
+
+  auto input =
+      std::make_shared<MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*input, onSubscribe_(_));
+  connection.setInput(input);
+
+  // nothing is read before the input requests
+  ASSERT_EQ(3, ::write(fds[1], "abc", 3));
+  EXPECT_CALL(*input, onNext_(_)).Times(0);
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  Mock::VerifyAndClearExpectations(input.get());
+
+  EXPECT_CALL(*input, onNext_(_))
+      .WillOnce(Invoke([](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_EQ("abc", buf->moveToFbString().toStdString());
+      }));
+  input->subscription()->request(1);
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  Mock::VerifyAndClearExpectations(input.get());
+
+  // the read used up the demand, the next bytes wait in the socket
+  ASSERT_EQ(3, ::write(fds[1], "def", 3));
+  EXPECT_CALL(*input, onNext_(_)).Times(0);
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  Mock::VerifyAndClearExpectations(input.get());
+
+  EXPECT_CALL(*input, onNext_(_))
+      .WillOnce(Invoke([](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_EQ("def", buf->moveToFbString().toStdString());
+      }));
+  input->subscription()->request(1);
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  Mock::VerifyAndClearExpectations(input.get());
+
+  input->subscription()->cancel();
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  ::close(fds[1]);
+}
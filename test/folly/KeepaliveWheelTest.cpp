@@ -0,0 +1,137 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+
+#include <folly/io/async/EventBase.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/ConnectionAutomaton.h"
+#include "src/Frame.h"
+#include "src/folly/KeepaliveWheel.h"
+
+using namespace ::testing;
+using namespace ::reactivesocket;
+
+namespace {
+class MockConnectionAutomaton : public FrameSink {
+ public:
+  // MOCK_METHOD doesn't take functions with unique_ptr args.
+  // A workaround for sendKeepalive method.
+  virtual void sendKeepalive(std::unique_ptr<folly::IOBuf> b) override {
+    sendKeepalive_(b);
+  }
+  MOCK_METHOD1(sendKeepalive_, void(std::unique_ptr<folly::IOBuf>&));
+
+  MOCK_METHOD1(disconnectOrCloseWithError_, void(Frame_ERROR&));
+
+  void disconnectOrCloseWithError(Frame_ERROR&& error) override {
+    disconnectOrCloseWithError_(error);
+  }
+};
+
+using Clock = KeepaliveWheel::Clock;
+using std::chrono::milliseconds;
+}
+
+TEST(KeepaliveWheelTest, SendsKeepalivesEveryPeriod) {
+  auto connectionAutomaton =
+      std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  folly::EventBase eventBase;
+  auto wheel = std::make_shared<KeepaliveWheel>(eventBase, milliseconds(10));
+  auto timer = wheel->createTimer(milliseconds(30));
+
+  const auto start = Clock::now();
+  timer->start(connectionAutomaton);
+  EXPECT_EQ(1, wheel->size());
+
+  wheel->expireTimers(start + milliseconds(10));
+
+  EXPECT_CALL(*connectionAutomaton, sendKeepalive_(_)).Times(1);
+  wheel->expireTimers(start + milliseconds(40));
+  Mock::VerifyAndClearExpectations(connectionAutomaton.get());
+
+  timer->keepaliveReceived();
+  EXPECT_CALL(*connectionAutomaton, sendKeepalive_(_)).Times(1);
+  wheel->expireTimers(start + milliseconds(70));
+  Mock::VerifyAndClearExpectations(connectionAutomaton.get());
+
+  timer->stop();
+  EXPECT_EQ(0, wheel->size());
+  wheel->expireTimers(start + milliseconds(200));
+}
+
+TEST(KeepaliveWheelTest, NoResponse) {
+  auto connectionAutomaton =
+      std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  folly::EventBase eventBase;
+  auto wheel = std::make_shared<KeepaliveWheel>(eventBase, milliseconds(10));
+  auto timer = wheel->createTimer(milliseconds(30));
+
+  const auto start = Clock::now();
+  timer->start(connectionAutomaton);
+
+  EXPECT_CALL(*connectionAutomaton, sendKeepalive_(_)).Times(1);
+  EXPECT_CALL(*connectionAutomaton, disconnectOrCloseWithError_(_))
+      .WillOnce(Invoke([&](Frame_ERROR&) { timer->stop(); }));
+  wheel->expireTimers(start + milliseconds(70));
+  EXPECT_EQ(0, wheel->size());
+}
+
+TEST(KeepaliveWheelTest, PeriodsLongerThanTheWheel) {
+  auto connectionAutomaton =
+      std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  folly::EventBase eventBase;
+  auto wheel = std::make_shared<KeepaliveWheel>(eventBase, milliseconds(1));
+  // wraps the 512 slots of the wheel
+  auto timer = wheel->createTimer(milliseconds(2000));
+
+  const auto start = Clock::now();
+  timer->start(connectionAutomaton);
+
+  wheel->expireTimers(start + milliseconds(1500));
+
+  EXPECT_CALL(*connectionAutomaton, sendKeepalive_(_)).Times(1);
+  wheel->expireTimers(start + milliseconds(2002));
+}
+
+TEST(KeepaliveWheelTest, ConnectionsStoppingEachOther) {
+  auto first = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  auto second = std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  folly::EventBase eventBase;
+  auto wheel = std::make_shared<KeepaliveWheel>(eventBase, milliseconds(10));
+  auto firstTimer = wheel->createTimer(milliseconds(30));
+  auto secondTimer = wheel->createTimer(milliseconds(30));
+
+  const auto start = Clock::now();
+  firstTimer->start(first);
+  secondTimer->start(second);
+
+  // the timers expire in the same tick, whichever goes first stops the other
+  auto stopBoth = [&](std::unique_ptr<folly::IOBuf>&) {
+    firstTimer->stop();
+    secondTimer->stop();
+  };
+  EXPECT_CALL(*first, sendKeepalive_(_)).Times(AtMost(1)).WillOnce(
+      Invoke(stopBoth));
+  EXPECT_CALL(*second, sendKeepalive_(_)).Times(AtMost(1)).WillOnce(
+      Invoke(stopBoth));
+  wheel->expireTimers(start + milliseconds(40));
+  EXPECT_EQ(0, wheel->size());
+}
+
+TEST(KeepaliveWheelTest, OneWheelPerEventBase) {
+  folly::EventBase eventBase;
+  auto wheel = KeepaliveWheel::forEventBase(eventBase);
+  EXPECT_EQ(wheel, KeepaliveWheel::forEventBase(eventBase));
+
+  folly::EventBase other;
+  EXPECT_NE(wheel, KeepaliveWheel::forEventBase(other));
+
+  // the timers of the connections of the EventBase share its wheel
+  auto connectionAutomaton =
+      std::make_shared<StrictMock<MockConnectionAutomaton>>();
+  auto timer = KeepaliveWheel::forEventBase(eventBase)->createTimer(
+      milliseconds(5000));
+  timer->start(connectionAutomaton);
+  EXPECT_EQ(1, wheel->size());
+  timer->stop();
+}
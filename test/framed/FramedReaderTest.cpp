@@ -7,11 +7,13 @@
 #include <folly/io/Cursor.h>
 #include <gmock/gmock.h>
 #include "src/FrameSerializer.h"
+#include "src/MemoryAccountant.h"
 #include "src/ReactiveSocket.h"
 #include "src/framed/FramedDuplexConnection.h"
 #include "src/framed/FramedReader.h"
 #include "test/InlineConnection.h"
 #include "test/MockRequestHandler.h"
+#include "test/MockStats.h"
 #include "test/streams/Mocks.h"
 
 using namespace ::testing;
@@ -182,6 +184,80 @@ TEST(FramedReaderTest, Read1FrameIncomplete) {
   framedReader->onComplete();
 }
 
+TEST(FramedReaderTest, PartialFrameIsCharged) {
+  auto frameSubscriber =
+      std::make_shared<MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  auto wireSubscription = std::make_shared<NiceMock<MockSubscription>>();
+  auto accountant = std::make_shared<MemoryAccountant>(
+      MemoryLimits(), std::make_shared<NiceMock<MockStats>>());
+
+  auto framedReader = std::make_shared<FramedReader>(
+      frameSubscriber,
+      inlineExecutor(),
+      std::make_shared<ProtocolVersion>(
+          FrameSerializer::getCurrentProtocolVersion()));
+  framedReader->setMemoryAccountant(accountant);
+  framedReader->onSubscribe(wireSubscription);
+  frameSubscriber->subscription()->request(1);
+
+  const std::string msg(100, 'x');
+  auto payload = folly::IOBuf::create(0);
+  {
+    folly::io::Appender appender(payload.get(), 10);
+    appender.writeBE<int32_t>(msg.size() + sizeof(int32_t));
+    folly::format("{}", msg.substr(0, 50))(appender);
+  }
+  framedReader->onNext(std::move(payload));
+  EXPECT_EQ(54, accountant->used(MemoryBuffer::PENDING_READS));
+
+  EXPECT_CALL(*frameSubscriber, onNext_(_))
+      .WillOnce(Invoke([&](std::unique_ptr<folly::IOBuf>& p) {
+        ASSERT_EQ(msg, p->moveToFbString().toStdString());
+      }));
+  framedReader->onNext(folly::IOBuf::copyBuffer(msg.substr(50)));
+  EXPECT_EQ(0, accountant->used(MemoryBuffer::PENDING_READS));
+
+  // the bytes of a frame still being read are released with the reader
+  framedReader->onNext(folly::IOBuf::copyBuffer(std::string("\0\0", 2)));
+  EXPECT_EQ(2, accountant->used(MemoryBuffer::PENDING_READS));
+
+  EXPECT_CALL(*frameSubscriber, onComplete_());
+  framedReader->onComplete();
+  EXPECT_EQ(0, accountant->used(MemoryBuffer::PENDING_READS));
+}
+
+TEST(FramedReaderTest, FrameOverMemoryCapIsRefused) {
+  auto frameSubscriber =
+      std::make_shared<MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  auto wireSubscription = std::make_shared<NiceMock<MockSubscription>>();
+  MemoryLimits limits;
+  limits.streamBytes = 64;
+  auto accountant = std::make_shared<MemoryAccountant>(
+      limits, std::make_shared<NiceMock<MockStats>>());
+
+  auto framedReader = std::make_shared<FramedReader>(
+      frameSubscriber,
+      inlineExecutor(),
+      std::make_shared<ProtocolVersion>(
+          FrameSerializer::getCurrentProtocolVersion()));
+  framedReader->setMemoryAccountant(accountant);
+  framedReader->onSubscribe(wireSubscription);
+  frameSubscriber->subscription()->request(1);
+
+  EXPECT_CALL(*frameSubscriber, onNext_(_)).Times(0);
+  EXPECT_CALL(*frameSubscriber, onError_(_));
+  EXPECT_CALL(*wireSubscription, cancel_());
+
+  // only the length of the frame has been read
+  auto payload = folly::IOBuf::create(0);
+  {
+    folly::io::Appender appender(payload.get(), 10);
+    appender.writeBE<int32_t>(65 + sizeof(int32_t));
+  }
+  framedReader->onNext(std::move(payload));
+  EXPECT_EQ(0, accountant->used(MemoryBuffer::PENDING_READS));
+}
+
 TEST(FramedReaderTest, InvalidDataStream) {
   auto rsConnection = std::make_unique<InlineConnection>();
   auto testConnection = std::make_unique<InlineConnection>();
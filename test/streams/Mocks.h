@@ -10,6 +10,8 @@
 #include <reactive-streams/ReactiveStreams.h>
 #include <yarpl/flowable/Subscriber.h>
 #include <yarpl/flowable/Subscription.h>
+#include <yarpl/single/SingleObserver.h>
+#include <yarpl/single/SingleSubscription.h>
 #include "src/ReactiveStreamsCompat.h"
 
 namespace yarpl {
@@ -145,6 +147,55 @@ class MockSubscription : public yarpl::flowable::Subscription {
 };
 
 } // flowable
+
+namespace single {
+
+/// GoogleMock-compatible SingleObserver implementation for fast prototyping.
+/// MockSingleObserver MUST be heap-allocated, as it manages its own lifetime.
+template <typename T>
+class MockSingleObserver : public yarpl::single::SingleObserver<T> {
+ public:
+  MockSingleObserver() {
+    VLOG(2) << "ctor MockSingleObserver " << this;
+  }
+  ~MockSingleObserver() {
+    VLOG(2) << "dtor MockSingleObserver " << this;
+  }
+
+  MOCK_METHOD1(
+      onSubscribe_,
+      void(yarpl::Reference<yarpl::single::SingleSubscription> subscription));
+  MOCK_METHOD1_T(onSuccess_, void(T& value));
+  MOCK_METHOD1(onError_, void(const std::exception_ptr ex));
+
+  void onSubscribe(yarpl::Reference<yarpl::single::SingleSubscription>
+                       subscription) override {
+    yarpl::single::SingleObserver<T>::onSubscribe(subscription);
+    onSubscribe_(std::move(subscription));
+  }
+
+  void onSuccess(T value) override {
+    onSuccess_(value);
+    yarpl::single::SingleObserver<T>::onSuccess(std::move(value));
+  }
+
+  void onError(const std::exception_ptr ex) override {
+    onError_(ex);
+    yarpl::single::SingleObserver<T>::onError(ex);
+  }
+};
+
+/// GoogleMock-compatible SingleSubscription implementation.
+class MockSingleSubscription : public yarpl::single::SingleSubscription {
+ public:
+  MOCK_METHOD0(cancel_, void());
+
+  void cancel() override {
+    cancel_();
+  }
+};
+
+} // single
 } // yarpl
 
 namespace reactivesocket {
@@ -14,6 +14,7 @@
 #include "src/tcp/TcpDuplexConnection.h"
 #include "test/simple/PrintSubscriber.h"
 #include "test/simple/StatsPrinter.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -77,10 +78,12 @@ class ClientRequestHandler : public DefaultRequestHandler {
   void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) noexcept override {
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          response) noexcept override {
     LOG(INFO) << "ServerRequestHandler.handleRequestResponse " << request;
 
-    response->onSubscribe(make_ref<ClientSubscription>(response, 1));
+    response->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+    response->onSuccess(Payload("from server 0"));
   }
 
   void handleFireAndForgetRequest(
@@ -12,6 +12,7 @@
 #include "src/tcp/TcpDuplexConnection.h"
 #include "test/simple/PrintSubscriber.h"
 #include "test/simple/StatsPrinter.h"
+#include "yarpl/single/SingleSubscriptions.h"
 
 using namespace ::testing;
 using namespace ::reactivesocket;
@@ -62,10 +63,12 @@ class ServerRequestHandler : public DefaultRequestHandler {
   void handleRequestResponse(
       Payload request,
       StreamId streamId,
-      const yarpl::Reference<yarpl::flowable::Subscriber<Payload>>& response) noexcept override {
+      const yarpl::Reference<yarpl::single::SingleObserver<Payload>>&
+          response) noexcept override {
     LOG(INFO) << "ServerRequestHandler.handleRequestResponse " << request;
 
-    response->onSubscribe(make_ref<ServerSubscription>(response, 1));
+    response->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+    response->onSuccess(Payload("from server 0"));
   }
 
   void handleFireAndForgetRequest(